@@ -0,0 +1,34 @@
+#ifndef __BENCHMARK_UTILS_H__
+#define __BENCHMARK_UTILS_H__
+#include <mlfe/core/tensor.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace mlfe_benchmark{
+
+// the inputs of every benchmark come from a fixed seed, so runs and
+// versions see the same data.
+inline std::vector<float> random_vector(const int size,
+                                        const float lo = -1,
+                                        const float hi = 1,
+                                        const unsigned int seed = 0
+                                       ){
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<float> v(size);
+    std::generate(v.begin(), v.end(), [&](){ return dist(rng); });
+    return v;
+}
+
+inline void fill(mlfe::Tensor x,
+                 const float lo = -1,
+                 const float hi = 1,
+                 const unsigned int seed = 0
+                ){
+    auto v = random_vector(x.size(), lo, hi, seed);
+    std::copy(v.begin(), v.end(), x.begin<float>());
+}
+
+} // end namespace mlfe_benchmark
+#endif // end ifndef __BENCHMARK_UTILS_H__
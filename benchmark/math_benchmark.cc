@@ -0,0 +1,269 @@
+#include "benchmark_utils.h"
+#include <benchmark/benchmark.h>
+#include <mlfe/math/activations.h>
+#include <mlfe/math/basic_functions.h>
+#include <mlfe/math/blas.h>
+#include <mlfe/math/broadcast.h>
+#include <mlfe/math/fast_math.h>
+#include <mlfe/math/optimizers.h>
+#include <mlfe/math/transform.h>
+#include <mlfe/device_context/cpu_context.h>
+#include <cmath>
+#include <vector>
+
+using namespace mlfe;
+using mlfe_benchmark::random_vector;
+
+namespace{
+
+// the counters of a kernel reading and writing bytes per iteration.
+void set_bytes(benchmark::State &state, const double bytes){
+    state.SetBytesProcessed(int64_t(state.iterations() * bytes));
+}
+
+void set_flops(benchmark::State &state, const double flops){
+    state.counters["FLOPS"] = benchmark::Counter(
+        flops, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// gemm of m x k and k x n.
+void BM_gemm(benchmark::State &state){
+    const int m = state.range(0), n = state.range(1), k = state.range(2);
+    auto a = random_vector(m * k), b = random_vector(k * n, -1, 1, 1);
+    std::vector<float> c(m * n);
+    for(auto _ : state){
+        math::gemm<float, CPUContext>(false, false, m, n, k,
+                                      1.f, a.data(), k, b.data(), n,
+                                      0.f, c.data(), n, nullptr);
+        benchmark::DoNotOptimize(c.data());
+    }
+    set_flops(state, 2. * m * n * k);
+}
+// square, the fc layers of the auto encoder and the conv layers of lenet
+// as filters x (kernel size) x (output size).
+BENCHMARK(BM_gemm)->Args({256, 256, 256})->Args({64, 500, 784})
+    ->Args({64, 784, 500})->Args({16, 576, 25})->Args({32, 64, 400});
+
+void BM_gemv(benchmark::State &state){
+    const int m = state.range(0), n = state.range(1);
+    auto a = random_vector(m * n), x = random_vector(n, -1, 1, 1);
+    std::vector<float> y(m);
+    for(auto _ : state){
+        math::gemv<float, CPUContext>(false, m, n, 1.f, a.data(), n,
+                                      x.data(), 0.f, y.data(), 1, nullptr);
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_flops(state, 2. * m * n);
+}
+BENCHMARK(BM_gemv)->Args({1024, 1024});
+
+// channels, size and kernel of a 3x3 or 5x5 convolution with stride 1.
+void BM_im2col(benchmark::State &state){
+    const int c = state.range(0), hw = state.range(1), k = state.range(2);
+    const int pad = k / 2;
+    auto im = random_vector(c * hw * hw);
+    std::vector<float> col(c * k * k * hw * hw);
+    for(auto _ : state){
+        math::im2col<float, CPUContext>(c, hw, hw, k, k, 1, pad,
+                                        im.data(), col.data());
+        benchmark::DoNotOptimize(col.data());
+    }
+    set_bytes(state, (im.size() + col.size()) * sizeof(float));
+}
+BENCHMARK(BM_im2col)->Args({16, 28, 5})->Args({64, 32, 3});
+
+void BM_col2im(benchmark::State &state){
+    const int c = state.range(0), hw = state.range(1), k = state.range(2);
+    const int pad = k / 2;
+    auto col = random_vector(c * k * k * hw * hw);
+    std::vector<float> im(c * hw * hw);
+    for(auto _ : state){
+        math::col2im<float, CPUContext>(col.data(), c, hw, hw, k, 1, pad,
+                                        im.data());
+        benchmark::DoNotOptimize(im.data());
+    }
+    set_bytes(state, (im.size() + col.size()) * sizeof(float));
+}
+BENCHMARK(BM_col2im)->Args({16, 28, 5})->Args({64, 32, 3});
+
+#define BENCHMARK_UNARY(Name, Call)                                      \
+void BM_##Name(benchmark::State &state){                                 \
+    const int size = state.range(0);                                     \
+    auto x = random_vector(size, -4, 4);                                 \
+    auto dy = random_vector(size, -1, 1, 1);                             \
+    std::vector<float> y(size);                                          \
+    for(auto _ : state){                                                 \
+        Call;                                                            \
+        benchmark::DoNotOptimize(y.data());                              \
+    }                                                                    \
+    set_bytes(state, 2. * size * sizeof(float));                        \
+}                                                                        \
+BENCHMARK(BM_##Name)->Arg(1 << 20);
+
+BENCHMARK_UNARY(axpy, (math::axpy<float, CPUContext>(
+    size, 0.5f, x.data(), y.data())))
+BENCHMARK_UNARY(scal, (math::scal<float, CPUContext>(
+    size, 0.5f, x.data(), y.data())))
+BENCHMARK_UNARY(relu, (math::relu<float, CPUContext>(
+    size, x.data(), y.data())))
+BENCHMARK_UNARY(relu_gradient, (math::relu_gradient<float, CPUContext>(
+    size, x.data(), dy.data(), y.data())))
+BENCHMARK_UNARY(sigmoid, (math::sigmoid<float, CPUContext>(
+    size, x.data(), y.data())))
+BENCHMARK_UNARY(sigmoid_gradient, (math::sigmoid_gradient<float, CPUContext>(
+    size, x.data(), dy.data(), y.data())))
+BENCHMARK_UNARY(exp, (math::exp<float, CPUContext>(
+    size, x.data(), y.data())))
+
+#undef BENCHMARK_UNARY
+
+// the approximations of math/fast_math.h against libm, one float at a
+// time as the kernels call them.
+#define BENCHMARK_FAST_MATH(Name, Lo, Hi)                                \
+void BM_fast_##Name(benchmark::State &state){                            \
+    auto x = random_vector(1 << 20, Lo, Hi);                             \
+    std::vector<float> y(x.size());                                      \
+    for(auto _ : state){                                                 \
+        for(int n = 0; n < x.size(); ++n){                               \
+            y[n] = math::fast::Name(x[n]);                               \
+        }                                                                \
+        benchmark::DoNotOptimize(y.data());                              \
+    }                                                                    \
+    state.SetItemsProcessed(state.iterations() * x.size());              \
+}                                                                        \
+BENCHMARK(BM_fast_##Name);                                               \
+void BM_libm_##Name(benchmark::State &state){                            \
+    auto x = random_vector(1 << 20, Lo, Hi);                             \
+    std::vector<float> y(x.size());                                      \
+    for(auto _ : state){                                                 \
+        for(int n = 0; n < x.size(); ++n){                               \
+            y[n] = libm_##Name(x[n]);                                    \
+        }                                                                \
+        benchmark::DoNotOptimize(y.data());                              \
+    }                                                                    \
+    state.SetItemsProcessed(state.iterations() * x.size());              \
+}                                                                        \
+BENCHMARK(BM_libm_##Name);
+
+float libm_exp(float x){ return std::exp(x); }
+float libm_log(float x){ return std::log(x); }
+float libm_log1p(float x){ return std::log1p(x); }
+float libm_tanh(float x){ return std::tanh(x); }
+float libm_sigmoid(float x){ return 1.f / (1.f + std::exp(-x)); }
+
+BENCHMARK_FAST_MATH(exp, -80, 80)
+BENCHMARK_FAST_MATH(log, 1e-6, 1e6)
+BENCHMARK_FAST_MATH(log1p, -0.9, 10)
+BENCHMARK_FAST_MATH(tanh, -10, 10)
+BENCHMARK_FAST_MATH(sigmoid, -20, 20)
+
+#undef BENCHMARK_FAST_MATH
+
+// batch x classes.
+void BM_softmax_cross_entropy(benchmark::State &state){
+    const int m = state.range(0), n = state.range(1);
+    auto x = random_vector(m * n, -4, 4), t = random_vector(m * n, 0, 1, 1);
+    std::vector<float> loss(m);
+    for(auto _ : state){
+        math::softmax_cross_entropy<float, CPUContext>(
+            m, n, x.data(), t.data(), loss.data(), nullptr);
+        benchmark::DoNotOptimize(loss.data());
+    }
+    set_bytes(state, 2. * m * n * sizeof(float));
+}
+BENCHMARK(BM_softmax_cross_entropy)->Args({64, 10})->Args({256, 1000});
+
+void BM_softmax_cross_entropy_gradient(benchmark::State &state){
+    const int m = state.range(0), n = state.range(1);
+    auto x = random_vector(m * n, -4, 4), t = random_vector(m * n, 0, 1, 1);
+    auto dy = random_vector(m, -1, 1, 2);
+    std::vector<float> dx(m * n);
+    for(auto _ : state){
+        math::softmax_cross_entropy_gradient<float, CPUContext>(
+            m, n, x.data(), t.data(), dy.data(), dx.data());
+        benchmark::DoNotOptimize(dx.data());
+    }
+    set_bytes(state, 3. * m * n * sizeof(float));
+}
+BENCHMARK(BM_softmax_cross_entropy_gradient)->Args({256, 1000});
+
+// the bias of a conv layer, n x c x h x w plus c x 1 x 1.
+void BM_broadcast_add_channel(benchmark::State &state){
+    const std::vector<int> x_shape = {64, 32, 28, 28}, b_shape = {32, 1, 1};
+    auto x = random_vector(64 * 32 * 28 * 28), b = random_vector(32);
+    std::vector<float> y(x.size());
+    for(auto _ : state){
+        math::broadcast_add<float, CPUContext>(x_shape, x.data(),
+                                               b_shape, b.data(),
+                                               x_shape, y.data());
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state, 2. * x.size() * sizeof(float));
+}
+BENCHMARK(BM_broadcast_add_channel);
+
+// the gradient of the conv bias, and a sum over all elements.
+void BM_reduce_sum_to(benchmark::State &state){
+    const std::vector<int> x_shape = {64, 32, 28, 28};
+    const std::vector<int> y_shape = state.range(0) == 0 ?
+        std::vector<int>{32, 1, 1} : std::vector<int>{1};
+    auto x = random_vector(64 * 32 * 28 * 28);
+    std::vector<float> y(32);
+    for(auto _ : state){
+        math::reduce_sum_to<float, CPUContext>(x_shape, x.data(),
+                                               y_shape, y.data());
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state, x.size() * sizeof(float));
+}
+BENCHMARK(BM_reduce_sum_to)->Arg(0)->Arg(1);
+
+// both halves of a lamb step, with a trust ratio of 1.
+void lamb_step(const int size, float *w, const float *dw,
+               float *m_hist, float *v_hist, const int step){
+    float norms[2] = {0, 0};
+    math::lamb_moments<float, CPUContext>(size, w, dw, m_hist, v_hist,
+                                          0.9f, 0.999f, 1e-6f, 1e-2f,
+                                          step, norms);
+    math::lamb_update<float, CPUContext>(size, w, m_hist, v_hist,
+                                         1e-3f, 0.9f, 0.999f, 1e-6f, 1e-2f,
+                                         step, 1.f);
+}
+
+// one update of a million weights.
+#define BENCHMARK_OPTIMIZER(Name, NumHist, Call)                         \
+void BM_##Name(benchmark::State &state){                                 \
+    const int size = 1 << 20;                                            \
+    auto w = random_vector(size);                                        \
+    auto dw = random_vector(size, -1, 1, 1);                             \
+    std::vector<float> h1(size), h2(size);                               \
+    int step = 0;                                                        \
+    for(auto _ : state){                                                 \
+        ++step;                                                          \
+        Call;                                                            \
+        benchmark::DoNotOptimize(w.data());                              \
+    }                                                                    \
+    set_bytes(state, (3. + 2 * NumHist) * size * sizeof(float));         \
+}                                                                        \
+BENCHMARK(BM_##Name);
+
+BENCHMARK_OPTIMIZER(gradient_descent_momentum, 1,
+    (math::gradient_descent_momentum<float, CPUContext>(
+        size, w.data(), dw.data(), h1.data(), 1e-3f, 0.9f, 0.f)))
+BENCHMARK_OPTIMIZER(adadelta, 2,
+    (math::adadelta<float, CPUContext>(
+        size, w.data(), dw.data(), h1.data(), h2.data(), 1.f, 0.95f, 1e-6f)))
+BENCHMARK_OPTIMIZER(adam, 2,
+    (math::adam<float, CPUContext>(
+        size, w.data(), dw.data(), h1.data(), h2.data(),
+        1e-3f, 0.9f, 0.999f, 1e-8f, step)))
+BENCHMARK_OPTIMIZER(adamw, 2,
+    (math::adamw<float, CPUContext>(
+        size, w.data(), dw.data(), h1.data(), h2.data(),
+        1e-3f, 0.9f, 0.999f, 1e-8f, 1e-2f, step)))
+BENCHMARK_OPTIMIZER(lamb, 2,
+    (lamb_step(size, w.data(), dw.data(), h1.data(), h2.data(), step)))
+
+#undef BENCHMARK_OPTIMIZER
+
+} // end anonymous namespace
@@ -0,0 +1,77 @@
+#include "benchmark_utils.h"
+#include "mnist_models.h"
+#include <benchmark/benchmark.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <mlfe/optimizers.h>
+#include <vector>
+
+using namespace mlfe;
+namespace fn = functional;
+using mlfe_benchmark::random_vector;
+
+namespace{
+
+constexpr int batch = 64;
+
+// one-hot labels of batch images, cycling through the classes.
+std::vector<float> one_hot_labels(const int classes){
+    std::vector<float> y(batch * classes, 0);
+    for(int n = 0; n < batch; ++n){
+        y[n * classes + n % classes] = 1;
+    }
+    return y;
+}
+
+// a training step of the models of example/train, forward, backward and
+// the sgd update, on a fixed synthetic batch instead of mnist.
+void BM_step_lenet(benchmark::State &state){
+    train_example::Lenet model(batch, 1e-2, 0.9);
+    auto x = random_vector(batch * 28 * 28, 0, 1);
+    auto y = one_hot_labels(10);
+    for(auto _ : state){
+        model.forward(x, y);
+        model.backward();
+        model.update();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_step_lenet)->Unit(benchmark::kMillisecond);
+
+void BM_step_auto_encoder(benchmark::State &state){
+    train_example::AutoEncoder model(batch, 1e-2, 0.9);
+    auto x = random_vector(batch * 28 * 28, 0, 1);
+    for(auto _ : state){
+        model.forward(x);
+        model.backward();
+        model.update();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_step_auto_encoder)->Unit(benchmark::kMillisecond);
+
+// the model of train_simple_mnist, a fc layer and softmax cross entropy.
+void BM_step_simple(benchmark::State &state){
+    auto x = fn::create_variable({batch, 28 * 28});
+    auto y = fn::create_variable({batch, 10});
+    auto w = fn::create_variable({28 * 28, 10});
+    auto b = fn::create_variable({10});
+    auto sgd = fn::create_gradient_descent_optimizer(1e-1, 0.9);
+    auto x_val = random_vector(x.size(), 0, 1);
+    auto y_val = one_hot_labels(10);
+    std::fill(w.begin<float>(), w.end<float>(), 0);
+    std::fill(b.begin<float>(), b.end<float>(), 0);
+    auto logit = fn::add(fn::matmul(x, w), b);
+    auto loss = fn::mean(fn::softmax_cross_entropy(logit, y));
+    for(auto _ : state){
+        std::copy(x_val.begin(), x_val.end(), x.begin<float>());
+        std::copy(y_val.begin(), y_val.end(), y.begin<float>());
+        loss.eval();
+        loss.backprop();
+        sgd->apply({w, b});
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_step_simple)->Unit(benchmark::kMillisecond);
+
+} // end anonymous namespace
@@ -0,0 +1,186 @@
+#include "benchmark_utils.h"
+#include <benchmark/benchmark.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace mlfe;
+namespace fn = functional;
+
+namespace{
+
+// an op on random inputs, the cpu OpAlgo of the op runs on eval() and the
+// gradient algos on backprop().
+struct op_graph{
+    std::vector<Tensor> inputs;
+    Tensor y;
+};
+
+using op_builder = std::function<op_graph()>;
+
+Tensor variable(std::vector<int> shape,
+                const float lo = -1,
+                const float hi = 1,
+                const unsigned int seed = 0
+               ){
+    auto x = fn::create_variable(shape);
+    mlfe_benchmark::fill(x, lo, hi, seed);
+    return x;
+}
+
+// the flops and bytes of the cost model per second.
+void set_cost_counters(benchmark::State &state, std::vector<Tensor> roots){
+    auto cost = fn::graph_cost(roots);
+    state.counters["flops"] = benchmark::Counter(cost.flops,
+        benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["bytes"] = benchmark::Counter(cost.bytes(),
+        benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void forward(benchmark::State &state, op_builder build){
+    auto g = build();
+    g.y.eval();
+    for(auto _ : state){
+        // an input is modified, so eval() runs the op again.
+        g.inputs[0].mutable_data<float>();
+        g.y.eval();
+    }
+    set_cost_counters(state, {g.y});
+}
+
+void forward_backward(benchmark::State &state, op_builder build){
+    auto g = build();
+    g.y.eval();
+    g.y.backprop();
+    for(auto _ : state){
+        g.inputs[0].mutable_data<float>();
+        g.y.eval();
+        // and dy, so the gradients reading only dy run again too.
+        g.y.grad().mutable_data<float>();
+        g.y.backprop();
+    }
+    auto roots = g.inputs;
+    for(auto &x : roots){
+        x = x.grad();
+    }
+    roots.push_back(g.y);
+    set_cost_counters(state, roots);
+}
+
+op_graph unary(std::vector<int> shape, std::function<Tensor(Tensor)> op){
+    auto x = variable(shape);
+    return {{x}, op(x)};
+}
+
+op_graph binary(std::vector<int> shape1,
+                std::vector<int> shape2,
+                std::function<Tensor(Tensor, Tensor)> op
+               ){
+    auto x1 = variable(shape1);
+    // away from zero for the div.
+    auto x2 = variable(shape2, 0.5, 2, 1);
+    return {{x1, x2}, op(x1, x2)};
+}
+
+// the shapes of the layers of the lenet and auto encoder examples, batch 64.
+const std::vector<int> image = {64, 16, 24, 24};
+
+const std::vector<std::pair<std::string, op_builder>> ops = {
+    {"Convolution/64x1x28x28/16x1x5x5", [](){
+        auto x = variable({64, 1, 28, 28});
+        auto w = variable({16, 1, 5, 5}, -0.2, 0.2, 1);
+        return op_graph{{x, w}, fn::conv2d(x, w, {1, 1}, {0, 0})};
+    }},
+    {"Convolution/64x16x12x12/32x16x5x5", [](){
+        auto x = variable({64, 16, 12, 12});
+        auto w = variable({32, 16, 5, 5}, -0.05, 0.05, 1);
+        return op_graph{{x, w}, fn::conv2d(x, w, {1, 1}, {0, 0})};
+    }},
+    {"Convolution/32x64x32x32/64x64x3x3", [](){
+        auto x = variable({32, 64, 32, 32});
+        auto w = variable({64, 64, 3, 3}, -0.05, 0.05, 1);
+        return op_graph{{x, w}, fn::conv2d(x, w, {1, 1}, {1, 1})};
+    }},
+    {"MaxPool/64x16x24x24", [](){
+        return unary(image, [](Tensor x){
+            return fn::pool_max(x, {2, 2}, {2, 2}, {0, 0});
+        });
+    }},
+    {"AvgPool/64x16x24x24", [](){
+        return unary(image, [](Tensor x){
+            return fn::pool_avg(x, {2, 2}, {2, 2}, {0, 0});
+        });
+    }},
+    {"GlobalAvgPool/64x16x24x24", [](){
+        return unary(image, fn::global_pool_avg);
+    }},
+    {"ReLU/64x16x24x24", [](){ return unary(image, fn::relu); }},
+    {"Sigmoid/64x16x24x24", [](){ return unary(image, fn::sigmoid); }},
+    {"Negative/64x16x24x24", [](){ return unary(image, fn::negative); }},
+    {"Dropout/64x16x24x24", [](){
+        auto prob = fn::create_variable({1});
+        prob.mutable_data<float>()[0] = 0.5;
+        return unary(image, [prob](Tensor x){
+            return fn::dropout(x, prob);
+        });
+    }},
+    {"MatMul/64x784/784x500", [](){
+        return binary({64, 784}, {784, 500}, [](Tensor a, Tensor b){
+            return fn::matmul(a, b);
+        });
+    }},
+    {"ElementwiseAdd/64x16x24x24", [](){
+        return binary(image, image, fn::add);
+    }},
+    {"ElementwiseAdd/64x16x24x24/16x1x1", [](){
+        return binary(image, {16, 1, 1}, fn::add);
+    }},
+    {"ElementwiseAdd/64x500/500", [](){
+        return binary({64, 500}, {500}, fn::add);
+    }},
+    {"ElementwiseSub/64x16x24x24", [](){
+        return binary(image, image, fn::sub);
+    }},
+    {"ElementwiseMul/64x16x24x24", [](){
+        return binary(image, image, fn::mul);
+    }},
+    {"ElementwiseDiv/64x16x24x24", [](){
+        return binary(image, image, fn::div);
+    }},
+    {"SquaredDifference/64x16x24x24", [](){
+        return binary(image, image, fn::squared_difference);
+    }},
+    {"SoftmaxCrossEntropy/64x10", [](){
+        return binary({64, 10}, {64, 10}, fn::softmax_cross_entropy);
+    }},
+    {"SigmoidCrossEntropy/64x784", [](){
+        return binary({64, 784}, {64, 784}, fn::sigmoid_cross_entropy);
+    }},
+    {"ReduceSum/64x16x24x24/0,2,3", [](){
+        return unary(image, [](Tensor x){
+            return fn::reduce_sum(x, {0, 2, 3});
+        });
+    }},
+    {"ReduceMean/64x16x24x24", [](){
+        return unary(image, [](Tensor x){ return fn::mean(x); });
+    }},
+    {"ReduceMax/64x16x24x24/1", [](){
+        return unary(image, [](Tensor x){ return fn::reduce_max(x, {1}); });
+    }},
+};
+
+// BM_op/<op>/<shapes>/forward and .../forward_backward.
+bool registered = [](){
+    for(auto &op : ops){
+        benchmark::RegisterBenchmark(("BM_op/" + op.first + "/forward").c_str(),
+                                     forward, op.second);
+        benchmark::RegisterBenchmark(
+            ("BM_op/" + op.first + "/forward_backward").c_str(),
+            forward_backward, op.second);
+    }
+    return true;
+}();
+
+} // end anonymous namespace
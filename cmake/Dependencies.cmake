@@ -29,6 +29,11 @@ if(BUILD_TEST)
   set(BUILD_SHARED_LIBS ${TEMP_BUILD_SHARED_LIBS})
 endif()
 
+if(BUILD_BENCHMARK)
+  find_package(benchmark REQUIRED)
+  message(STATUS "Found benchmark : " ${benchmark_VERSION})
+endif()
+
 find_package(flatbuffers QUIET)
 
 if(FLATBUFFERS_FOUND)
@@ -73,26 +78,19 @@ endif()
 include(${PROJECT_SOURCE_DIR}/cmake/mkldnn.cmake)
 if(USE_INTEL_MKLDNN)
     find_mkldnn()
-    if(FOUND_MKLDNN)
+    if(MKLDNN_FOUND)
         list(APPEND mlfe_include_dirs ${MKLDNN_INCLUDE_DIRS})
         list(APPEND mlfe_library_dependencies ${MKLDNN_LIBS})
     else()
         set(INTEL_MKLDNN_ROOT ${PROJECT_SOURCE_DIR}/third_party/mkldnn)
-        message(STATUS "Not found intel-mkldnn, use instead third_party/mkldnn")
-        message(STATUS "Downloading intel mkl...")
-        if(WIN32)
-            execute_process(
-                COMMAND cmd ${INTEL_MKLDNN_ROOT}/scripts/prepare_mkl.bat
-                )
-        else()
-            execute_process(
-                COMMAND bash ${INTEL_MKLDNN_ROOT}/scripts/prepare_mkl.sh
-                )
-        endif()
-        set(WITH_EXAMPLE OFF CACHE BOOL "INTEL MKLDNN EXAMPLE BUILD" FORCE)
-        set(WITH_TEST OFF CACHE BOOL "INTEL MKLDNN TEST BUILD" FORCE)
+        message(STATUS "Not found oneDNN, use instead third_party/mkldnn")
+        set(DNNL_BUILD_EXAMPLES OFF CACHE BOOL "ONEDNN EXAMPLE BUILD" FORCE)
+        set(DNNL_BUILD_TESTS OFF CACHE BOOL "ONEDNN TEST BUILD" FORCE)
         add_subdirectory(${INTEL_MKLDNN_ROOT})
+        # dnnl_config.h and dnnl_version.h are generated.
         list(APPEND mlfe_include_dirs ${INTEL_MKLDNN_ROOT}/include)
-        list(APPEND mlfe_library_dependencies mkldnn)
+        list(APPEND mlfe_include_dirs ${CMAKE_BINARY_DIR}/third_party/mkldnn/include)
+        list(APPEND mlfe_library_dependencies dnnl)
     endif()
+    add_definitions(-DOPTION_USE_MKLDNN)
 endif()
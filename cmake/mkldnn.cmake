@@ -1,14 +1,15 @@
 function(find_mkldnn )
     set(MKLDNN_FOUND FALSE)
-    find_path(MKLDNN_INCLUDE_DIR mkldnn.h)
-    find_library(MKLDNN_LIB mkldnn)
+    find_path(MKLDNN_INCLUDE_DIR dnnl.hpp)
+    find_library(MKLDNN_LIB dnnl)
 
-    if(NOT MKLDNN_INCLUDE_DIR-NOTFOUND AND NOT MKLDNN_LIBS-NOTFOUND)
+    if(MKLDNN_INCLUDE_DIR AND MKLDNN_LIB)
         set(MKLDNN_FOUND TRUE)
     endif()
 
     if(MKLDNN_FOUND)
         set(MKLDNN_INCLUDE_DIRS ${MKLDNN_INCLUDE_DIR} PARENT_SCOPE)
-        set(MKLDNN_LIBS ${MKLDNN_LIBS} PARENT_SCOPE)
+        set(MKLDNN_LIBS ${MKLDNN_LIB} PARENT_SCOPE)
     endif()
+    set(MKLDNN_FOUND ${MKLDNN_FOUND} PARENT_SCOPE)
 endfunction()
@@ -2,9 +2,8 @@
 #include <mlfe/core.h>
 #include <mlfe/operators.h>
 #include <mlfe/optimizers.h>
-#include <mlfe/utils/db/simpledb_reader.h>
-#include <opencv2/opencv.hpp>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 
 namespace train_example{
 using namespace mlfe;
@@ -101,9 +100,11 @@ Tensor AutoEncoder::fc_relu(const std::string name,
 }
 
 void AutoEncoder::update(){
+    std::vector<Tensor> params;
     for(auto &it : vars){
-        sgd->apply(it.second, it.second.grad());
+        params.push_back(it.second);
     }
+    sgd->apply(params);
 }
 
 Lenet::Lenet(const int batch, const double lr, const double mm) 
@@ -212,9 +213,11 @@ mlfe::Tensor Lenet::maxpool(const std::string name,
 }
 
 void Lenet::update(){
+    std::vector<Tensor> params;
     for(auto &it : vars){
-        sgd->apply(it.second, it.second.grad());
+        params.push_back(it.second);
     }
+    sgd->apply(params);
 }
 
 } // end namespace train_example
\ No newline at end of file
@@ -39,9 +39,7 @@ void train_simple_mnist(const std::string train_path,
     std::mt19937 rng;
     std::uniform_real_distribution<float> dist(0.1);
 
-    std::vector<float> x_val, y_val;
-    x_val.resize(x.size());
-    y_val.resize(batch);
+    Tensor label = fn::create_variable({batch});
     auto train_db = mlfe::SimpleDBReader(train_path);
     auto test_db = mlfe::SimpleDBReader(test_path);
 
@@ -59,18 +57,15 @@ void train_simple_mnist(const std::string train_path,
     for(int n = 0; n < iter; ++n) {
         std::vector<float> onehot(batch * cls);
         std::fill(onehot.begin(), onehot.end(), 0);
-        train_db.Read<float>(batch, {x_val, y_val});
-        for(auto &val : x_val){ val = val / 255.f; }
+        train_db.Read(batch, {x, label}, {1.f / 255.f});
         for(int n = 0; n < batch; ++n){
-            onehot.data()[(int)y_val.data()[n] + n * cls] = 1.f;
+            onehot.data()[(int)label.data<float>()[n] + n * cls] = 1.f;
         }
-        std::copy(x_val.begin(), x_val.end(), x.begin<float>());
         std::copy(onehot.begin(), onehot.end(), y.begin<float>());
         
         loss.eval();
         loss.backprop();
-        sgd->apply(w, w.grad());
-        sgd->apply(b, b.grad());
+        sgd->apply({w, b});
         
         if(((n + 1) % 100) == 0) {
             int test_iter = 10000. / float(64) + 0.5;
@@ -78,14 +73,10 @@ void train_simple_mnist(const std::string train_path,
             for(int m = 0; m < test_iter; ++m){
                 std::vector<float> out_val;
                 std::fill(onehot.begin(), onehot.end(), 0.f);
-                test_db.Read<float>(batch, { x_val, y_val });
-                for(auto &val : x_val){
-                    val /= 256.f;
-                }
+                test_db.Read(batch, {x, label}, {1.f / 255.f});
                 for(int k = 0; k < batch; ++k){
-                    onehot.data()[(int)y_val.data()[k] + k * cls] = 1.f;
+                    onehot.data()[(int)label.data<float>()[k] + k * cls] = 1.f;
                 }
-                std::copy(x_val.begin(), x_val.end(), x.begin<float>());
                 std::copy(onehot.begin(), onehot.end(), y.begin<float>());
                 out.eval();
                 out_val.assign(out.data<float>(), out.data<float>() + out.size());
@@ -94,7 +85,7 @@ void train_simple_mnist(const std::string train_path,
                     auto e = out_val.begin() + (k + 1) * cls;
                     auto pos = std::max_element(s, e);
                     int infer = std::distance(out_val.begin() + k * cls, pos);
-                    if(y_val.data()[k] == infer){
+                    if(label.data<float>()[k] == infer){
                         corrent += 1;
                     }
                 }
@@ -120,13 +111,22 @@ void train_lenet(const std::string train_path,
     y.resize(batch);
     onehot.resize(batch * 10);
 
-    auto train_db = mlfe::SimpleDBReader(train_path);
+    mlfe::SimpleDBReader::Option train_option;
+    train_option.num_workers = 2;
+    train_option.prefetch = 4;
+    train_option.shuffle = true;
+    auto train_db = mlfe::SimpleDBReader(train_path, train_option);
     auto test_db = mlfe::SimpleDBReader(test_path);
+    // shifts of up to 2 pixels on the train set, and the mnist mean and
+    // stddev on both sets.
+    const mlfe::ImageShape shape = {1, 28, 28, false};
+    train_db.SetAugmentation(0, shape,
+        {std::make_shared<mlfe::RandomCrop>(28, 28, 2)}, {0.1307f}, {0.3081f});
+    test_db.SetAugmentation(0, shape, {}, {0.1307f}, {0.3081f});
     
     for(int n = 0; n < iter; ++n) {
         std::fill(onehot.begin(), onehot.end(), 0);
-        train_db.Read<float>(batch, {x, y});
-        for(auto &val : x){ val = val / 255.f; }
+        train_db.Read<float>(batch, {x, y}, {1.f / 255.f});
         for(int k = 0; k < batch; ++k){
             onehot.data()[(int)y.data()[k] + k * 10] = 1.f;
         }
@@ -140,8 +140,7 @@ void train_lenet(const std::string train_path,
             test_db.MoveToFirst();
             for(int m = 0; m < test_iter; ++m){
                 std::fill(onehot.begin(), onehot.end(), 0);
-                test_db.Read<float>(batch, {x, y});
-                for(auto &val : x){ val = val / 255.f; }
+                test_db.Read<float>(batch, {x, y}, {1.f / 255.f});
                 for(int k = 0; k < batch; ++k){
                     onehot.data()[(int)y.data()[k] + k * 10] = 1.f;
                 }
@@ -186,13 +185,11 @@ void train_ae(const std::string train_path,
     input_test.resize(batch * 28 * 28);
     auto train_db = mlfe::SimpleDBReader(train_path);
     auto test_db = mlfe::SimpleDBReader(test_path);
-    test_db.Read<float>(batch, { input_test, label });
-    for(auto &val : input_test){ val = val / 255.f; }
+    test_db.Read<float>(batch, { input_test, label }, {1.f / 255.f});
     test_db.MoveToFirst();
 
     for(int n = 0; n < iter; ++n) {
-        train_db.Read<float>(batch, { input, label });
-        for(auto &val : input){ val = val / 255.f; }
+        train_db.Read<float>(batch, { input, label }, {1.f / 255.f});
         ae.forward(input);
         ae.backward();
         ae.update();
@@ -212,8 +209,7 @@ void train_ae(const std::string train_path,
             int test_iter = 10000. / batch + 0.5;
             double loss_mean = 0.;
             for(int n = 0; n < test_iter; ++n){
-                test_db.Read<float>(batch, { input, label });
-                for(auto &val : input){ val = val / 255.f; }
+                test_db.Read<float>(batch, { input, label }, {1.f / 255.f});
                 auto loss_val = ae.get_loss(input);
                 loss_mean += loss_val[0];
             }
@@ -2,5 +2,9 @@
 #define __CORE_H__
 #include "core/tensor.h"
 #include "core/device.h"
+#include "core/profiler.h"
+#include "core/memory_tracker.h"
+#include "core/op_algo.h"
+#include "core/autotuner.h"
 
 #endif // end #ifndef __CORE_H__
@@ -0,0 +1,351 @@
+#include "autotuner.h"
+#include "op_algo.h"
+#include "device.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace mlfe{
+namespace autotuner{
+
+namespace{
+
+using clock_type = std::chrono::steady_clock;
+
+// the fastest of these runs is the time of a candidate, after one run to
+// warm up the caches and the workspace.
+constexpr int timed_runs = 3;
+
+struct tuner{
+    tuner(){
+        const char *env = std::getenv("MLFE_AUTOTUNE_CACHE");
+        file = env ? env : "";
+    }
+
+    // select() may be reentered through an algo that makes a variable.
+    std::recursive_mutex mtx;
+    bool enabled = true;
+    bool loaded = false;
+    int num_tuned = 0;
+    std::string file;
+    std::map<std::string, key_fn> ops;
+    std::map<std::string, entry> winners;
+};
+
+tuner &get_tuner(){
+    static tuner t;
+    return t;
+}
+
+double to_us(clock_type::duration d){
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+std::string shape_string(const std::vector<int> &shape){
+    std::stringstream ss;
+    for(int n = 0; n < shape.size(); ++n){
+        ss << (n == 0 ? "" : "x") << shape[n];
+    }
+    return ss.str();
+}
+
+std::string make_key(OpAlgoContext *oac, const key_fn &key){
+    auto dev = get_enabled_device();
+    std::stringstream ss;
+    ss << oac->get_op_name();
+    for(auto &x : oac->get_output(0).get_children()){
+        ss << " " << shape_string(x.shape());
+    }
+    ss << " " << key(oac);
+    ss << " " << dev->get_device_name();
+    ss << "(" << dev->get_accelerator_name() << ")";
+    // the isa only tells the algos of the cpu apart.
+    if(dev->get_device_name() == "CPU"){
+        ss << " " << isa();
+    }
+    return ss.str();
+}
+
+// an exclusive lock on file_name + ".lock" between the processes sharing
+// a cache file, while it lives.
+class file_lock{
+public:
+    explicit file_lock(std::string file_name){
+        std::string lock_name = file_name + ".lock";
+#if defined(_WIN32)
+        _handle = CreateFileA(lock_name.c_str(),
+            GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(_handle != INVALID_HANDLE_VALUE){
+            OVERLAPPED ov = {};
+            LockFileEx(_handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov);
+        }
+#else
+        _fd = open(lock_name.c_str(), O_RDWR | O_CREAT, 0644);
+        if(_fd >= 0){
+            flock(_fd, LOCK_EX);
+        }
+#endif
+    }
+
+    ~file_lock(){
+#if defined(_WIN32)
+        if(_handle != INVALID_HANDLE_VALUE){
+            OVERLAPPED ov = {};
+            UnlockFileEx(_handle, 0, 1, 0, &ov);
+            CloseHandle(_handle);
+        }
+#else
+        if(_fd >= 0){
+            flock(_fd, LOCK_UN);
+            close(_fd);
+        }
+#endif
+    }
+
+private:
+#if defined(_WIN32)
+    HANDLE _handle;
+#else
+    int _fd;
+#endif
+};
+
+int process_id(){
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
+
+// a line is the key, the algo and the time, separated by tabs. the
+// entries of winners are kept.
+void read_file(std::string file_name, std::map<std::string, entry> &winners){
+    std::ifstream in(file_name);
+    std::string line;
+    while(std::getline(in, line)){
+        auto first = line.find('\t');
+        auto second = line.find('\t', first + 1);
+        if(line.empty() || line[0] == '#' ||
+           first == std::string::npos || second == std::string::npos){
+            continue;
+        }
+        entry e;
+        e.key = line.substr(0, first);
+        e.algo = line.substr(first + 1, second - first - 1);
+        e.time = std::atof(line.substr(second + 1).c_str());
+        winners.insert({e.key, e});
+    }
+}
+
+void load(tuner &t){
+    if(t.loaded){
+        return;
+    }
+    t.loaded = true;
+    if(t.file.empty()){
+        return;
+    }
+    file_lock lock(t.file);
+    read_file(t.file, t.winners);
+}
+
+// merges the winners of the other processes, which may have tuned since
+// load(), and replaces the file through a temporary file of this process,
+// so a reader never sees half of it.
+void save(tuner &t){
+    if(t.file.empty()){
+        return;
+    }
+    file_lock lock(t.file);
+    read_file(t.file, t.winners);
+    std::string tmp = t.file + "." + std::to_string(process_id()) + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if(!out.is_open()){
+            return;
+        }
+        out << "# mlfe autotuner cache" << std::endl;
+        for(auto &w : t.winners){
+            out << w.second.key << "\t" << w.second.algo << "\t";
+            out << w.second.time << std::endl;
+        }
+    }
+    if(std::rename(tmp.c_str(), t.file.c_str()) != 0){
+        std::remove(t.file.c_str());
+        std::rename(tmp.c_str(), t.file.c_str());
+    }
+}
+
+// the algos of an accelerator only queue their kernels, so the device is
+// synchronized before the clock is read.
+double time_algo(std::string name, OpAlgoContext *oac){
+    auto dev = get_enabled_device();
+    auto algo = OpAlgoRegistry::Get()->GetOpAlgo(name, oac);
+    algo->Compute();
+    dev->synchronize();
+    double best = 0;
+    for(int n = 0; n < timed_runs; ++n){
+        auto start = clock_type::now();
+        algo->Compute();
+        dev->synchronize();
+        double us = to_us(clock_type::now() - start);
+        if(n == 0 || us < best){
+            best = us;
+        }
+    }
+    return best;
+}
+
+bool contains(const std::vector<std::string> &names, const std::string &name){
+    for(auto &n : names){
+        if(n == name){
+            return true;
+        }
+    }
+    return false;
+}
+
+} // end anonymous namespace
+
+void tune_op(std::string op_name, key_fn key){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    t.ops[op_name] = key;
+}
+
+registerer::registerer(std::string op_name, key_fn key){
+    tune_op(op_name, key);
+}
+
+bool is_tuned(std::string op_name){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    return t.ops.count(op_name) != 0;
+}
+
+void set_enabled(bool enable){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    t.enabled = enable;
+}
+
+bool enabled(){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    return t.enabled;
+}
+
+std::string select(OpAlgoContext *oac, std::vector<std::string> candidates){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    auto op = t.ops.find(oac->get_op_name());
+    if(!t.enabled || op == t.ops.end() || candidates.size() < 2){
+        return "";
+    }
+    load(t);
+    std::string key = make_key(oac, op->second);
+    auto cached = t.winners.find(key);
+    // a winner of an older build may not be registered anymore.
+    if(cached != t.winners.end() && contains(candidates, cached->second.algo)){
+        return cached->second.algo;
+    }
+    entry best = {key, "", 0};
+    for(auto &name : candidates){
+        double us;
+        // a candidate may reject the node, like a oneDNN primitive which
+        // throws a dnnl::error.
+        try{
+            us = time_algo(name, oac);
+        }
+        catch(...){
+            continue;
+        }
+        if(best.algo.empty() || us < best.time){
+            best.algo = name;
+            best.time = us;
+        }
+    }
+    if(best.algo.empty()){
+        return "";
+    }
+    t.winners[key] = best;
+    t.num_tuned += 1;
+    save(t);
+    return best.algo;
+}
+
+void set_cache_file(std::string file_name){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    t.file = file_name;
+    t.winners.clear();
+    t.loaded = false;
+}
+
+std::string cache_file(){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    return t.file;
+}
+
+void clear(){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    t.winners.clear();
+    t.loaded = false;
+}
+
+std::vector<entry> entries(){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    std::vector<entry> es;
+    for(auto &w : t.winners){
+        es.push_back(w.second);
+    }
+    return es;
+}
+
+int num_tuned(){
+    auto &t = get_tuner();
+    std::lock_guard<std::recursive_mutex> lock(t.mtx);
+    return t.num_tuned;
+}
+
+std::string isa(){
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")){
+        return "avx512f";
+    }
+    if(__builtin_cpu_supports("avx2")){
+        return "avx2";
+    }
+    if(__builtin_cpu_supports("avx")){
+        return "avx";
+    }
+    if(__builtin_cpu_supports("sse4.2")){
+        return "sse4.2";
+    }
+#elif defined(__aarch64__)
+    return "neon";
+#endif
+    return "generic";
+}
+
+} // end namespace autotuner
+} // end namespace mlfe
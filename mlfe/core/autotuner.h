@@ -0,0 +1,75 @@
+#ifndef __AUTOTUNER_HPP__
+#define __AUTOTUNER_HPP__
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mlfe{
+class OpAlgoContext;
+
+// picks the algo of a tuned op by timing. the first time a node of the op
+// is built for a key, each candidate, the algo of the device and its
+// variants, runs on the tensors of the node and the fastest is kept. a run
+// is timed until the device has finished it. the winners are cached in
+// memory and in a file, so later nodes, runs and processes with the same
+// key skip the timing.
+namespace autotuner{
+
+// the attributes of a node which change the work of its algo, like the
+// strides of a convolution. the key of a node is its op name, the shapes
+// of its inputs, this, the device and, on the cpu, its isa.
+using key_fn = std::function<std::string(OpAlgoContext *)>;
+
+struct entry{
+    std::string key;
+    // the schema name of the winner.
+    std::string algo;
+    // microseconds, the fastest run of the winner.
+    double time;
+};
+
+// tunes the nodes of op_name from now on. the candidates run on the
+// tensors of the node, so the algos of the op must only write its outputs.
+void tune_op(std::string op_name, key_fn key);
+
+// tune_op() at static initialization, next to the algos of the op.
+struct registerer{
+    registerer(std::string op_name, key_fn key);
+};
+
+bool is_tuned(std::string op_name);
+
+// tuning is enabled by default, when it is disabled select() returns
+// nothing.
+void set_enabled(bool enable);
+
+bool enabled();
+
+// the schema name of the fastest of candidates for oac, which has its
+// outputs. empty if the op is not tuned, if there are less than two
+// candidates, or if none of them could be made. a candidate which throws
+// is skipped.
+std::string select(OpAlgoContext *oac, std::vector<std::string> candidates);
+
+// the file of the winners, read by the first select() and merged with the
+// winners of this process when a key is tuned. MLFE_AUTOTUNE_CACHE if it is
+// set, otherwise empty, and with an empty name the winners are only kept
+// in memory.
+void set_cache_file(std::string file_name);
+
+std::string cache_file();
+
+// forgets the winners in memory, the next select() reads the file again.
+void clear();
+
+std::vector<entry> entries();
+
+// the number of keys timed by this process.
+int num_tuned();
+
+// the widest simd extension of the cpu, like "avx2", or "generic".
+std::string isa();
+
+} // end namespace autotuner
+} // end namespace mlfe
+#endif // end ifndef __AUTOTUNER_HPP__
@@ -1,4 +1,5 @@
 #include "device.h"
+#include "memory_tracker.h"
 #include <functional>
 #include <cstring>
 #if defined(OPTION_USE_CUDNN) || defined(OPTION_USE_CUDA)
@@ -14,6 +15,8 @@ struct enabled_device final : device{
 
     std::string get_accelerator_name() const override;
 
+    void synchronize() const override;
+
     std::string _dev_name;
     std::string _accel_name;
 };
@@ -42,15 +45,37 @@ std::string enabled_device::get_accelerator_name() const{
     return _accel_name;
 }
 
+void enabled_device::synchronize() const{
+#if defined(OPTION_USE_CUDNN) || defined(OPTION_USE_CUDA)
+    cudaDeviceSynchronize();
+#endif
+}
+
 device_ptr get_enabled_device(){
     static device_ptr dev = std::make_shared<enabled_device>();
     return dev;
 }
 
+void memory::defer_write(std::function<void(void *)> write){
+    _deferred_write = write;
+}
+
+bool memory::has_deferred_write() const{
+    return _deferred_write != nullptr;
+}
+
+void memory::run_deferred_write(){
+    auto write = std::move(_deferred_write);
+    _deferred_write = nullptr;
+    write(_mutable_host_data());
+}
+
 memory::~memory(){}
 
 class device_memory final : public memory{
 public:
+    device_memory();
+
     void allocate(type::uint32::T size) override;
 
     type::uint32::T size() const override;
@@ -74,6 +99,68 @@ private:
     bool is_mutated_device;
 };
 
+device_memory::device_memory()
+    : _h_data(nullptr),
+      _d_data(nullptr),
+      _byte_size(0),
+      is_mutated_host(false),
+      is_mutated_device(false){}
+
+class memory_view final : public memory{
+public:
+    memory_view(memory_ptr base,
+                type::uint32::T byte_offset,
+                type::uint32::T byte_size
+               );
+
+    void allocate(type::uint32::T size) override;
+
+    type::uint32::T size() const override;
+
+    void defer_write(std::function<void(void *)> write) override;
+
+protected:
+    const void *_device_data() override;
+
+    void *_mutable_device_data() override;
+
+    const void *_host_data() override;
+
+    void *_mutable_host_data() override;
+
+private:
+    memory_ptr _base;
+    type::uint32::T _byte_offset;
+    type::uint32::T _byte_size;
+};
+
+class lazy_memory final : public memory{
+public:
+    lazy_memory(type::uint32::T byte_size,
+                std::function<void(void *)> init
+               );
+
+    void allocate(type::uint32::T size) override;
+
+    type::uint32::T size() const override;
+
+protected:
+    const void *_device_data() override;
+
+    void *_mutable_device_data() override;
+
+    const void *_host_data() override;
+
+    void *_mutable_host_data() override;
+
+private:
+    memory_ptr materialize();
+
+    memory_ptr _mem;
+    type::uint32::T _byte_size;
+    std::function<void(void *)> _init;
+};
+
 // for nvidia cuda device memory synchronization.
 #if defined(OPTION_USE_CUDNN) || defined(OPTION_USE_CUDA)
 
@@ -217,12 +304,109 @@ void *device_memory::_mutable_host_data(){
     return _h_data;
 }
 
+memory_view::memory_view(memory_ptr base,
+                         type::uint32::T byte_offset,
+                         type::uint32::T byte_size
+                        )
+    : _base(base), _byte_offset(byte_offset), _byte_size(byte_size){}
+
+void memory_view::allocate(type::uint32::T){
+    throw std::string("memory_view::allocate() - "
+        "a view can not be allocated.");
+}
+
+type::uint32::T memory_view::size() const{
+    return _byte_size;
+}
+
+void memory_view::defer_write(std::function<void(void *)> write){
+    write(_mutable_host_data());
+}
+
+const void *memory_view::_device_data(){
+    return _base->device_data<type::uint8::T>() + _byte_offset;
+}
+
+void *memory_view::_mutable_device_data(){
+    return _base->mutable_device_data<type::uint8::T>() + _byte_offset;
+}
+
+const void *memory_view::_host_data(){
+    return _base->host_data<type::uint8::T>() + _byte_offset;
+}
+
+void *memory_view::_mutable_host_data(){
+    return _base->mutable_host_data<type::uint8::T>() + _byte_offset;
+}
+
+lazy_memory::lazy_memory(type::uint32::T byte_size,
+                         std::function<void(void *)> init
+                        )
+    : _byte_size(byte_size), _init(init){}
+
+void lazy_memory::allocate(type::uint32::T){
+    throw std::string("lazy_memory::allocate() - "
+        "a lazy memory allocates itself.");
+}
+
+type::uint32::T lazy_memory::size() const{
+    return _byte_size;
+}
+
+memory_ptr lazy_memory::materialize(){
+    if(_mem == nullptr){
+        memory_tracker::scoped_tag tag("Constant");
+        _mem = create_memory(_byte_size);
+        // filled on the host, the device copy follows on its first access.
+        _init(_mem->mutable_host_data<void>());
+        _init = nullptr;
+    }
+    return _mem;
+}
+
+const void *lazy_memory::_device_data(){
+    return materialize()->device_data<void>();
+}
+
+void *lazy_memory::_mutable_device_data(){
+    return materialize()->mutable_device_data<void>();
+}
+
+const void *lazy_memory::_host_data(){
+    return materialize()->host_data<void>();
+}
+
+void *lazy_memory::_mutable_host_data(){
+    return materialize()->mutable_host_data<void>();
+}
+
 memory_ptr create_memory(type::uint32::T byte_size){
-    memory_ptr mem = std::make_shared<device_memory>();
+    memory_ptr mem(new device_memory, [](memory *m){
+        memory_tracker::on_free(m);
+        delete m;
+    });
     mem->allocate(byte_size);
+    memory_tracker::on_allocate(mem.get(), byte_size);
     return mem;
 }
 
+memory_ptr create_memory_view(memory_ptr base,
+                              type::uint32::T byte_offset,
+                              type::uint32::T byte_size
+                             ){
+    if(byte_offset + byte_size > base->size()){
+        throw std::string("create_memory_view() - "
+            "the view is out of the base memory.");
+    }
+    return std::make_shared<memory_view>(base, byte_offset, byte_size);
+}
+
+memory_ptr create_lazy_memory(type::uint32::T byte_size,
+                              std::function<void(void *)> init
+                             ){
+    return std::make_shared<lazy_memory>(byte_size, init);
+}
+
 void copy(memory_ptr from, memory_ptr to){
     if(from->size() != to->size()){
         throw std::string("copy() - size not matches");
@@ -1,6 +1,7 @@
 #ifndef __DEVICE_HPP__
 #define __DEVICE_HPP__
 #include "../utils/types.h"
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -10,6 +11,10 @@ struct device{
     virtual std::string get_device_name() const = 0;
 
     virtual std::string get_accelerator_name() const = 0;
+
+    // waits for the work queued on the device, like the kernels an algo
+    // launched, to finish. nothing to wait for on the cpu.
+    virtual void synchronize() const = 0;
 };
 
 using device_ptr = std::shared_ptr<device>;
@@ -35,6 +40,14 @@ public:
 
     virtual void allocate(type::uint32::T size) = 0;
 
+    // defers writing the data until it is next accessed through this
+    // memory, once. write gets the host data. an accelerator keeping a
+    // result in a layout of its own converts it only if it is read.
+    // a view writes at once, its base may be read without it.
+    virtual void defer_write(std::function<void(void *)> write);
+
+    bool has_deferred_write() const;
+
     virtual ~memory();
 
 protected:
@@ -47,25 +60,40 @@ protected:
     virtual void *_mutable_host_data() = 0;
 
 private:
+    void run_deferred_write();
+
+    std::function<void(void *)> _deferred_write;
 };
 
 template <typename T>
 const T *memory::device_data(){
+    if(_deferred_write){
+        run_deferred_write();
+    }
     return static_cast<const T *>(_device_data());
 }
 
 template <typename T>
 T *memory::mutable_device_data(){
+    if(_deferred_write){
+        run_deferred_write();
+    }
     return static_cast<T *>(_mutable_device_data());
 }
 
 template <typename T>
 const T *memory::host_data(){
+    if(_deferred_write){
+        run_deferred_write();
+    }
     return static_cast<const T *>(_host_data());
 }
 
 template <typename T>
 T *memory::mutable_host_data(){
+    if(_deferred_write){
+        run_deferred_write();
+    }
     return static_cast<T *>(_mutable_host_data());
 }
 
@@ -73,6 +101,20 @@ using memory_ptr = std::shared_ptr<memory>;
 
 memory_ptr create_memory(type::uint32::T byte_size);
 
+// byte_size bytes of base from byte_offset on, without a copy.
+// the view keeps base alive, and base keeps the host and device copies
+// in sync for the whole range.
+memory_ptr create_memory_view(memory_ptr base,
+                              type::uint32::T byte_offset,
+                              type::uint32::T byte_size
+                             );
+
+// byte_size bytes that are allocated on the first access, when init
+// fills the host data. a constant that is never read costs no memory.
+memory_ptr create_lazy_memory(type::uint32::T byte_size,
+                              std::function<void(void *)> init
+                             );
+
 void copy(memory_ptr from, memory_ptr to);
 
 } // end namespace mlfe
@@ -0,0 +1,151 @@
+#include "memory_tracker.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace mlfe{
+namespace memory_tracker{
+
+namespace{
+
+struct allocation{
+    std::string tag;
+    std::size_t byte_size;
+};
+
+struct tracker{
+    std::mutex mtx;
+    std::unordered_map<const memory *, allocation> live;
+    std::map<std::string, tag_usage> tags;
+    std::size_t current = 0;
+    std::size_t peak = 0;
+};
+
+tracker &get_tracker(){
+    static tracker tr;
+    return tr;
+}
+
+thread_local std::string current_tag = "Variable";
+
+// the caller holds the lock.
+void add_bytes(tracker &tr, const std::string &tag, std::size_t byte_size){
+    auto &u = tr.tags[tag];
+    u.tag = tag;
+    u.current += byte_size;
+    u.peak = std::max(u.peak, u.current);
+    tr.current += byte_size;
+    tr.peak = std::max(tr.peak, tr.current);
+}
+
+void sub_bytes(tracker &tr, const std::string &tag, std::size_t byte_size){
+    tr.tags[tag].current -= byte_size;
+    tr.current -= byte_size;
+}
+
+} // end anonymous namespace
+
+std::size_t current_bytes(){
+    auto &tr = get_tracker();
+    std::lock_guard<std::mutex> lock(tr.mtx);
+    return tr.current;
+}
+
+std::size_t peak_bytes(){
+    auto &tr = get_tracker();
+    std::lock_guard<std::mutex> lock(tr.mtx);
+    return tr.peak;
+}
+
+void reset_peak(){
+    auto &tr = get_tracker();
+    std::lock_guard<std::mutex> lock(tr.mtx);
+    tr.peak = tr.current;
+    for(auto &kv : tr.tags){
+        kv.second.peak = kv.second.current;
+    }
+}
+
+std::vector<tag_usage> usage(){
+    auto &tr = get_tracker();
+    std::vector<tag_usage> us;
+    {
+        std::lock_guard<std::mutex> lock(tr.mtx);
+        for(auto &kv : tr.tags){
+            us.push_back(kv.second);
+        }
+    }
+    std::sort(us.begin(), us.end(), [](const tag_usage &a,
+                                       const tag_usage &b){
+        return a.peak > b.peak;
+    });
+    return us;
+}
+
+std::string report(){
+    const double mb = 1.0 / (1 << 20);
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << std::left << std::setw(32) << "tag" << std::right
+       << std::setw(14) << "current MB"
+       << std::setw(14) << "peak MB"
+       << std::setw(8) << "allocs" << std::endl;
+    for(auto &u : usage()){
+        ss << std::left << std::setw(32) << u.tag << std::right
+           << std::setw(14) << u.current * mb
+           << std::setw(14) << u.peak * mb
+           << std::setw(8) << u.allocations << std::endl;
+    }
+    ss << std::left << std::setw(32) << "total" << std::right
+       << std::setw(14) << current_bytes() * mb
+       << std::setw(14) << peak_bytes() * mb << std::endl;
+    return ss.str();
+}
+
+void on_allocate(const memory *mem, std::size_t byte_size){
+    auto &tr = get_tracker();
+    std::lock_guard<std::mutex> lock(tr.mtx);
+    tr.live[mem] = {current_tag, byte_size};
+    tr.tags[current_tag].allocations += 1;
+    add_bytes(tr, current_tag, byte_size);
+}
+
+void on_free(const memory *mem){
+    auto &tr = get_tracker();
+    std::lock_guard<std::mutex> lock(tr.mtx);
+    auto it = tr.live.find(mem);
+    if(it != tr.live.end()){
+        sub_bytes(tr, it->second.tag, it->second.byte_size);
+        tr.live.erase(it);
+    }
+}
+
+void set_tag(const memory *mem, std::string tag){
+    auto &tr = get_tracker();
+    std::lock_guard<std::mutex> lock(tr.mtx);
+    auto it = tr.live.find(mem);
+    if(it == tr.live.end() || it->second.tag == tag){
+        return;
+    }
+    auto &a = it->second;
+    // the move does not raise the total, only the peak of the new tag.
+    sub_bytes(tr, a.tag, a.byte_size);
+    tr.tags[a.tag].allocations -= 1;
+    a.tag = tag;
+    tr.tags[tag].allocations += 1;
+    add_bytes(tr, tag, a.byte_size);
+}
+
+scoped_tag::scoped_tag(std::string tag) : _prev(current_tag){
+    current_tag = tag;
+}
+
+scoped_tag::~scoped_tag(){
+    current_tag = _prev;
+}
+
+} // end namespace memory_tracker
+} // end namespace mlfe
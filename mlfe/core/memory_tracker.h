@@ -0,0 +1,62 @@
+#ifndef __MEMORY_TRACKER_HPP__
+#define __MEMORY_TRACKER_HPP__
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mlfe{
+class memory;
+
+// accounts every memory made by create_memory() to a tag, while it lives.
+// the memory of an op output is tagged with the op name, as is the
+// workspace its algo allocates, like an im2col buffer or the moments of an
+// optimizer. other memory takes the tag of the innermost scoped_tag, or
+// "Variable".
+namespace memory_tracker{
+
+struct tag_usage{
+    std::string tag;
+    std::size_t current;
+    // the most bytes the tag held at once, since the last reset_peak().
+    std::size_t peak;
+    int allocations;
+};
+
+std::size_t current_bytes();
+
+// the most bytes alive at once, since the last reset_peak().
+std::size_t peak_bytes();
+
+// sets the peaks to the current bytes, to measure the peak of a part like
+// a backprop().
+void reset_peak();
+
+// the usage of the tags ever used, sorted by peak.
+std::vector<tag_usage> usage();
+
+// usage() and the totals as a table.
+std::string report();
+
+// called by create_memory().
+void on_allocate(const memory *mem, std::size_t byte_size);
+
+void on_free(const memory *mem);
+
+// moves the bytes of mem to tag. memory not made by create_memory(), like
+// a view, is not accounted and is ignored.
+void set_tag(const memory *mem, std::string tag);
+
+// memory allocated by this thread while it lives is tagged with tag.
+class scoped_tag{
+public:
+    explicit scoped_tag(std::string tag);
+
+    ~scoped_tag();
+
+private:
+    std::string _prev;
+};
+
+} // end namespace memory_tracker
+} // end namespace mlfe
+#endif // end ifndef __MEMORY_TRACKER_HPP__
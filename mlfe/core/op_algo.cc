@@ -1,10 +1,53 @@
 #include "op_algo.h"
+#include "memory_tracker.h"
 #include <iostream>
 
 namespace mlfe{
 
+OpAlgoCost::OpAlgoCost(double flops,
+                       double bytes_read,
+                       double bytes_written
+                      )
+    : flops(flops), bytes_read(bytes_read), bytes_written(bytes_written){}
+
+OpAlgoCost &OpAlgoCost::operator+=(const OpAlgoCost &other){
+    flops += other.flops;
+    bytes_read += other.bytes_read;
+    bytes_written += other.bytes_written;
+    return *this;
+}
+
+double OpAlgoCost::bytes() const{
+    return bytes_read + bytes_written;
+}
+
+double OpAlgoCost::intensity() const{
+    return bytes() > 0 ? flops / bytes() : 0;
+}
+
+OpAlgoCost streaming_cost(OpAlgoContext *oac, double flops_per_output){
+    OpAlgoCost cost;
+    for(int n = 0; n < oac->num_outputs(); ++n){
+        auto y = oac->get_output(n);
+        cost.bytes_written += double(y.size()) * y.type().size;
+    }
+    if(oac->num_outputs() > 0){
+        auto y = oac->get_output(0);
+        for(auto &x : y.get_children()){
+            cost.bytes_read += double(x.size()) * x.type().size;
+        }
+        cost.flops = flops_per_output * y.size();
+    }
+    return cost;
+}
+
 OpAlgo::OpAlgo(OpAlgoContext *oac, std::string name){
     this->name = name;
+    op_name = oac->get_op_name();
+    if(oac->num_outputs() > 0){
+        output_shape = oac->get_output(0).shape();
+    }
+    cost = streaming_cost(oac);
 }
 
 using OAS = OpAlgoSchema;
@@ -25,10 +68,18 @@ std::string OAS::Device() const{
     return device;
 }
 
+std::string OAS::Variant() const{
+    return variant;
+}
+
 OAS::OpAlgoCreator OAS::Creator() const{
     return creator;
 }
 
+OAS::OpAlgoCostFn OAS::Cost() const{
+    return cost;
+}
+
 using OASB = OAS::Builder;
 
 OASB::Builder(std::string name){
@@ -50,14 +101,27 @@ OASB &OASB::Device(std::string device){
     return *this;
 }
 
+OASB &OASB::Variant(std::string variant){
+    oas.variant = variant;
+    return *this;
+}
+
 OASB &OASB::CreatorFn(OAS::OpAlgoCreator fn){
     oas.creator = fn;
     return *this;
 }
 
+OASB &OASB::CostFn(OAS::OpAlgoCostFn fn){
+    oas.cost = fn;
+    return *this;
+}
+
 OpAlgoSchema OASB::Finish(){
     oas.name = "Name:" + oas.name;
     oas.name += "/Device:" + oas.device;
+    if(!oas.variant.empty()){
+        oas.name += "/Variant:" + oas.variant;
+    }
     return oas;
 }
 
@@ -127,12 +191,33 @@ std::vector<std::string> OAR::GetAllOpName() const{
     return op_names;
 }
 
+std::vector<std::string> OAR::GetVariants(std::string op_name) const{
+    std::vector<std::string> names;
+    if(Has(op_name)){
+        names.push_back(op_name);
+    }
+    std::string prefix = op_name + "/Variant:";
+    for(auto it = registry.lower_bound(prefix);
+        it != registry.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+        ++it){
+        names.push_back(it->first);
+    }
+    return names;
+}
+
 OAR::OpAlgoPtr OAR::GetOpAlgo(std::string op_name, OpAlgoContext *oac) const{
     if(registry.find(op_name) == registry.end()){
         throw std::string("OpAlgoRegistry::GetOpAlgo - "
             "Not found for ") + op_name;
     }
-    return registry.find(op_name)->second.Creator()(oac);
+    auto &schema = registry.find(op_name)->second;
+    // the workspace of the algo.
+    memory_tracker::scoped_tag tag(oac->get_op_name());
+    auto algo = schema.Creator()(oac);
+    if(schema.Cost()){
+        algo->cost = schema.Cost()(oac);
+    }
+    return algo;
 }
 
 OAR *OAR::Get(){
@@ -156,6 +241,8 @@ REGIST_OP_ALGO(Identity)
     .Input("X", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("Any")
+    // a variable, nothing runs.
+    .CostFn([](OpAlgoContext *oac){ return OpAlgoCost(); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = Identity<type::float32>;
         return std::make_shared<T>(oac);
@@ -174,6 +261,8 @@ REGIST_OP_GRAD_ALGO(Identity)
     .Input("X", type::float32::string)
     .Output("dX", type::float32::string)
     .Device("Any")
+    // a variable, nothing runs.
+    .CostFn([](OpAlgoContext *oac){ return OpAlgoCost(); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = IdentityGrad<type::float32>;
         return std::make_shared<T>(oac);
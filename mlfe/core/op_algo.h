@@ -5,6 +5,7 @@
 #include "device.h"
 #include "tensor.h"
 #include "attribute.h"
+#include "profiler.h"
 #include <vector>
 #include <memory>
 #include <map>
@@ -15,22 +16,79 @@ namespace mlfe{
 
 class OpAlgoContext;
 
+// the work of an algo for the shapes it was made for, which puts its
+// measured time in perspective: achieved flop/s and bytes/s, and whether
+// it is bound by compute or by memory.
+struct OpAlgoCost{
+    OpAlgoCost(double flops = 0,
+               double bytes_read = 0,
+               double bytes_written = 0
+              );
+
+    OpAlgoCost &operator+=(const OpAlgoCost &other);
+
+    double bytes() const;
+
+    // flops per byte moved.
+    double intensity() const;
+
+    double flops;
+    double bytes_read;
+    double bytes_written;
+};
+
+// the cost of an algo that reads the inputs of its output 0 and writes its
+// outputs once each, with flops_per_output flops for each element of
+// output 0. an algo without a cost function has this cost with no flops.
+OpAlgoCost streaming_cost(OpAlgoContext *oac, double flops_per_output = 0);
+
 class OpAlgo{
 public:
     OpAlgo(OpAlgoContext *oac, std::string name = "");
 
     virtual void Compute() = 0;
 
+    // Compute(), recorded if the profiler is enabled.
+    void Run(){
+        if(profiler::enabled()){
+            profiler::record(this);
+        }
+        else{
+            Compute();
+        }
+    }
+
     std::string get_name() const{
         return name;
     }
+
+    // the name of the op in the registry, like "Conv2DGradientInput",
+    // which the algos without a name also have.
+    std::string get_op_name() const{
+        return op_name;
+    }
+
+    std::vector<int> get_output_shape() const{
+        return output_shape;
+    }
+
+    // from the cost function of the schema, see OpAlgoSchema::Builder.
+    OpAlgoCost get_cost() const{
+        return cost;
+    }
+
 private:
+    friend class OpAlgoRegistry;
     std::string name;
+    std::string op_name;
+    std::vector<int> output_shape;
+    OpAlgoCost cost;
 };
 
 class OpAlgoSchema{
 using OpAlgoPtr = std::shared_ptr<OpAlgo>;
 using OpAlgoCreator = std::function<OpAlgoPtr(OpAlgoContext *)>;
+using OpAlgoCostFn = std::function<OpAlgoCost(OpAlgoContext *)>;
 public:
     std::string Name() const;
 
@@ -40,15 +98,23 @@ public:
 
     std::string Device() const;
 
+    // empty for the algo picked by the device, see Builder::Variant.
+    std::string Variant() const;
+
     OpAlgoCreator Creator() const;
 
+    // empty if the schema has no cost function.
+    OpAlgoCostFn Cost() const;
+
     class Builder;
 private:
     std::string name;
     std::string device;
+    std::string variant;
     std::unordered_map<std::string, std::string> inputs;
     std::unordered_map<std::string, std::string> outputs;
     OpAlgoCreator creator;
+    OpAlgoCostFn cost;
 };
 
 class OpAlgoSchema::Builder{
@@ -61,8 +127,16 @@ public:
 
     Builder &Device(std::string device);
 
+    // another algo of the op for the device, named with "/Variant:" and
+    // variant after the device. only the autotuner picks it.
+    Builder &Variant(std::string variant);
+
     Builder &CreatorFn(OpAlgoCreator fn);
 
+    // the cost of the algo made by the creator for the same context.
+    // it reads only the shapes and the attributes.
+    Builder &CostFn(OpAlgoCostFn fn);
+
     OpAlgoSchema Finish();
 private:
     OpAlgoSchema  oas;
@@ -88,6 +162,8 @@ public:
 
     void add_output(Tensor out);
 
+    // an algo may add the attributes the algo of its gradient reads, like
+    // a mask in a layout of its own. they are kept with its output.
     void add_attr(Attribution attr);
 
     template <class T>
@@ -116,6 +192,9 @@ public:
 
     std::vector<std::string> GetAllOpName() const;
 
+    // op_name, if registered, and its variants.
+    std::vector<std::string> GetVariants(std::string op_name) const;
+
     OpAlgoPtr GetOpAlgo(std::string op_name, OpAlgoContext *oac) const;
 
     static OpAlgoRegistry *Get();
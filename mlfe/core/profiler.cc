@@ -0,0 +1,181 @@
+#include "profiler.h"
+#include "op_algo.h"
+#include "device.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace mlfe{
+namespace profiler{
+
+std::atomic<bool> _enabled(false);
+
+namespace{
+
+using clock_type = std::chrono::steady_clock;
+
+struct recorder{
+    std::mutex mtx;
+    clock_type::time_point origin;
+    std::vector<op_event> events;
+    std::map<std::thread::id, int> thread_ids;
+};
+
+recorder &get_recorder(){
+    static recorder rec;
+    return rec;
+}
+
+double to_us(clock_type::duration d){
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+std::string shape_string(const std::vector<int> &shape){
+    std::stringstream ss;
+    for(int n = 0; n < shape.size(); ++n){
+        ss << (n == 0 ? "" : "x") << shape[n];
+    }
+    return ss.str();
+}
+
+// op names are identifiers, but keep the json valid anyway.
+std::string json_escape(const std::string &str){
+    std::string out;
+    for(char c : str){
+        if(c == '"' || c == '\\'){
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // end anonymous namespace
+
+void start(){
+    auto &rec = get_recorder();
+    std::lock_guard<std::mutex> lock(rec.mtx);
+    rec.events.clear();
+    rec.thread_ids.clear();
+    rec.origin = clock_type::now();
+    _enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop(){
+    _enabled.store(false, std::memory_order_relaxed);
+}
+
+void record(OpAlgo *algo){
+    auto &rec = get_recorder();
+    auto dev = get_enabled_device();
+    const bool sync = dev->get_device_name() != "CPU";
+    if(sync){
+        dev->synchronize();
+    }
+    auto begin = clock_type::now();
+    algo->Compute();
+    if(sync){
+        dev->synchronize();
+    }
+    auto end = clock_type::now();
+    op_event e;
+    e.name = algo->get_op_name();
+    e.shape = algo->get_output_shape();
+    e.start = to_us(begin - rec.origin);
+    e.duration = to_us(end - begin);
+    auto cost = algo->get_cost();
+    e.flops = cost.flops;
+    e.bytes = cost.bytes();
+    std::lock_guard<std::mutex> lock(rec.mtx);
+    auto id = rec.thread_ids.insert({std::this_thread::get_id(),
+                                     int(rec.thread_ids.size())});
+    e.thread_id = id.first->second;
+    rec.events.push_back(e);
+}
+
+std::vector<op_event> events(){
+    auto &rec = get_recorder();
+    std::lock_guard<std::mutex> lock(rec.mtx);
+    return rec.events;
+}
+
+void write_chrome_trace(std::string file_name){
+    std::ofstream file(file_name);
+    if(!file.is_open()){
+        throw std::string("profiler::write_chrome_trace() - "
+            "can not open ") + file_name;
+    }
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[";
+    auto evs = events();
+    for(int n = 0; n < evs.size(); ++n){
+        auto &e = evs[n];
+        file << (n == 0 ? "\n" : ",\n");
+        file << "{\"name\":\"" << json_escape(e.name) << "\","
+             << "\"cat\":\"op\",\"ph\":\"X\","
+             << "\"ts\":" << e.start << ","
+             << "\"dur\":" << e.duration << ","
+             << "\"pid\":0,\"tid\":" << e.thread_id << ","
+             << "\"args\":{\"shape\":\"" << shape_string(e.shape) << "\","
+             << "\"flops\":" << e.flops << ","
+             << "\"bytes\":" << e.bytes << "}}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+std::string summary(){
+    struct op_total{
+        std::string name;
+        int calls = 0;
+        double time = 0;
+        double flops = 0;
+        double bytes = 0;
+    };
+    std::map<std::string, op_total> by_name;
+    double total_time = 0;
+    for(auto &e : events()){
+        auto &t = by_name[e.name];
+        t.name = e.name;
+        t.calls += 1;
+        t.time += e.duration;
+        t.flops += e.flops;
+        t.bytes += e.bytes;
+        total_time += e.duration;
+    }
+    std::vector<op_total> rows;
+    for(auto &kv : by_name){
+        rows.push_back(kv.second);
+    }
+    std::sort(rows.begin(), rows.end(), [](const op_total &a,
+                                           const op_total &b){
+        return a.time > b.time;
+    });
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << std::left << std::setw(32) << "op" << std::right
+       << std::setw(8) << "calls"
+       << std::setw(14) << "total ms"
+       << std::setw(14) << "mean us"
+       << std::setw(9) << "%"
+       << std::setw(10) << "GFLOPS"
+       << std::setw(10) << "GB/s" << std::endl;
+    for(auto &r : rows){
+        ss << std::left << std::setw(32) << r.name << std::right
+           << std::setw(8) << r.calls
+           << std::setw(14) << r.time * 1e-3
+           << std::setw(14) << r.time / r.calls
+           << std::setw(9) << (total_time > 0 ? 100 * r.time / total_time : 0)
+           << std::setw(10) << (r.time > 0 ? r.flops / r.time * 1e-3 : 0)
+           << std::setw(10) << (r.time > 0 ? r.bytes / r.time * 1e-3 : 0)
+           << std::endl;
+    }
+    return ss.str();
+}
+
+} // end namespace profiler
+} // end namespace mlfe
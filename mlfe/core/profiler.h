@@ -0,0 +1,56 @@
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+#include "../utils/types.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace mlfe{
+class OpAlgo;
+
+// an opt-in per-op profiler, every OpAlgo::Run() between start() and
+// stop() is timed and recorded. when it is stopped, Run() only tests one
+// global flag before Compute().
+namespace profiler{
+
+struct op_event{
+    std::string name;
+    std::vector<int> shape;
+    // microseconds, start is relative to start().
+    double start;
+    double duration;
+    int thread_id;
+    // the cost of the algo, see OpAlgoCost.
+    double flops;
+    double bytes;
+};
+
+// clears the recorded events and starts recording.
+void start();
+
+void stop();
+
+// only gates recording, the events are guarded by their own mutex.
+extern std::atomic<bool> _enabled;
+
+inline bool enabled(){
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+// runs algo->Compute() and records it. on an accelerator the device is
+// synchronized around Compute(), so the duration covers the kernels it
+// queued and not only their launch.
+void record(OpAlgo *algo);
+
+std::vector<op_event> events();
+
+// writes the events as chrome trace_event json, for chrome://tracing or
+// perfetto.
+void write_chrome_trace(std::string file_name);
+
+// a table of the events by op name, sorted by total time.
+std::string summary();
+
+} // end namespace profiler
+} // end namespace mlfe
+#endif // end ifndef __PROFILER_HPP__
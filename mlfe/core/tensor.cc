@@ -4,11 +4,14 @@
 #include "attribute.h"
 #include "graph.h"
 #include "gradient_helper.h"
+#include "memory_tracker.h"
+#include "autotuner.h"
 #include "../operators/initializer.h"
 #include "../operators/basic_arithmetics.h"
 #include "../utils/assert.h"
 #include <algorithm>
 #include <sstream>
+#include <unordered_set>
 
 namespace mlfe{
 
@@ -81,7 +84,7 @@ void Tensor::eval(){
         if(t._pimpl->_algo != nullptr &&
            t._pimpl->_children_modified
           ){
-            t._pimpl->_algo->Compute();
+            t._pimpl->_algo->Run();
             t._pimpl->_children_modified = false;
             for(int n = 0; n < t._pimpl->_parents.size(); ++n){
                 t._pimpl->_parents[n]._pimpl->_children_modified = true;
@@ -148,7 +151,7 @@ void Tensor::compute_gradient(const Tensor root){
     std::sort(v_list.begin(), v_list.end(), [](Tensor v1, Tensor v2){
         return v1.get_exec_order() > v2.get_exec_order();
     });
-    // root gradient is 1.
+    // root gradient is 1, allocated only if a gradient kernel reads it.
     dy_collector[root].push_back(functional::constant(1, root.shape()));
     // set root gradient.
     root._pimpl->_gradient = make_ptr(dy_collector[root][0]);
@@ -179,7 +182,13 @@ void Tensor::compute_gradient(const Tensor root){
     }
 }
 
-Tensor::AssignOpFunctor::AssignOpFunctor(Tensor t, OpAlgoContext ctx){
+Tensor::AssignOpFunctor::AssignOpFunctor(Tensor t, OpAlgoContext ctx)
+    : AssignOpFunctor(t, ctx, {}){}
+
+Tensor::AssignOpFunctor::AssignOpFunctor(Tensor t,
+                                         OpAlgoContext ctx,
+                                         std::vector<Tensor> others
+                                        ){
     auto reg = OpAlgoRegistry::Get();
     auto dev = get_enabled_device();
     std::string op_name = ctx.get_op_name();
@@ -193,8 +202,23 @@ Tensor::AssignOpFunctor::AssignOpFunctor(Tensor t, OpAlgoContext ctx){
                 );
 
     ctx.add_output(t);
-    t._pimpl->_ctx = ctx;
-    if(reg->Has(full_op_name + with_accel)){
+    for(auto &o : others){
+        ctx.add_output(o);
+    }
+    // a tuned op takes the fastest algo of the device, see autotuner.
+    std::string tuned;
+    if(autotuner::is_tuned(op_name)){
+        std::vector<std::string> candidates;
+        for(auto name : {with_accel, dev_name}){
+            auto variants = reg->GetVariants(full_op_name + name);
+            candidates.insert(candidates.end(), variants.begin(), variants.end());
+        }
+        tuned = autotuner::select(&ctx, candidates);
+    }
+    if(!tuned.empty()){
+        t._pimpl->_algo = reg->GetOpAlgo(tuned, &ctx);
+    }
+    else if(reg->Has(full_op_name + with_accel)){
         t._pimpl->_algo = reg->GetOpAlgo(full_op_name + with_accel, &ctx);
     }
     else if(reg->Has(full_op_name + dev_name)){
@@ -206,21 +230,57 @@ Tensor::AssignOpFunctor::AssignOpFunctor(Tensor t, OpAlgoContext ctx){
     else{
         throw std::string(op_name) + " is not supported.";
     }
+    // with the attributes the algo added for its gradient, like a mask.
+    t._pimpl->_ctx = ctx;
+    // a reshape shares the memory of its input.
+    if(op_name != "Identity" && op_name != "Reshape"){
+        memory_tracker::set_tag(t._pimpl->_mem.get(), op_name);
+        for(auto &o : others){
+            memory_tracker::set_tag(o._pimpl->_mem.get(), op_name);
+        }
+    }
+    // the other outputs keep their algo, which does nothing for a
+    // variable, and now come after t in their compute lists.
+    for(auto &o : others){
+        o.add_child(t);
+        o._pimpl->_compute_list = visit_bfs(o);
+        std::reverse(o._pimpl->_compute_list.begin(),
+                     o._pimpl->_compute_list.end()
+                    );
+    }
 }
 
 
 namespace functional{
 
 Tensor create_variable(std::vector<int> shape){
+    return create_variable(shape, type::float32());
+}
+
+Tensor create_variable(std::vector<int> shape, type::TypeInfo ti){
     Tensor var;
     OpAlgoContext ctx("Identity");
-    var.reshape(shape);
+    var.reshape(shape, ti);
     var._pimpl->_mem = create_memory(var.size() * var.type().size);
     var._pimpl->_ctx = ctx;
     Tensor::AssignOpFunctor(var, ctx);
     return var;
 }
 
+Tensor create_variable(std::vector<int> shape, memory_ptr mem){
+    Tensor var;
+    OpAlgoContext ctx("Identity");
+    var.reshape(shape);
+    if(mem->size() < var.size() * var.type().size){
+        throw std::string("create_variable() - "
+            "the memory is smaller than the shape.");
+    }
+    var._pimpl->_mem = mem;
+    var._pimpl->_ctx = ctx;
+    Tensor::AssignOpFunctor(var, ctx);
+    return var;
+}
+
 Tensor reshape(Tensor x, std::vector<int> shape){
     Tensor y;
     OpAlgoContext ctx("Reshape");
@@ -234,6 +294,56 @@ Tensor reshape(Tensor x, std::vector<int> shape){
     return y;
 }
 
+memory_ptr flatten_memory(std::vector<Tensor> xs){
+    std::unordered_set<memory *> mems;
+    type::uint32::T byte_size = 0;
+    for(auto &x : xs){
+        if(!mems.insert(x._pimpl->_mem.get()).second){
+            throw std::string("flatten_memory() - "
+                "the tensors share memory.");
+        }
+        byte_size += x._pimpl->_mem->size();
+    }
+    memory_tracker::scoped_tag tag("flatten_memory");
+    auto flat = create_memory(byte_size);
+    type::uint32::T offset = 0;
+    for(auto &x : xs){
+        auto old_mem = x._pimpl->_mem;
+        auto view = create_memory_view(flat, offset, old_mem->size());
+        copy(old_mem, view);
+        // x and every tensor reached through tensors sharing old_mem.
+        std::vector<Tensor> will_visit = {x};
+        while(!will_visit.empty()){
+            auto t = will_visit.back();
+            will_visit.pop_back();
+            if(t._pimpl->_mem == old_mem){
+                t._pimpl->_mem = view;
+                for(auto &c : t._pimpl->_children){
+                    will_visit.push_back(c);
+                }
+                for(auto &p : t._pimpl->_parents){
+                    will_visit.push_back(p);
+                }
+            }
+        }
+        offset += old_mem->size();
+    }
+    return flat;
+}
+
+OpAlgoCost graph_cost(std::vector<Tensor> roots){
+    std::unordered_set<Tensor> visited;
+    OpAlgoCost cost;
+    for(auto &root : roots){
+        for(auto &t : visit_bfs(root)){
+            if(visited.insert(t).second && t._pimpl->_algo != nullptr){
+                cost += t._pimpl->_algo->get_cost();
+            }
+        }
+    }
+    return cost;
+}
+
 } // end namespace functional
 } // end namespace mlfe
 
@@ -12,13 +12,34 @@ namespace mlfe{
 class Tensor;
 class Attribution;
 class OpAlgoContext;
+struct OpAlgoCost;
 
 namespace functional{
 
 Tensor create_variable(std::vector<int> shape);
 
+// a variable of the type ti, like the uint8 mask of an algo.
+Tensor create_variable(std::vector<int> shape, type::TypeInfo ti);
+
+// a variable of shape on mem, which is not allocated here, like the
+// lazy memory of a constant.
+Tensor create_variable(std::vector<int> shape, memory_ptr mem);
+
 Tensor reshape(Tensor x, std::vector<int> shape);
 
+// moves the data of xs into one new buffer, one after another in order,
+// and makes the memory of each x a view into it. tensors sharing memory
+// with an x, like reshape outputs, follow it.
+// parameters and their gradients flattened in the same order give a
+// parameter buffer and a parallel gradient buffer, which can be saved or
+// reduced in one call.
+memory_ptr flatten_memory(std::vector<Tensor> xs);
+
+// the sum of the costs of the ops reachable from roots, each op counted
+// once. the loss gives the forward pass, the loss and the gradients of the
+// parameters after backprop() give a training step.
+OpAlgoCost graph_cost(std::vector<Tensor> roots);
+
 } // end namespace functional
 
 class Tensor final : public Variable{
@@ -100,7 +121,11 @@ protected:
 
 private:
     friend Tensor functional::create_variable(std::vector<int>);
+    friend Tensor functional::create_variable(std::vector<int>, type::TypeInfo);
+    friend Tensor functional::create_variable(std::vector<int>, memory_ptr);
     friend Tensor functional::reshape(Tensor x, std::vector<int> shape);
+    friend memory_ptr functional::flatten_memory(std::vector<Tensor>);
+    friend OpAlgoCost functional::graph_cost(std::vector<Tensor>);
     friend struct std::hash<Tensor>;
     friend struct AssignOpFunctor;
     struct impl;
@@ -235,6 +260,11 @@ private:
 
 struct Tensor::AssignOpFunctor{
     AssignOpFunctor(Tensor t, OpAlgoContext cxt);
+
+    // one algo with several outputs, like a fused gradient. t runs it and
+    // is output 0, the others follow in order. they are made to depend on
+    // t, so evaluating any of them runs the algo, and only once.
+    AssignOpFunctor(Tensor t, OpAlgoContext cxt, std::vector<Tensor> others);
 };
 
 } // end namespace mlfe
@@ -1,12 +1,20 @@
 #include <string>
 #include <new>
 #include <functional>
+#include <atomic>
 #include "cpu_context.h"
 
 namespace mlfe {
 
 std::mt19937 CPUContext::rng = std::mt19937(1357);
 
+unsigned long long CPUContext::seed = 1357;
+
+unsigned int CPUContext::new_op_id(){
+    static std::atomic<unsigned int> op_id(0);
+    return op_id++;
+}
+
 CPUContext::~CPUContext(){}
 
 } /* namespace mlfe */
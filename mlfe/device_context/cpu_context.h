@@ -10,6 +10,12 @@ public:
     ~CPUContext() override;
 
     static std::mt19937 rng;
+
+    // seed of the counter based random streams (math/random.h).
+    static unsigned long long seed;
+
+    // a new id for each random op, which selects its own stream.
+    static unsigned int new_op_id();
 };
     
 } // end namespace mlfe
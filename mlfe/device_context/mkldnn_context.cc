@@ -0,0 +1,183 @@
+#include "mkldnn_context.h"
+#include "../core/memory_tracker.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace mlfe {
+
+namespace {
+
+// a dnnl memory attached to the memory of a tensor, valid while the
+// tensor memory is alive. the blocked outputs and the shared memories.
+struct attached_memory{
+    std::weak_ptr<memory> owner;
+    dnnl::memory data;
+};
+
+using attached_map = std::unordered_map<const memory *, attached_memory>;
+
+std::mutex attached_mtx;
+
+attached_map &blocked_outputs(){
+    static attached_map outputs;
+    return outputs;
+}
+
+attached_map &shared_memories(){
+    static attached_map memories;
+    return memories;
+}
+
+dnnl::memory find_attached(attached_map &m, memory_ptr mem){
+    std::lock_guard<std::mutex> lock(attached_mtx);
+    auto it = m.find(mem.get());
+    if(it == m.end() || it->second.owner.lock() != mem){
+        return dnnl::memory();
+    }
+    return it->second.data;
+}
+
+void attach(attached_map &m, memory_ptr mem, dnnl::memory data){
+    std::lock_guard<std::mutex> lock(attached_mtx);
+    m[mem.get()] = {mem, data};
+}
+
+// unless another memory was attached to mem since.
+void detach(attached_map &m, const memory *mem, dnnl::memory data){
+    std::lock_guard<std::mutex> lock(attached_mtx);
+    auto it = m.find(mem);
+    if(it != m.end() && it->second.data == data){
+        m.erase(it);
+    }
+}
+
+// the blocked output of the algo of x, if its shape is the one of x.
+// a reshape shares the memory of its input, but not the layout.
+dnnl::memory find_blocked(Tensor x){
+    auto blocked = find_attached(blocked_outputs(), x.get_memory());
+    if(blocked &&
+       blocked.get_desc().get_dims() != MKLDNNContext::dims(x.shape())){
+        return dnnl::memory();
+    }
+    return blocked;
+}
+
+void reorder_into(dnnl::memory from, dnnl::memory to){
+    dnnl::reorder(from, to).execute(MKLDNNContext::stream(), from, to);
+    MKLDNNContext::stream().wait();
+}
+
+} // end anonymous namespace
+
+MKLDNNContext::~MKLDNNContext(){}
+
+dnnl::engine &MKLDNNContext::engine(){
+    static dnnl::engine eng(dnnl::engine::kind::cpu, 0);
+    return eng;
+}
+
+dnnl::stream &MKLDNNContext::stream(){
+    static dnnl::stream s(engine());
+    return s;
+}
+
+dnnl::memory::dims MKLDNNContext::dims(std::vector<int> v){
+    return dnnl::memory::dims(v.begin(), v.end());
+}
+
+dnnl::memory::desc MKLDNNContext::plain_desc(std::vector<int> shape){
+    dnnl::memory::dims strides(shape.size(), 1);
+    for(int n = int(shape.size()) - 2; n >= 0; --n){
+        strides[n] = strides[n + 1] * shape[n + 1];
+    }
+    return dnnl::memory::desc(dims(shape),
+                              dnnl::memory::data_type::f32,
+                              strides);
+}
+
+dnnl::memory::desc MKLDNNContext::any_desc(std::vector<int> shape){
+    return dnnl::memory::desc(dims(shape),
+                              dnnl::memory::data_type::f32,
+                              dnnl::memory::format_tag::any);
+}
+
+dnnl::memory::desc MKLDNNContext::layout(Tensor x){
+    auto blocked = find_blocked(x);
+    return blocked ? blocked.get_desc() : plain_desc(x.shape());
+}
+
+dnnl::memory MKLDNNContext::shared_memory(Tensor key,
+                                          const dnnl::memory::desc &md
+                                         ){
+    auto mem = find_attached(shared_memories(), key.get_memory());
+    if(!mem || mem.get_desc() != md){
+        mem = dnnl::memory(md, engine());
+        attach(shared_memories(), key.get_memory(), mem);
+    }
+    return mem;
+}
+
+mkldnn_input::mkldnn_input(Tensor x, dnnl::memory::desc md)
+    : _x(x), _md(md){}
+
+dnnl::memory mkldnn_input::get(){
+    auto &eng = MKLDNNContext::engine();
+    dnnl::memory from = find_blocked(_x);
+    // the plain data is current once the deferred reorder ran.
+    if(!from || !_x.get_memory()->has_deferred_write()){
+        auto plain = MKLDNNContext::plain_desc(_x.shape());
+        auto ptr = const_cast<float *>(_x.device_data<float>());
+        from = dnnl::memory(plain, eng, ptr);
+    }
+    if(from.get_desc() == _md){
+        return from;
+    }
+    if(!_reordered){
+        memory_tracker::scoped_tag tag("mkldnn_reorder");
+        _buffer = create_memory(_md.get_size());
+        _reordered = dnnl::memory(_md, eng,
+                                  _buffer->mutable_device_data<void>());
+    }
+    reorder_into(from, _reordered);
+    return _reordered;
+}
+
+mkldnn_output::mkldnn_output(Tensor y, dnnl::memory::desc md)
+    : _y(y), _md(md){
+    if(_md != MKLDNNContext::plain_desc(_y.shape())){
+        _buffer = create_memory(_md.get_size());
+        _blocked = dnnl::memory(_md, MKLDNNContext::engine(),
+                                _buffer->mutable_device_data<void>());
+        attach(blocked_outputs(), _y.get_memory(), _blocked);
+        // an algo the autotuner discarded leaves no layout for the next
+        // algos.
+        const memory *key = _y.get_memory().get();
+        auto blocked = _blocked;
+        _attachment = std::shared_ptr<void>(nullptr, [key, blocked](void *){
+            detach(blocked_outputs(), key, blocked);
+        });
+    }
+}
+
+dnnl::memory mkldnn_output::get(){
+    if(_blocked){
+        return _blocked;
+    }
+    return dnnl::memory(_md, MKLDNNContext::engine(),
+                        _y.mutable_device_data<float>());
+}
+
+void mkldnn_output::publish(){
+    if(!_blocked){
+        return;
+    }
+    auto blocked = _blocked;
+    auto buffer = _buffer;
+    auto plain = MKLDNNContext::plain_desc(_y.shape());
+    _y.get_memory()->defer_write([blocked, buffer, plain](void *ptr){
+        auto &eng = MKLDNNContext::engine();
+        reorder_into(blocked, dnnl::memory(plain, eng, ptr));
+    });
+}
+
+} // end namespace mlfe
@@ -0,0 +1,87 @@
+#ifndef __MKLDNN_CONTEXT_HPP__
+#define __MKLDNN_CONTEXT_HPP__
+#include "context.h"
+#include "../core/tensor.h"
+#include <dnnl.hpp>
+#include <vector>
+
+namespace mlfe {
+
+// the engine and stream of the oneDNN algos.
+// an algo may write its output in the blocked layout its primitive
+// prefers, like nChw16c, and the next oneDNN algo reads it as it is.
+// the plain layout of the tensor, which every other algo reads, is
+// written only when the tensor is accessed, see memory::defer_write().
+class MKLDNNContext final : public Context {
+public:
+    ~MKLDNNContext() override;
+
+    static dnnl::engine &engine();
+
+    static dnnl::stream &stream();
+
+    static dnnl::memory::dims dims(std::vector<int> v);
+
+    // the row major layout of a float tensor of shape.
+    static dnnl::memory::desc plain_desc(std::vector<int> shape);
+
+    // a float tensor of shape in the layout the primitive chooses.
+    static dnnl::memory::desc any_desc(std::vector<int> shape);
+
+    // the layout the algo of x writes, plain unless it is a oneDNN algo
+    // which chose a blocked one.
+    static dnnl::memory::desc layout(Tensor x);
+
+    // a memory of md shared by the algos of the same key, like the
+    // workspace of a max pool and its gradient.
+    static dnnl::memory shared_memory(Tensor key,
+                                      const dnnl::memory::desc &md
+                                     );
+};
+
+// an input of an algo in the layout of its primitive.
+class mkldnn_input{
+public:
+    mkldnn_input() = default;
+
+    mkldnn_input(Tensor x, dnnl::memory::desc md);
+
+    // the blocked data of the producer if it is current and in the
+    // layout, the plain data if the layout is plain, otherwise a reorder
+    // of either.
+    dnnl::memory get();
+
+private:
+    Tensor _x;
+    dnnl::memory::desc _md;
+    memory_ptr _buffer;
+    dnnl::memory _reordered;
+};
+
+// an output of an algo. in the plain layout it is the memory of y, in a
+// blocked layout a buffer of the algo, which the next oneDNN algos read
+// and which is reordered into y once y is accessed.
+class mkldnn_output{
+public:
+    mkldnn_output() = default;
+
+    mkldnn_output(Tensor y, dnnl::memory::desc md);
+
+    // the memory the primitive writes.
+    dnnl::memory get();
+
+    // after the primitive ran. a y on a view, like a gradient after
+    // flatten_memory(), is reordered at once.
+    void publish();
+
+private:
+    Tensor _y;
+    dnnl::memory::desc _md;
+    memory_ptr _buffer;
+    dnnl::memory _blocked;
+    // detaches _blocked from y with the last copy, see layout().
+    std::shared_ptr<void> _attachment;
+};
+
+} // end namespace mlfe
+#endif // end #ifndef __MKLDNN_CONTEXT_HPP__
@@ -1,7 +1,10 @@
 #include "activations.h"
+#include "fast_math.h"
 #include "../device_context/cpu_context.h"
+#include "../utils/parallel_for.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 namespace mlfe { namespace math {
 
@@ -58,7 +61,7 @@ void sigmoid<float, CPUContext>(const int size,
                                )
 {
     for (int i = 0; i < size; ++i) {
-        y[i] = 1.f / (1.f + std::exp(-x[i]));
+        y[i] = fast::sigmoid(x[i]);
     }
 }
 
@@ -69,7 +72,7 @@ void sigmoid<double, CPUContext>(const int size,
                                 )
 {
     for (int i = 0; i < size; ++i) {
-        y[i] = 1.f / (1.f + std::exp(-x[i]));
+        y[i] = fast::sigmoid(x[i]);
     }
 }
 
@@ -170,5 +173,184 @@ void cross_entropy_gradient<double, CPUContext>(const int m, const int n,
     }
 }
 
+namespace {
+
+// elements per block of the online softmax.
+// a block is small enough to stay in l1 and is reduced with plain loops
+// the compiler can vectorize.
+constexpr int softmax_block = 256;
+
+// rows handled by one parallel_for chunk, about 16k elements.
+inline int softmax_grain(const int n){
+    return std::max(1, (1 << 14) / std::max(n, 1));
+}
+
+// float reductions are not reordered by the compiler, so the sums are
+// kept in independent lanes that map onto simd registers.
+constexpr int reduce_lanes = 8;
+
+template <class T, class Fn>
+T lane_sum(const int len, Fn fn){
+    T acc[reduce_lanes] = { T(0) };
+    int j = 0;
+    for(; j + reduce_lanes <= len; j += reduce_lanes){
+        for(int k = 0; k < reduce_lanes; ++k){
+            acc[k] += fn(j + k);
+        }
+    }
+    for(; j < len; ++j){
+        acc[0] += fn(j);
+    }
+    T sum = T(0);
+    for(int k = 0; k < reduce_lanes; ++k){
+        sum += acc[k];
+    }
+    return sum;
+}
+
+template <class T>
+T lane_max(const int len, const T *x){
+    T acc[reduce_lanes];
+    std::fill(acc, acc + reduce_lanes, x[0]);
+    int j = 0;
+    for(; j + reduce_lanes <= len; j += reduce_lanes){
+        for(int k = 0; k < reduce_lanes; ++k){
+            acc[k] = acc[k] > x[j + k] ? acc[k] : x[j + k];
+        }
+    }
+    for(; j < len; ++j){
+        acc[0] = acc[0] > x[j] ? acc[0] : x[j];
+    }
+    return *std::max_element(acc, acc + reduce_lanes);
+}
+
+template <class T>
+void softmax_row_stats(const int n, const T *x, const T *t,
+                       T &row_max, T &row_sum, T &tx, T &ts){
+    using namespace std;
+    row_max = -numeric_limits<T>::infinity();
+    row_sum = T(0);
+    tx = T(0);
+    ts = T(0);
+    for(int b = 0; b < n; b += softmax_block){
+        const int len = min(softmax_block, n - b);
+        const T *xb = x + b;
+        const T block_max = lane_max(len, xb);
+        if(block_max > row_max){
+            row_sum *= fast::exp(row_max - block_max);
+            row_max = block_max;
+        }
+        const T shift = row_max;
+        row_sum += lane_sum<T>(len, [=](int j){
+            return fast::exp(xb[j] - shift);
+        });
+        if(t != nullptr){
+            const T *tb = t + b;
+            tx += lane_sum<T>(len, [=](int j){ return tb[j] * xb[j]; });
+            ts += lane_sum<T>(len, [=](int j){ return tb[j]; });
+        }
+    }
+}
+
+template <class T>
+void softmax_cross_entropy_impl(const int m,
+                                const int n,
+                                const T *x_ptr,
+                                const T *t_ptr,
+                                T *loss_ptr,
+                                T *prob_ptr
+                               ){
+    parallel_for(0, m, softmax_grain(n), [=](int from, int to){
+        for(int i = from; i < to; ++i){
+            const T *x = x_ptr + i * n;
+            T row_max, row_sum, tx, ts;
+            softmax_row_stats(n, x, t_ptr + i * n, row_max, row_sum, tx, ts);
+            const T log_z = row_max + fast::log(row_sum);
+            // -sum(t * log(softmax(x))) = sum(t) * log_z - sum(t * x).
+            loss_ptr[i] = ts * log_z - tx;
+            if(prob_ptr != nullptr){
+                T *p = prob_ptr + i * n;
+                for(int j = 0; j < n; ++j){
+                    p[j] = fast::exp(x[j] - log_z);
+                }
+            }
+        }
+    });
+}
+
+template <class T>
+void softmax_cross_entropy_gradient_impl(const int m,
+                                         const int n,
+                                         const T *x_ptr,
+                                         const T *t_ptr,
+                                         const T *dy_ptr,
+                                         T *dx_ptr
+                                        ){
+    parallel_for(0, m, softmax_grain(n), [=](int from, int to){
+        for(int i = from; i < to; ++i){
+            const T *x = x_ptr + i * n;
+            const T *t = t_ptr + i * n;
+            T *dx = dx_ptr + i * n;
+            T row_max, row_sum, tx, ts;
+            softmax_row_stats<T>(n, x, nullptr, row_max, row_sum, tx, ts);
+            const T log_z = row_max + fast::log(row_sum);
+            const T dy = dy_ptr[i];
+            for(int j = 0; j < n; ++j){
+                dx[j] = (fast::exp(x[j] - log_z) - t[j]) * dy;
+            }
+        }
+    });
+}
+
+} // end anonymous namespace
+
+template <>
+void softmax_cross_entropy<float, CPUContext>(const int m,
+                                              const int n,
+                                              const float *x_ptr,
+                                              const float *t_ptr,
+                                              float *loss_ptr,
+                                              float *prob_ptr
+                                             )
+{
+    softmax_cross_entropy_impl(m, n, x_ptr, t_ptr, loss_ptr, prob_ptr);
+}
+
+template <>
+void softmax_cross_entropy<double, CPUContext>(const int m,
+                                               const int n,
+                                               const double *x_ptr,
+                                               const double *t_ptr,
+                                               double *loss_ptr,
+                                               double *prob_ptr
+                                              )
+{
+    softmax_cross_entropy_impl(m, n, x_ptr, t_ptr, loss_ptr, prob_ptr);
+}
+
+template <>
+void softmax_cross_entropy_gradient<float, CPUContext>(const int m,
+                                                       const int n,
+                                                       const float *x_ptr,
+                                                       const float *t_ptr,
+                                                       const float *dy_ptr,
+                                                       float *dx_ptr
+                                                      )
+{
+    softmax_cross_entropy_gradient_impl(m, n, x_ptr, t_ptr, dy_ptr, dx_ptr);
+}
+
+template <>
+void softmax_cross_entropy_gradient<double, CPUContext>(const int m,
+                                                        const int n,
+                                                        const double *x_ptr,
+                                                        const double *t_ptr,
+                                                        const double *dy_ptr,
+                                                        double *dx_ptr
+                                                       )
+{
+    softmax_cross_entropy_gradient_impl(m, n, x_ptr, t_ptr, dy_ptr, dx_ptr);
+}
+
 } /* namespace math */
 } /* namespace mlfe */
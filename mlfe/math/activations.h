@@ -32,6 +32,29 @@ void cross_entropy_gradient(const int m,
                             T *dx_ptr
                            );
 
+// fused softmax and cross entropy over the rows of a m x n matrix.
+// the max, the sum of exps and the loss are accumulated in one pass
+// (online softmax), so no intermediate buffer is needed.
+// prob_ptr may be nullptr, otherwise the softmax is also written to it.
+template <class T, class Dev>
+void softmax_cross_entropy(const int m,
+                           const int n,
+                           const T *x_ptr,
+                           const T *t_ptr,
+                           T *loss_ptr,
+                           T *prob_ptr
+                          );
+
+// dx = (softmax(x) - t) * dy, row by row, without storing the softmax.
+template <class T, class Dev>
+void softmax_cross_entropy_gradient(const int m,
+                                    const int n,
+                                    const T *x_ptr,
+                                    const T *t_ptr,
+                                    const T *dy_ptr,
+                                    T *dx_ptr
+                                   );
+
 template <class T, class Dev>
 void sigmoid_cross_entropy(const int m,
                            const int n,
@@ -1,6 +1,9 @@
 #include "basic_functions.h"
+#include "fast_math.h"
 #include "../device_context/cpu_context.h"
+#include "../utils/parallel_for.h"
 #include <Eigen/Dense>
+#include <algorithm>
 
 namespace mlfe{ namespace math{
 
@@ -24,6 +27,80 @@ void squared_difference<double, CPUContext>(const int size,
     }
 }
 
+namespace{
+
+// elements handled by one parallel_for chunk.
+constexpr int binary_grain = 1 << 14;
+
+template <class T>
+void squared_difference_gradient_impl(const int size,
+                                      const T *x1_ptr,
+                                      const T *x2_ptr,
+                                      const T *dy_ptr,
+                                      T *dx1_ptr,
+                                      T *dx2_ptr){
+    parallel_for(0, size, binary_grain, [=](int from, int to){
+        for(int n = from; n < to; ++n){
+            const T d = T(2) * (x1_ptr[n] - x2_ptr[n]) * dy_ptr[n];
+            dx1_ptr[n] = d;
+            dx2_ptr[n] = -d;
+        }
+    });
+}
+
+template <class T>
+void elementwise_mul_gradient_impl(const int size,
+                                   const T *x1_ptr,
+                                   const T *x2_ptr,
+                                   const T *dy_ptr,
+                                   T *dx1_ptr,
+                                   T *dx2_ptr){
+    parallel_for(0, size, binary_grain, [=](int from, int to){
+        for(int n = from; n < to; ++n){
+            const T dy = dy_ptr[n];
+            const T x1 = x1_ptr[n];
+            dx1_ptr[n] = dy * x2_ptr[n];
+            dx2_ptr[n] = dy * x1;
+        }
+    });
+}
+
+template <class T>
+void elementwise_div_gradient_impl(const int size,
+                                   const T *x2_ptr,
+                                   const T *y_ptr,
+                                   const T *dy_ptr,
+                                   T *dx1_ptr,
+                                   T *dx2_ptr){
+    parallel_for(0, size, binary_grain, [=](int from, int to){
+        for(int n = from; n < to; ++n){
+            const T d = dy_ptr[n] / x2_ptr[n];
+            const T y = y_ptr[n];
+            dx1_ptr[n] = d;
+            dx2_ptr[n] = -d * y;
+        }
+    });
+}
+
+} // end anonymous namespace
+
+#define DEFINE_BINARY_GRADIENT(Name, A, B, T)                            \
+template <>                                                              \
+void Name<T, CPUContext>(const int size,                                 \
+                         const T *A, const T *B, const T *dy_ptr,        \
+                         T *dx1_ptr, T *dx2_ptr){                        \
+    Name##_impl(size, A, B, dy_ptr, dx1_ptr, dx2_ptr);                   \
+}
+
+DEFINE_BINARY_GRADIENT(squared_difference_gradient, x1_ptr, x2_ptr, float)
+DEFINE_BINARY_GRADIENT(squared_difference_gradient, x1_ptr, x2_ptr, double)
+DEFINE_BINARY_GRADIENT(elementwise_mul_gradient, x1_ptr, x2_ptr, float)
+DEFINE_BINARY_GRADIENT(elementwise_mul_gradient, x1_ptr, x2_ptr, double)
+DEFINE_BINARY_GRADIENT(elementwise_div_gradient, x2_ptr, y_ptr, float)
+DEFINE_BINARY_GRADIENT(elementwise_div_gradient, x2_ptr, y_ptr, double)
+
+#undef DEFINE_BINARY_GRADIENT
+
 template <>
 void rowwise_max<float, CPUContext>(const int m,
                                     const int n,
@@ -80,8 +157,9 @@ void exp<float, CPUContext>(const int size,
                             float *y_ptr
                            )
 {
-    Eigen::Map<Eigen::VectorXf>(y_ptr, size) =
-    Eigen::Map<const Eigen::VectorXf>(x_ptr, size).array().exp();
+    for(int n = 0; n < size; ++n){
+        y_ptr[n] = fast::exp(x_ptr[n]);
+    }
 }
 
 template<>
@@ -187,5 +265,152 @@ void set<double, CPUContext>(const int size,
     Eigen::Map<Eigen::VectorXd>(x_ptr, size).setConstant(val);
 }
 
+namespace {
+
+template <class T>
+void scale_uint8_impl(const int size,
+                      const T alpha,
+                      const type::uint8::T *x_ptr,
+                      T *y_ptr
+                     ){
+    // uint8 may alias y, so the bytes of a block are loaded first,
+    // which lets both loops vectorize without a runtime alias check.
+    constexpr int block = 16;
+    int n = 0;
+    for(; n + block <= size; n += block){
+        type::uint8::T x[block];
+        for(int k = 0; k < block; ++k){
+            x[k] = x_ptr[n + k];
+        }
+        for(int k = 0; k < block; ++k){
+            y_ptr[n + k] = alpha * T(x[k]);
+        }
+    }
+    for(; n < size; ++n){
+        y_ptr[n] = alpha * T(x_ptr[n]);
+    }
+}
+
+template <class T>
+void affine_uint8(const int size,
+                  const T alpha,
+                  const T beta,
+                  const type::uint8::T *x_ptr,
+                  T *y_ptr
+                 ){
+    constexpr int block = 16;
+    int n = 0;
+    for(; n + block <= size; n += block){
+        type::uint8::T x[block];
+        for(int k = 0; k < block; ++k){
+            x[k] = x_ptr[n + k];
+        }
+        for(int k = 0; k < block; ++k){
+            y_ptr[n + k] = alpha * T(x[k]) + beta;
+        }
+    }
+    for(; n < size; ++n){
+        y_ptr[n] = alpha * T(x_ptr[n]) + beta;
+    }
+}
+
+template <class T>
+void normalize_uint8_impl(const int size,
+                          const int channels,
+                          const int inner,
+                          const T *alpha,
+                          const T *beta,
+                          const type::uint8::T *x_ptr,
+                          T *y_ptr
+                         ){
+    // a channel run of 16 or more elements is one affine pass.
+    if(inner >= 16){
+        for(int n = 0, c = 0; n < size; n += inner, c = (c + 1) % channels){
+            affine_uint8(std::min(inner, size - n), alpha[c], beta[c],
+                         x_ptr + n, y_ptr + n);
+        }
+        return;
+    }
+    // otherwise the coefficients are tiled over a block that is a
+    // multiple of the period and of 16, so the block loop vectorizes.
+    constexpr int max_block = 256;
+    const int period = channels * inner;
+    int block = period;
+    while(block % 16 != 0 || block < 64){
+        block += period;
+    }
+    if(block > max_block){
+        for(int n = 0; n < size; ++n){
+            const int c = (n / inner) % channels;
+            y_ptr[n] = alpha[c] * T(x_ptr[n]) + beta[c];
+        }
+        return;
+    }
+    T a[max_block], b[max_block];
+    for(int k = 0; k < block; ++k){
+        a[k] = alpha[(k / inner) % channels];
+        b[k] = beta[(k / inner) % channels];
+    }
+    int n = 0;
+    for(; n + block <= size; n += block){
+        for(int k = 0; k < block; k += 16){
+            type::uint8::T x[16];
+            for(int j = 0; j < 16; ++j){
+                x[j] = x_ptr[n + k + j];
+            }
+            for(int j = 0; j < 16; ++j){
+                y_ptr[n + k + j] = a[k + j] * T(x[j]) + b[k + j];
+            }
+        }
+    }
+    for(int k = 0; n < size; ++n, ++k){
+        y_ptr[n] = a[k] * T(x_ptr[n]) + b[k];
+    }
+}
+
+} // end anonymous namespace
+
+template <>
+void normalize_uint8<float, CPUContext>(const int size,
+                                        const int channels,
+                                        const int inner,
+                                        const float *alpha,
+                                        const float *beta,
+                                        const type::uint8::T *x_ptr,
+                                        float *y_ptr
+                                       ){
+    normalize_uint8_impl(size, channels, inner, alpha, beta, x_ptr, y_ptr);
+}
+
+template <>
+void normalize_uint8<double, CPUContext>(const int size,
+                                         const int channels,
+                                         const int inner,
+                                         const double *alpha,
+                                         const double *beta,
+                                         const type::uint8::T *x_ptr,
+                                         double *y_ptr
+                                        ){
+    normalize_uint8_impl(size, channels, inner, alpha, beta, x_ptr, y_ptr);
+}
+
+template <>
+void scale_uint8<float, CPUContext>(const int size,
+                                    const float alpha,
+                                    const type::uint8::T *x_ptr,
+                                    float *y_ptr
+                                   ){
+    scale_uint8_impl(size, alpha, x_ptr, y_ptr);
+}
+
+template <>
+void scale_uint8<double, CPUContext>(const int size,
+                                     const double alpha,
+                                     const type::uint8::T *x_ptr,
+                                     double *y_ptr
+                                    ){
+    scale_uint8_impl(size, alpha, x_ptr, y_ptr);
+}
+
 } // end namespace math
 } // end namespace mlfe
@@ -52,6 +52,68 @@ void squared_difference<double, CUDAContext>(const int size,
         CUDA_CONTEXT_NUM_THREADS>>>(size, x1_ptr, x2_ptr, y_ptr);
 }
 
+template <class T> __global__
+void squared_difference_gradient_kernel(const int size,
+                                        const T *x1_ptr,
+                                        const T *x2_ptr,
+                                        const T *dy_ptr,
+                                        T *dx1_ptr,
+                                        T *dx2_ptr){
+    CUDA_1D_KERNEL_LOOP(n, size){
+        const T d = T(2) * (x1_ptr[n] - x2_ptr[n]) * dy_ptr[n];
+        dx1_ptr[n] = d;
+        dx2_ptr[n] = -d;
+    }
+}
+
+template <class T> __global__
+void elementwise_mul_gradient_kernel(const int size,
+                                     const T *x1_ptr,
+                                     const T *x2_ptr,
+                                     const T *dy_ptr,
+                                     T *dx1_ptr,
+                                     T *dx2_ptr){
+    CUDA_1D_KERNEL_LOOP(n, size){
+        const T dy = dy_ptr[n];
+        const T x1 = x1_ptr[n];
+        dx1_ptr[n] = dy * x2_ptr[n];
+        dx2_ptr[n] = dy * x1;
+    }
+}
+
+template <class T> __global__
+void elementwise_div_gradient_kernel(const int size,
+                                     const T *x2_ptr,
+                                     const T *y_ptr,
+                                     const T *dy_ptr,
+                                     T *dx1_ptr,
+                                     T *dx2_ptr){
+    CUDA_1D_KERNEL_LOOP(n, size){
+        const T d = dy_ptr[n] / x2_ptr[n];
+        const T y = y_ptr[n];
+        dx1_ptr[n] = d;
+        dx2_ptr[n] = -d * y;
+    }
+}
+
+#define DEFINE_BINARY_GRADIENT(Name, A, B, T)                            \
+template <>                                                              \
+void Name<T, CUDAContext>(const int size,                                \
+                          const T *A, const T *B, const T *dy_ptr,       \
+                          T *dx1_ptr, T *dx2_ptr){                       \
+    Name##_kernel<<<CUDA_CONTEXT_GET_BLOCKS(size),                       \
+        CUDA_CONTEXT_NUM_THREADS>>>(size, A, B, dy_ptr, dx1_ptr, dx2_ptr); \
+}
+
+DEFINE_BINARY_GRADIENT(squared_difference_gradient, x1_ptr, x2_ptr, float)
+DEFINE_BINARY_GRADIENT(squared_difference_gradient, x1_ptr, x2_ptr, double)
+DEFINE_BINARY_GRADIENT(elementwise_mul_gradient, x1_ptr, x2_ptr, float)
+DEFINE_BINARY_GRADIENT(elementwise_mul_gradient, x1_ptr, x2_ptr, double)
+DEFINE_BINARY_GRADIENT(elementwise_div_gradient, x2_ptr, y_ptr, float)
+DEFINE_BINARY_GRADIENT(elementwise_div_gradient, x2_ptr, y_ptr, double)
+
+#undef DEFINE_BINARY_GRADIENT
+
 template <class DataType> __global__
 void rowwise_max_kernel(const int rows,
                         const int cols,
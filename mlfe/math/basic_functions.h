@@ -1,5 +1,6 @@
 #ifndef __MATH_BASIC_FUNCTIONS_H__
 #define __MATH_BASIC_FUNCTIONS_H__
+#include "../utils/types.h"
 
 namespace mlfe{
 namespace math{
@@ -15,6 +16,34 @@ void squared_difference(const int size,
                         const T *x2_ptr,
                         T *y_ptr);
 
+// the fused gradients of the binary ops, both inputs in one pass.
+// dx1 = 2 * (x1 - x2) * dy, dx2 = -dx1.
+template <class T, class Dev>
+void squared_difference_gradient(const int size,
+                                 const T *x1_ptr,
+                                 const T *x2_ptr,
+                                 const T *dy_ptr,
+                                 T *dx1_ptr,
+                                 T *dx2_ptr);
+
+// dx1 = dy * x2, dx2 = dy * x1.
+template <class T, class Dev>
+void elementwise_mul_gradient(const int size,
+                              const T *x1_ptr,
+                              const T *x2_ptr,
+                              const T *dy_ptr,
+                              T *dx1_ptr,
+                              T *dx2_ptr);
+
+// dx1 = dy / x2, dx2 = -dx1 * y, y = x1 / x2.
+template <class T, class Dev>
+void elementwise_div_gradient(const int size,
+                              const T *x2_ptr,
+                              const T *y_ptr,
+                              const T *dy_ptr,
+                              T *dx1_ptr,
+                              T *dx2_ptr);
+
 template <class T, class Dev>
 void rowwise_max(const int m,
                  const int n,
@@ -88,6 +117,26 @@ void bernoulli_distribution(const int size,
                             T *bernoulli
                            );
 
+// y = alpha * x, with x widened from uint8 in the same pass.
+template <class T, class Dev>
+void scale_uint8(const int size,
+                 const T alpha,
+                 const type::uint8::T *x_ptr,
+                 T *y_ptr
+                );
+
+// y[i] = alpha[c] * x[i] + beta[c], with c = (i / inner) % channels.
+// inner is h * w for nchw images and 1 for nhwc images.
+template <class T, class Dev>
+void normalize_uint8(const int size,
+                     const int channels,
+                     const int inner,
+                     const T *alpha,
+                     const T *beta,
+                     const type::uint8::T *x_ptr,
+                     T *y_ptr
+                    );
+
 #define DECLARE_CUDA_BINARY_OP(OpName)    \
 template <typename T>                     \
 void OpName##Cuda(const int size,         \
@@ -0,0 +1,561 @@
+#include "broadcast.h"
+#include "../device_context/cpu_context.h"
+#include "../utils/parallel_for.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace mlfe{ namespace math{
+namespace {
+
+// a shape collapsed to as few dimensions as possible, with the strides
+// of up to two operands, which are 0 where an operand is broadcast.
+// the last dimension is contiguous or broadcast in every operand.
+struct Layout{
+    std::vector<int> dims;
+    std::vector<int> strides[2];
+    int num_operands;
+};
+
+std::string shape_string(const std::vector<int> &shape){
+    std::string s = "[";
+    for(int n = 0; n < shape.size(); ++n){
+        s += (n > 0 ? ", " : "") + std::to_string(shape[n]);
+    }
+    return s + "]";
+}
+
+// the strides of x broadcast to y, 0 along the repeated dimensions.
+std::vector<int> broadcast_strides(const std::vector<int> &x,
+                                   const std::vector<int> &y
+                                  ){
+    const int offset = int(y.size()) - int(x.size());
+    std::vector<int> strides(y.size(), 0);
+    int stride = 1;
+    for(int d = int(y.size()) - 1; d >= 0; --d){
+        const int xd = d >= offset ? x[d - offset] : 1;
+        if(offset < 0 || (xd != 1 && xd != y[d])){
+            throw std::string("can not broadcast ") + shape_string(x) +
+                " to " + shape_string(y) + ".";
+        }
+        strides[d] = xd == 1 ? 0 : stride;
+        stride *= xd;
+    }
+    return strides;
+}
+
+// merges neighboring dimensions of y that every operand walks through
+// with the same step, and drops the dimensions of 1.
+Layout collapse(const std::vector<int> &y,
+                const std::vector<const std::vector<int> *> &xs
+               ){
+    Layout layout;
+    layout.num_operands = xs.size();
+    std::vector<int> strides[2];
+    for(int k = 0; k < xs.size(); ++k){
+        strides[k] = broadcast_strides(*xs[k], y);
+    }
+    for(int d = 0; d < y.size(); ++d){
+        if(y[d] == 1){
+            continue;
+        }
+        bool merge = !layout.dims.empty();
+        for(int k = 0; k < xs.size(); ++k){
+            merge = merge && layout.strides[k].back() == strides[k][d] * y[d];
+        }
+        if(merge){
+            layout.dims.back() *= y[d];
+            for(int k = 0; k < xs.size(); ++k){
+                layout.strides[k].back() = strides[k][d];
+            }
+        }
+        else{
+            layout.dims.push_back(y[d]);
+            for(int k = 0; k < xs.size(); ++k){
+                layout.strides[k].push_back(strides[k][d]);
+            }
+        }
+    }
+    if(layout.dims.empty()){
+        layout.dims.push_back(1);
+        for(int k = 0; k < xs.size(); ++k){
+            layout.strides[k].push_back(0);
+        }
+    }
+    return layout;
+}
+
+int shape_size(const std::vector<int> &shape){
+    int size = 1;
+    for(auto d : shape){
+        size *= d;
+    }
+    return size;
+}
+
+// walks the rows of a layout, a row is the last dimension, and keeps
+// the offset of every operand at the start of the row.
+class RowCursor{
+public:
+    RowCursor(const Layout &layout, int row)
+        : _layout(layout), _index(layout.dims.size() - 1, 0){
+        _offset[0] = _offset[1] = 0;
+        for(int d = int(_index.size()) - 1; d >= 0; --d){
+            _index[d] = row % layout.dims[d];
+            row /= layout.dims[d];
+            for(int k = 0; k < layout.num_operands; ++k){
+                _offset[k] += _index[d] * layout.strides[k][d];
+            }
+        }
+    }
+
+    int Offset(int k) const{ return _offset[k]; }
+
+    void Next(){
+        for(int d = int(_index.size()) - 1; d >= 0; --d){
+            for(int k = 0; k < _layout.num_operands; ++k){
+                _offset[k] += _layout.strides[k][d];
+            }
+            if(++_index[d] < _layout.dims[d]){
+                return;
+            }
+            for(int k = 0; k < _layout.num_operands; ++k){
+                _offset[k] -= _layout.strides[k][d] * _layout.dims[d];
+            }
+            _index[d] = 0;
+        }
+    }
+
+private:
+    const Layout &_layout;
+    std::vector<int> _index;
+    int _offset[2];
+};
+
+// rows handled by one parallel_for chunk, about 16k elements.
+inline int row_grain(const int row_size){
+    return std::max(1, (1 << 14) / std::max(row_size, 1));
+}
+
+struct FirstOp{
+    template <class T>
+    T operator()(const T a, const T) const{ return a; }
+};
+
+struct AddOp{
+    template <class T>
+    T operator()(const T a, const T b) const{ return a + b; }
+};
+
+struct SubOp{
+    template <class T>
+    T operator()(const T a, const T b) const{ return a - b; }
+};
+
+struct MulOp{
+    template <class T>
+    T operator()(const T a, const T b) const{ return a * b; }
+};
+
+struct DivOp{
+    template <class T>
+    T operator()(const T a, const T b) const{ return a / b; }
+};
+
+template <class T, class Op>
+void broadcast_binary(const std::vector<int> &x1_shape, const T *x1,
+                      const std::vector<int> &x2_shape, const T *x2,
+                      const std::vector<int> &y_shape, T *y,
+                      const Op op
+                     ){
+    const int size = shape_size(y_shape);
+    const Layout layout = collapse(y_shape, {&x1_shape, &x2_shape});
+    if(size == 0){
+        return;
+    }
+    const int inner = layout.dims.back();
+    const bool step1 = layout.strides[0].back() != 0;
+    const bool step2 = layout.strides[1].back() != 0;
+    parallel_for(0, size / inner, row_grain(inner), [&](int from, int to){
+        RowCursor cursor(layout, from);
+        for(int r = from; r < to; ++r, cursor.Next()){
+            const T *a = x1 + cursor.Offset(0);
+            const T *b = x2 + cursor.Offset(1);
+            T *c = y + r * inner;
+            if(step1 && step2){
+                for(int i = 0; i < inner; ++i){
+                    c[i] = op(a[i], b[i]);
+                }
+            }
+            else if(step1){
+                const T bv = b[0];
+                for(int i = 0; i < inner; ++i){
+                    c[i] = op(a[i], bv);
+                }
+            }
+            else if(step2){
+                const T av = a[0];
+                for(int i = 0; i < inner; ++i){
+                    c[i] = op(av, b[i]);
+                }
+            }
+            else{
+                std::fill(c, c + inner, op(a[0], b[0]));
+            }
+        }
+    });
+}
+
+struct SumReducer{
+    template <class T>
+    static T apply(const T a, const T b){ return a + b; }
+
+    template <class T>
+    static T empty(){ return T(0); }
+};
+
+struct MaxReducer{
+    template <class T>
+    static T apply(const T a, const T b){ return a < b ? b : a; }
+
+    template <class T>
+    static T empty(){ return std::numeric_limits<T>::lowest(); }
+};
+
+// reduces n > 0 contiguous values. the range is halved down to blocks of
+// 128, so the rounding error grows with log(n) rather than n, and a block
+// runs on 8 independent chains the cpu can overlap.
+template <class R, class T>
+T reduce_contiguous(const T *x, const int n){
+    constexpr int leaf = 128;
+    constexpr int chains = 8;
+    if(n > leaf){
+        const int half = n / 2;
+        return R::apply(reduce_contiguous<R>(x, half),
+                        reduce_contiguous<R>(x + half, n - half));
+    }
+    if(n < chains){
+        T acc = x[0];
+        for(int i = 1; i < n; ++i){
+            acc = R::apply(acc, x[i]);
+        }
+        return acc;
+    }
+    T acc[chains];
+    std::copy(x, x + chains, acc);
+    int i = chains;
+    for(; i + chains <= n; i += chains){
+        for(int k = 0; k < chains; ++k){
+            acc[k] = R::apply(acc[k], x[i + k]);
+        }
+    }
+    for(int k = 0; i < n; ++i, ++k){
+        acc[k] = R::apply(acc[k], x[i]);
+    }
+    for(int width = chains / 2; width > 0; width /= 2){
+        for(int k = 0; k < width; ++k){
+            acc[k] = R::apply(acc[k], acc[k + width]);
+        }
+    }
+    return acc[0];
+}
+
+// out = the reduction of the rows [lo, hi) of width w, which start at
+// x + offsets[r]. pairwise over the rows, tmp holds one row per level.
+template <class R, class T>
+void reduce_rows(const T *x, const int *offsets, const int lo, const int hi,
+                 const int w, T *out, T *tmp
+                ){
+    constexpr int leaf = 8;
+    if(hi - lo > leaf){
+        const int mid = lo + (hi - lo) / 2;
+        reduce_rows<R>(x, offsets, lo, mid, w, out, tmp + w);
+        reduce_rows<R>(x, offsets, mid, hi, w, tmp, tmp + w);
+        for(int i = 0; i < w; ++i){
+            out[i] = R::apply(out[i], tmp[i]);
+        }
+        return;
+    }
+    std::copy(x + offsets[lo], x + offsets[lo] + w, out);
+    for(int r = lo + 1; r < hi; ++r){
+        const T *in = x + offsets[r];
+        for(int i = 0; i < w; ++i){
+            out[i] = R::apply(out[i], in[i]);
+        }
+    }
+}
+
+// the reduction of the rows [lo, hi), each row of n contiguous values
+// reduced to one first.
+template <class R, class T>
+T reduce_row_values(const T *x, const int *offsets,
+                    const int lo, const int hi, const int n
+                   ){
+    constexpr int leaf = 8;
+    if(hi - lo > leaf){
+        const int mid = lo + (hi - lo) / 2;
+        return R::apply(reduce_row_values<R>(x, offsets, lo, mid, n),
+                        reduce_row_values<R>(x, offsets, mid, hi, n));
+    }
+    T acc = reduce_contiguous<R>(x + offsets[lo], n);
+    for(int r = lo + 1; r < hi; ++r){
+        acc = R::apply(acc, reduce_contiguous<R>(x + offsets[r], n));
+    }
+    return acc;
+}
+
+// y = x reduced over the dimensions that broadcasting y_shape to x_shape
+// repeats. y splits into blocks of the kept dimensions. a block reduces
+// rows of the reduced dimensions, which are rows of x when the last
+// dimension is kept, and single values of a contiguous run otherwise.
+// when there are few blocks for the threads, the rows of a block are split
+// into parts that are reduced apart and then pairwise. the parts depend
+// only on the shapes, so the result does not change with the threads.
+template <class R, class T>
+void reduce_to(const std::vector<int> &x_shape, const T *x,
+               const std::vector<int> &y_shape, T *y
+              ){
+    const int x_size = shape_size(x_shape);
+    const int y_size = shape_size(y_shape);
+    const Layout layout = collapse(x_shape, {&y_shape});
+    if(x_size == 0){
+        std::fill(y, y + y_size, R::template empty<T>());
+        return;
+    }
+    // x is contiguous, y walks only the kept dimensions.
+    const int num_dims = layout.dims.size();
+    std::vector<int> x_strides(num_dims);
+    for(int d = num_dims - 1, s = 1; d >= 0; --d){
+        x_strides[d] = s;
+        s *= layout.dims[d];
+    }
+    // the outer dimensions split into the kept and the reduced ones.
+    Layout kept, reduced;
+    kept.num_operands = reduced.num_operands = 2;
+    for(int d = 0; d < num_dims - 1; ++d){
+        Layout &part = layout.strides[0][d] != 0 ? kept : reduced;
+        part.dims.push_back(layout.dims[d]);
+        part.strides[0].push_back(layout.strides[0][d]);
+        part.strides[1].push_back(x_strides[d]);
+    }
+    // the cursors walk rows, so the row is a dimension of 1.
+    for(Layout *part : {&kept, &reduced}){
+        part->dims.push_back(1);
+        part->strides[0].push_back(0);
+        part->strides[1].push_back(0);
+    }
+    const int inner = layout.dims.back();
+    const bool inner_kept = layout.strides[0].back() != 0;
+    const int num_blocks = shape_size(kept.dims);
+    const int num_rows = shape_size(reduced.dims);
+    const int width = inner_kept ? inner : 1;
+    std::vector<int> offsets(num_rows);
+    RowCursor row(reduced, 0);
+    for(int r = 0; r < num_rows; ++r, row.Next()){
+        offsets[r] = row.Offset(1);
+    }
+    // a block of one contiguous run is split along the run.
+    const bool split_run = !inner_kept && num_rows == 1;
+    constexpr int part_grain = 1 << 15;
+    const int block_size = x_size / num_blocks;
+    int num_parts = 1;
+    if(num_blocks < 64 && block_size >= 2 * part_grain){
+        num_parts = std::min(64, block_size / part_grain);
+        num_parts = std::min(num_parts, split_run ? inner : num_rows);
+    }
+    std::vector<T> partials(num_parts > 1 ? num_blocks * num_parts * width : 0);
+    const int depth = 2 + int(std::log2(std::max(num_rows, 1)));
+    const int grain = num_parts > 1 ? 1 : row_grain(block_size);
+    parallel_for(0, num_blocks * num_parts, grain, [&](int from, int to){
+        std::vector<T> tmp(inner_kept ? depth * width : 0);
+        int b = from / num_parts;
+        RowCursor block(kept, b);
+        for(int t = from; t < to; ++t){
+            if(t / num_parts != b){
+                b = t / num_parts;
+                block.Next();
+            }
+            const int p = t % num_parts;
+            const T *base = x + block.Offset(1);
+            T *out = num_parts > 1 ? partials.data() + t * width :
+                                     y + block.Offset(0);
+            if(split_run){
+                const int lo = int(int64_t(inner) * p / num_parts);
+                const int hi = int(int64_t(inner) * (p + 1) / num_parts);
+                out[0] = reduce_contiguous<R>(base + lo, hi - lo);
+                continue;
+            }
+            const int lo = int(int64_t(num_rows) * p / num_parts);
+            const int hi = int(int64_t(num_rows) * (p + 1) / num_parts);
+            if(inner_kept){
+                reduce_rows<R>(base, offsets.data(), lo, hi, width,
+                               out, tmp.data());
+            }
+            else{
+                out[0] = reduce_row_values<R>(base, offsets.data(),
+                                              lo, hi, inner);
+            }
+        }
+    });
+    if(num_parts == 1){
+        return;
+    }
+    RowCursor block(kept, 0);
+    for(int b = 0; b < num_blocks; ++b, block.Next()){
+        T *parts = partials.data() + b * num_parts * width;
+        for(int step = 1; step < num_parts; step *= 2){
+            for(int p = 0; p + step < num_parts; p += 2 * step){
+                T *a = parts + p * width;
+                const T *c = parts + (p + step) * width;
+                for(int i = 0; i < width; ++i){
+                    a[i] = R::apply(a[i], c[i]);
+                }
+            }
+        }
+        std::copy(parts, parts + width, y + block.Offset(0));
+    }
+}
+
+// dx = dy where x equals the max y it was reduced to, 0 elsewhere.
+template <class T>
+void reduce_max_grad_impl(const std::vector<int> &x_shape, const T *x,
+                          const std::vector<int> &y_shape, const T *y,
+                          const T *dy, T *dx
+                         ){
+    const int size = shape_size(x_shape);
+    const Layout layout = collapse(x_shape, {&y_shape});
+    if(size == 0){
+        return;
+    }
+    const int inner = layout.dims.back();
+    const int step = layout.strides[0].back() != 0 ? 1 : 0;
+    parallel_for(0, size / inner, row_grain(inner), [&](int from, int to){
+        RowCursor cursor(layout, from);
+        for(int r = from; r < to; ++r, cursor.Next()){
+            const T *a = x + r * inner;
+            const T *m = y + cursor.Offset(0);
+            const T *g = dy + cursor.Offset(0);
+            T *c = dx + r * inner;
+            for(int i = 0; i < inner; ++i){
+                c[i] = a[i] == m[i * step] ? g[i * step] : T(0);
+            }
+        }
+    });
+}
+
+} // end anonymous namespace
+
+std::vector<int> broadcast_shape(const std::vector<int> &a,
+                                 const std::vector<int> &b
+                                ){
+    const int rank = std::max(a.size(), b.size());
+    std::vector<int> shape(rank);
+    for(int d = 0; d < rank; ++d){
+        const int ad = d < rank - int(a.size()) ? 1 : a[d - rank + a.size()];
+        const int bd = d < rank - int(b.size()) ? 1 : b[d - rank + b.size()];
+        if(ad != bd && ad != 1 && bd != 1){
+            throw std::string("can not broadcast ") + shape_string(a) +
+                " and " + shape_string(b) + ".";
+        }
+        shape[d] = ad == 1 ? bd : ad;
+    }
+    return shape;
+}
+
+std::vector<int> reduced_shape(const std::vector<int> &shape,
+                               const std::vector<int> &axes
+                              ){
+    const int rank = shape.size();
+    std::vector<int> reduced(rank, 1);
+    if(axes.empty()){
+        return reduced;
+    }
+    reduced = shape;
+    for(auto axis : axes){
+        if(axis < -rank || axis >= rank){
+            throw std::string("axis ") + std::to_string(axis) +
+                " is out of range of " + shape_string(shape) + ".";
+        }
+        reduced[axis < 0 ? axis + rank : axis] = 1;
+    }
+    return reduced;
+}
+
+#define DEFINE_BROADCAST_BINARY(Name, Op, T)                             \
+template <>                                                              \
+void broadcast_##Name<T, CPUContext>(                                    \
+    const std::vector<int> &x1_shape, const T *x1,                       \
+    const std::vector<int> &x2_shape, const T *x2,                       \
+    const std::vector<int> &y_shape, T *y){                              \
+    broadcast_binary(x1_shape, x1, x2_shape, x2, y_shape, y, Op());      \
+}
+
+DEFINE_BROADCAST_BINARY(add, AddOp, float)
+DEFINE_BROADCAST_BINARY(add, AddOp, double)
+DEFINE_BROADCAST_BINARY(sub, SubOp, float)
+DEFINE_BROADCAST_BINARY(sub, SubOp, double)
+DEFINE_BROADCAST_BINARY(mul, MulOp, float)
+DEFINE_BROADCAST_BINARY(mul, MulOp, double)
+DEFINE_BROADCAST_BINARY(div, DivOp, float)
+DEFINE_BROADCAST_BINARY(div, DivOp, double)
+
+#undef DEFINE_BROADCAST_BINARY
+
+template <>
+void broadcast_to<float, CPUContext>(const std::vector<int> &x_shape,
+                                     const float *x,
+                                     const std::vector<int> &y_shape,
+                                     float *y
+                                    ){
+    broadcast_binary(x_shape, x, x_shape, x, y_shape, y, FirstOp());
+}
+
+template <>
+void broadcast_to<double, CPUContext>(const std::vector<int> &x_shape,
+                                      const double *x,
+                                      const std::vector<int> &y_shape,
+                                      double *y
+                                     ){
+    broadcast_binary(x_shape, x, x_shape, x, y_shape, y, FirstOp());
+}
+
+#define DEFINE_REDUCE_TO(Name, Reducer, T)                               \
+template <>                                                              \
+void Name<T, CPUContext>(const std::vector<int> &x_shape, const T *x,    \
+                         const std::vector<int> &y_shape, T *y){         \
+    reduce_to<Reducer>(x_shape, x, y_shape, y);                          \
+}
+
+DEFINE_REDUCE_TO(reduce_sum_to, SumReducer, float)
+DEFINE_REDUCE_TO(reduce_sum_to, SumReducer, double)
+DEFINE_REDUCE_TO(reduce_max_to, MaxReducer, float)
+DEFINE_REDUCE_TO(reduce_max_to, MaxReducer, double)
+
+#undef DEFINE_REDUCE_TO
+
+template <>
+void reduce_max_grad<float, CPUContext>(const std::vector<int> &x_shape,
+                                        const float *x,
+                                        const std::vector<int> &y_shape,
+                                        const float *y,
+                                        const float *dy,
+                                        float *dx
+                                       ){
+    reduce_max_grad_impl(x_shape, x, y_shape, y, dy, dx);
+}
+
+template <>
+void reduce_max_grad<double, CPUContext>(const std::vector<int> &x_shape,
+                                         const double *x,
+                                         const std::vector<int> &y_shape,
+                                         const double *y,
+                                         const double *dy,
+                                         double *dx
+                                        ){
+    reduce_max_grad_impl(x_shape, x, y_shape, y, dy, dx);
+}
+
+} // end namespace math
+} // end namespace mlfe
@@ -0,0 +1,251 @@
+#include "broadcast.h"
+#include "../device_context/cuda_context.h"
+#include <string>
+
+namespace mlfe{ namespace math{
+namespace {
+
+constexpr int max_dims = 8;
+
+// the dimensions of y and the strides of up to two operands broadcast to
+// it, 0 along the repeated dimensions. passed to the kernels by value.
+struct BroadcastIndex{
+    int num_dims;
+    int dims[max_dims];
+    int strides[2][max_dims];
+};
+
+BroadcastIndex make_index(const std::vector<int> &y,
+                          const std::vector<const std::vector<int> *> &xs
+                         ){
+    if(y.size() > max_dims){
+        throw std::string("broadcast: too many dimensions for cuda.");
+    }
+    BroadcastIndex index;
+    index.num_dims = y.size();
+    for(int k = 0; k < xs.size(); ++k){
+        const std::vector<int> &x = *xs[k];
+        if(broadcast_shape(x, y) != y){
+            throw std::string("broadcast: the shapes do not broadcast.");
+        }
+        const int offset = int(y.size()) - int(x.size());
+        int stride = 1;
+        for(int d = int(y.size()) - 1; d >= 0; --d){
+            const int xd = d >= offset ? x[d - offset] : 1;
+            index.strides[k][d] = xd == 1 ? 0 : stride;
+            stride *= xd;
+        }
+    }
+    for(int d = 0; d < y.size(); ++d){
+        index.dims[d] = y[d];
+    }
+    return index;
+}
+
+// the dimensions of x which reduce_sum_to keeps and those it sums, with
+// the strides of x along them.
+struct ReduceIndex{
+    int num_kept;
+    int kept_dims[max_dims];
+    int kept_strides[max_dims];
+    int num_reduced;
+    int reduced_dims[max_dims];
+    int reduced_strides[max_dims];
+    int reduced_size;
+};
+
+ReduceIndex make_reduce_index(const std::vector<int> &x,
+                              const std::vector<int> &y
+                             ){
+    if(x.size() > max_dims){
+        throw std::string("broadcast: too many dimensions for cuda.");
+    }
+    if(broadcast_shape(y, x) != x){
+        throw std::string("broadcast: the shapes do not broadcast.");
+    }
+    ReduceIndex index;
+    index.num_kept = 0;
+    index.num_reduced = 0;
+    index.reduced_size = 1;
+    const int offset = int(x.size()) - int(y.size());
+    int stride = 1;
+    std::vector<int> strides(x.size());
+    for(int d = int(x.size()) - 1; d >= 0; --d){
+        strides[d] = stride;
+        stride *= x[d];
+    }
+    for(int d = 0; d < x.size(); ++d){
+        const int yd = d >= offset ? y[d - offset] : 1;
+        if(yd == 1 && x[d] != 1){
+            index.reduced_dims[index.num_reduced] = x[d];
+            index.reduced_strides[index.num_reduced] = strides[d];
+            index.num_reduced += 1;
+            index.reduced_size *= x[d];
+        }
+        else{
+            index.kept_dims[index.num_kept] = x[d];
+            index.kept_strides[index.num_kept] = strides[d];
+            index.num_kept += 1;
+        }
+    }
+    return index;
+}
+
+int shape_size(const std::vector<int> &shape){
+    int size = 1;
+    for(auto d : shape){
+        size *= d;
+    }
+    return size;
+}
+
+// the offset in operand k of the element n of y.
+__device__ int operand_offset(const BroadcastIndex &index, int k, int n){
+    int offset = 0;
+    for(int d = index.num_dims - 1; d >= 0; --d){
+        offset += (n % index.dims[d]) * index.strides[k][d];
+        n /= index.dims[d];
+    }
+    return offset;
+}
+
+struct AddOp{
+    template <class T>
+    __device__ T operator()(const T a, const T b) const{ return a + b; }
+};
+
+struct SubOp{
+    template <class T>
+    __device__ T operator()(const T a, const T b) const{ return a - b; }
+};
+
+struct MulOp{
+    template <class T>
+    __device__ T operator()(const T a, const T b) const{ return a * b; }
+};
+
+struct DivOp{
+    template <class T>
+    __device__ T operator()(const T a, const T b) const{ return a / b; }
+};
+
+template <class T, class Op> __global__
+void broadcast_binary_kernel(const int size, const BroadcastIndex index,
+                             const T *x1, const T *x2, T *y, const Op op){
+    CUDA_1D_KERNEL_LOOP(n, size){
+        y[n] = op(x1[operand_offset(index, 0, n)],
+                  x2[operand_offset(index, 1, n)]);
+    }
+}
+
+template <class T> __global__
+void broadcast_to_kernel(const int size, const BroadcastIndex index,
+                         const T *x, T *y){
+    CUDA_1D_KERNEL_LOOP(n, size){
+        y[n] = x[operand_offset(index, 0, n)];
+    }
+}
+
+// a thread sums the elements of x of one element of y, always in the
+// same order, so the result does not change from run to run. the last
+// reduced dimension is the inner loop.
+template <class T> __global__
+void reduce_sum_to_kernel(const int size, const ReduceIndex index,
+                          const T *x, T *y){
+    CUDA_1D_KERNEL_LOOP(m, size){
+        int base = 0;
+        int n = m;
+        for(int d = index.num_kept - 1; d >= 0; --d){
+            base += (n % index.kept_dims[d]) * index.kept_strides[d];
+            n /= index.kept_dims[d];
+        }
+        T sum = 0;
+        if(index.num_reduced == 0){
+            sum = x[base];
+        }
+        else if(index.reduced_size > 0){
+            const int last = index.num_reduced - 1;
+            const int inner_dim = index.reduced_dims[last];
+            const int inner_stride = index.reduced_strides[last];
+            const int outer_size = index.reduced_size / inner_dim;
+            for(int r = 0; r < outer_size; ++r){
+                int offset = base;
+                int k = r;
+                for(int d = last - 1; d >= 0; --d){
+                    offset += (k % index.reduced_dims[d]) * index.reduced_strides[d];
+                    k /= index.reduced_dims[d];
+                }
+                for(int j = 0; j < inner_dim; ++j){
+                    sum += x[offset + j * inner_stride];
+                }
+            }
+        }
+        y[m] = sum;
+    }
+}
+
+template <class T, class Op>
+void broadcast_binary(const std::vector<int> &x1_shape, const T *x1,
+                      const std::vector<int> &x2_shape, const T *x2,
+                      const std::vector<int> &y_shape, T *y,
+                      const Op op
+                     ){
+    const int size = shape_size(y_shape);
+    const BroadcastIndex index = make_index(y_shape, {&x1_shape, &x2_shape});
+    if(size == 0){
+        return;
+    }
+    broadcast_binary_kernel<T, Op><<<CUDA_CONTEXT_GET_BLOCKS(size),
+        CUDA_CONTEXT_NUM_THREADS>>>(size, index, x1, x2, y, op);
+}
+
+} // end anonymous namespace
+
+#define DEFINE_BROADCAST_BINARY(Name, Op)                                \
+template <>                                                              \
+void broadcast_##Name<float, CUDAContext>(                               \
+    const std::vector<int> &x1_shape, const float *x1,                   \
+    const std::vector<int> &x2_shape, const float *x2,                   \
+    const std::vector<int> &y_shape, float *y){                          \
+    broadcast_binary(x1_shape, x1, x2_shape, x2, y_shape, y, Op());      \
+}
+
+DEFINE_BROADCAST_BINARY(add, AddOp)
+DEFINE_BROADCAST_BINARY(sub, SubOp)
+DEFINE_BROADCAST_BINARY(mul, MulOp)
+DEFINE_BROADCAST_BINARY(div, DivOp)
+
+#undef DEFINE_BROADCAST_BINARY
+
+template <>
+void broadcast_to<float, CUDAContext>(const std::vector<int> &x_shape,
+                                      const float *x,
+                                      const std::vector<int> &y_shape,
+                                      float *y
+                                     ){
+    const int size = shape_size(y_shape);
+    const BroadcastIndex index = make_index(y_shape, {&x_shape});
+    if(size == 0){
+        return;
+    }
+    broadcast_to_kernel<float><<<CUDA_CONTEXT_GET_BLOCKS(size),
+        CUDA_CONTEXT_NUM_THREADS>>>(size, index, x, y);
+}
+
+template <>
+void reduce_sum_to<float, CUDAContext>(const std::vector<int> &x_shape,
+                                       const float *x,
+                                       const std::vector<int> &y_shape,
+                                       float *y
+                                      ){
+    const int size = shape_size(y_shape);
+    const ReduceIndex index = make_reduce_index(x_shape, y_shape);
+    if(size == 0){
+        return;
+    }
+    reduce_sum_to_kernel<float><<<CUDA_CONTEXT_GET_BLOCKS(size),
+        CUDA_CONTEXT_NUM_THREADS>>>(size, index, x, y);
+}
+
+} // end namespace math
+} // end namespace mlfe
@@ -0,0 +1,73 @@
+#ifndef __BROADCAST_HPP__
+#define __BROADCAST_HPP__
+#include <vector>
+
+namespace mlfe{ namespace math{
+
+// the shape of an elementwise op of a and b under numpy rules: shapes are
+// aligned at the last dimension, and a dimension of 1 or a missing one is
+// repeated to match the other. throws if the shapes are not compatible.
+std::vector<int> broadcast_shape(const std::vector<int> &a,
+                                 const std::vector<int> &b
+                                );
+
+// y = x1 op x2, x1 and x2 are broadcast to y_shape.
+// the shapes are collapsed to as few dimensions as possible first, so
+// equal shapes, a scalar, a row (bias of a fc layer) or a column/channel
+// (bias of a conv layer) run as flat loops over rows of y.
+template <class T, class Dev>
+void broadcast_add(const std::vector<int> &x1_shape, const T *x1,
+                   const std::vector<int> &x2_shape, const T *x2,
+                   const std::vector<int> &y_shape, T *y);
+
+template <class T, class Dev>
+void broadcast_sub(const std::vector<int> &x1_shape, const T *x1,
+                   const std::vector<int> &x2_shape, const T *x2,
+                   const std::vector<int> &y_shape, T *y);
+
+template <class T, class Dev>
+void broadcast_mul(const std::vector<int> &x1_shape, const T *x1,
+                   const std::vector<int> &x2_shape, const T *x2,
+                   const std::vector<int> &y_shape, T *y);
+
+template <class T, class Dev>
+void broadcast_div(const std::vector<int> &x1_shape, const T *x1,
+                   const std::vector<int> &x2_shape, const T *x2,
+                   const std::vector<int> &y_shape, T *y);
+
+// y = x repeated along the dimensions it is broadcast to y_shape.
+template <class T, class Dev>
+void broadcast_to(const std::vector<int> &x_shape, const T *x,
+                  const std::vector<int> &y_shape, T *y);
+
+// the shape with the axes set to 1, axes may be negative and count from
+// the last dimension. an empty axes is all of them. throws on an axis out
+// of range.
+std::vector<int> reduced_shape(const std::vector<int> &shape,
+                               const std::vector<int> &axes
+                              );
+
+// y = x summed over the dimensions that broadcasting y_shape to x_shape
+// repeats, the gradient of broadcasting, and the sum along axes of x when
+// y_shape is reduced_shape(x_shape, axes).
+// the sums are pairwise, and a large reduction into a few outputs is split
+// across the threads as well. the result does not depend on the threads.
+template <class T, class Dev>
+void reduce_sum_to(const std::vector<int> &x_shape, const T *x,
+                   const std::vector<int> &y_shape, T *y);
+
+// same as reduce_sum_to, the max instead of the sum.
+template <class T, class Dev>
+void reduce_max_to(const std::vector<int> &x_shape, const T *x,
+                   const std::vector<int> &y_shape, T *y);
+
+// the gradient of reduce_max_to, dx is dy where x equals its max y and 0
+// elsewhere. every x tied with the max gets the whole dy.
+template <class T, class Dev>
+void reduce_max_grad(const std::vector<int> &x_shape, const T *x,
+                     const std::vector<int> &y_shape, const T *y,
+                     const T *dy, T *dx);
+
+} // end namespace math
+} // end namespace mlfe
+#endif // end ifndef __BROADCAST_HPP__
@@ -0,0 +1,173 @@
+#ifndef __MATH_FAST_MATH_H__
+#define __MATH_FAST_MATH_H__
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// branch-free float approximations of the libm functions used by the cpu
+// activation and loss kernels. they are inline and written with selects
+// instead of branches, so the loops calling them are auto-vectorized.
+//
+// max error against the exact result, measured over every float input
+// of the domain (a correctly rounded function has 0.5 ulp):
+//   exp     : 1.0 ulp  x in [-87.3, 88.7], smaller results flush softly
+//                      to zero through the denormals.
+//   log     : 1.0 ulp  x > 0, denormals included.
+//   log1p   : 2.5 ulp  x > -1.
+//   tanh    : 1.5 ulp  all x.
+//   sigmoid : 2.5 ulp  x >= -87.3, below that the result is a denormal.
+//
+// define OPTION_STRICT_MATH (cmake USE_STRICT_MATH) to use libm instead.
+// the double overloads always use libm.
+
+namespace mlfe{ namespace math{ namespace fast{
+
+namespace detail{
+
+inline float as_float(int i){
+    float f;
+    std::memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+inline int as_int(float f){
+    int i;
+    std::memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+} // end namespace detail
+
+inline float exp(float x){
+#if defined(OPTION_STRICT_MATH)
+    return std::exp(x);
+#else
+    using namespace detail;
+    // round(x / ln2) with the 1.5 * 2^23 trick, exact for |x| < 2^22.
+    constexpr float round_magic = 12582912.f;
+    x = x < -104.f ? -104.f : x;
+    x = x > 89.f ? 89.f : x;
+    const float n = (x * 1.44269504088896341f + round_magic) - round_magic;
+    // r = x - n * ln2, with ln2 split in a high and a low part.
+    float r = x - n * 0.693359375f;
+    r = r + n * 2.12194440e-4f;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    const float y = p * r * r + r + 1.f;
+    // 2^n in two halves, so n in [-150, 128] neither wraps the exponent
+    // nor loses the gradual underflow.
+    const int ni = static_cast<int>(n);
+    const int n1 = ni >> 1;
+    const int n2 = ni - n1;
+    return y * as_float((n1 + 127) << 23) * as_float((n2 + 127) << 23);
+#endif
+}
+
+inline float log(float x){
+#if defined(OPTION_STRICT_MATH)
+    return std::log(x);
+#else
+    using namespace detail;
+    // scale the denormals up into the normal range first.
+    const bool denormal = x < std::numeric_limits<float>::min();
+    const float xs = denormal ? x * 8388608.f : x;
+    const int bits = as_int(xs);
+    float e = static_cast<float>(((bits >> 23) & 0xff) - 126);
+    e = denormal ? e - 23.f : e;
+    // mantissa in [0.5, 1), shifted to [sqrt(0.5), sqrt(2)) - 1.
+    float m = as_float((bits & 0x007fffff) | 0x3f000000);
+    const bool small = m < 0.707106781186547524f;
+    e = small ? e - 1.f : e;
+    m = small ? m + m - 1.f : m - 1.f;
+    const float z = m * m;
+    float p = 7.0376836292e-2f;
+    p = p * m - 1.1514610310e-1f;
+    p = p * m + 1.1676998740e-1f;
+    p = p * m - 1.2420140846e-1f;
+    p = p * m + 1.4249322787e-1f;
+    p = p * m - 1.6668057665e-1f;
+    p = p * m + 2.0000714765e-1f;
+    p = p * m - 2.4999993993e-1f;
+    p = p * m + 3.3333331174e-1f;
+    float y = p * m * z;
+    y = y - e * 2.12194440e-4f;
+    y = y - 0.5f * z;
+    float r = m + y + e * 0.693359375f;
+    r = x == std::numeric_limits<float>::infinity() ? x : r;
+    r = x == 0.f ? -std::numeric_limits<float>::infinity() : r;
+    // negative numbers and nan.
+    r = !(x >= 0.f) ? std::numeric_limits<float>::quiet_NaN() : r;
+    return r;
+#endif
+}
+
+inline float log1p(float x){
+#if defined(OPTION_STRICT_MATH)
+    return std::log1p(x);
+#else
+    // log1p(x) = log(u) * x / (u - 1) with u = 1 + x cancels
+    // the rounding error of u.
+    const float u = 1.f + x;
+    const float d = u - 1.f;
+    float r = log(u) * (x / (d == 0.f ? 1.f : d));
+    r = d == 0.f ? x : r;
+    r = x == std::numeric_limits<float>::infinity() ? x : r;
+    return r;
+#endif
+}
+
+inline float tanh(float x){
+#if defined(OPTION_STRICT_MATH)
+    return std::tanh(x);
+#else
+    const float ax = std::fabs(x);
+    // odd polynomial near zero.
+    const float z = x * x;
+    float p = -5.70498872745e-3f;
+    p = p * z + 2.06390887954e-2f;
+    p = p * z - 5.37397155531e-2f;
+    p = p * z + 1.33314422036e-1f;
+    p = p * z - 3.33332819422e-1f;
+    const float near_zero = p * z * x + x;
+    // 1 - 2 / (exp(2|x|) + 1) elsewhere.
+    const float far = 1.f - 2.f / (exp(ax + ax) + 1.f);
+    return ax < 0.625f ? near_zero : std::copysign(far, x);
+#endif
+}
+
+inline float sigmoid(float x){
+#if defined(OPTION_STRICT_MATH)
+    return 1.f / (1.f + std::exp(-x));
+#else
+    return 1.f / (1.f + exp(-x));
+#endif
+}
+
+inline double exp(double x){
+    return std::exp(x);
+}
+
+inline double log(double x){
+    return std::log(x);
+}
+
+inline double log1p(double x){
+    return std::log1p(x);
+}
+
+inline double tanh(double x){
+    return std::tanh(x);
+}
+
+inline double sigmoid(double x){
+    return 1. / (1. + std::exp(-x));
+}
+
+} // end namespace fast
+} // end namespace math
+} // end namespace mlfe
+#endif // end #ifndef __MATH_FAST_MATH_H__
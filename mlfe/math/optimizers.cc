@@ -1,7 +1,53 @@
 #include "optimizers.h"
 #include "../device_context/cpu_context.h"
+#include <algorithm>
+#include <cmath>
 
 namespace mlfe{ namespace math{
+namespace {
+
+// bias correction of the adam moments at step, which counts from 1.
+template <class T>
+struct adam_correction{
+    adam_correction(const T beta1, const T beta2, const int step)
+        : m_scale(T(1) / (T(1) - std::pow(beta1, T(step)))),
+          v_scale(T(1) / std::sqrt(T(1) - std::pow(beta2, T(step)))){}
+
+    // the update direction of corrected moments.
+    T direction(const T m, const T v, const T eps) const{
+        return m * m_scale / (std::sqrt(v) * v_scale + eps);
+    }
+
+    T m_scale;
+    T v_scale;
+};
+
+// one pass over w, dw and the moments. decay = 0 is adam.
+template <class T>
+void adam_impl(const int size,
+               T *w,
+               const T *dw,
+               T *m_hist,
+               T *v_hist,
+               const T lr,
+               const T beta1,
+               const T beta2,
+               const T eps,
+               const T decay,
+               const int step
+              ){
+    const adam_correction<T> c(beta1, beta2, step);
+    for(int n = 0; n < size; ++n){
+        const T g = dw[n];
+        const T mh = beta1 * m_hist[n] + (T(1) - beta1) * g;
+        const T vh = beta2 * v_hist[n] + (T(1) - beta2) * g * g;
+        m_hist[n] = mh;
+        v_hist[n] = vh;
+        w[n] -= lr * (c.direction(mh, vh, eps) + decay * w[n]);
+    }
+}
+
+} // end anonymous namespace
 
 template <>
 void gradient_descent_momentum<float, CPUContext>(const int size,
@@ -35,7 +81,7 @@ void adadelta<float, CPUContext>(const int size,
         float g = dw[n];
         float gh = momentum * grad_hist[n] + (1.f - momentum) * g * g;
         grad_hist[n] = gh;
-        g = sqrt((acc_hist[n] + eps) / (gh + eps)) * g;
+        g = std::sqrt((acc_hist[n] + eps) / (gh + eps)) * g;
         acc_hist[n] = momentum * acc_hist[n] + (1.f - momentum) * g * g;
         w[n] -= lr * g;
     }
@@ -50,17 +96,116 @@ void adam<float, CPUContext>(const int size,
                              const float lr,
                              const float beta1,
                              const float beta2,
-                             const float eps
+                             const float eps,
+                             const int step
                             )
 {
-    float correction = lr * sqrt(1.f - beta2) / (1.f - beta1);
-    for(int n = 0; n < size; ++n){
-        float g = dw[n];
-        float mh = beta1 * m_hist[n] + (1.f - beta1) * g;
-        float vh = beta2 * v_hist[n] + (1.f - beta2) * g * g;
+    adam_impl(size, w, dw, m_hist, v_hist, lr, beta1, beta2, eps, 0.f, step);
+}
+
+template <>
+void adamw<float, CPUContext>(const int size,
+                              float *w,
+                              const float *dw,
+                              float *m_hist,
+                              float *v_hist,
+                              const float lr,
+                              const float beta1,
+                              const float beta2,
+                              const float eps,
+                              const float decay,
+                              const int step
+                             )
+{
+    adam_impl(size, w, dw, m_hist, v_hist, lr, beta1, beta2, eps, decay, step);
+}
+
+template <>
+void lamb_moments<float, CPUContext>(const int size,
+                                     const float *w,
+                                     const float *dw,
+                                     float *m_hist,
+                                     float *v_hist,
+                                     const float beta1,
+                                     const float beta2,
+                                     const float eps,
+                                     const float decay,
+                                     const int step,
+                                     float *norms
+                                    )
+{
+    const adam_correction<float> c(beta1, beta2, step);
+    // the squared norms are kept in independent lanes, which vectorize.
+    constexpr int lanes = 8;
+    float w_acc[lanes] = { 0.f };
+    float r_acc[lanes] = { 0.f };
+    auto accumulate = [&](const int n, const int k){
+        const float g = dw[n];
+        const float mh = beta1 * m_hist[n] + (1.f - beta1) * g;
+        const float vh = beta2 * v_hist[n] + (1.f - beta2) * g * g;
         m_hist[n] = mh;
         v_hist[n] = vh;
-        w[n] -= correction * mh / (sqrt(vh) + eps);
+        const float r = c.direction(mh, vh, eps) + decay * w[n];
+        w_acc[k] += w[n] * w[n];
+        r_acc[k] += r * r;
+    };
+    int n = 0;
+    for(; n + lanes <= size; n += lanes){
+        for(int k = 0; k < lanes; ++k){
+            accumulate(n + k, k);
+        }
+    }
+    for(int k = 0; n + k < size; ++k){
+        accumulate(n + k, k);
+    }
+    for(int k = 0; k < lanes; ++k){
+        norms[0] += w_acc[k];
+        norms[1] += r_acc[k];
+    }
+}
+
+template <>
+void lamb_update<float, CPUContext>(const int size,
+                                    float *w,
+                                    const float *m_hist,
+                                    const float *v_hist,
+                                    const float lr,
+                                    const float beta1,
+                                    const float beta2,
+                                    const float eps,
+                                    const float decay,
+                                    const int step,
+                                    const float trust_ratio
+                                   )
+{
+    const adam_correction<float> c(beta1, beta2, step);
+    const float step_size = lr * trust_ratio;
+    for(int n = 0; n < size; ++n){
+        const float r = c.direction(m_hist[n], v_hist[n], eps) + decay * w[n];
+        w[n] -= step_size * r;
+    }
+}
+
+template <>
+void squared_norm<float, CPUContext>(const int size,
+                                     const float *x,
+                                     float *y
+                                    )
+{
+    constexpr int lanes = 8;
+    float acc[lanes] = { 0.f };
+    int n = 0;
+    for(; n + lanes <= size; n += lanes){
+        for(int k = 0; k < lanes; ++k){
+            acc[k] += x[n + k] * x[n + k];
+        }
+    }
+    for(int k = 0; n + k < size; ++k){
+        acc[k] += x[n + k] * x[n + k];
+    }
+    y[0] = 0.f;
+    for(int k = 0; k < lanes; ++k){
+        y[0] += acc[k];
     }
 }
 
@@ -1,5 +1,8 @@
 #include "optimizers.h"
+#include "basic_functions.h"
 #include "../device_context/cuda_context.h"
+#include <cub/block/block_reduce.cuh>
+#include <cmath>
 
 namespace mlfe{ namespace math{
 template <typename T>
@@ -77,6 +80,8 @@ void adadelta<float, CUDAContext>(const int size,
             );
 }
 
+// m_scale and v_scale are the bias corrections of the step,
+// decay = 0 is adam.
 template <typename T>
 __global__ void adam_kernel(const int size,
                             T *w,
@@ -86,20 +91,47 @@ __global__ void adam_kernel(const int size,
                             const T lr,
                             const T beta1,
                             const T beta2,
-                            const T eps
+                            const T eps,
+                            const T decay,
+                            const T m_scale,
+                            const T v_scale
                            )
 {
-    T correction = lr * sqrt(T(1) - beta2) / (T(1) - beta1);
     CUDA_1D_KERNEL_LOOP(n, size){
         T g = dw[n];
         T mh = beta1 * m_hist[n] + (T(1) - beta1) * g;
         T vh = beta2 * v_hist[n] + (T(1) - beta2) * g * g;
         m_hist[n] = mh;
         v_hist[n] = vh;
-        w[n] -= correction * mh / (sqrt(vh) + eps);
+        T r = mh * m_scale / (sqrt(vh) * v_scale + eps);
+        w[n] -= lr * (r + decay * w[n]);
     }
 }
 
+template <>
+void adamw<float, CUDAContext>(const int size,
+                               float *w,
+                               const float *dw,
+                               float *m_hist,
+                               float *v_hist,
+                               const float lr,
+                               const float beta1,
+                               const float beta2,
+                               const float eps,
+                               const float decay,
+                               const int step
+                              )
+{
+    const float m_scale = 1.f / (1.f - std::pow(beta1, float(step)));
+    const float v_scale = 1.f / std::sqrt(1.f - std::pow(beta2, float(step)));
+    adam_kernel<float><<<
+        CUDA_CONTEXT_GET_BLOCKS(size),
+        CUDA_CONTEXT_NUM_THREADS>>>(
+            size, w, dw, m_hist, v_hist,
+            lr, beta1, beta2, eps, decay, m_scale, v_scale
+            );
+}
+
 template <>
 void adam<float, CUDAContext>(const int size,
                               float *w,
@@ -109,15 +141,47 @@ void adam<float, CUDAContext>(const int size,
                               const float lr,
                               const float beta1,
                               const float beta2,
-                              const float eps
+                              const float eps,
+                              const int step
                              )
 {
-    adam_kernel<float><<<
+    adamw<float, CUDAContext>(size, w, dw, m_hist, v_hist,
+        lr, beta1, beta2, eps, 0.f, step);
+}
+
+// each thread sums the squares of its strided elements, the blocks reduce
+// them and add their sums into y.
+template <int BLOCK_THREADS, typename T> __global__
+void squared_norm_kernel(const int size,
+                         const T *x,
+                         T *y
+                        )
+{
+    typedef cub::BlockReduce<T, BLOCK_THREADS> BlockReduce;
+
+    __shared__ typename BlockReduce::TempStorage smem_storage;
+
+    T data = 0;
+    CUDA_1D_KERNEL_LOOP(n, size){
+        data += x[n] * x[n];
+    }
+
+    T aggregate = BlockReduce(smem_storage).Sum(data);
+    if(threadIdx.x == 0){
+        atomicAdd(y, aggregate);
+    }
+}
+
+template <>
+void squared_norm<float, CUDAContext>(const int size,
+                                      const float *x,
+                                      float *y
+                                     )
+{
+    set<float, CUDAContext>(1, 0.f, y);
+    squared_norm_kernel<CUDA_CONTEXT_NUM_THREADS, float><<<
         CUDA_CONTEXT_GET_BLOCKS(size),
-        CUDA_CONTEXT_NUM_THREADS>>>(
-            size, w, dw, m_hist, v_hist,
-            lr, beta1, beta2, eps
-            );
+        CUDA_CONTEXT_NUM_THREADS>>>(size, x, y);
 }
 
 } // end namespace math
@@ -3,6 +3,9 @@
 
 namespace mlfe { namespace math {
 
+// elements updated by one chunk of the multi tensor optimizer algos.
+constexpr int multi_tensor_grain = 1 << 14;
+
 template <class T, class Dev>
 void gradient_descent_momentum(const int size,
                                T *w,
@@ -24,6 +27,7 @@ void adadelta(const int size,
               const T eps
              );
 
+// adam with the bias correction of step, which counts from 1.
 template <class T, class Dev>
 void adam(const int size,
           T *w,
@@ -33,9 +37,66 @@ void adam(const int size,
           const T lr,
           const T beta1,
           const T beta2,
-          const T eps
+          const T eps,
+          const int step
         );
 
+// adam with decoupled weight decay (loshchilov and hutter, iclr'19),
+// w -= lr * (adam direction + decay * w).
+template <class T, class Dev>
+void adamw(const int size,
+           T *w,
+           const T *dw,
+           T *m_hist,
+           T *v_hist,
+           const T lr,
+           const T beta1,
+           const T beta2,
+           const T eps,
+           const T decay,
+           const int step
+          );
+
+// first half of a lamb step (you et al., iclr'20). updates the moments
+// like adamw and adds the squared norms of w and of the update direction
+// r = adam direction + decay * w to norms[0] and norms[1].
+template <class T, class Dev>
+void lamb_moments(const int size,
+                  const T *w,
+                  const T *dw,
+                  T *m_hist,
+                  T *v_hist,
+                  const T beta1,
+                  const T beta2,
+                  const T eps,
+                  const T decay,
+                  const int step,
+                  T *norms
+                 );
+
+// second half of a lamb step, w -= lr * trust_ratio * r with r
+// recomputed from the moments.
+template <class T, class Dev>
+void lamb_update(const int size,
+                 T *w,
+                 const T *m_hist,
+                 const T *v_hist,
+                 const T lr,
+                 const T beta1,
+                 const T beta2,
+                 const T eps,
+                 const T decay,
+                 const int step,
+                 const T trust_ratio
+                );
+
+// y[0] = the sum of x[i]^2, for the global norm of gradient clipping.
+template <class T, class Dev>
+void squared_norm(const int size,
+                  const T *x,
+                  T *y
+                 );
+
 } // end namespace math
 } // end namespace mlfe
 #endif // end #ifndef __MATH_OPTIMIZAERS_H__
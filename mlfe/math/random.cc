@@ -0,0 +1,217 @@
+#include "random.h"
+#include "../device_context/cpu_context.h"
+#include "../utils/parallel_for.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mlfe{ namespace math{
+namespace {
+
+using u32 = type::uint32::T;
+
+// blocks handled by one parallel_for chunk.
+constexpr int random_grain = 1 << 12;
+
+// 24 bit threshold of a bernoulli draw, compared on the integer so the
+// draw is exact for any probability.
+template <class T>
+inline u32 bernoulli_threshold(const T prob){
+    const double p = std::min(std::max(double(prob), 0.), 1.);
+    return static_cast<u32>(p * 16777216.);
+}
+
+// 24 random bits in [0, 1).
+template <class T>
+inline T to_uniform(const u32 bits){
+    return static_cast<T>(bits >> 8) * T(1.f / 16777216.f);
+}
+
+template <class T>
+void bernoulli_philox_impl(const int size,
+                           const T prob,
+                           const philox gen,
+                           T *bernoulli
+                          ){
+    const u32 threshold = bernoulli_threshold(prob);
+    const int blocks = (size + 3) / 4;
+    parallel_for(0, blocks, random_grain, [=](int from, int to){
+        u32 words[4];
+        for(int b = from; b < to; ++b){
+            gen(b, words);
+            const int len = std::min(4, size - b * 4);
+            for(int k = 0; k < len; ++k){
+                bernoulli[b * 4 + k] = (words[k] >> 8) < threshold ? T(1) : T(0);
+            }
+        }
+    });
+}
+
+template <class T>
+void dropout_philox_impl(const int size,
+                         const T keep_prob,
+                         const philox gen,
+                         const T *x,
+                         u32 *mask,
+                         T *y
+                        ){
+    const u32 threshold = bernoulli_threshold(keep_prob);
+    const T scale = T(1) / keep_prob;
+    const int mask_words = (size + 31) / 32;
+    // one mask word is 8 philox blocks.
+    parallel_for(0, mask_words, random_grain / 8, [=](int from, int to){
+        u32 words[32];
+        for(int m = from; m < to; ++m){
+            for(int b = 0; b < 8; ++b){
+                gen(m * 8 + b, words + b * 4);
+            }
+            u32 bits = 0;
+            for(int k = 0; k < 32; ++k){
+                bits |= u32((words[k] >> 8) < threshold) << k;
+            }
+            mask[m] = bits;
+            const int base = m * 32;
+            const int len = std::min(32, size - base);
+            for(int k = 0; k < len; ++k){
+                y[base + k] = (bits >> k) & 1 ? x[base + k] * scale : T(0);
+            }
+        }
+    });
+}
+
+template <class T>
+void dropout_gradient_impl(const int size,
+                           const T keep_prob,
+                           const u32 *mask,
+                           const T *dy,
+                           T *dx
+                          ){
+    const T scale = T(1) / keep_prob;
+    const int mask_words = (size + 31) / 32;
+    parallel_for(0, mask_words, random_grain, [=](int from, int to){
+        for(int m = from; m < to; ++m){
+            const u32 bits = mask[m];
+            const int base = m * 32;
+            const int len = std::min(32, size - base);
+            for(int k = 0; k < len; ++k){
+                dx[base + k] = (bits >> k) & 1 ? dy[base + k] * scale : T(0);
+            }
+        }
+    });
+}
+
+// two normal samples from two words.
+template <class T>
+inline void box_muller(const u32 w0, const u32 w1, T &z0, T &z1){
+    constexpr T two_pi = T(6.283185307179586);
+    // u0 in (0, 1] keeps the log finite.
+    const T u0 = T(1) - to_uniform<T>(w0);
+    const T u1 = to_uniform<T>(w1);
+    const T r = std::sqrt(T(-2) * std::log(u0));
+    z0 = r * std::cos(two_pi * u1);
+    z1 = r * std::sin(two_pi * u1);
+}
+
+template <class T>
+void normal_philox_impl(const int size,
+                        const T std,
+                        const philox gen,
+                        T *y
+                       ){
+    const int blocks = (size + 3) / 4;
+    parallel_for(0, blocks, random_grain, [=](int from, int to){
+        u32 words[4];
+        T z[4];
+        for(int b = from; b < to; ++b){
+            gen(b, words);
+            box_muller(words[0], words[1], z[0], z[1]);
+            box_muller(words[2], words[3], z[2], z[3]);
+            const int len = std::min(4, size - b * 4);
+            for(int k = 0; k < len; ++k){
+                y[b * 4 + k] = z[k] * std;
+            }
+        }
+    });
+}
+
+} // end anonymous namespace
+
+template <>
+void bernoulli_philox<float, CPUContext>(const int size,
+                                         const float prob,
+                                         const philox gen,
+                                         float *bernoulli
+                                        ){
+    bernoulli_philox_impl(size, prob, gen, bernoulli);
+}
+
+template <>
+void bernoulli_philox<double, CPUContext>(const int size,
+                                          const double prob,
+                                          const philox gen,
+                                          double *bernoulli
+                                         ){
+    bernoulli_philox_impl(size, prob, gen, bernoulli);
+}
+
+template <>
+void dropout_philox<float, CPUContext>(const int size,
+                                       const float keep_prob,
+                                       const philox gen,
+                                       const float *x,
+                                       type::uint32::T *mask,
+                                       float *y
+                                      ){
+    dropout_philox_impl(size, keep_prob, gen, x, mask, y);
+}
+
+template <>
+void dropout_philox<double, CPUContext>(const int size,
+                                        const double keep_prob,
+                                        const philox gen,
+                                        const double *x,
+                                        type::uint32::T *mask,
+                                        double *y
+                                       ){
+    dropout_philox_impl(size, keep_prob, gen, x, mask, y);
+}
+
+template <>
+void dropout_gradient<float, CPUContext>(const int size,
+                                         const float keep_prob,
+                                         const type::uint32::T *mask,
+                                         const float *dy,
+                                         float *dx
+                                        ){
+    dropout_gradient_impl(size, keep_prob, mask, dy, dx);
+}
+
+template <>
+void dropout_gradient<double, CPUContext>(const int size,
+                                          const double keep_prob,
+                                          const type::uint32::T *mask,
+                                          const double *dy,
+                                          double *dx
+                                         ){
+    dropout_gradient_impl(size, keep_prob, mask, dy, dx);
+}
+
+template <>
+void normal_philox<float, CPUContext>(const int size,
+                                      const float std,
+                                      const philox gen,
+                                      float *y
+                                     ){
+    normal_philox_impl(size, std, gen, y);
+}
+
+template <>
+void normal_philox<double, CPUContext>(const int size,
+                                       const double std,
+                                       const philox gen,
+                                       double *y
+                                      ){
+    normal_philox_impl(size, std, gen, y);
+}
+
+} // end namespace math
+} // end namespace mlfe
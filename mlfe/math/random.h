@@ -0,0 +1,89 @@
+#ifndef __MATH_RANDOM_H__
+#define __MATH_RANDOM_H__
+#include "../utils/types.h"
+
+namespace mlfe{ namespace math{
+
+// philox4x32-10 counter based generator (salmon et al., sc'11).
+// a stream is keyed by (seed, op id, step) and its i-th block of four
+// 32-bit words is computed directly from i, so any range of a stream can
+// be filled on its own, and the result does not depend on how the range
+// is split over threads.
+class philox{
+using u32 = type::uint32::T;
+public:
+    philox(const unsigned long long seed, const u32 op_id, const u32 step)
+        : _key0(static_cast<u32>(seed)),
+          _key1(static_cast<u32>(seed >> 32)),
+          _op_id(op_id),
+          _step(step){}
+
+    // writes the four words of a block.
+    void operator()(const u32 index, u32 *out) const{
+        u32 c0 = index, c1 = 0, c2 = _op_id, c3 = _step;
+        u32 k0 = _key0, k1 = _key1;
+        for(int r = 0; r < 10; ++r){
+            const unsigned long long p0 = 0xD2511F53ull * c0;
+            const unsigned long long p1 = 0xCD9E8D57ull * c2;
+            const u32 hi0 = static_cast<u32>(p0 >> 32);
+            const u32 hi1 = static_cast<u32>(p1 >> 32);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = static_cast<u32>(p1);
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = static_cast<u32>(p0);
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+private:
+    u32 _key0, _key1;
+    u32 _op_id;
+    u32 _step;
+};
+
+// bernoulli[i] = 1 with probability prob, otherwise 0.
+// element i is drawn from word i % 4 of block i / 4.
+template <class T, class Dev>
+void bernoulli_philox(const int size,
+                      const T prob,
+                      const philox gen,
+                      T *bernoulli
+                     );
+
+// fused dropout, y = x * keep / keep_prob.
+// keep[i] is drawn like bernoulli_philox and stored as bit i % 32 of
+// mask[i / 32], which is 32 times smaller than a float mask.
+template <class T, class Dev>
+void dropout_philox(const int size,
+                    const T keep_prob,
+                    const philox gen,
+                    const T *x,
+                    type::uint32::T *mask,
+                    T *y
+                   );
+
+// dx = dy * keep / keep_prob, with the mask of dropout_philox.
+template <class T, class Dev>
+void dropout_gradient(const int size,
+                      const T keep_prob,
+                      const type::uint32::T *mask,
+                      const T *dy,
+                      T *dx
+                     );
+
+// y[i] ~ N(0, std^2) with the box-muller transform.
+template <class T, class Dev>
+void normal_philox(const int size,
+                   const T std,
+                   const philox gen,
+                   T *y
+                  );
+
+} // end namespace math
+} // end namespace mlfe
+#endif // end #ifndef __MATH_RANDOM_H__
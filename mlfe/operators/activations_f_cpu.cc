@@ -34,6 +34,7 @@ REGIST_OP_ALGO(ReLU)
     .Input("X", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){ return streaming_cost(oac, 1); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = ReLU<type::float32>;
         return std::make_shared<T>(oac);
@@ -77,6 +78,7 @@ REGIST_OP_GRAD_ALGO(ReLU)
     .Input("dY", type::float32::string)
     .Output("dX", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){ return streaming_cost(oac, 1); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = ReLUGrad<type::float32>;
         return std::make_shared<T>(oac);
@@ -113,6 +115,7 @@ REGIST_OP_ALGO(Sigmoid)
     .Input("X", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){ return streaming_cost(oac, 4); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = Sigmoid<type::float32>;
         return std::make_shared<T>(oac);
@@ -156,6 +159,7 @@ REGIST_OP_GRAD_ALGO(Sigmoid)
     .Input("dY", type::float32::string)
     .Output("dX", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){ return streaming_cost(oac, 3); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = SigmoidGrad<type::float32>;
         return std::make_shared<T>(oac);
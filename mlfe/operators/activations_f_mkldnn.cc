@@ -0,0 +1,119 @@
+#include "../core/op_algo.h"
+#include "../core/device.h"
+#include "../device_context/mkldnn_context.h"
+
+namespace mlfe{
+namespace algorithm_mkldnn{
+using namespace dnnl;
+using MKLDNN = MKLDNNContext;
+
+namespace{
+
+// in the layout of x for y too, a relu after a oneDNN convolution or pool
+// stays blocked.
+eltwise_forward::primitive_desc relu_desc(Tensor x){
+    auto md = MKLDNN::layout(x);
+    return eltwise_forward::primitive_desc(
+        MKLDNN::engine(),
+        prop_kind::forward_training,
+        algorithm::eltwise_relu,
+        md, md, 0.f, 0.f);
+}
+
+} // end anonymous namespace
+
+template <class Tp>
+class ReLU : public OpAlgo{
+using T = typename Tp::T;
+public:
+    ReLU(OpAlgoContext *oac) : OpAlgo(oac, "ReLU"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+        auto pd = relu_desc(x);
+        relu = eltwise_forward(pd);
+        x_in = mkldnn_input(x, pd.src_desc());
+        y_out = mkldnn_output(y, pd.dst_desc());
+    }
+
+    void Compute() override{
+        relu.execute(MKLDNN::stream(), {
+            {DNNL_ARG_SRC, x_in.get()},
+            {DNNL_ARG_DST, y_out.get()}
+        });
+        MKLDNN::stream().wait();
+        y_out.publish();
+    }
+
+private:
+    Tensor x;
+    Tensor y;
+    eltwise_forward relu;
+    mkldnn_input x_in;
+    mkldnn_output y_out;
+};
+
+REGIST_OP_ALGO(ReLU)
+    .Input("X", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = ReLU<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class ReLUGrad : public OpAlgo{
+using T = typename Tp::T;
+public:
+    ReLUGrad(OpAlgoContext *oac) : OpAlgo(oac, "ReLUGradient"){
+        dx = oac->get_output(0);
+        x = dx.get_children()[0];
+        dy = dx.get_children()[2];
+        auto hint = relu_desc(x);
+        auto md = hint.src_desc();
+        auto pd = eltwise_backward::primitive_desc(
+            MKLDNN::engine(),
+            algorithm::eltwise_relu,
+            md, md, md, 0.f, 0.f,
+            hint);
+        relu = eltwise_backward(pd);
+        x_in = mkldnn_input(x, pd.src_desc());
+        dy_in = mkldnn_input(dy, pd.diff_dst_desc());
+        dx_out = mkldnn_output(dx, pd.diff_src_desc());
+    }
+
+    void Compute() override{
+        relu.execute(MKLDNN::stream(), {
+            {DNNL_ARG_SRC, x_in.get()},
+            {DNNL_ARG_DIFF_DST, dy_in.get()},
+            {DNNL_ARG_DIFF_SRC, dx_out.get()}
+        });
+        MKLDNN::stream().wait();
+        dx_out.publish();
+    }
+
+private:
+    Tensor x;
+    Tensor dy;
+    Tensor dx;
+    eltwise_backward relu;
+    mkldnn_input x_in;
+    mkldnn_input dy_in;
+    mkldnn_output dx_out;
+};
+
+REGIST_OP_GRAD_ALGO(ReLU)
+    .Input("X", type::float32::string)
+    .Input("Y", type::float32::string)
+    .Input("dY", type::float32::string)
+    .Output("dX", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = ReLUGrad<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_mkldnn
+} // end namespace mlfe
@@ -3,6 +3,7 @@
 #include "basic_arithmetics.h"
 #include "matmul.h"
 #include "initializer.h"
+#include "../math/broadcast.h"
 #include <algorithm>
 
 namespace mlfe{
@@ -52,11 +53,8 @@ REGIST_OP(ElementwiseAdd)
         auto x1 = odc->Input(0);
         auto x2 = odc->Input(1);
         auto y = odc->Output(0);
-        if(x1.size() != x2.size()){
-            throw std::string("ElementwiseAdd : "
-                "the Shape of A and B is not same.");
-        }
-        y.reshape(x1.shape(), type::float32());
+        y.reshape(math::broadcast_shape(x1.shape(), x2.shape()),
+                  type::float32());
     })
     .Finish();
 
@@ -67,11 +65,12 @@ REGIST_OP_GRAD(ElementwiseAdd)
     .Output("dX1", "float32")
     .Output("dX2", "float32")
     .ShapeInference([](OpDesignContext * odc){
-        auto dy = odc->Input(1);
+        auto x1 = odc->Input(0);
+        auto x2 = odc->Input(1);
         auto dx1 = odc->Output(0);
         auto dx2 = odc->Output(1);
-        dx1.reshape(dy.shape(), type::float32());
-        dx2.reshape(dy.shape(), type::float32());
+        dx1.reshape(x1.shape(), type::float32());
+        dx2.reshape(x2.shape(), type::float32());
     })
     .Finish();
 
@@ -82,8 +81,10 @@ public:
 
     VecTensor compute_gradient(Tensor y, Tensor dy) override{
         VecTensor in_grads;
-        in_grads.push_back(dy);
-        in_grads.push_back(dy);
+        Tensor x1 = y.get_children()[0];
+        Tensor x2 = y.get_children()[1];
+        in_grads.push_back(functional::reduce_sum_to(dy, x1.shape()));
+        in_grads.push_back(functional::reduce_sum_to(dy, x2.shape()));
         return in_grads;
     }
 };
@@ -98,11 +99,8 @@ REGIST_OP(ElementwiseSub)
         auto x1 = odc->Input(0);
         auto x2 = odc->Input(1);
         auto y = odc->Output(0);
-        if(x1.size() != x2.size()){
-            throw std::string("ElementwiseSub : "
-                "the Shape of A and B is not same.");
-        }
-        y.reshape(x1.shape(), type::float32());
+        y.reshape(math::broadcast_shape(x1.shape(), x2.shape()),
+                  type::float32());
     })
     .Finish();
 
@@ -113,11 +111,12 @@ REGIST_OP_GRAD(ElementwiseSub)
     .Output("dX1", "float32")
     .Output("dX2", "float32")
     .ShapeInference([](OpDesignContext * odc){
-        auto dy = odc->Input(1);
+        auto x1 = odc->Input(0);
+        auto x2 = odc->Input(1);
         auto dx1 = odc->Output(0);
         auto dx2 = odc->Output(1);
-        dx1.reshape(dy.shape(), type::float32());
-        dx2.reshape(dy.shape(), type::float32());
+        dx1.reshape(x1.shape(), type::float32());
+        dx2.reshape(x2.shape(), type::float32());
     })
     .Finish();
 
@@ -128,8 +127,11 @@ public:
 
     VecTensor compute_gradient(Tensor y, Tensor dy) override{
         VecTensor in_grads;
-        auto dx1 = dy;
-        auto dx2 = functional::negative(dy);
+        Tensor x1 = y.get_children()[0];
+        Tensor x2 = y.get_children()[1];
+        auto dx1 = functional::reduce_sum_to(dy, x1.shape());
+        auto dx2 = functional::negative(
+            functional::reduce_sum_to(dy, x2.shape()));
         in_grads.push_back(dx1);
         in_grads.push_back(dx2);
         return in_grads;
@@ -146,11 +148,8 @@ REGIST_OP(ElementwiseMul)
         auto x1 = odc->Input(0);
         auto x2 = odc->Input(1);
         auto y = odc->Output(0);
-        if(x1.size() != x2.size()){
-            throw std::string("ElementwiseMul : "
-                "the Shape of A and B is not same.");
-        }
-        y.reshape(x1.shape(), type::float32());
+        y.reshape(math::broadcast_shape(x1.shape(), x2.shape()),
+                  type::float32());
     })
     .Finish();
 
@@ -161,11 +160,12 @@ REGIST_OP_GRAD(ElementwiseMul)
     .Output("dX1", "float32")
     .Output("dX2", "float32")
     .ShapeInference([](OpDesignContext * odc){
-        auto dy = odc->Input(2);
+        auto x1 = odc->Input(0);
+        auto x2 = odc->Input(1);
         auto dx1 = odc->Output(0);
         auto dx2 = odc->Output(1);
-        dx1.reshape(dy.shape(), type::float32());
-        dx2.reshape(dy.shape(), type::float32());
+        dx1.reshape(x1.shape(), type::float32());
+        dx2.reshape(x2.shape(), type::float32());
     })
     .Finish();
 
@@ -178,8 +178,21 @@ public:
         VecTensor in_grads;
         Tensor x1 = y.get_children()[0];
         Tensor x2 = y.get_children()[1];
-        Tensor dx1 = functional::mul(x2, dy);
-        Tensor dx2 = functional::mul(x1, dy);
+        if(x1.shape() == y.shape() && x2.shape() == y.shape()){
+            // dx1 and dx2 in one pass, dx2 is the second output.
+            Tensor dx1 = functional::create_variable(x1.shape());
+            Tensor dx2 = functional::create_variable(x2.shape());
+            OpAlgoContext ctx("ElementwiseMulGradient");
+            dx1.add_child(x1);
+            dx1.add_child(x2);
+            dx1.add_child(dy);
+            Tensor::AssignOpFunctor(dx1, ctx, {dx2});
+            in_grads.push_back(dx1);
+            in_grads.push_back(dx2);
+            return in_grads;
+        }
+        Tensor dx1 = functional::reduce_sum_to(functional::mul(x2, dy), x1.shape());
+        Tensor dx2 = functional::reduce_sum_to(functional::mul(x1, dy), x2.shape());
         in_grads.push_back(dx1);
         in_grads.push_back(dx2);
         return in_grads;
@@ -196,11 +209,8 @@ REGIST_OP(ElementwiseDiv)
         auto x1 = odc->Input(0);
         auto x2 = odc->Input(1);
         auto y = odc->Output(0);
-        if(x1.size() != x2.size()){
-            throw std::string("ElementwiseDiv : "
-                "the Shape of A and B is not same.");
-        }
-        y.reshape(x1.shape(), type::float32());
+        y.reshape(math::broadcast_shape(x1.shape(), x2.shape()),
+                  type::float32());
     })
     .Finish();
 
@@ -211,11 +221,12 @@ REGIST_OP_GRAD(ElementwiseDiv)
     .Output("dX1", "float32")
     .Output("dX2", "float32")
     .ShapeInference([](OpDesignContext * odc){
-        auto dy = odc->Input(2);
+        auto x1 = odc->Input(0);
+        auto x2 = odc->Input(1);
         auto dx1 = odc->Output(0);
         auto dx2 = odc->Output(1);
-        dx1.reshape(dy.shape(), type::float32());
-        dx2.reshape(dy.shape(), type::float32());
+        dx1.reshape(x1.shape(), type::float32());
+        dx2.reshape(x2.shape(), type::float32());
     })
     .Finish();
 
@@ -228,9 +239,23 @@ public:
         VecTensor in_grads;
         auto x1 = y.get_children()[0];
         auto x2 = y.get_children()[1];
-        auto one = functional::constant(1, x2.shape());
-        auto dx1 = functional::div(one, x2);
-        auto dx2 = functional::negative(functional::div(y, x2));
+        // dx1 = dy / x2, dx2 = -dy * x1 / x2^2 = -dy * y / x2.
+        if(x1.shape() == y.shape() && x2.shape() == y.shape()){
+            // dx1 and dx2 in one pass, dx2 is the second output.
+            Tensor dx1 = functional::create_variable(x1.shape());
+            Tensor dx2 = functional::create_variable(x2.shape());
+            OpAlgoContext ctx("ElementwiseDivGradient");
+            dx1.add_child(x2);
+            dx1.add_child(y);
+            dx1.add_child(dy);
+            Tensor::AssignOpFunctor(dx1, ctx, {dx2});
+            in_grads.push_back(dx1);
+            in_grads.push_back(dx2);
+            return in_grads;
+        }
+        auto dx1 = functional::reduce_sum_to(functional::div(dy, x2), x1.shape());
+        auto dx2 = functional::reduce_sum_to(functional::negative(
+            functional::div(functional::mul(dy, y), x2)), x2.shape());
         in_grads.push_back(dx1);
         in_grads.push_back(dx2);
         return in_grads;
@@ -239,6 +264,58 @@ public:
 
 REGIST_GRADIENT_HELPER(ElementwiseDiv, ElementwiseDivGradient)
 
+REGIST_OP(BroadcastTo)
+    .Input("X", "float32")
+    .Output("Y", "float32")
+    .Attr("shape", "int32s")
+    .ShapeInference([](OpDesignContext * odc){
+        auto y = odc->Output(0);
+        auto shape = odc->GetAttr<std::vector<type::int32::T>>("shape");
+        y.reshape(shape, type::float32());
+    })
+    .Finish();
+
+class BroadcastToGradient : public GradientHelper{
+public:
+    BroadcastToGradient(const OpDesignContext *odc)
+        : GradientHelper(odc){}
+
+    VecTensor compute_gradient(Tensor y, Tensor dy) override{
+        VecTensor in_grads;
+        Tensor x = y.get_children()[0];
+        in_grads.push_back(functional::reduce_sum_to(dy, x.shape()));
+        return in_grads;
+    }
+};
+
+REGIST_GRADIENT_HELPER(BroadcastTo, BroadcastToGradient)
+
+REGIST_OP(ReduceSumTo)
+    .Input("X", "float32")
+    .Output("Y", "float32")
+    .Attr("shape", "int32s")
+    .ShapeInference([](OpDesignContext * odc){
+        auto y = odc->Output(0);
+        auto shape = odc->GetAttr<std::vector<type::int32::T>>("shape");
+        y.reshape(shape, type::float32());
+    })
+    .Finish();
+
+class ReduceSumToGradient : public GradientHelper{
+public:
+    ReduceSumToGradient(const OpDesignContext *odc)
+        : GradientHelper(odc){}
+
+    VecTensor compute_gradient(Tensor y, Tensor dy) override{
+        VecTensor in_grads;
+        Tensor x = y.get_children()[0];
+        in_grads.push_back(functional::broadcast_to(dy, x.shape()));
+        return in_grads;
+    }
+};
+
+REGIST_GRADIENT_HELPER(ReduceSumTo, ReduceSumToGradient)
+
 REGIST_OP(AddN)
     .Input("Xs", "float32s")
     .Output("Y", "float32")
@@ -303,32 +380,25 @@ public:
 
 REGIST_GRADIENT_HELPER(MatrixVectorAdd, MatrixVectorAddGradient)
 
+// a scalar operand is a constant of shape {1}, which is broadcast.
 template <>
 Tensor Add<double>(Tensor a, double b){
-    Tensor y;
-    throw std::string("Tensor add op with Scalar Value is not support.");
-    return y;
+    return add(a, constant(b, {1}));
 }
 
 template <>
 Tensor Sub<double>(Tensor a, double b){
-    Tensor y;
-    throw std::string("Tensor sub op with scalar value is not support.");
-    return y;
+    return sub(a, constant(b, {1}));
 }
 
 template <>
 Tensor Mul<double>(Tensor a, double b){
-    Tensor y;
-    throw std::string("Tensor mul op with Scalar Value is not support.");
-    return y;
+    return mul(a, constant(b, {1}));
 }
 
 template <>
 Tensor Div<double>(Tensor a, double b){
-    Tensor y;
-    throw std::string("Tensor div op with Scalar Value is not support.");
-    return y;
+    return div(a, constant(b, {1}));
 }
 
 Tensor negative(Tensor x){
@@ -341,59 +411,30 @@ Tensor negative(Tensor x){
 }
 
 Tensor add(Tensor x1, Tensor x2){
-    Tensor y;
-    auto x1_shape = x1.shape();
-    auto x2_shape = x2.shape();
-    auto max_dim = std::max(x1_shape.size(), x2_shape.size());
-    auto min_dim = std::min(x1_shape.size(), x2_shape.size());
-    std::vector<int> max_shape, min_shape;
-    if(max_dim == x1_shape.size()){
-        max_shape = x1_shape;
-        min_shape = x2_shape;
+    // a vector added to a 4d tensor is a bias per channel.
+    if(x1.shape().size() == 4 && x2.shape().size() == 1 &&
+       x1.shape()[1] == x2.shape()[0]){
+        x2 = functional::reshape(x2, {x2.shape()[0], 1, 1});
     }
-    else{
-        max_shape = x2_shape;
-        min_shape = x1_shape;
-    }
-    y = functional::create_variable(max_shape);
+    Tensor y = functional::create_variable(
+        math::broadcast_shape(x1.shape(), x2.shape()));
     y.add_child(x1);
     y.add_child(x2);
-    if(max_dim == 4 && min_dim == 1){
-        if(max_shape[1] == min_shape[0]){
-            OpAlgoContext cxt("BatchedMatrixVectorAdd");
-            Tensor::AssignOpFunctor(y, cxt);
-        }
-        else{
-            std::string err = "Can not add with ";
-            err += std::to_string(max_dim) + "d";
-            err += " and ";
-            err += std::to_string(min_dim) + "d";
-            throw err;
-        }
-    }
-    else if(max_dim == 2 && min_dim == 1){
-        if(max_shape[1] == min_shape[0]){
-            OpAlgoContext cxt("MatrixVectorAdd");
-            Tensor::AssignOpFunctor(y, cxt);
-        }
-        else{
-            std::string err = "Can not add with ";
-            err += std::to_string(max_dim) + "d";
-            err += " and ";
-            err += std::to_string(min_dim) + "d";
-            throw err;
-        }
+    if(x1.shape().size() == 2 && x2.shape().size() == 1 &&
+       x1.shape()[1] == x2.shape()[0]){
+        OpAlgoContext cxt("MatrixVectorAdd");
+        Tensor::AssignOpFunctor(y, cxt);
     }
-    else if(max_dim == min_dim){
+    else{
         OpAlgoContext cxt("ElementwiseAdd");
         Tensor::AssignOpFunctor(y, cxt);
     }
-
     return y;
 }
 
 Tensor sub(Tensor x1, Tensor x2){
-    Tensor y = functional::create_variable(x1.shape());
+    Tensor y = functional::create_variable(
+        math::broadcast_shape(x1.shape(), x2.shape()));
     OpAlgoContext cxt("ElementwiseSub");
     y.add_child(x1);
     y.add_child(x2);
@@ -402,7 +443,8 @@ Tensor sub(Tensor x1, Tensor x2){
 }
 
 Tensor mul(Tensor x1, Tensor x2){
-    Tensor y = functional::create_variable(x1.shape());
+    Tensor y = functional::create_variable(
+        math::broadcast_shape(x1.shape(), x2.shape()));
     OpAlgoContext cxt("ElementwiseMul");
     y.add_child(x1);
     y.add_child(x2);
@@ -411,7 +453,8 @@ Tensor mul(Tensor x1, Tensor x2){
 }
 
 Tensor div(Tensor x1, Tensor x2){
-    Tensor y = functional::create_variable(x1.shape());
+    Tensor y = functional::create_variable(
+        math::broadcast_shape(x1.shape(), x2.shape()));
     OpAlgoContext cxt("ElementwiseDiv");
     y.add_child(x1);
     y.add_child(x2);
@@ -419,6 +462,35 @@ Tensor div(Tensor x1, Tensor x2){
     return y;
 }
 
+Tensor broadcast_to(Tensor x, std::vector<int> shape){
+    if(x.shape() == shape){
+        return x;
+    }
+    if(math::broadcast_shape(x.shape(), shape) != shape){
+        throw std::string("broadcast_to : can not broadcast to the shape.");
+    }
+    Tensor y = functional::create_variable(shape);
+    OpAlgoContext cxt("BroadcastTo");
+    y.add_child(x);
+    Tensor::AssignOpFunctor(y, cxt);
+    return y;
+}
+
+Tensor reduce_sum_to(Tensor x, std::vector<int> shape){
+    if(x.shape() == shape){
+        return x;
+    }
+    if(math::broadcast_shape(x.shape(), shape) != x.shape()){
+        throw std::string("reduce_sum_to : the shape does not broadcast "
+                          "to the input.");
+    }
+    Tensor y = functional::create_variable(shape);
+    OpAlgoContext cxt("ReduceSumTo");
+    y.add_child(x);
+    Tensor::AssignOpFunctor(y, cxt);
+    return y;
+}
+
 Tensor add_n(std::vector<Tensor> xs){
     if(xs.size() >= 2){
         Tensor y = functional::create_variable(xs[0].shape());
@@ -450,4 +522,15 @@ DEFINE_BASIC_ARITHMETIC_TENSOR_EXPR(add, +)
 DEFINE_BASIC_ARITHMETIC_TENSOR_EXPR(mul, *)
 //DEFINE_BASIC_ARITHMETIC_TENSOR_EXPR(div, /)
 
+#define DEFINE_BASIC_ARITHMETIC_SCALAR_EXPR(OpName, Expr) \
+template <>                                               \
+Tensor operator Expr<double>(Tensor a, double b){         \
+    return functional::OpName<double>(a, b);              \
+}
+
+DEFINE_BASIC_ARITHMETIC_SCALAR_EXPR(Add, +)
+DEFINE_BASIC_ARITHMETIC_SCALAR_EXPR(Sub, -)
+DEFINE_BASIC_ARITHMETIC_SCALAR_EXPR(Mul, *)
+DEFINE_BASIC_ARITHMETIC_SCALAR_EXPR(Div, /)
+
 } // end namespace mlfe
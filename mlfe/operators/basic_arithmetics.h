@@ -38,6 +38,9 @@ Tensor Div(Tensor a, T b);
 
 Tensor negative(Tensor x);
 
+// the binary ops broadcast x1 and x2 to a common shape with numpy
+// rules, see math::broadcast_shape. as an exception, a vector added to
+// a 4d tensor is a bias per channel of dimension 1.
 Tensor add(Tensor x1, Tensor x2);
 
 Tensor sub(Tensor x1, Tensor x2);
@@ -46,6 +49,13 @@ Tensor mul(Tensor x1, Tensor x2);
 
 Tensor div(Tensor x1, Tensor x2);
 
+// x repeated along the dimensions it is broadcast to shape.
+Tensor broadcast_to(Tensor x, std::vector<int> shape);
+
+// x summed along the dimensions shape is broadcast to x.shape(),
+// the gradient of broadcasting.
+Tensor reduce_sum_to(Tensor x, std::vector<int> shape);
+
 Tensor add_n(std::vector<Tensor> xs);
 
 } // end namespace functional
@@ -2,6 +2,7 @@
 #include "../core/device.h"
 #include "../math/basic_functions.h"
 #include "../math/blas.h"
+#include "../math/broadcast.h"
 #include "../device_context/cpu_context.h"
 
 namespace mlfe{
@@ -41,7 +42,7 @@ REGIST_OP_ALGO(Negative)
     })
     .Finish();
 
-#define ADD_BASIC_OP(Name, Expr)                                     \
+#define ADD_BASIC_OP(Name, Fn)                                       \
 template <class Tp>                                                  \
 class Elementwise##Name : public OpAlgo{                             \
 using T = typename Tp::T;                                            \
@@ -51,40 +52,94 @@ public:                                                              \
         y = oac->get_output(0);                                      \
         x1 = y.get_children()[0];                                    \
         x2 = y.get_children()[1];                                    \
-        size = y.size();                                             \
     }                                                                \
     void Compute() override{                                         \
         auto x1_ptr = x1.device_data<T>();                           \
         auto x2_ptr = x2.device_data<T>();                           \
         auto y_ptr = y.mutable_device_data<T>();                     \
-        for(int n = 0; n < size; ++n){                               \
-            y_ptr[n] = x1_ptr[n] Expr x2_ptr[n];                     \
-        }                                                            \
+        math::Fn<T, CPUContext>(x1.shape(), x1_ptr,                  \
+                                x2.shape(), x2_ptr,                  \
+                                y.shape(), y_ptr);                   \
     }                                                                \
 private:                                                             \
     Tensor x1;                                                       \
     Tensor x2;                                                       \
     Tensor y;                                                        \
-    int size;                                                        \
 };                                                                   \
 REGIST_OP_ALGO(Elementwise##Name)                                    \
     .Input("X1", "float32")                                          \
     .Input("X2", "float32")                                          \
     .Output("Y", type::float32::string)                              \
     .Device("CPU")                                                   \
+    .CostFn([](OpAlgoContext *oac){                                  \
+        return streaming_cost(oac, 1);                               \
+    })                                                               \
     .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{    \
         using T = Elementwise##Name<type::float32>;                  \
         return std::make_shared<T>(oac);                             \
     })                                                               \
     .Finish();
 
-ADD_BASIC_OP(Add, +)
-ADD_BASIC_OP(Sub, -)
-ADD_BASIC_OP(Mul, *)
-ADD_BASIC_OP(Div, /)
+ADD_BASIC_OP(Add, broadcast_add)
+ADD_BASIC_OP(Sub, broadcast_sub)
+ADD_BASIC_OP(Mul, broadcast_mul)
+ADD_BASIC_OP(Div, broadcast_div)
 
 #undef ADD_BASIC_OP
 
+// the fused gradients, see the gradient helpers. the algo writes dx1 and
+// its second output dx2 in one pass, from two of x1, x2 and y, and dy.
+// flops is the count of both outputs per element.
+#define BINARY_GRADIENT_OP(Name, Fn, In1, In2, Flops)                  \
+template <class Tp>                                                    \
+class Name##Grad : public OpAlgo{                                      \
+using T = typename Tp::T;                                              \
+public:                                                                \
+    Name##Grad(OpAlgoContext *oac)                                     \
+        : OpAlgo(oac, # Name "Gradient"){                              \
+        dx1 = oac->get_output(0);                                      \
+        dx2 = oac->get_output(1);                                      \
+        a = dx1.get_children()[0];                                     \
+        b = dx1.get_children()[1];                                     \
+        dy = dx1.get_children()[2];                                    \
+        size = dx1.size();                                             \
+    }                                                                  \
+    void Compute() override{                                           \
+        math::Fn<T, CPUContext>(size, a.device_data<T>(),              \
+                                b.device_data<T>(),                    \
+                                dy.device_data<T>(),                   \
+                                dx1.mutable_device_data<T>(),          \
+                                dx2.mutable_device_data<T>());         \
+    }                                                                  \
+private:                                                               \
+    Tensor a;                                                          \
+    Tensor b;                                                          \
+    Tensor dy;                                                         \
+    Tensor dx1;                                                        \
+    Tensor dx2;                                                        \
+    int size;                                                          \
+};                                                                     \
+REGIST_OP_GRAD_ALGO(Name)                                              \
+    .Input(In1, type::float32::string)                                 \
+    .Input(In2, type::float32::string)                                 \
+    .Input("dY", type::float32::string)                                \
+    .Output("dX1", type::float32::string)                              \
+    .Output("dX2", type::float32::string)                              \
+    .Device("CPU")                                                     \
+    .CostFn([](OpAlgoContext *oac){                                    \
+        return streaming_cost(oac, Flops);                             \
+    })                                                                 \
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{      \
+        using T = Name##Grad<type::float32>;                           \
+        return std::make_shared<T>(oac);                               \
+    })                                                                 \
+    .Finish();
+
+BINARY_GRADIENT_OP(ElementwiseMul, elementwise_mul_gradient, "X1", "X2", 2)
+BINARY_GRADIENT_OP(ElementwiseDiv, elementwise_div_gradient, "X2", "Y", 2)
+
+#undef BINARY_GRADIENT_OP
+
 template <class Tp>
 class AddN : public OpAlgo{
 using T = typename Tp::T;
@@ -124,6 +179,8 @@ REGIST_OP_ALGO(AddN)
     })
     .Finish();
 
+// the cpu version is a row broadcast, the gradient helper is shared
+// with the cuda version.
 template <class Tp>
 class MatrixVectorAdd : public OpAlgo{
 using T = typename Tp::T;
@@ -133,36 +190,21 @@ public:
         y = oac->get_output(0);
         mat = y.get_children()[0];
         vec = y.get_children()[1];
-        m = mat.shape()[0];
-        n = mat.shape()[1];
-        multiplier = create_memory(m * Tp::size);
-        math::set<T, CPUContext>(m, T(1), 
-                                 multiplier->mutable_device_data<T>());
     }
 
     void Compute() override{
         auto mat_ptr = mat.device_data<T>();
         auto vec_ptr = vec.device_data<T>();
         auto y_ptr = y.mutable_device_data<T>();
-        auto mul_ptr = multiplier->device_data<T>();
-
-        copy(mat.get_memory(), y.get_memory());
-
-        math::gemm<T, CPUContext>(
-            false, false,
-            m, n, 1,
-            T(1), mul_ptr, 1,
-            vec_ptr, n,
-            T(1), y_ptr, n, nullptr
-            );
+        math::broadcast_add<T, CPUContext>(mat.shape(), mat_ptr,
+                                           vec.shape(), vec_ptr,
+                                           y.shape(), y_ptr);
     }
 
 private:
     Tensor mat;
     Tensor vec;
     Tensor y;
-    memory_ptr multiplier;
-    int m, n;
 };
 
 REGIST_OP_ALGO(MatrixVectorAdd)
@@ -176,5 +218,63 @@ REGIST_OP_ALGO(MatrixVectorAdd)
     })
     .Finish();
 
+template <class Tp>
+class BroadcastTo : public OpAlgo{
+using T = typename Tp::T;
+public:
+    BroadcastTo(OpAlgoContext *oac) : OpAlgo(oac, "BroadcastTo"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+    }
+
+    void Compute() override{
+        math::broadcast_to<T, CPUContext>(x.shape(), x.device_data<T>(),
+                                          y.shape(), y.mutable_device_data<T>());
+    }
+
+private:
+    Tensor x;
+    Tensor y;
+};
+
+REGIST_OP_ALGO(BroadcastTo)
+    .Input("X", "float32")
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = BroadcastTo<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class ReduceSumTo : public OpAlgo{
+using T = typename Tp::T;
+public:
+    ReduceSumTo(OpAlgoContext *oac) : OpAlgo(oac, "ReduceSumTo"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+    }
+
+    void Compute() override{
+        math::reduce_sum_to<T, CPUContext>(x.shape(), x.device_data<T>(),
+                                           y.shape(), y.mutable_device_data<T>());
+    }
+
+private:
+    Tensor x;
+    Tensor y;
+};
+
+REGIST_OP_ALGO(ReduceSumTo)
+    .Input("X", "float32")
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = ReduceSumTo<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
 } // end namespace algorithm_cpu
 } // end namespace mlfe
@@ -3,6 +3,7 @@
 #include "../math/basic_functions.h"
 #include "../device_context/cuda_context.h"
 #include "../math/blas.h"
+#include "../math/broadcast.h"
 
 namespace mlfe{
 namespace algorithm_cuda{
@@ -39,7 +40,8 @@ REGIST_OP_ALGO(Negative)
     })
     .Finish();
 
-#define ADD_BASIC_OP(Name)                                           \
+// operands of the shape of y run the flat kernel, others broadcast.
+#define ADD_BASIC_OP(Name, Fn)                                       \
 template <class Tp>                                                  \
 class Elementwise##Name : public OpAlgo{                             \
 using T = typename Tp::T;                                            \
@@ -50,18 +52,27 @@ public:                                                              \
         x1 = y.get_children()[0];                                    \
         x2 = y.get_children()[1];                                    \
         size = y.size();                                             \
+        flat = x1.size() == size && x2.size() == size;               \
     }                                                                \
     void Compute() override{                                         \
         auto x1_ptr = x1.device_data<T>();                           \
         auto x2_ptr = x2.device_data<T>();                           \
         auto y_ptr = y.mutable_device_data<T>();                     \
-        math::Name##Cuda<T>(size, x1_ptr, x2_ptr, y_ptr);            \
+        if(flat){                                                    \
+            math::Name##Cuda<T>(size, x1_ptr, x2_ptr, y_ptr);        \
+        }                                                            \
+        else{                                                        \
+            math::Fn<T, CUDAContext>(x1.shape(), x1_ptr,             \
+                                     x2.shape(), x2_ptr,             \
+                                     y.shape(), y_ptr);              \
+        }                                                            \
     }                                                                \
 private:                                                             \
     Tensor x1;                                                       \
     Tensor x2;                                                       \
     Tensor y;                                                        \
     int size;                                                        \
+    bool flat;                                                       \
 };                                                                   \
 REGIST_OP_ALGO(Elementwise##Name)                                    \
     .Input("X1", "float32")                                          \
@@ -74,10 +85,10 @@ REGIST_OP_ALGO(Elementwise##Name)                                    \
     })                                                               \
     .Finish();
 
-ADD_BASIC_OP(Add)
-ADD_BASIC_OP(Sub)
-ADD_BASIC_OP(Mul)
-ADD_BASIC_OP(Div)
+ADD_BASIC_OP(Add, broadcast_add)
+ADD_BASIC_OP(Sub, broadcast_sub)
+ADD_BASIC_OP(Mul, broadcast_mul)
+ADD_BASIC_OP(Div, broadcast_div)
 
 #undef ADD_BASIC_OP
 
@@ -226,6 +237,55 @@ REGIST_OP_ALGO(ElementwiseDiv)
 
 #endif
 
+// the fused gradients, see the gradient helpers. the algo writes dx1 and
+// its second output dx2 in one pass, from two of x1, x2 and y, and dy.
+#define BINARY_GRADIENT_OP(Name, Fn, In1, In2)                         \
+template <class Tp>                                                    \
+class Name##Grad : public OpAlgo{                                      \
+using T = typename Tp::T;                                              \
+public:                                                                \
+    Name##Grad(OpAlgoContext *oac)                                     \
+        : OpAlgo(oac, # Name "Gradient"){                              \
+        dx1 = oac->get_output(0);                                      \
+        dx2 = oac->get_output(1);                                      \
+        a = dx1.get_children()[0];                                     \
+        b = dx1.get_children()[1];                                     \
+        dy = dx1.get_children()[2];                                    \
+        size = dx1.size();                                             \
+    }                                                                  \
+    void Compute() override{                                           \
+        math::Fn<T, CUDAContext>(size, a.device_data<T>(),              \
+                                b.device_data<T>(),                    \
+                                dy.device_data<T>(),                   \
+                                dx1.mutable_device_data<T>(),          \
+                                dx2.mutable_device_data<T>());         \
+    }                                                                  \
+private:                                                               \
+    Tensor a;                                                          \
+    Tensor b;                                                          \
+    Tensor dy;                                                         \
+    Tensor dx1;                                                        \
+    Tensor dx2;                                                        \
+    int size;                                                          \
+};                                                                     \
+REGIST_OP_GRAD_ALGO(Name)                                              \
+    .Input(In1, type::float32::string)                                 \
+    .Input(In2, type::float32::string)                                 \
+    .Input("dY", type::float32::string)                                \
+    .Output("dX1", type::float32::string)                              \
+    .Output("dX2", type::float32::string)                              \
+    .Device("CUDA")                                                    \
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{      \
+        using T = Name##Grad<type::float32>;                           \
+        return std::make_shared<T>(oac);                               \
+    })                                                                 \
+    .Finish();
+
+BINARY_GRADIENT_OP(ElementwiseMul, elementwise_mul_gradient, "X1", "X2")
+BINARY_GRADIENT_OP(ElementwiseDiv, elementwise_div_gradient, "X2", "Y")
+
+#undef BINARY_GRADIENT_OP
+
 template <class Tp>
 class AddN : public OpAlgo{
 using T = typename Tp::T;
@@ -318,5 +378,63 @@ REGIST_OP_ALGO(MatrixVectorAdd)
     })
     .Finish();
 
+template <class Tp>
+class BroadcastTo : public OpAlgo{
+using T = typename Tp::T;
+public:
+    BroadcastTo(OpAlgoContext *oac) : OpAlgo(oac, "BroadcastTo"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+    }
+
+    void Compute() override{
+        math::broadcast_to<T, CUDAContext>(x.shape(), x.device_data<T>(),
+                                           y.shape(), y.mutable_device_data<T>());
+    }
+
+private:
+    Tensor x;
+    Tensor y;
+};
+
+REGIST_OP_ALGO(BroadcastTo)
+    .Input("X", "float32")
+    .Output("Y", type::float32::string)
+    .Device("CUDA")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = BroadcastTo<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class ReduceSumTo : public OpAlgo{
+using T = typename Tp::T;
+public:
+    ReduceSumTo(OpAlgoContext *oac) : OpAlgo(oac, "ReduceSumTo"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+    }
+
+    void Compute() override{
+        math::reduce_sum_to<T, CUDAContext>(x.shape(), x.device_data<T>(),
+                                            y.shape(), y.mutable_device_data<T>());
+    }
+
+private:
+    Tensor x;
+    Tensor y;
+};
+
+REGIST_OP_ALGO(ReduceSumTo)
+    .Input("X", "float32")
+    .Output("Y", type::float32::string)
+    .Device("CUDA")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = ReduceSumTo<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
 } // end namespace algorithm_cuda
 } // end namespace mlfe
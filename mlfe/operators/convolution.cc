@@ -1,6 +1,8 @@
 #include "convolution.h"
 #include "../core/op_algo.h"
 #include "../core/gradient_helper.h"
+#include "../core/autotuner.h"
+#include <sstream>
 
 namespace mlfe{ namespace functional{
 
@@ -36,6 +38,19 @@ REGIST_OP(Convolution)
     })
     .Finish();
 
+// the fastest algo of a convolution depends on its shapes, the key of the
+// autotuner has the strides and the pads besides the shapes of x and w.
+static autotuner::registerer conv_tuning("Convolution",
+    [](OpAlgoContext *oac){
+        using IntVec = std::vector<type::int32::T>;
+        auto strides = oac->get_attr<IntVec>("strides");
+        auto pads = oac->get_attr<IntVec>("pads");
+        std::stringstream ss;
+        ss << "strides=" << strides[0] << "," << strides[1];
+        ss << " pads=" << pads[0] << "," << pads[1];
+        return ss.str();
+    });
+
 // * Convolution Gradient Operator
 //     - Input Shape = [batch, In Filters, Height, Width]
 //     - Weight Shape = [Out Filters, In Filters, Weight_H, Weight_W]
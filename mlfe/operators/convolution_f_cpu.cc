@@ -8,6 +8,17 @@
 
 namespace mlfe{
 namespace algorithm_cpu{
+namespace{
+
+// a multiply-add per filter tap of each output, the forward pass and
+// both gradients run the same gemms with the operands swapped.
+OpAlgoCost conv_cost(OpAlgoContext *oac, Tensor y, Tensor w){
+    auto cost = streaming_cost(oac);
+    cost.flops = 2. * y.size() * (w.size() / w.shape()[0]);
+    return cost;
+}
+
+} // end anonymous namespace
 
 template <class Tp>
 class Convolution : public OpAlgo{
@@ -101,11 +112,110 @@ REGIST_OP_ALGO(Convolution)
     .Input("W", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){
+        auto y = oac->get_output(0);
+        return conv_cost(oac, y, y.get_children()[1]);
+    })
     .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
         using T = Convolution<type::float32>;
         return std::make_shared<T>(oac);
     })
     .Finish();
+
+// the lowering of the gradients, a column buffer and a gemm per image.
+// the variant the autotuner weighs against the patch contraction above.
+// im2col takes one stride and one pad for both axes.
+template <class Tp>
+class ConvolutionIm2Col : public OpAlgo{
+using T = typename Tp::T;
+using IntVec = std::vector<type::int32::T>;
+public:
+    ConvolutionIm2Col(OpAlgoContext *oac) : OpAlgo(oac, "Convolution"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+        w = y.get_children()[1];
+        strides = oac->get_attr<IntVec>("strides");
+        pads = oac->get_attr<IntVec>("pads");
+        if(strides[0] != strides[1] || pads[0] != pads[1]){
+            throw std::string("ConvolutionIm2Col - "
+                "the strides or the pads differ by axis.");
+        }
+
+        batch = x.shape()[0];
+        in_c = x.shape()[1];
+        in_h = x.shape()[2];
+        in_w = x.shape()[3];
+        filters_hw.resize(2);
+        filters_hw[0] = w.shape()[2];
+        filters_hw[1] = w.shape()[3];
+
+        // Output Filters.
+        m = w.shape()[0];
+        // Output Feature Map Size.
+        n = y.shape()[2] * y.shape()[3];
+        // Weight Size.
+        k = in_c * filters_hw[0] * filters_hw[1];
+
+        col_buf = create_memory(k * n * Tp::size);
+    }
+
+    void Compute() override{
+        auto x_ptr = x.device_data<T>();
+        auto w_ptr = w.device_data<T>();
+        auto y_ptr = y.mutable_device_data<T>();
+        auto col_ptr = col_buf->mutable_device_data<T>();
+
+        for(int i = 0; i < batch; ++i){
+            math::im2col<T, CPUContext>(
+                in_c, in_h, in_w,
+                filters_hw[0], filters_hw[1],
+                strides[0], pads[0],
+                x_ptr, col_ptr
+                );
+
+            /*
+            * w({filters, kernel_size}) * col({kernel_size, out_size})
+            *  = y({filters, out_size})
+            */
+            math::gemm<T, CPUContext>(
+                false, false, m, n, k,
+                static_cast<T>(1), w_ptr, k,
+                col_ptr, n,
+                static_cast<T>(0), y_ptr, n, nullptr
+                );
+
+            x_ptr += x.size() / batch;
+            y_ptr += m * n;
+        }
+    }
+
+private:
+    Tensor x;
+    Tensor w;
+    Tensor y;
+    memory_ptr col_buf;
+    int m, n, k, batch;
+    int in_c, in_h, in_w;
+    std::vector<type::int32::T> filters_hw;
+    std::vector<type::int32::T> strides;
+    std::vector<type::int32::T> pads;
+};
+
+REGIST_OP_ALGO(Convolution)
+    .Input("X", type::float32::string)
+    .Input("W", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .Variant("Im2Col")
+    .CostFn([](OpAlgoContext *oac){
+        auto y = oac->get_output(0);
+        return conv_cost(oac, y, y.get_children()[1]);
+    })
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = ConvolutionIm2Col<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
     
 template <class Tp>
 class Conv2DGradientInput : public OpAlgo{
@@ -197,6 +307,10 @@ REGIST_OP_GRAD_ALGO(Conv2DGradientInput)
     .Input("dY", type::float32::string)
     .Output("dX", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){
+        auto dx = oac->get_output(0);
+        return conv_cost(oac, dx.get_children()[1], dx.get_children()[0]);
+    })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = Conv2DGradientInput<type::float32>;
         return std::make_shared<T>(oac);
@@ -296,6 +410,10 @@ REGIST_OP_GRAD_ALGO(Conv2DGradientFilter)
     .Input("dY", type::float32::string)
     .Output("dW", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){
+        auto dw = oac->get_output(0);
+        return conv_cost(oac, dw.get_children()[1], dw);
+    })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = Conv2DGradientFilter<type::float32>;
         return std::make_shared<T>(oac);
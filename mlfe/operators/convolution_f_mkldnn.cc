@@ -0,0 +1,199 @@
+#include "../core/op_algo.h"
+#include "../core/device.h"
+#include "../device_context/mkldnn_context.h"
+
+namespace mlfe{
+namespace algorithm_mkldnn{
+using namespace dnnl;
+using MKLDNN = MKLDNNContext;
+
+namespace{
+
+dnnl::memory::dims strides(OpAlgoContext *oac){
+    return MKLDNN::dims(oac->get_attr<std::vector<int>>("strides"));
+}
+
+dnnl::memory::dims pads(OpAlgoContext *oac){
+    return MKLDNN::dims(oac->get_attr<std::vector<int>>("pads"));
+}
+
+// the forward primitive, the gradients need it as a hint.
+convolution_forward::primitive_desc forward_desc(OpAlgoContext *oac,
+                                                 std::vector<int> x_shape,
+                                                 std::vector<int> w_shape,
+                                                 std::vector<int> y_shape
+                                                ){
+    return convolution_forward::primitive_desc(
+        MKLDNN::engine(),
+        prop_kind::forward_training,
+        algorithm::convolution_direct,
+        MKLDNN::any_desc(x_shape),
+        MKLDNN::any_desc(w_shape),
+        MKLDNN::any_desc(y_shape),
+        strides(oac), pads(oac), pads(oac));
+}
+
+} // end anonymous namespace
+
+template <class Tp>
+class Convolution : public OpAlgo{
+using T = typename Tp::T;
+public:
+    Convolution(OpAlgoContext *oac) : OpAlgo(oac, "Convolution"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+        w = y.get_children()[1];
+        // the primitive picks the layouts, a blocked x of a previous
+        // oneDNN algo is read as it is, and y is left blocked.
+        auto pd = forward_desc(oac, x.shape(), w.shape(), y.shape());
+        conv = convolution_forward(pd);
+        x_in = mkldnn_input(x, pd.src_desc());
+        w_in = mkldnn_input(w, pd.weights_desc());
+        y_out = mkldnn_output(y, pd.dst_desc());
+    }
+
+    void Compute() override{
+        conv.execute(MKLDNN::stream(), {
+            {DNNL_ARG_SRC, x_in.get()},
+            {DNNL_ARG_WEIGHTS, w_in.get()},
+            {DNNL_ARG_DST, y_out.get()}
+        });
+        MKLDNN::stream().wait();
+        y_out.publish();
+    }
+
+private:
+    Tensor x;
+    Tensor w;
+    Tensor y;
+    convolution_forward conv;
+    mkldnn_input x_in;
+    mkldnn_input w_in;
+    mkldnn_output y_out;
+};
+
+REGIST_OP_ALGO(Convolution)
+    .Input("X", type::float32::string)
+    .Input("W", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = Convolution<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class Conv2DGradientInput : public OpAlgo{
+using T = typename Tp::T;
+public:
+    Conv2DGradientInput(OpAlgoContext *oac)
+        : OpAlgo(oac, "Conv2DGradientInput"){
+        dx = oac->get_output(0);
+        w = dx.get_children()[0];
+        dy = dx.get_children()[1];
+        auto hint = forward_desc(oac, dx.shape(), w.shape(), dy.shape());
+        auto pd = convolution_backward_data::primitive_desc(
+            MKLDNN::engine(),
+            algorithm::convolution_direct,
+            MKLDNN::any_desc(dx.shape()),
+            MKLDNN::any_desc(w.shape()),
+            MKLDNN::any_desc(dy.shape()),
+            strides(oac), pads(oac), pads(oac),
+            hint);
+        conv = convolution_backward_data(pd);
+        w_in = mkldnn_input(w, pd.weights_desc());
+        dy_in = mkldnn_input(dy, pd.diff_dst_desc());
+        dx_out = mkldnn_output(dx, pd.diff_src_desc());
+    }
+
+    void Compute() override{
+        conv.execute(MKLDNN::stream(), {
+            {DNNL_ARG_DIFF_DST, dy_in.get()},
+            {DNNL_ARG_WEIGHTS, w_in.get()},
+            {DNNL_ARG_DIFF_SRC, dx_out.get()}
+        });
+        MKLDNN::stream().wait();
+        dx_out.publish();
+    }
+
+private:
+    Tensor w;
+    Tensor dy;
+    Tensor dx;
+    convolution_backward_data conv;
+    mkldnn_input w_in;
+    mkldnn_input dy_in;
+    mkldnn_output dx_out;
+};
+
+REGIST_OP_GRAD_ALGO(Conv2DGradientInput)
+    .Input("W", type::float32::string)
+    .Input("Y", type::float32::string)
+    .Input("dY", type::float32::string)
+    .Output("dX", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = Conv2DGradientInput<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class Conv2DGradientFilter : public OpAlgo{
+using T = typename Tp::T;
+public:
+    Conv2DGradientFilter(OpAlgoContext *oac)
+        : OpAlgo(oac, "Conv2DGradientFilter"){
+        dw = oac->get_output(0);
+        x = dw.get_children()[0];
+        dy = dw.get_children()[1];
+        auto hint = forward_desc(oac, x.shape(), dw.shape(), dy.shape());
+        auto pd = convolution_backward_weights::primitive_desc(
+            MKLDNN::engine(),
+            algorithm::convolution_direct,
+            MKLDNN::any_desc(x.shape()),
+            MKLDNN::any_desc(dw.shape()),
+            MKLDNN::any_desc(dy.shape()),
+            strides(oac), pads(oac), pads(oac),
+            hint);
+        conv = convolution_backward_weights(pd);
+        x_in = mkldnn_input(x, pd.src_desc());
+        dy_in = mkldnn_input(dy, pd.diff_dst_desc());
+        dw_out = mkldnn_output(dw, pd.diff_weights_desc());
+    }
+
+    void Compute() override{
+        conv.execute(MKLDNN::stream(), {
+            {DNNL_ARG_SRC, x_in.get()},
+            {DNNL_ARG_DIFF_DST, dy_in.get()},
+            {DNNL_ARG_DIFF_WEIGHTS, dw_out.get()}
+        });
+        MKLDNN::stream().wait();
+        dw_out.publish();
+    }
+
+private:
+    Tensor x;
+    Tensor dy;
+    Tensor dw;
+    convolution_backward_weights conv;
+    mkldnn_input x_in;
+    mkldnn_input dy_in;
+    mkldnn_output dw_out;
+};
+
+REGIST_OP_GRAD_ALGO(Conv2DGradientFilter)
+    .Input("X", type::float32::string)
+    .Input("Y", type::float32::string)
+    .Input("dY", type::float32::string)
+    .Output("dW", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = Conv2DGradientFilter<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_mkldnn
+} // end namespace mlfe
@@ -2,6 +2,7 @@
 #include "../math/blas.h"
 #include "../math/basic_functions.h"
 #include "../math/activations.h"
+#include "../math/fast_math.h"
 #include "../device_context/cpu_context.h"
 #include <cmath>
 #include <algorithm>
@@ -33,7 +34,8 @@ public:
             for (int u = 0; u < n; ++u){
                 int idx = t * n + u;
                 T a = logit_ptr[idx] * label_ptr[idx] - std::max(logit_ptr[idx], T(0));
-                T b = std::log(T(1) + std::exp(-std::abs(logit_ptr[idx])));
+                T e = math::fast::exp(-std::abs(logit_ptr[idx]));
+                T b = math::fast::log1p(e);
                 loss_ptr[t] += (a - b);
             }
             loss_ptr[t] = -loss_ptr[t] / static_cast<float>(n);
@@ -82,7 +84,7 @@ public:
             T dy_val = -loss_grad_ptr[b] / T(n);
             for(int u = 0; u < n; ++u){
                 int idx = b * n + u;
-                T sig = T(1) / (T(1) + std::exp(-logit_ptr[idx]));
+                T sig = math::fast::sigmoid(logit_ptr[idx]);
                 logit_grad_ptr[idx] = (label_ptr[idx] - sig) * dy_val;
             }
         }
@@ -120,76 +122,25 @@ public:
         label = loss.get_children()[1];
         m = logit.shape()[0];
         n = logit.shape()[1];
-        size = m * n;
-
-        prob = create_memory(m * n * Tp::size);
-        sm = create_memory(n * Tp::size);
-        rm = create_memory(m * Tp::size);
-        scal = create_memory(m * Tp::size);
-
-        math::set<T, CPUContext>(
-            n,
-            static_cast<T>(1),
-            sm->mutable_device_data<T>()
-            );
     }
 
     void Compute() override{
         auto x_ptr = logit.device_data<T>();
         auto t_ptr = label.device_data<T>();
         auto loss_ptr = loss.mutable_device_data<T>();
-        auto sm_ptr = sm->mutable_device_data<T>();
-        auto rm_ptr = rm->mutable_device_data<T>();
-        auto scal_ptr = scal->mutable_device_data<T>();
-        auto prob_ptr = prob->mutable_device_data<T>();
 
-        math::rowwise_max<T, CPUContext>(
-            m, n,
+        math::softmax_cross_entropy<T, CPUContext>(m, n,
             x_ptr,
-            rm_ptr
-            );
-
-        copy(logit.get_memory(), prob);
-
-        math::gemm<T, CPUContext>(false, false,
-            m, n, 1,
-            T(-1), rm_ptr, 1,
-            sm_ptr, n,
-            T(1), prob_ptr, n, nullptr);
-
-        math::exp<T, CPUContext>(
-            m * n,
-            prob_ptr,
-            prob_ptr
-            );
-
-        math::gemv<T, CPUContext>(false,
-            m, n,
-            T(1), prob_ptr, n,
-            sm_ptr,
-            T(0), scal_ptr, 1, nullptr);
-
-        math::rowwise_normalize<T, CPUContext>(m, n,
-            scal_ptr,
-            prob_ptr
-            );
-
-        math::cross_entropy<T, CPUContext>(m, n,
-            prob_ptr,
             t_ptr,
-            loss_ptr
+            loss_ptr,
+            nullptr
             );
     }
 private:
     Tensor logit;
     Tensor label;
     Tensor loss;
-    memory_ptr sm;
-    memory_ptr rm;
-    memory_ptr scal;
-    memory_ptr prob;
     int m, n;
-    int size;
 };
 
 REGIST_OP_ALGO(SoftmaxCrossEntropyWithLabel)
@@ -214,68 +165,17 @@ public:
         loss_grad = logit_grad.get_children()[3];
         m = logit.shape()[0];
         n = logit.shape()[1];
-        size = m * n;
-
-        prob = create_memory(m * n * Tp::size);
-        sm = create_memory(n * Tp::size);
-        rm = create_memory(m * Tp::size);
-        scal = create_memory(m * Tp::size);
-
-        math::set<T, CPUContext>(
-            n,
-            static_cast<T>(1),
-            sm->mutable_device_data<T>()
-            );
     }
 
     void Compute() override{
         auto x_ptr = logit.device_data<T>();
         auto t_ptr = label.device_data<T>();
-        auto dy_ptr = loss_grad.mutable_device_data<T>();
+        auto dy_ptr = loss_grad.device_data<T>();
         auto dx_ptr = logit_grad.mutable_device_data<T>();
-        auto sm_ptr = sm->mutable_device_data<T>();
-        auto rm_ptr = rm->mutable_device_data<T>();
-        auto scal_ptr = scal->mutable_device_data<T>();
-        auto prob_ptr = prob->mutable_device_data<T>();
 
-        math::rowwise_max<T, CPUContext>(
+        math::softmax_cross_entropy_gradient<T, CPUContext>(
             m, n,
             x_ptr,
-            rm_ptr
-            );
-
-        math::scal<T, CPUContext>(
-            m * n, T(1),
-            x_ptr,
-            prob_ptr
-            );
-
-        math::gemm<T, CPUContext>(false, false,
-            m, n, 1,
-            T(-1), rm_ptr, 1,
-            sm_ptr, n,
-            T(1), prob_ptr, n, nullptr);
-
-        math::exp<T, CPUContext>(
-            m * n,
-            prob_ptr,
-            prob_ptr
-            );
-
-        math::gemv<T, CPUContext>(false,
-            m, n,
-            T(1), prob_ptr, n,
-            sm_ptr,
-            T(0), scal_ptr, 1, nullptr);
-
-        math::rowwise_normalize<T, CPUContext>(m, n,
-            scal_ptr,
-            prob_ptr
-            );
-
-        math::cross_entropy_gradient<T, CPUContext>(
-            m, n,
-            prob_ptr,
             t_ptr,
             dy_ptr,
             dx_ptr
@@ -287,12 +187,7 @@ private:
     Tensor label;
     Tensor loss_grad;
     Tensor logit_grad;
-    memory_ptr sm;
-    memory_ptr rm;
-    memory_ptr scal;
-    memory_ptr prob;
     int m, n;
-    int size;
 };
 
 REGIST_OP_GRAD_ALGO(SoftmaxCrossEntropyWithLabel)
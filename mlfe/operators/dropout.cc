@@ -59,10 +59,8 @@ REGIST_GRADIENT_HELPER(Dropout, DropoutGradient)
 
 Tensor dropout(Tensor x, Tensor prob){
     Tensor y = create_variable(x.shape());
-    Tensor dropout_mask = create_variable(x.shape());
     OpAlgoContext ctx("Dropout");
     y.add_child(x);
-    ctx.add_attr({"mask", dropout_mask});
     ctx.add_attr({"prob", prob});
     Tensor::AssignOpFunctor(y, ctx);
 
@@ -1,5 +1,6 @@
 #include "../core/op_algo.h"
 #include "../math/blas.h"
+#include "../math/random.h"
 #include "../device_context/cpu_context.h"
 #include "../core/device.h"
 
@@ -10,28 +11,29 @@ template <class Tp>
 class Dropout : public OpAlgo{
 using T = typename Tp::T;
 public:
-    Dropout(OpAlgoContext *oac) : OpAlgo(oac){
+    Dropout(OpAlgoContext *oac) : OpAlgo(oac, "Dropout"){
         y = oac->get_output(0);
         x = y.get_children()[0];
-        mask = oac->get_attr<Tensor>("mask");
         prob = oac->get_attr<Tensor>("prob");
         size = x.size();
-        
+        // the mask, for the gradient, one bit per element in 32 bit words.
+        mask = functional::create_variable({(size + 31) / 32});
+        oac->add_attr({"mask", mask});
+        op_id = CPUContext::new_op_id();
+        step = 0;
     }
 
     void Compute() override{
         auto x_ptr = x.device_data<T>();
         auto y_ptr = y.mutable_device_data<T>();
-        auto mask_ptr = mask.mutable_device_data<T>();
+        auto mask_ptr = mask.mutable_device_data<type::uint32::T>();
 
         drop_ratio = prob.data<T>()[0];
-        drop_ratio_inv = T(1) / (T(1) - drop_ratio);
-        b_dist = std::bernoulli_distribution(T(1) - drop_ratio);
         if(drop_ratio != 0){
-            for(int n = 0; n < size; ++n){
-                T mask_val = mask_ptr[n] = b_dist(CPUContext::rng);
-                y_ptr[n] = x_ptr[n] * mask_val * drop_ratio_inv;
-            }
+            // each step draws a new mask from its own stream.
+            math::philox gen(CPUContext::seed, op_id, step++);
+            math::dropout_philox<T, CPUContext>(
+                size, T(1) - drop_ratio, gen, x_ptr, mask_ptr, y_ptr);
         }
         else{
             copy(x.get_memory(), y.get_memory());
@@ -42,9 +44,10 @@ private:
     Tensor y;
     Tensor mask;
     Tensor prob;
-    std::bernoulli_distribution b_dist;
-    T drop_ratio, drop_ratio_inv;
+    T drop_ratio;
     int size;
+    unsigned int op_id;
+    unsigned int step;
 };
 
 REGIST_OP_ALGO(Dropout)
@@ -73,14 +76,12 @@ public:
     void Compute() override{
         auto dy_ptr = dy.device_data<T>();
         auto dx_ptr = dx.mutable_device_data<T>();
-        auto mask_ptr = mask.device_data<T>();
+        auto mask_ptr = mask.device_data<type::uint32::T>();
 
         drop_ratio = prob.data<T>()[0];
-        drop_ratio_inv = T(1) / (T(1) - drop_ratio);
         if(drop_ratio != T(0)){
-            for(int n = 0; n < size; ++n){
-                dx_ptr[n] = dy_ptr[n] * mask_ptr[n] * drop_ratio_inv;
-            }
+            math::dropout_gradient<T, CPUContext>(
+                size, T(1) - drop_ratio, mask_ptr, dy_ptr, dx_ptr);
         }
         else{
             for(int n = 0; n < size; ++n){
@@ -94,7 +95,7 @@ private:
     Tensor mask;
     Tensor dy;
     Tensor dx;
-    T drop_ratio, drop_ratio_inv;
+    T drop_ratio;
     int size;
 };
 
@@ -13,9 +13,11 @@ public:
     Dropout(OpAlgoContext *oac) : OpAlgo(oac, "Dropout"){
         y = oac->get_output(0);
         x = y.get_children()[0];
-        mask = oac->get_attr<Tensor>("mask");
         prob = oac->get_attr<Tensor>("prob");
         size = x.size();
+        // the mask, for the gradient, the scale of each element.
+        mask = functional::create_variable(x.shape());
+        oac->add_attr({"mask", mask});
     }
 
     void Compute() override{
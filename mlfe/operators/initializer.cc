@@ -3,6 +3,7 @@
 #include "../core/tensor.h"
 #include "../core/op_design.h"
 #include "../core/gradient_helper.h"
+#include <algorithm>
 
 namespace mlfe{
 
@@ -58,7 +59,16 @@ REGIST_GRADIENT_HELPER(Normal, NormalGradient)
 namespace functional{
 
 Tensor constant(type::float64::T val, std::vector<int> shape){
-    Tensor y = create_variable(shape);
+    using T = type::float32::T;
+    int size = 1;
+    for(auto d : shape){
+        size *= d;
+    }
+    const T value = static_cast<T>(val);
+    auto mem = create_lazy_memory(size * sizeof(T), [value, size](void *ptr){
+        std::fill(static_cast<T *>(ptr), static_cast<T *>(ptr) + size, value);
+    });
+    Tensor y = create_variable(shape, mem);
     OpAlgoContext ctx("Constant");
     ctx.add_attr({"value", static_cast<type::float32::T>(val)});
     Tensor::AssignOpFunctor(y, ctx);
@@ -69,7 +79,7 @@ Tensor normal(type::float64::T std, std::vector<int> shape){
     Tensor y = create_variable(shape);
     OpAlgoContext ctx("Normal");
     ctx.add_attr({"std", static_cast<type::float32::T>(std)});
-    ctx.add_attr({"clrip", static_cast<bool>(false)});
+    ctx.add_attr({"clip", static_cast<bool>(false)});
     Tensor::AssignOpFunctor(y, ctx);
     return y;
 }
@@ -78,7 +88,7 @@ Tensor truncated_normal(type::float64::T std, std::vector<int> shape){
     Tensor y = create_variable(shape);
     OpAlgoContext ctx("Normal");
     ctx.add_attr({"std", static_cast<type::float32::T>(std)});
-    ctx.add_attr({"clrip", static_cast<bool>(true)});
+    ctx.add_attr({"clip", static_cast<bool>(true)});
     Tensor::AssignOpFunctor(y, ctx);
     return y;
 }
@@ -6,10 +6,14 @@
 namespace mlfe{
 namespace functional{
 
+// the memory is filled with val on its first access, a constant that no
+// kernel reads costs nothing. a constant of shape {1} is a scalar, which
+// the binary ops broadcast to the other operand without a full buffer.
 Tensor constant(type::float64::T val, std::vector<int> shape);
 
 Tensor normal(type::float64::T std, std::vector<int> shape);
 
+// same as normal, but the samples are clipped to [-std, std].
 Tensor truncated_normal(type::float64::T std, std::vector<int> shape);
 
 } // end namespace functional
@@ -1,7 +1,8 @@
 #include "../math/basic_functions.h"
+#include "../math/random.h"
 #include "../core/op_algo.h"
 #include "../device_context/cpu_context.h"
-#include <random>
+#include <algorithm>
 
 namespace mlfe{
 namespace algorithm_cpu{
@@ -10,20 +11,11 @@ template <class Tp>
 class Constant : public OpAlgo{
 using T = typename Tp::T;
 public:
-    Constant(OpAlgoContext *oac) : OpAlgo(oac, "Constant"){
-        y = oac->get_output(0);
-        value = oac->get_attr<float>("value");
-        size = y.size();
-    }
-
-    void Compute() override{
-        math::set<T, CPUContext>(size, value, y.mutable_device_data<T>());
-    }
+    Constant(OpAlgoContext *oac) : OpAlgo(oac, "Constant"){}
 
-private:
-    Tensor y;
-    int size;
-    type::float32::T value;
+    // the memory of a constant fills itself on the first access,
+    // see functional::constant.
+    void Compute() override{}
 };
 
 REGIST_OP_ALGO(Constant)
@@ -39,27 +31,22 @@ template <class Tp>
 class Normal : public OpAlgo{
 using T = typename Tp::T;
 public:
-    Normal(OpAlgoContext *oac) : OpAlgo(oac){
+    Normal(OpAlgoContext *oac) : OpAlgo(oac, "Normal"){
         x = oac->get_output(0);
         std = oac->get_attr<type::float32::T>("std");
         clip = oac->get_attr<bool>("clip");
         size = x.size();
-        dist = std::normal_distribution<T>(-std, std);
+        op_id = CPUContext::new_op_id();
+        step = 0;
     }
 
     void Compute() override{
         auto x_ptr = x.mutable_device_data<T>();
-        for(int n = 0; n < size; ++n){
-            x_ptr[n] = dist(CPUContext::rng);
-        }
+        math::philox gen(CPUContext::seed, op_id, step++);
+        math::normal_philox<T, CPUContext>(size, std, gen, x_ptr);
         if(clip){
             for(int n = 0; n < size; ++n){
-                if(x_ptr[n] < -std){
-                    x_ptr[n] = -std;
-                }
-                else if(x_ptr[n] > std){
-                    x_ptr[n] = std;
-                }
+                x_ptr[n] = std::min(std::max(x_ptr[n], -std), std);
             }
         }
     }
@@ -69,7 +56,8 @@ private:
     type::float32::T std;
     bool clip;
     int size;
-    std::normal_distribution<T> dist;
+    unsigned int op_id;
+    unsigned int step;
 };
 
 REGIST_OP_ALGO(Normal)
@@ -12,23 +12,11 @@ template <class Tp>
 class Constant : public OpAlgo{
 using T = typename Tp::T;
 public:
-    Constant(OpAlgoContext *oac) : OpAlgo(oac, "Constant"){
-        y = oac->get_output(0);
-        value = oac->get_attr<type::float32::T>("value");
-        size = y.size();
-    }
+    Constant(OpAlgoContext *oac) : OpAlgo(oac, "Constant"){}
 
-    void Compute() override{
-        math::set<T, CUDAContext>(size,
-                                  value, 
-                                  y.mutable_device_data<T>()
-                                 );
-    }
-
-private:
-    Tensor y;
-    int size;
-    type::float32::T value;
+    // the memory of a constant fills itself on the first access,
+    // see functional::constant.
+    void Compute() override{}
 };
 
 REGIST_OP_ALGO(Constant)
@@ -3,6 +3,7 @@
 #include "../core/gradient_helper.h"
 #include "../operators/basic_arithmetics.h"
 #include "../operators/initializer.h"
+#include "../math/broadcast.h"
 
 namespace mlfe{
 
@@ -53,13 +54,17 @@ public:
         : GradientHelper(odc){}
 
     VecTensor compute_gradient(Tensor y, Tensor dy) override{
-        namespace fn = functional;
         VecTensor in_grads;
         auto x1 = y.get_children()[0];
         auto x2 = y.get_children()[1];
-        auto two = functional::constant(2, x1.shape());
-        Tensor dx1 = fn::mul(dy, fn::mul(two, fn::sub(x1, x2)));
-        Tensor dx2 = fn::mul(dy, fn::negative(fn::mul(two, fn::sub(x1, x2))));
+        // dx1 and dx2 in one pass, dx2 is the second output.
+        Tensor dx1 = functional::create_variable(x1.shape());
+        Tensor dx2 = functional::create_variable(x2.shape());
+        OpAlgoContext ctx("SquaredDifferenceGradient");
+        dx1.add_child(x1);
+        dx1.add_child(x2);
+        dx1.add_child(dy);
+        Tensor::AssignOpFunctor(dx1, ctx, {dx2});
         in_grads.push_back(dx1);
         in_grads.push_back(dx2);
         return in_grads;
@@ -68,26 +73,106 @@ public:
 
 REGIST_GRADIENT_HELPER(SquaredDifference, SquaredDifferenceGradient)
 
-REGIST_OP(ReduceMean)
-.Input("X", "float32")
-.Output("Y", "float32")
-.ShapeInference([](OpDesignContext * odc){
-    auto x = odc->Input(0);
-    auto y = odc->Output(0);
-    y.reshape({ 1 }, type::float32());
-})
-.Finish();
+// * Reduce Operators (ReduceSum, ReduceMean, ReduceMax)
+//     - Input Shape = x.shape()
+//     - axes = the reduced dimensions, all of them if empty
+//     - Output Shape = x.shape() with the axes of 1 if keepdims,
+//                      else with the axes removed, or [1] if none is left
+#define REGIST_REDUCE_OP(Name)                                         \
+REGIST_OP(Name)                                                        \
+    .Input("X", "float32")                                             \
+    .Output("Y", "float32")                                            \
+    .Attr("axes", "int32s")                                            \
+    .Attr("keepdims", "bool")                                          \
+    .ShapeInference([](OpDesignContext * odc){                         \
+        using IntVec = std::vector<type::int32::T>;                    \
+        auto x = odc->Input(0);                                        \
+        auto y = odc->Output(0);                                       \
+        auto axes = odc->GetAttr<IntVec>("axes");                      \
+        auto keepdims = odc->GetAttr<bool>("keepdims");                \
+        y.reshape(reduce_output_shape(x.shape(), axes, keepdims),      \
+                  type::float32());                                    \
+    })                                                                 \
+    .Finish();
+
+namespace{
+
+std::vector<int> reduce_output_shape(const std::vector<int> &x_shape,
+                                     const std::vector<int> &axes,
+                                     const bool keepdims
+                                    ){
+    auto keep = math::reduced_shape(x_shape, axes);
+    if(keepdims){
+        return keep;
+    }
+    const int rank = x_shape.size();
+    std::vector<bool> reduced(rank, axes.empty());
+    for(auto axis : axes){
+        reduced[axis < 0 ? axis + rank : axis] = true;
+    }
+    std::vector<int> shape;
+    for(int n = 0; n < rank; ++n){
+        if(!reduced[n]){
+            shape.push_back(x_shape[n]);
+        }
+    }
+    if(shape.empty()){
+        shape.push_back(1);
+    }
+    return shape;
+}
+
+} // end anonymous namespace
+
+REGIST_REDUCE_OP(ReduceSum)
+REGIST_REDUCE_OP(ReduceMean)
+REGIST_REDUCE_OP(ReduceMax)
+
+#undef REGIST_REDUCE_OP
 
 REGIST_OP_GRAD(ReduceMean)
-.Input("X", "float32")
-.Input("dY", "float32")
-.Output("dX", "float32")
-.ShapeInference([](OpDesignContext * odc){
-    auto x = odc->Input(0);
-    auto dx = odc->Output(0);
-    dx.reshape(x.shape(), type::float32());
-})
-.Finish();
+    .Input("X", "float32")
+    .Input("dY", "float32")
+    .Output("dX", "float32")
+    .Attr("axes", "int32s")
+    .ShapeInference([](OpDesignContext * odc){
+        auto x = odc->Input(0);
+        auto dx = odc->Output(0);
+        dx.reshape(x.shape(), type::float32());
+    })
+    .Finish();
+
+REGIST_OP_GRAD(ReduceMax)
+    .Input("X", "float32")
+    .Input("Y", "float32")
+    .Input("dY", "float32")
+    .Output("dX", "float32")
+    .Attr("axes", "int32s")
+    .ShapeInference([](OpDesignContext * odc){
+        auto x = odc->Input(0);
+        auto dx = odc->Output(0);
+        dx.reshape(x.shape(), type::float32());
+    })
+    .Finish();
+
+class ReduceSumGradient : public GradientHelper{
+public:
+    ReduceSumGradient(const OpDesignContext *odc)
+        : GradientHelper(odc){}
+
+    VecTensor compute_gradient(Tensor y, Tensor dy) override{
+        using IntVec = std::vector<type::int32::T>;
+        namespace fn = functional;
+        VecTensor in_grads;
+        Tensor x = y.get_children()[0];
+        auto axes = y.get_context().get_attr<IntVec>("axes");
+        auto keep = math::reduced_shape(x.shape(), axes);
+        in_grads.push_back(fn::broadcast_to(fn::reshape(dy, keep), x.shape()));
+        return in_grads;
+    }
+};
+
+REGIST_GRADIENT_HELPER(ReduceSum, ReduceSumGradient)
 
 class ReduceMeanGradient : public GradientHelper{
 public:
@@ -95,10 +180,12 @@ public:
     : GradientHelper(odc){}
     
     VecTensor compute_gradient(Tensor y, Tensor dy) override{
+        using IntVec = std::vector<type::int32::T>;
         VecTensor in_grads;
         Tensor x = y.get_children()[0];
         Tensor dx = functional::create_variable(x.shape());
         OpAlgoContext ctx("ReduceMeanGradient");
+        ctx.add_attr({"axes", y.get_context().get_attr<IntVec>("axes")});
         dx.add_child(dy);
         Tensor::AssignOpFunctor(dx, ctx);
         in_grads.push_back(dx);
@@ -108,7 +195,45 @@ public:
 
 REGIST_GRADIENT_HELPER(ReduceMean, ReduceMeanGradient)
 
+class ReduceMaxGradient : public GradientHelper{
+public:
+    ReduceMaxGradient(const OpDesignContext *odc)
+        : GradientHelper(odc){}
+
+    VecTensor compute_gradient(Tensor y, Tensor dy) override{
+        using IntVec = std::vector<type::int32::T>;
+        VecTensor in_grads;
+        Tensor x = y.get_children()[0];
+        Tensor dx = functional::create_variable(x.shape());
+        OpAlgoContext ctx("ReduceMaxGradient");
+        ctx.add_attr({"axes", y.get_context().get_attr<IntVec>("axes")});
+        dx.add_child(x);
+        dx.add_child(y);
+        dx.add_child(dy);
+        Tensor::AssignOpFunctor(dx, ctx);
+        in_grads.push_back(dx);
+        return in_grads;
+    }
+};
+
+REGIST_GRADIENT_HELPER(ReduceMax, ReduceMaxGradient)
+
 namespace functional{
+namespace{
+
+Tensor reduce(std::string op_name, Tensor x, std::vector<int> axes,
+              bool keepdims
+             ){
+    Tensor y = create_variable(reduce_output_shape(x.shape(), axes, keepdims));
+    OpAlgoContext ctx(op_name);
+    ctx.add_attr({"axes", axes});
+    ctx.add_attr({"keepdims", keepdims});
+    y.add_child(x);
+    Tensor::AssignOpFunctor(y, ctx);
+    return y;
+}
+
+} // end anonymous namespace
 
 Tensor squared_difference(Tensor x1, Tensor x2){
     Tensor y = create_variable(x1.shape());
@@ -120,13 +245,19 @@ Tensor squared_difference(Tensor x1, Tensor x2){
 }
 
 Tensor mean(Tensor x){
-    Tensor y = create_variable({1});
-    OpAlgoContext ctx("ReduceMean");
-    
-    y.add_child(x);
-    Tensor::AssignOpFunctor(y, ctx);
-    
-    return y;
+    return reduce("ReduceMean", x, {}, false);
+}
+
+Tensor reduce_sum(Tensor x, std::vector<int> axes, bool keepdims){
+    return reduce("ReduceSum", x, axes, keepdims);
+}
+
+Tensor reduce_mean(Tensor x, std::vector<int> axes, bool keepdims){
+    return reduce("ReduceMean", x, axes, keepdims);
+}
+
+Tensor reduce_max(Tensor x, std::vector<int> axes, bool keepdims){
+    return reduce("ReduceMax", x, axes, keepdims);
 }
 
 } // end namespace functional
@@ -1,5 +1,6 @@
 #ifndef __MATH_OP_H__
 #define __MATH_OP_H__
+#include <vector>
 
 namespace mlfe{
 // forward declaration.
@@ -11,6 +12,17 @@ Tensor squared_difference(Tensor x1, Tensor x2);
 
 Tensor mean(Tensor x);
 
+// the sum, mean or max of x along axes, or along every axis if axes is
+// empty. axes may be negative and count from the last dimension.
+// with keepdims the reduced axes stay as dimensions of 1, otherwise they
+// are removed, and a reduction to one value has the shape [1].
+Tensor reduce_sum(Tensor x, std::vector<int> axes = {}, bool keepdims = false);
+
+Tensor reduce_mean(Tensor x, std::vector<int> axes = {}, bool keepdims = false);
+
+// the gradient goes to every element equal to the max.
+Tensor reduce_max(Tensor x, std::vector<int> axes = {}, bool keepdims = false);
+
 } // end namespace functional
 } // end namespace mlfe
 #endif // end ifndef __MATH_OP_H__
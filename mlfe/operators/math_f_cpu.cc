@@ -1,6 +1,7 @@
 #include "../core/op_algo.h"
 #include "../math/blas.h"
 #include "../math/basic_functions.h"
+#include "../math/broadcast.h"
 #include "../device_context/cpu_context.h"
 #include "../core/device.h"
 
@@ -38,6 +39,7 @@ REGIST_OP_ALGO(SquaredDifference)
     .Input("X2", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){ return streaming_cost(oac, 2); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = SquaredDifference<type::float32>;
         return std::make_shared<T>(oac);
@@ -48,9 +50,22 @@ template <class Tp>
 class SquaredDifferenceGrad : public OpAlgo{
 using T = typename Tp::T;
 public:
-    SquaredDifferenceGrad(OpAlgoContext *oac) : OpAlgo(oac){}
+    SquaredDifferenceGrad(OpAlgoContext *oac)
+        : OpAlgo(oac, "SquaredDifferenceGradient"){
+        dx1 = oac->get_output(0);
+        dx2 = oac->get_output(1);
+        x1 = dx1.get_children()[0];
+        x2 = dx1.get_children()[1];
+        dy = dx1.get_children()[2];
+        size = dx1.size();
+    }
 
-    void Compute() override{}
+    void Compute() override{
+        math::squared_difference_gradient<T, CPUContext>(
+            size, x1.device_data<T>(), x2.device_data<T>(),
+            dy.device_data<T>(), dx1.mutable_device_data<T>(),
+            dx2.mutable_device_data<T>());
+    }
 
 private:
     Tensor x1;
@@ -68,82 +83,139 @@ REGIST_OP_GRAD_ALGO(SquaredDifference)
     .Output("dX1", type::float32::string)
     .Output("dX2", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){ return streaming_cost(oac, 3); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = SquaredDifferenceGrad<type::float32>;
         return std::make_shared<T>(oac);
     })
     .Finish();
 
+// a mean is the sum scaled by the number of outputs over the inputs.
+// the cost is an add or a compare per input.
+#define REDUCE_OP(Name, Fn, IsMean)                                    \
+template <class Tp>                                                    \
+class Name : public OpAlgo{                                            \
+using T = typename Tp::T;                                              \
+public:                                                                \
+    Name(OpAlgoContext *oac) : OpAlgo(oac, # Name){                    \
+        using IntVec = std::vector<type::int32::T>;                    \
+        y = oac->get_output(0);                                        \
+        x = y.get_children()[0];                                       \
+        keep_shape = math::reduced_shape(x.shape(),                    \
+            oac->get_attr<IntVec>("axes"));                            \
+        scale = T(y.size()) / T(x.size());                             \
+    }                                                                  \
+    void Compute() override{                                           \
+        auto y_ptr = y.mutable_device_data<T>();                       \
+        math::Fn<T, CPUContext>(x.shape(), x.device_data<T>(),         \
+                                keep_shape, y_ptr);                    \
+        for(int n = 0; IsMean && n < y.size(); ++n){                   \
+            y_ptr[n] *= scale;                                         \
+        }                                                              \
+    }                                                                  \
+private:                                                               \
+    Tensor x;                                                          \
+    Tensor y;                                                          \
+    std::vector<int> keep_shape;                                       \
+    T scale;                                                           \
+};                                                                     \
+REGIST_OP_ALGO(Name)                                                   \
+    .Input("X", type::float32::string)                                 \
+    .Output("Y", type::float32::string)                                \
+    .Device("CPU")                                                     \
+    .CostFn([](OpAlgoContext *oac){                                    \
+        auto cost = streaming_cost(oac);                               \
+        cost.flops = oac->get_output(0).get_children()[0].size();      \
+        return cost;                                                   \
+    })                                                                 \
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{       \
+        using T = Name<type::float32>;                                 \
+        return std::make_shared<T>(oac);                               \
+    })                                                                 \
+    .Finish();
+
+REDUCE_OP(ReduceSum, reduce_sum_to, false)
+REDUCE_OP(ReduceMean, reduce_sum_to, true)
+REDUCE_OP(ReduceMax, reduce_max_to, false)
+
+#undef REDUCE_OP
+
 template <class Tp>
-class ReduceMean : public OpAlgo{
+class ReduceMeanGrad : public OpAlgo{
     using T = typename Tp::T;
 public:
-    ReduceMean(OpAlgoContext *oac) : OpAlgo(oac, "ReduceMean"){
-        y = oac->get_output(0);
-        x = y.get_children()[0];
-        size = x.size();
+    ReduceMeanGrad(OpAlgoContext *oac) : OpAlgo(oac, "ReduceMeanGradient"){
+        using IntVec = std::vector<type::int32::T>;
+        dx = oac->get_output(0);
+        dy = dx.get_children()[0];
+        keep_shape = math::reduced_shape(dx.shape(),
+                                         oac->get_attr<IntVec>("axes"));
+        scale = T(dy.size()) / T(dx.size());
     }
     
+    // dx = dy broadcast back to x and scaled, in one pass.
     void Compute() override{
-        auto x_ptr = x.device_data<T>();
-        auto y_ptr = y.mutable_device_data<T>();
-        T sum = T(0);
-        for(int n = 0; n < size; ++n){
-            sum += x_ptr[n];
-        }
-        y_ptr[0] = sum / T(size);
+        math::broadcast_mul<T, CPUContext>(keep_shape, dy.device_data<T>(),
+                                           {1}, &scale,
+                                           dx.shape(),
+                                           dx.mutable_device_data<T>());
     }
+    
 private:
-    Tensor x;
-    Tensor y;
-    int size;
+    Tensor dy;
+    Tensor dx;
+    std::vector<int> keep_shape;
+    T scale;
 };
 
-REGIST_OP_ALGO(ReduceMean)
+REGIST_OP_GRAD_ALGO(ReduceMean)
     .Input("X", type::float32::string)
-    .Output("Y", type::float32::string)
+    .Input("dY", type::float32::string)
+    .Output("dX", type::float32::string)
     .Device("CPU")
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
-        using T = ReduceMean<type::float32>;
+        using T = ReduceMeanGrad<type::float32>;
         return std::make_shared<T>(oac);
     })
     .Finish();
 
 template <class Tp>
-class ReduceMeanGrad : public OpAlgo{
+class ReduceMaxGrad : public OpAlgo{
     using T = typename Tp::T;
 public:
-    ReduceMeanGrad(OpAlgoContext *oac) : OpAlgo(oac, "ReduceMeanGradient"){
+    ReduceMaxGrad(OpAlgoContext *oac) : OpAlgo(oac, "ReduceMaxGradient"){
+        using IntVec = std::vector<type::int32::T>;
         dx = oac->get_output(0);
-        dy = dx.get_children()[0];
-        size = dx.size();
-        scale = T(1) / T(size);
+        x = dx.get_children()[0];
+        y = dx.get_children()[1];
+        dy = dx.get_children()[2];
+        keep_shape = math::reduced_shape(x.shape(),
+                                         oac->get_attr<IntVec>("axes"));
     }
-    
+
     void Compute() override{
-        auto dy_ptr = dy.device_data<T>();
-        auto dx_ptr = dx.mutable_device_data<T>();
-        T dy_val = dy_ptr[0];
-        
-        for(int n = 0; n < size; ++n){
-            dx_ptr[n] = dy_val * scale;
-        }
+        math::reduce_max_grad<T, CPUContext>(x.shape(), x.device_data<T>(),
+                                             keep_shape, y.device_data<T>(),
+                                             dy.device_data<T>(),
+                                             dx.mutable_device_data<T>());
     }
-    
+
 private:
+    Tensor x;
+    Tensor y;
     Tensor dy;
     Tensor dx;
-    int size;
-    T scale;
+    std::vector<int> keep_shape;
 };
 
-REGIST_OP_GRAD_ALGO(ReduceMean)
+REGIST_OP_GRAD_ALGO(ReduceMax)
     .Input("X", type::float32::string)
+    .Input("Y", type::float32::string)
     .Input("dY", type::float32::string)
     .Output("dX", type::float32::string)
     .Device("CPU")
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
-        using T = ReduceMeanGrad<type::float32>;
+        using T = ReduceMaxGrad<type::float32>;
         return std::make_shared<T>(oac);
     })
     .Finish();
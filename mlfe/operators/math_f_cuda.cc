@@ -47,9 +47,22 @@ template <class Tp>
 class SquaredDifferenceGrad : public OpAlgo{
 using T = typename Tp::T;
 public:
-    SquaredDifferenceGrad(OpAlgoContext *oac) : OpAlgo(oac){}
+    SquaredDifferenceGrad(OpAlgoContext *oac)
+        : OpAlgo(oac, "SquaredDifferenceGradient"){
+        dx1 = oac->get_output(0);
+        dx2 = oac->get_output(1);
+        x1 = dx1.get_children()[0];
+        x2 = dx1.get_children()[1];
+        dy = dx1.get_children()[2];
+        size = dx1.size();
+    }
 
-    void Compute() override{}
+    void Compute() override{
+        math::squared_difference_gradient<T, CUDAContext>(
+            size, x1.device_data<T>(), x2.device_data<T>(),
+            dy.device_data<T>(), dx1.mutable_device_data<T>(),
+            dx2.mutable_device_data<T>());
+    }
 
 private:
     Tensor x1;
@@ -81,6 +94,10 @@ public:
         y = oac->get_output(0);
         x = y.get_children()[0];
         size = x.size();
+        if(y.size() != 1){
+            throw std::string("ReduceMean : only the mean of all elements "
+                              "is supported on CUDA.");
+        }
     }
 
     void Compute() override{
@@ -116,6 +133,10 @@ public:
         dy = dx.get_children()[0];
         size = dx.size();
         scale = T(1) / T(size);
+        if(dy.size() != 1){
+            throw std::string("ReduceMeanGradient : only the mean of all "
+                              "elements is supported on CUDA.");
+        }
     }
 
     void Compute() override{
@@ -73,6 +73,12 @@ REGIST_OP_ALGO(MatMul)
     .Input("B", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CPU")
+    .CostFn([](OpAlgoContext *oac){
+        // a multiply-add per k of each of the m x n outputs.
+        auto a = oac->get_output(0).get_children()[0];
+        auto k = oac->get_attr<bool>("trans_a") ? a.shape()[0] : a.shape()[1];
+        return streaming_cost(oac, 2. * k);
+    })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = MatMul<type::float32>;
         return std::make_shared<T>(oac);
@@ -0,0 +1,76 @@
+#include "../core/op_algo.h"
+#include "../core/device.h"
+#include "../device_context/mkldnn_context.h"
+
+namespace mlfe{
+namespace algorithm_mkldnn{
+using namespace dnnl;
+using MKLDNN = MKLDNNContext;
+
+// the gradients of a matmul are matmuls, see MatMulGradient.
+// the operands are read in place, a transposed one through the strides of
+// its layout.
+template <class Tp>
+class MatMul : public OpAlgo{
+using T = typename Tp::T;
+public:
+    MatMul(OpAlgoContext *oac) : OpAlgo(oac, "MatMul"){
+        y = oac->get_output(0);
+        a = y.get_children()[0];
+        b = y.get_children()[1];
+        bool trans_a = oac->get_attr<bool>("trans_a");
+        bool trans_b = oac->get_attr<bool>("trans_b");
+        int m = y.shape()[0];
+        int n = y.shape()[1];
+        int k = trans_a ? a.shape()[0] : a.shape()[1];
+        auto desc = [](int rows, int cols, bool trans){
+            return dnnl::memory::desc({rows, cols},
+                dnnl::memory::data_type::f32,
+                trans ? dnnl::memory::format_tag::ba :
+                        dnnl::memory::format_tag::ab);
+        };
+        auto pd = matmul::primitive_desc(MKLDNN::engine(),
+                                         desc(m, k, trans_a),
+                                         desc(k, n, trans_b),
+                                         desc(m, n, false));
+        mm = matmul(pd);
+        a_mem = dnnl::memory(pd.src_desc(), MKLDNN::engine(), nullptr);
+        b_mem = dnnl::memory(pd.weights_desc(), MKLDNN::engine(), nullptr);
+        y_mem = dnnl::memory(pd.dst_desc(), MKLDNN::engine(), nullptr);
+    }
+
+    void Compute() override{
+        a_mem.set_data_handle(const_cast<T *>(a.device_data<T>()));
+        b_mem.set_data_handle(const_cast<T *>(b.device_data<T>()));
+        y_mem.set_data_handle(y.mutable_device_data<T>());
+        mm.execute(MKLDNN::stream(), {
+            {DNNL_ARG_SRC, a_mem},
+            {DNNL_ARG_WEIGHTS, b_mem},
+            {DNNL_ARG_DST, y_mem}
+        });
+        MKLDNN::stream().wait();
+    }
+
+private:
+    Tensor a;
+    Tensor b;
+    Tensor y;
+    matmul mm;
+    dnnl::memory a_mem;
+    dnnl::memory b_mem;
+    dnnl::memory y_mem;
+};
+
+REGIST_OP_ALGO(MatMul)
+    .Input("A", type::float32::string)
+    .Input("B", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = MatMul<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_mkldnn
+} // end namespace mlfe
@@ -3,6 +3,25 @@
 #include "../core/gradient_helper.h"
 
 namespace mlfe{ 
+namespace{
+
+// the shape of y, N, C, H', W'. a padding as large as the kernel would
+// leave windows with no element of x.
+std::vector<int> pool_shape(std::string op_name,
+                            std::vector<int> x_shape,
+                            std::vector<int> kernel,
+                            std::vector<int> stride,
+                            std::vector<int> padding
+                           ){
+    if(padding[0] >= kernel[0] || padding[1] >= kernel[1]){
+        throw op_name + ": the padding must be smaller than the kernel.";
+    }
+    int out_h = (x_shape[2] - kernel[0] + 2 * padding[0]) / stride[0] + 1;
+    int out_w = (x_shape[3] - kernel[1] + 2 * padding[1]) / stride[1] + 1;
+    return {x_shape[0], x_shape[1], out_h, out_w};
+}
+
+} // end anonymous namespace
 
 // X Shape : N, C, H , W
 // Y Shape : N, C, H', W'
@@ -21,11 +40,10 @@ REGIST_OP(MaxPool)
         auto filters_hw = odc->GetAttr<IntVec>("filters_hw");
         auto strides = odc->GetAttr<IntVec>("strides");
         auto pads = odc->GetAttr<IntVec>("pads");
-        auto x_shape = x.shape();
-        int out_h = (x_shape[2] - filters_hw[0] + 2 * pads[0]) / strides[0] + 1;
-        int out_w = (x_shape[3] - filters_hw[1] + 2 * pads[1]) / strides[1] + 1;
-        idx.reshape({ x_shape[0], x_shape[1], out_h, out_w }, type::float32());
-        y.reshape({ x_shape[0], x_shape[1], out_h, out_w }, type::float32());
+        auto y_shape = pool_shape("MaxPool", x.shape(),
+                                  filters_hw, strides, pads);
+        idx.reshape(y_shape, type::float32());
+        y.reshape(y_shape, type::float32());
     })
     .Finish();
 
@@ -46,7 +64,6 @@ REGIST_OP_GRAD(MaxPool)
 // Y Shape : N, C, H', W'
 REGIST_OP(AvgPool)
     .Input("X", "float32")
-    .Output("IDX", "float32")
     .Output("Y", "float32")
     .Attr("filters_hw", "int32s")
     .Attr("strides", "int32s")
@@ -54,22 +71,17 @@ REGIST_OP(AvgPool)
     .ShapeInference([](OpDesignContext * odc){
         using IntVec = std::vector<type::int32::T>;
         auto x = odc->Input(0);
-        auto idx = odc->Output(0);
-        auto y = odc->Output(1);
+        auto y = odc->Output(0);
         auto filters_hw = odc->GetAttr<IntVec>("filters_hw");
         auto strides = odc->GetAttr<IntVec>("strides");
         auto pads = odc->GetAttr<IntVec>("pads");
-        auto x_shape = x.shape();
-        int out_h = (x_shape[2] - filters_hw[0] + 2 * pads[0]) / strides[0] + 1;
-        int out_w = (x_shape[3] - filters_hw[1] + 2 * pads[1]) / strides[1] + 1;
-        idx.reshape({ x_shape[0], x_shape[1], out_h, out_w }, type::float32());
-        y.reshape({ x_shape[0], x_shape[1], out_h, out_w }, type::float32());
+        y.reshape(pool_shape("AvgPool", x.shape(), filters_hw, strides, pads),
+                  type::float32());
     })
     .Finish();
 
 REGIST_OP_GRAD(AvgPool)
     .Input("X", "float32")
-    .Input("IDX", "float32")
     .Input("Y", "float32")
     .Input("dY", "float32")
     .Output("dX", "float32")
@@ -116,9 +128,22 @@ public:
         : GradientHelper(odc){}
 
     VecTensor compute_gradient(Tensor y, Tensor dy) override{
-        using IntVec = std::vector<type::int32::T>;
+        using Ints = std::vector<type::int32::T>;
         VecTensor in_grads;
+        Tensor x = y.get_children()[0];
+        Tensor dx = functional::create_variable(x.shape());
+        auto y_ctx = y.get_context();
+        OpAlgoContext ctx("AvgPoolGradient");
+
+        dx.add_child(x);
+        dx.add_child(y);
+        dx.add_child(dy);
 
+        ctx.add_attr({"kernel", y_ctx.get_attr<Ints>("kernel")});
+        ctx.add_attr({"stride", y_ctx.get_attr<Ints>("stride")});
+        ctx.add_attr({"padding", y_ctx.get_attr<Ints>("padding")});
+        Tensor::AssignOpFunctor(dx, ctx);
+        in_grads.push_back(dx);
         return in_grads;
     }
 };
@@ -132,20 +157,43 @@ Tensor pool_max(Tensor x,
                 std::vector<int> stride, 
                 std::vector<int> padding
                ){
-    int out_h = (x.shape()[2] - kernel[0] + 2 * padding[0]) / stride[0] + 1;
-    int out_w = (x.shape()[3] - kernel[1] + 2 * padding[1]) / stride[1] + 1;
-    Tensor y = create_variable({x.shape()[0], x.shape()[1], out_h, out_w});
-    Tensor idx = create_variable({x.shape()[0], x.shape()[1], out_h, out_w});
+    Tensor y = create_variable(
+        pool_shape("MaxPool", x.shape(), kernel, stride, padding));
     OpAlgoContext ctx("MaxPool");
     y.add_child(x);
     ctx.add_attr({"kernel", kernel});
     ctx.add_attr({"stride", stride});
     ctx.add_attr({"padding", padding});
-    ctx.add_attr({"idx", idx});
+    // the algo adds the "idx" of the maxima, in a layout of its own.
     Tensor::AssignOpFunctor(y, ctx);
 
     return y;
 }
 
+Tensor pool_avg(Tensor x,
+                std::vector<int> kernel,
+                std::vector<int> stride,
+                std::vector<int> padding
+               ){
+    Tensor y = create_variable(
+        pool_shape("AvgPool", x.shape(), kernel, stride, padding));
+    OpAlgoContext ctx("AvgPool");
+    y.add_child(x);
+    ctx.add_attr({"kernel", kernel});
+    ctx.add_attr({"stride", stride});
+    ctx.add_attr({"padding", padding});
+    Tensor::AssignOpFunctor(y, ctx);
+
+    return y;
+}
+
+Tensor global_pool_avg(Tensor x){
+    return pool_avg(x, 
+                    {x.shape()[2], x.shape()[3]},
+                    {1, 1},
+                    {0, 0}
+                   );
+}
+
 } // end namespace functional
 } // end namespace mlfe
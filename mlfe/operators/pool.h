@@ -12,6 +12,16 @@ Tensor pool_max(Tensor x,
                 std::vector<int> padding
                );
 
+// the average excludes the padded elements.
+Tensor pool_avg(Tensor x,
+                std::vector<int> kernel,
+                std::vector<int> stride,
+                std::vector<int> padding
+               );
+
+// averages each channel over the whole plane, y shape is (N, C, 1, 1).
+Tensor global_pool_avg(Tensor x);
+
 } // end namespace functional
 } // end namespace mlfe
 #endif // end ifndef __POOL_OP_HPP__
@@ -1,13 +1,311 @@
 #include "../core/op_algo.h"
 #include "../core/device.h"
 #include "../math/basic_functions.h"
-#include "../math/transform.h"
 #include "../device_context/cpu_context.h"
+#include "../utils/parallel_for.h"
+#include "../utils/types.h"
 #include <algorithm>
-#include <cfloat>
 
 namespace mlfe{
 namespace algorithm_cpu{
+namespace {
+
+// geometry of one (n, c) plane.
+struct pool_geometry{
+    int kh, kw;
+    int sh, sw;
+    int ph, pw;
+    int in_h, in_w;
+    int out_h, out_w;
+
+    // output columns whose window lies fully inside the input width.
+    // they are computed with branch-free loops over the output width.
+    int interior_begin() const{
+        return std::min(out_w, (pw + sw - 1) / sw);
+    }
+
+    int interior_end() const{
+        int end = in_w + pw - kw < 0 ? 0 : (in_w + pw - kw) / sw + 1;
+        return std::max(interior_begin(), std::min(out_w, end));
+    }
+};
+
+// KH, KW, SH and SW are compile time window sizes for the common
+// 2x2/s2 and 3x3/s2 cases, zero means the runtime value in g is used.
+//
+// the max pool mask keeps the argmax as an offset inside the window
+// (i * kw + j), which fits in uint8 for windows up to 16x16
+// and in uint16 otherwise.
+template <class T, class M, int KH, int KW, int SH, int SW>
+void max_pool_plane(const pool_geometry &g, const T *x, T *y, M *mask){
+    const int kh = KH ? KH : g.kh;
+    const int kw = KW ? KW : g.kw;
+    const int sh = SH ? SH : g.sh;
+    const int sw = SW ? SW : g.sw;
+    const int ib = g.interior_begin();
+    const int ie = g.interior_end();
+    for(int oh = 0; oh < g.out_h; ++oh){
+        const int hs = oh * sh - g.ph;
+        const int i_from = std::max(0, -hs);
+        const int i_to = std::min(kh, g.in_h - hs);
+        T *y_row = y + oh * g.out_w;
+        M *m_row = mask + oh * g.out_w;
+        // each window starts from its first element inside the input, so
+        // a window of -inf or nan never keeps a mask into the padding.
+        for(int ow = 0; ow < g.out_w; ++ow){
+            const int ws = ow * sw - g.pw;
+            const int j_from = std::max(0, -ws);
+            y_row[ow] = x[(hs + i_from) * g.in_w + ws + j_from];
+            m_row[ow] = static_cast<M>(i_from * kw + j_from);
+        }
+        for(int i = i_from; i < i_to; ++i){
+            const T *x_row = x + (hs + i) * g.in_w - g.pw;
+            for(int j = 0; j < kw; ++j){
+                const M off = static_cast<M>(i * kw + j);
+                for(int ow = ib; ow < ie; ++ow){
+                    const T val = x_row[ow * sw + j];
+                    const bool gt = val > y_row[ow];
+                    y_row[ow] = gt ? val : y_row[ow];
+                    m_row[ow] = gt ? off : m_row[ow];
+                }
+            }
+        }
+        // left and right border columns see the padding.
+        for(int ow = 0; ow < g.out_w; ++ow){
+            if(ow == ib && ie > ib){
+                ow = ie - 1;
+                continue;
+            }
+            const int ws = ow * sw - g.pw;
+            const int j_from = std::max(0, -ws);
+            const int j_to = std::min(kw, g.in_w - ws);
+            for(int i = i_from; i < i_to; ++i){
+                const T *x_row = x + (hs + i) * g.in_w + ws;
+                for(int j = j_from; j < j_to; ++j){
+                    if(x_row[j] > y_row[ow]){
+                        y_row[ow] = x_row[j];
+                        m_row[ow] = static_cast<M>(i * kw + j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// dx must be zero filled.
+template <class T, class M, int KH, int KW, int SH, int SW>
+void max_pool_grad_plane(const pool_geometry &g,
+                         const M *mask,
+                         const T *dy,
+                         T *dx
+                        ){
+    const int kw = KW ? KW : g.kw;
+    const int sh = SH ? SH : g.sh;
+    const int sw = SW ? SW : g.sw;
+    for(int oh = 0; oh < g.out_h; ++oh){
+        const int hs = oh * sh - g.ph;
+        for(int ow = 0; ow < g.out_w; ++ow){
+            const int idx = oh * g.out_w + ow;
+            const int off = mask[idx];
+            const int h = hs + off / kw;
+            const int w = ow * sw - g.pw + off % kw;
+            dx[h * g.in_w + w] += dy[idx];
+        }
+    }
+}
+
+// the average excludes the padded elements.
+template <class T, int KH, int KW, int SH, int SW>
+void avg_pool_plane(const pool_geometry &g, const T *x, T *y){
+    const int kh = KH ? KH : g.kh;
+    const int kw = KW ? KW : g.kw;
+    const int sh = SH ? SH : g.sh;
+    const int sw = SW ? SW : g.sw;
+    const int ib = g.interior_begin();
+    const int ie = g.interior_end();
+    for(int oh = 0; oh < g.out_h; ++oh){
+        const int hs = oh * sh - g.ph;
+        const int i_from = std::max(0, -hs);
+        const int i_to = std::min(kh, g.in_h - hs);
+        T *y_row = y + oh * g.out_w;
+        std::fill(y_row, y_row + g.out_w, T(0));
+        for(int i = i_from; i < i_to; ++i){
+            const T *x_row = x + (hs + i) * g.in_w - g.pw;
+            for(int j = 0; j < kw; ++j){
+                for(int ow = ib; ow < ie; ++ow){
+                    y_row[ow] += x_row[ow * sw + j];
+                }
+            }
+        }
+        const T inv = T(1) / T(std::max(i_to - i_from, 1) * kw);
+        for(int ow = ib; ow < ie; ++ow){
+            y_row[ow] *= inv;
+        }
+        for(int ow = 0; ow < g.out_w; ++ow){
+            if(ow == ib && ie > ib){
+                ow = ie - 1;
+                continue;
+            }
+            const int ws = ow * sw - g.pw;
+            const int j_from = std::max(0, -ws);
+            const int j_to = std::min(kw, g.in_w - ws);
+            T sum = T(0);
+            for(int i = i_from; i < i_to; ++i){
+                const T *x_row = x + (hs + i) * g.in_w + ws;
+                for(int j = j_from; j < j_to; ++j){
+                    sum += x_row[j];
+                }
+            }
+            const int count = (i_to - i_from) * (j_to - j_from);
+            y_row[ow] = count > 0 ? sum / T(count) : T(0);
+        }
+    }
+}
+
+// dx must be zero filled.
+template <class T, int KH, int KW, int SH, int SW>
+void avg_pool_grad_plane(const pool_geometry &g,
+                         const T *dy,
+                         T *dx,
+                         T *scaled_dy
+                        ){
+    const int kh = KH ? KH : g.kh;
+    const int kw = KW ? KW : g.kw;
+    const int sh = SH ? SH : g.sh;
+    const int sw = SW ? SW : g.sw;
+    for(int oh = 0; oh < g.out_h; ++oh){
+        const int hs = oh * sh - g.ph;
+        const int i_from = std::max(0, -hs);
+        const int i_to = std::min(kh, g.in_h - hs);
+        const T *dy_row = dy + oh * g.out_w;
+        for(int ow = 0; ow < g.out_w; ++ow){
+            const int ws = ow * sw - g.pw;
+            const int j_from = std::max(0, -ws);
+            const int j_to = std::min(kw, g.in_w - ws);
+            const int count = (i_to - i_from) * (j_to - j_from);
+            scaled_dy[ow] = count > 0 ? dy_row[ow] / T(count) : T(0);
+        }
+        for(int ow = 0; ow < g.out_w; ++ow){
+            const int ws = ow * sw - g.pw;
+            const int j_from = std::max(0, -ws);
+            const int j_to = std::min(kw, g.in_w - ws);
+            for(int i = i_from; i < i_to; ++i){
+                T *dx_row = dx + (hs + i) * g.in_w + ws;
+                for(int j = j_from; j < j_to; ++j){
+                    dx_row[j] += scaled_dy[ow];
+                }
+            }
+        }
+    }
+}
+
+// picks a specialized plane function for 2x2/s2 and 3x3/s2 windows.
+template <class Fn2x2, class Fn3x3, class FnAny>
+void dispatch_window(const pool_geometry &g,
+                     Fn2x2 fn_2x2,
+                     Fn3x3 fn_3x3,
+                     FnAny fn_any
+                    ){
+    if(g.sh == 2 && g.sw == 2 && g.kh == 2 && g.kw == 2){
+        fn_2x2();
+    }
+    else if(g.sh == 2 && g.sw == 2 && g.kh == 3 && g.kw == 3){
+        fn_3x3();
+    }
+    else{
+        fn_any();
+    }
+}
+
+// planes handled by one parallel_for chunk.
+inline int pool_grain(const pool_geometry &g){
+    return std::max(1, (1 << 14) / std::max(g.in_h * g.in_w, 1));
+}
+
+template <class T, class M>
+void max_pool(const pool_geometry &g,
+              const int planes,
+              const T *x_ptr,
+              T *y_ptr,
+              M *mask_ptr
+             ){
+    const int x_step = g.in_h * g.in_w;
+    const int y_step = g.out_h * g.out_w;
+    parallel_for(0, planes, pool_grain(g), [&](int from, int to){
+        for(int p = from; p < to; ++p){
+            const T *x = x_ptr + p * x_step;
+            T *y = y_ptr + p * y_step;
+            M *mask = mask_ptr + p * y_step;
+            dispatch_window(g,
+                [&](){ max_pool_plane<T, M, 2, 2, 2, 2>(g, x, y, mask); },
+                [&](){ max_pool_plane<T, M, 3, 3, 2, 2>(g, x, y, mask); },
+                [&](){ max_pool_plane<T, M, 0, 0, 0, 0>(g, x, y, mask); });
+        }
+    });
+}
+
+template <class T, class M>
+void max_pool_grad(const pool_geometry &g,
+                   const int planes,
+                   const M *mask_ptr,
+                   const T *dy_ptr,
+                   T *dx_ptr
+                  ){
+    const int x_step = g.in_h * g.in_w;
+    const int y_step = g.out_h * g.out_w;
+    parallel_for(0, planes, pool_grain(g), [&](int from, int to){
+        std::fill(dx_ptr + from * x_step, dx_ptr + to * x_step, T(0));
+        for(int p = from; p < to; ++p){
+            const M *mask = mask_ptr + p * y_step;
+            const T *dy = dy_ptr + p * y_step;
+            T *dx = dx_ptr + p * x_step;
+            dispatch_window(g,
+                [&](){ max_pool_grad_plane<T, M, 2, 2, 2, 2>(g, mask, dy, dx); },
+                [&](){ max_pool_grad_plane<T, M, 3, 3, 2, 2>(g, mask, dy, dx); },
+                [&](){ max_pool_grad_plane<T, M, 0, 0, 0, 0>(g, mask, dy, dx); });
+        }
+    });
+}
+
+pool_geometry make_geometry(Tensor x,
+                            Tensor y,
+                            std::vector<type::int32::T> filters_hw,
+                            std::vector<type::int32::T> strides,
+                            std::vector<type::int32::T> pads
+                           ){
+    pool_geometry g;
+    g.kh = filters_hw[0];
+    g.kw = filters_hw[1];
+    g.sh = strides[0];
+    g.sw = strides[1];
+    g.ph = pads[0];
+    g.pw = pads[1];
+    g.in_h = x.shape()[2];
+    g.in_w = x.shape()[3];
+    g.out_h = y.shape()[2];
+    g.out_w = y.shape()[3];
+    return g;
+}
+
+// a window covering the whole unpadded plane is a global pooling.
+inline bool is_global(const pool_geometry &g){
+    return g.kh == g.in_h && g.kw == g.in_w &&
+        g.ph == 0 && g.pw == 0 && g.out_h == 1 && g.out_w == 1;
+}
+
+// a compare or an add per kernel element of each output.
+OpAlgoCost pool_cost(OpAlgoContext *oac){
+    using IntVec = std::vector<type::int32::T>;
+    auto kernel = oac->get_attr<IntVec>("kernel");
+    return streaming_cost(oac, kernel[0] * kernel[1]);
+}
+
+// the offsets of a window up to 16x16 fit in a uint8 mask.
+inline bool is_compact(const std::vector<type::int32::T> &kernel){
+    return kernel[0] * kernel[1] <= 256;
+}
+
+} // end anonymous namespace
 
 template <class Tp>
 class MaxPool : public OpAlgo{
@@ -20,60 +318,37 @@ public:
         filters_hw = oac->get_attr<IntVec>("kernel");
         strides = oac->get_attr<IntVec>("stride");
         pads = oac->get_attr<IntVec>("padding");
-        idx = oac->get_attr<Tensor>("idx");
+        // the mask, for the gradient, in uint8 or uint16 offsets.
+        if(is_compact(filters_hw)){
+            idx = functional::create_variable(y.shape(), type::uint8());
+        }
+        else{
+            idx = functional::create_variable(y.shape(), type::uint16());
+        }
+        oac->add_attr({"idx", idx});
 
-        batch = x.shape()[0];
-        in_c = x.shape()[1];
-        in_h = x.shape()[2];
-        in_w = x.shape()[3];
-        out_h = y.shape()[2];
-        out_w = y.shape()[3];
+        planes = x.shape()[0] * x.shape()[1];
+        geometry = make_geometry(x, y, filters_hw, strides, pads);
     }
 
     void Compute() override{
         auto x_ptr = x.device_data<T>();
-        auto idx_ptr = idx.mutable_device_data<int>();
         auto y_ptr = y.mutable_device_data<T>();
-
-        math::set<T, CPUContext>(
-            y.size(),
-            T(-FLT_MAX),
-            y.mutable_device_data<T>()
-            );
-
-        for(int n = 0; n < batch; ++n){
-            for(int c = 0; c < in_c; ++c){
-                for(int ph = 0; ph < out_h; ++ph){
-                    for(int pw = 0; pw < out_w; ++pw){
-                        int hstart = ph * strides[0];
-                        int wstart = pw * strides[1];
-                        int hend = std::min<int>(hstart + filters_hw[0], in_h);
-                        int wend = std::min<int>(wstart + filters_hw[1], in_w);
-                        const int pool_index = ph * out_w + pw;
-                        for(int h = hstart; h < hend; ++h){
-                            for(int w = wstart; w < wend; ++w){
-                                const int index = h * in_w + w;
-                                if(x_ptr[index] > y_ptr[pool_index]){
-                                    y_ptr[pool_index] = x_ptr[index];
-                                    idx_ptr[pool_index] = index;
-                                }
-                            }
-                        }
-                    }
-                }
-                x_ptr += in_h * in_w;
-                y_ptr += out_h * out_w;
-                idx_ptr += out_h * out_w;
-            }
+        if(is_compact(filters_hw)){
+            auto mask_ptr = idx.mutable_device_data<type::uint8::T>();
+            max_pool(geometry, planes, x_ptr, y_ptr, mask_ptr);
+        }
+        else{
+            auto mask_ptr = idx.mutable_device_data<type::uint16::T>();
+            max_pool(geometry, planes, x_ptr, y_ptr, mask_ptr);
         }
     }
 private:
     Tensor x;
     Tensor idx;
     Tensor y;
-    int batch;
-    int in_c, in_h, in_w;
-    int out_h, out_w;
+    int planes;
+    pool_geometry geometry;
     std::vector<type::int32::T> filters_hw;
     std::vector<type::int32::T> strides;
     std::vector<type::int32::T> pads;
@@ -84,6 +359,7 @@ REGIST_OP_ALGO(MaxPool)
     .Output("IDX", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CPU")
+    .CostFn(pool_cost)
     .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
         using T = MaxPool<type::float32>;
         return std::make_shared<T>(oac);
@@ -104,39 +380,20 @@ public:
         pads = oac->get_attr<IntVec>("padding");
         idx = oac->get_attr<Tensor>("idx");
 
-        batch = x.shape()[0];
-        in_c = x.shape()[1];
-        in_h = x.shape()[2];
-        in_w = x.shape()[3];
-        out_h = dy.shape()[2];
-        out_w = dy.shape()[3];
+        planes = x.shape()[0] * x.shape()[1];
+        geometry = make_geometry(x, dy, filters_hw, strides, pads);
     }
 
     void Compute() override{
-        auto x_ptr = x.device_data<T>();
-        auto idx_ptr = idx.device_data<int>();
         auto dy_ptr = dy.device_data<T>();
         auto dx_ptr = dx.mutable_device_data<T>();
-
-        math::set<T, CPUContext>(
-            dx.size(),
-            static_cast<T>(0),
-            dx_ptr
-            );
-
-        for(int n = 0; n < batch; ++n){
-            for(int c = 0; c < in_c; ++c){
-                for(int ph = 0; ph < out_h; ++ph){
-                    for(int pw = 0; pw < out_w; ++pw){
-                        const int index = ph * out_w + pw;
-                        const int bottom_index = idx_ptr[index];
-                        dx_ptr[bottom_index] += dy_ptr[index];
-                    }
-                }
-                dx_ptr += in_h * in_w;
-                dy_ptr += out_h * out_w;
-                idx_ptr += out_h * out_w;
-            }
+        if(is_compact(filters_hw)){
+            auto mask_ptr = idx.device_data<type::uint8::T>();
+            max_pool_grad(geometry, planes, mask_ptr, dy_ptr, dx_ptr);
+        }
+        else{
+            auto mask_ptr = idx.device_data<type::uint16::T>();
+            max_pool_grad(geometry, planes, mask_ptr, dy_ptr, dx_ptr);
         }
     }
 
@@ -145,9 +402,8 @@ private:
     Tensor idx;
     Tensor dy;
     Tensor dx;
-    int batch;
-    int in_c, in_h, in_w;
-    int out_h, out_w;
+    int planes;
+    pool_geometry geometry;
     std::vector<type::int32::T> filters_hw;
     std::vector<type::int32::T> strides;
     std::vector<type::int32::T> pads;
@@ -166,5 +422,144 @@ REGIST_OP_GRAD_ALGO(MaxPool)
     })
     .Finish();
 
+template <class Tp>
+class AvgPool : public OpAlgo{
+using T = typename Tp::T;
+public:
+    AvgPool(OpAlgoContext *oac) : OpAlgo(oac, "AvgPool"){
+        using IntVec = std::vector<type::int32::T>;
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+        filters_hw = oac->get_attr<IntVec>("kernel");
+        strides = oac->get_attr<IntVec>("stride");
+        pads = oac->get_attr<IntVec>("padding");
+
+        planes = x.shape()[0] * x.shape()[1];
+        geometry = make_geometry(x, y, filters_hw, strides, pads);
+    }
+
+    void Compute() override{
+        auto x_ptr = x.device_data<T>();
+        auto y_ptr = y.mutable_device_data<T>();
+        const pool_geometry &g = geometry;
+        const int x_step = g.in_h * g.in_w;
+        const int y_step = g.out_h * g.out_w;
+        if(is_global(g)){
+            const T inv = T(1) / T(x_step);
+            parallel_for(0, planes, pool_grain(g), [&](int from, int to){
+                for(int p = from; p < to; ++p){
+                    const T *x = x_ptr + p * x_step;
+                    T sum = T(0);
+                    for(int k = 0; k < x_step; ++k){
+                        sum += x[k];
+                    }
+                    y_ptr[p] = sum * inv;
+                }
+            });
+            return;
+        }
+        parallel_for(0, planes, pool_grain(g), [&](int from, int to){
+            for(int p = from; p < to; ++p){
+                const T *x = x_ptr + p * x_step;
+                T *y = y_ptr + p * y_step;
+                dispatch_window(g,
+                    [&](){ avg_pool_plane<T, 2, 2, 2, 2>(g, x, y); },
+                    [&](){ avg_pool_plane<T, 3, 3, 2, 2>(g, x, y); },
+                    [&](){ avg_pool_plane<T, 0, 0, 0, 0>(g, x, y); });
+            }
+        });
+    }
+private:
+    Tensor x;
+    Tensor y;
+    int planes;
+    pool_geometry geometry;
+    std::vector<type::int32::T> filters_hw;
+    std::vector<type::int32::T> strides;
+    std::vector<type::int32::T> pads;
+};
+
+REGIST_OP_ALGO(AvgPool)
+    .Input("X", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CostFn(pool_cost)
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = AvgPool<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class AvgPoolGrad : public OpAlgo{
+using T = typename Tp::T;
+public:
+    AvgPoolGrad(OpAlgoContext *oac) : OpAlgo(oac){
+        using IntVec = std::vector<type::int32::T>;
+        dx = oac->get_output(0);
+        x = dx.get_children()[0];
+        dy = dx.get_children()[2];
+        filters_hw = oac->get_attr<IntVec>("kernel");
+        strides = oac->get_attr<IntVec>("stride");
+        pads = oac->get_attr<IntVec>("padding");
+
+        planes = x.shape()[0] * x.shape()[1];
+        geometry = make_geometry(x, dy, filters_hw, strides, pads);
+    }
+
+    void Compute() override{
+        auto dy_ptr = dy.device_data<T>();
+        auto dx_ptr = dx.mutable_device_data<T>();
+        const pool_geometry &g = geometry;
+        const int x_step = g.in_h * g.in_w;
+        const int y_step = g.out_h * g.out_w;
+        if(is_global(g)){
+            const T inv = T(1) / T(x_step);
+            parallel_for(0, planes, pool_grain(g), [&](int from, int to){
+                for(int p = from; p < to; ++p){
+                    T *dx = dx_ptr + p * x_step;
+                    std::fill(dx, dx + x_step, dy_ptr[p] * inv);
+                }
+            });
+            return;
+        }
+        parallel_for(0, planes, pool_grain(g), [&](int from, int to){
+            std::vector<T> scaled_dy(g.out_w);
+            std::fill(dx_ptr + from * x_step, dx_ptr + to * x_step, T(0));
+            for(int p = from; p < to; ++p){
+                const T *dy = dy_ptr + p * y_step;
+                T *dx = dx_ptr + p * x_step;
+                T *sdy = scaled_dy.data();
+                dispatch_window(g,
+                    [&](){ avg_pool_grad_plane<T, 2, 2, 2, 2>(g, dy, dx, sdy); },
+                    [&](){ avg_pool_grad_plane<T, 3, 3, 2, 2>(g, dy, dx, sdy); },
+                    [&](){ avg_pool_grad_plane<T, 0, 0, 0, 0>(g, dy, dx, sdy); });
+            }
+        });
+    }
+
+private:
+    Tensor x;
+    Tensor dy;
+    Tensor dx;
+    int planes;
+    pool_geometry geometry;
+    std::vector<type::int32::T> filters_hw;
+    std::vector<type::int32::T> strides;
+    std::vector<type::int32::T> pads;
+};
+
+REGIST_OP_GRAD_ALGO(AvgPool)
+    .Input("X", type::float32::string)
+    .Input("Y", type::float32::string)
+    .Input("dY", type::float32::string)
+    .Output("dX", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = AvgPoolGrad<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
 } // end namespace algorithm_cpu
 } // end namespace mlfe
@@ -18,7 +18,9 @@ public:
         filters_hw = oac->get_attr<IntVec>("kernel");
         strides = oac->get_attr<IntVec>("stride");
         pads = oac->get_attr<IntVec>("padding");
-        idx = oac->get_attr<Tensor>("idx");
+        // the int index of each maximum, for the gradient.
+        idx = functional::create_variable(y.shape(), type::int32());
+        oac->add_attr({"idx", idx});
 
         in_c = x.shape()[1];
         in_h = x.shape()[2];
@@ -58,7 +58,7 @@ public:
             PoolingMode,
             CUDNN_PROPAGATE_NAN,
             filters_hw[0], filters_hw[1],
-            0, 0,
+            pads[0], pads[1],
             strides[0], strides[1]
         ));
     }
@@ -107,7 +107,6 @@ REGIST_OP_ALGO(MaxPool)
 
 REGIST_OP_ALGO(AvgPool)
     .Input("X", type::float32::string)
-    .Output("IDX", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CUDA(CUDNN)")
     .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
@@ -167,7 +166,7 @@ public:
             PoolingMode,
             CUDNN_PROPAGATE_NAN,
             filters_hw[0], filters_hw[1],
-            0, 0,
+            pads[0], pads[1],
             strides[0], strides[1]
         ));
     }
@@ -222,7 +221,6 @@ REGIST_OP_GRAD_ALGO(MaxPool)
 
 REGIST_OP_GRAD_ALGO(AvgPool)
     .Input("X", type::float32::string)
-    .Input("IDX", type::float32::string)
     .Input("Y", type::float32::string)
     .Input("dY", type::float32::string)
     .Output("dX", type::float32::string)
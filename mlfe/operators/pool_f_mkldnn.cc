@@ -0,0 +1,149 @@
+#include "../core/op_algo.h"
+#include "../core/device.h"
+#include "../device_context/mkldnn_context.h"
+
+namespace mlfe{
+namespace algorithm_mkldnn{
+using namespace dnnl;
+using MKLDNN = MKLDNNContext;
+
+namespace{
+
+// the forward primitive, the gradient needs it as a hint. it keeps the
+// layout of x, which is blocked after a oneDNN convolution.
+pooling_forward::primitive_desc forward_desc(OpAlgoContext *oac,
+                                             Tensor x,
+                                             std::vector<int> y_shape
+                                            ){
+    using IntVec = std::vector<type::int32::T>;
+    auto pads = MKLDNN::dims(oac->get_attr<IntVec>("padding"));
+    return pooling_forward::primitive_desc(
+        MKLDNN::engine(),
+        prop_kind::forward_training,
+        algorithm::pooling_max,
+        MKLDNN::layout(x),
+        MKLDNN::any_desc(y_shape),
+        MKLDNN::dims(oac->get_attr<IntVec>("stride")),
+        MKLDNN::dims(oac->get_attr<IntVec>("kernel")),
+        dnnl::memory::dims{0, 0},
+        pads, pads);
+}
+
+} // end anonymous namespace
+
+// the workspace of the primitive, where the maxima are, replaces the mask
+// of the cpu algorithm. it is shared with the gradient through the memory
+// of the idx tensor.
+template <class Tp>
+class MaxPool : public OpAlgo{
+using T = typename Tp::T;
+public:
+    MaxPool(OpAlgoContext *oac) : OpAlgo(oac, "MaxPool"){
+        y = oac->get_output(0);
+        x = y.get_children()[0];
+        // idx only keys the workspace, for the gradient.
+        idx = functional::create_variable({1});
+        oac->add_attr({"idx", idx});
+        auto pd = forward_desc(oac, x, y.shape());
+        pool = pooling_forward(pd);
+        x_in = mkldnn_input(x, pd.src_desc());
+        y_out = mkldnn_output(y, pd.dst_desc());
+        workspace = MKLDNN::shared_memory(idx, pd.workspace_desc());
+    }
+
+    void Compute() override{
+        pool.execute(MKLDNN::stream(), {
+            {DNNL_ARG_SRC, x_in.get()},
+            {DNNL_ARG_DST, y_out.get()},
+            {DNNL_ARG_WORKSPACE, workspace}
+        });
+        MKLDNN::stream().wait();
+        y_out.publish();
+    }
+
+private:
+    Tensor x;
+    Tensor idx;
+    Tensor y;
+    pooling_forward pool;
+    mkldnn_input x_in;
+    mkldnn_output y_out;
+    dnnl::memory workspace;
+};
+
+REGIST_OP_ALGO(MaxPool)
+    .Input("X", type::float32::string)
+    .Output("IDX", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        using T = MaxPool<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+template <class Tp>
+class MaxPoolGrad : public OpAlgo{
+using T = typename Tp::T;
+public:
+    MaxPoolGrad(OpAlgoContext *oac) : OpAlgo(oac, "MaxPoolGradient"){
+        using IntVec = std::vector<type::int32::T>;
+        dx = oac->get_output(0);
+        x = dx.get_children()[0];
+        dy = dx.get_children()[2];
+        idx = oac->get_attr<Tensor>("idx");
+        auto hint = forward_desc(oac, x, dy.shape());
+        auto pads = MKLDNN::dims(oac->get_attr<IntVec>("padding"));
+        // dx and dy in the layouts of x and y.
+        auto pd = pooling_backward::primitive_desc(
+            MKLDNN::engine(),
+            algorithm::pooling_max,
+            hint.src_desc(),
+            hint.dst_desc(),
+            MKLDNN::dims(oac->get_attr<IntVec>("stride")),
+            MKLDNN::dims(oac->get_attr<IntVec>("kernel")),
+            dnnl::memory::dims{0, 0},
+            pads, pads,
+            hint);
+        pool = pooling_backward(pd);
+        dy_in = mkldnn_input(dy, pd.diff_dst_desc());
+        dx_out = mkldnn_output(dx, pd.diff_src_desc());
+        workspace = MKLDNN::shared_memory(idx, hint.workspace_desc());
+    }
+
+    void Compute() override{
+        pool.execute(MKLDNN::stream(), {
+            {DNNL_ARG_DIFF_DST, dy_in.get()},
+            {DNNL_ARG_DIFF_SRC, dx_out.get()},
+            {DNNL_ARG_WORKSPACE, workspace}
+        });
+        MKLDNN::stream().wait();
+        dx_out.publish();
+    }
+
+private:
+    Tensor x;
+    Tensor idx;
+    Tensor dy;
+    Tensor dx;
+    pooling_backward pool;
+    mkldnn_input dy_in;
+    mkldnn_output dx_out;
+    dnnl::memory workspace;
+};
+
+REGIST_OP_GRAD_ALGO(MaxPool)
+    .Input("X", type::float32::string)
+    .Input("IDX", type::float32::string)
+    .Input("Y", type::float32::string)
+    .Input("dY", type::float32::string)
+    .Output("dX", type::float32::string)
+    .Device("CPU(MKLDNN)")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = MaxPoolGrad<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_mkldnn
+} // end namespace mlfe
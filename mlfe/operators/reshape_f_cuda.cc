@@ -20,6 +20,8 @@ REGIST_OP_ALGO(Reshape)
     .Input("X", type::float32::string)
     .Output("Y", type::float32::string)
     .Device("CUDA")
+    // nothing moves, the output is the memory of the input.
+    .CostFn([](OpAlgoContext *oac){ return OpAlgoCost(); })
     .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
         using T = Reshape<type::float32>;
         return std::make_shared<T>(oac);
@@ -45,6 +47,8 @@ REGIST_OP_GRAD_ALGO(Reshape)
     .Input("dY", type::float32::string)
     .Output("dX", type::float32::string)
     .Device("CUDA")
+    // nothing moves, the output is the memory of the input.
+    .CostFn([](OpAlgoContext *oac){ return OpAlgoCost(); })
     .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
         using T = ReshapeGrad<type::float32>;
         return std::make_shared<T>(oac);
@@ -3,5 +3,7 @@
 #include "optimizers/gradient_descent.h"
 #include "optimizers/adadelta.h"
 #include "optimizers/adam.h"
+#include "optimizers/adamw.h"
+#include "optimizers/lamb.h"
 
 #endif // end #ifndef __OPTIMIZERS_H__
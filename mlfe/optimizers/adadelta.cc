@@ -11,6 +11,9 @@ public:
 
     void apply(Tensor var, Tensor var_grad) override;
 
+protected:
+    void add_attrs(OpAlgoContext &oac) const override;
+
 private:
     double _lr;
     double _mm;
@@ -20,7 +23,7 @@ private:
 };
 
 adadelta::adadelta(double lr, double mm, double eps)
-    : _lr(lr), _mm(mm), _eps(eps){
+    : optimizer("AdaDelta"), _lr(lr), _mm(mm), _eps(eps){
     auto dev = get_enabled_device();
     std::string op_name = "AdaDelta";
     std::string full_op_name = "Name:" + op_name + "/Device:";
@@ -32,12 +35,16 @@ void adadelta::apply(Tensor var, Tensor var_grad){
     if(_reg_var.find(var) == _reg_var.end()){
         OpAlgoContext oac("AdaDelta");
         oac.add_output(var);
-        oac.add_attr({"LearningRate", static_cast<float>(_lr)});
-        oac.add_attr({"Momentum", static_cast<float>(_mm)});
-        oac.add_attr({"Epsilon", static_cast<float>(_eps)});
+        add_attrs(oac);
         _reg_var[var] = OpAlgoRegistry::Get()->GetOpAlgo(_opt_name, &oac);
     }
-    _reg_var[var]->Compute();
+    _reg_var[var]->Run();
+}
+
+void adadelta::add_attrs(OpAlgoContext &oac) const{
+    oac.add_attr({"LearningRate", static_cast<float>(_lr)});
+    oac.add_attr({"MomentumRate", static_cast<float>(_mm)});
+    oac.add_attr({"Epsilon", static_cast<float>(_eps)});
 }
 
 } // end namespace optimizer
@@ -2,6 +2,7 @@
 #include "../device_context/cpu_context.h"
 #include "../math/basic_functions.h"
 #include "../math/optimizers.h"
+#include "../utils/parallel_for.h"
 
 namespace mlfe{
 namespace algorithm_cpu{
@@ -74,5 +75,82 @@ REGIST_OP_ALGO(AdaDelta)
     })
     .Finish();
 
+// AdaDelta over all outputs at once, see MultiTensorGradientDescent.
+template <class Tp>
+class MultiTensorAdaDelta : public OpAlgo{
+using T = typename Tp::T;
+public:
+    MultiTensorAdaDelta(OpAlgoContext *oac) : OpAlgo(oac){
+        offsets.push_back(0);
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+            dxs.push_back(xs.back().grad());
+            offsets.push_back(offsets.back() + xs.back().size());
+        }
+        lr = oac->get_attr<T>("LearningRate");
+        mr = oac->get_attr<T>("MomentumRate");
+        eps = oac->get_attr<T>("Epsilon");
+        grad_hist = create_memory(offsets.back() * Tp::size);
+        acc_hist = create_memory(offsets.back() * Tp::size);
+        x_ptrs.resize(xs.size());
+        dx_ptrs.resize(xs.size());
+
+        math::set<T, CPUContext>(
+            offsets.back(),
+            static_cast<T>(0),
+            grad_hist->mutable_device_data<T>()
+            );
+        math::set<T, CPUContext>(
+            offsets.back(),
+            static_cast<T>(0),
+            acc_hist->mutable_device_data<T>()
+            );
+    }
+
+    void Compute() override{
+        for(int n = 0; n < xs.size(); ++n){
+            x_ptrs[n] = xs[n].mutable_device_data<T>();
+            dx_ptrs[n] = dxs[n].device_data<T>();
+        }
+        auto grad_hist_ptr = grad_hist->mutable_device_data<T>();
+        auto acc_hist_ptr = acc_hist->mutable_device_data<T>();
+
+        parallel_for_segments(offsets, math::multi_tensor_grain,
+            [&](int n, int from, int to){
+                math::adadelta<T, CPUContext>(
+                    to - from,
+                    x_ptrs[n] + from,
+                    dx_ptrs[n] + from,
+                    grad_hist_ptr + offsets[n] + from,
+                    acc_hist_ptr + offsets[n] + from,
+                    lr,
+                    mr,
+                    eps
+                    );
+            });
+    }
+
+private:
+    std::vector<Tensor> xs;
+    std::vector<Tensor> dxs;
+    std::vector<T *> x_ptrs;
+    std::vector<const T *> dx_ptrs;
+    std::vector<int> offsets;
+    memory_ptr grad_hist;
+    memory_ptr acc_hist;
+    T lr;
+    T mr;
+    T eps;
+};
+
+REGIST_OP_ALGO(MultiTensorAdaDelta)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = MultiTensorAdaDelta<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
 } // end namespace algorithm_cpu
 } // end namespace mlfe
@@ -2,6 +2,7 @@
 #include "../device_context/cpu_context.h"
 #include "../math/basic_functions.h"
 #include "../math/optimizers.h"
+#include "../utils/parallel_for.h"
 
 namespace mlfe{
 namespace algorithm_cpu{
@@ -17,6 +18,7 @@ public:
         beta1 = oac->get_attr<T>("Beta1");
         beta2 = oac->get_attr<T>("Beta2");
         eps = oac->get_attr<T>("Epsilon");
+        step = 0;
         size = x.size();
 
         m_hist = create_memory(size * Tp::size);
@@ -49,7 +51,8 @@ public:
             T(lr),
             T(beta1),
             T(beta2),
-            T(eps)
+            T(eps),
+            ++step
             );
     }
 
@@ -64,6 +67,7 @@ private:
     T beta1;
     T beta2;
     T eps;
+    int step;
 };
 
 REGIST_OP_ALGO(Adam)
@@ -77,5 +81,89 @@ REGIST_OP_ALGO(Adam)
     })
     .Finish();
 
+// Adam over all outputs at once, see MultiTensorGradientDescent.
+template <class Tp>
+class MultiTensorAdam : public OpAlgo{
+using T = typename Tp::T;
+public:
+    MultiTensorAdam(OpAlgoContext *oac) : OpAlgo(oac){
+        offsets.push_back(0);
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+            dxs.push_back(xs.back().grad());
+            offsets.push_back(offsets.back() + xs.back().size());
+        }
+        lr = oac->get_attr<T>("LearningRate");
+        beta1 = oac->get_attr<T>("Beta1");
+        beta2 = oac->get_attr<T>("Beta2");
+        eps = oac->get_attr<T>("Epsilon");
+        step = 0;
+        m_hist = create_memory(offsets.back() * Tp::size);
+        v_hist = create_memory(offsets.back() * Tp::size);
+        x_ptrs.resize(xs.size());
+        dx_ptrs.resize(xs.size());
+
+        math::set<T, CPUContext>(
+            offsets.back(),
+            static_cast<T>(0),
+            m_hist->mutable_device_data<T>()
+            );
+        math::set<T, CPUContext>(
+            offsets.back(),
+            static_cast<T>(0),
+            v_hist->mutable_device_data<T>()
+            );
+    }
+
+    void Compute() override{
+        for(int n = 0; n < xs.size(); ++n){
+            x_ptrs[n] = xs[n].mutable_device_data<T>();
+            dx_ptrs[n] = dxs[n].device_data<T>();
+        }
+        auto m_hist_ptr = m_hist->mutable_device_data<T>();
+        auto v_hist_ptr = v_hist->mutable_device_data<T>();
+
+        ++step;
+        parallel_for_segments(offsets, math::multi_tensor_grain,
+            [&](int n, int from, int to){
+                math::adam<T, CPUContext>(
+                    to - from,
+                    x_ptrs[n] + from,
+                    dx_ptrs[n] + from,
+                    m_hist_ptr + offsets[n] + from,
+                    v_hist_ptr + offsets[n] + from,
+                    lr,
+                    beta1,
+                    beta2,
+                    eps,
+                    step
+                    );
+            });
+    }
+
+private:
+    std::vector<Tensor> xs;
+    std::vector<Tensor> dxs;
+    std::vector<T *> x_ptrs;
+    std::vector<const T *> dx_ptrs;
+    std::vector<int> offsets;
+    memory_ptr m_hist;
+    memory_ptr v_hist;
+    T lr;
+    T beta1;
+    T beta2;
+    T eps;
+    int step;
+};
+
+REGIST_OP_ALGO(MultiTensorAdam)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = MultiTensorAdam<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
 } // end namespace algorithm_cpu
 } // end namespace mlfe
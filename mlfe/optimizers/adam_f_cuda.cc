@@ -18,6 +18,7 @@ public:
         beta1 = oac->get_attr<T>("Beta1");
         beta2 = oac->get_attr<T>("Beta2");
         eps = oac->get_attr<T>("Epsilon");
+        step = 0;
         size = x.size();
 
         m_hist = create_memory(size * Tp::size);
@@ -50,7 +51,8 @@ public:
                                    T(lr),
                                    T(beta1),
                                    T(beta2),
-                                   T(eps)
+                                   T(eps),
+                                   ++step
                                   );
     }
 
@@ -65,6 +67,7 @@ private:
     T beta1;
     T beta2;
     T eps;
+    int step;
 };
 
 REGIST_OP_ALGO(Adam)
@@ -0,0 +1,70 @@
+#include "adamw.h"
+#include "../core/op_algo.h"
+
+namespace mlfe{
+namespace opt{
+
+class adamw : public optimizer{
+    using algo_ptr = std::shared_ptr<OpAlgo>;
+public:
+    adamw(double lr, double beta1, double beta2, double eps, double decay);
+
+    void apply(Tensor var, Tensor var_grad) override;
+
+protected:
+    void add_attrs(OpAlgoContext &oac) const override;
+
+private:
+    double _lr;
+    double _b1;
+    double _b2;
+    double _eps;
+    double _decay;
+    std::unordered_map<Tensor, algo_ptr> _reg_var;
+    std::string _opt_name;
+};
+
+adamw::adamw(double lr, double beta1, double beta2, double eps, double decay)
+    : optimizer("AdamW"),
+      _lr(lr), _b1(beta1), _b2(beta2), _eps(eps), _decay(decay){
+    auto dev = get_enabled_device();
+    std::string op_name = "AdamW";
+    std::string full_op_name = "Name:" + op_name + "/Device:";
+    std::string dev_name = dev->get_device_name();
+    _opt_name = full_op_name + dev_name;
+}
+
+void adamw::apply(Tensor var, Tensor var_grad){
+    if(_reg_var.find(var) == _reg_var.end()){
+        OpAlgoContext oac("AdamW");
+        oac.add_output(var);
+        add_attrs(oac);
+        _reg_var[var] = OpAlgoRegistry::Get()->GetOpAlgo(_opt_name, &oac);
+    }
+    _reg_var[var]->Run();
+}
+
+void adamw::add_attrs(OpAlgoContext &oac) const{
+    oac.add_attr({"LearningRate", static_cast<float>(_lr)});
+    oac.add_attr({"Beta1", static_cast<float>(_b1)});
+    oac.add_attr({"Beta2", static_cast<float>(_b2)});
+    oac.add_attr({"Epsilon", static_cast<float>(_eps)});
+    oac.add_attr({"WeightDecay", static_cast<float>(_decay)});
+}
+
+} // end namespace optimizer
+
+namespace functional{
+
+opt::optimizer_ptr create_adamw_optimizer(double lr,
+                                          double beta1,
+                                          double beta2,
+                                          double epsilon,
+                                          double weight_decay
+                                          ){
+    return std::make_shared<opt::adamw>(
+        lr, beta1, beta2, epsilon, weight_decay);
+}
+
+} // end namespace functional
+} // end namespace mlfe
@@ -0,0 +1,110 @@
+#include "../core/op_algo.h"
+#include "../device_context/cpu_context.h"
+#include "../math/basic_functions.h"
+#include "../math/optimizers.h"
+#include "../utils/parallel_for.h"
+
+namespace mlfe{
+namespace algorithm_cpu{
+
+// updates all outputs at once, like MultiTensorAdam. one output is the
+// single tensor AdamW.
+template <class Tp>
+class AdamW : public OpAlgo{
+using T = typename Tp::T;
+public:
+    AdamW(OpAlgoContext *oac) : OpAlgo(oac){
+        offsets.push_back(0);
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+            dxs.push_back(xs.back().grad());
+            offsets.push_back(offsets.back() + xs.back().size());
+        }
+        lr = oac->get_attr<T>("LearningRate");
+        beta1 = oac->get_attr<T>("Beta1");
+        beta2 = oac->get_attr<T>("Beta2");
+        eps = oac->get_attr<T>("Epsilon");
+        decay = oac->get_attr<T>("WeightDecay");
+        step = 0;
+        m_hist = create_memory(offsets.back() * Tp::size);
+        v_hist = create_memory(offsets.back() * Tp::size);
+        x_ptrs.resize(xs.size());
+        dx_ptrs.resize(xs.size());
+
+        math::set<T, CPUContext>(
+            offsets.back(),
+            static_cast<T>(0),
+            m_hist->mutable_device_data<T>()
+            );
+        math::set<T, CPUContext>(
+            offsets.back(),
+            static_cast<T>(0),
+            v_hist->mutable_device_data<T>()
+            );
+    }
+
+    void Compute() override{
+        for(int n = 0; n < xs.size(); ++n){
+            x_ptrs[n] = xs[n].mutable_device_data<T>();
+            dx_ptrs[n] = dxs[n].device_data<T>();
+        }
+        auto m_hist_ptr = m_hist->mutable_device_data<T>();
+        auto v_hist_ptr = v_hist->mutable_device_data<T>();
+
+        ++step;
+        parallel_for_segments(offsets, math::multi_tensor_grain,
+            [&](int n, int from, int to){
+                math::adamw<T, CPUContext>(
+                    to - from,
+                    x_ptrs[n] + from,
+                    dx_ptrs[n] + from,
+                    m_hist_ptr + offsets[n] + from,
+                    v_hist_ptr + offsets[n] + from,
+                    lr,
+                    beta1,
+                    beta2,
+                    eps,
+                    decay,
+                    step
+                    );
+            });
+    }
+
+private:
+    std::vector<Tensor> xs;
+    std::vector<Tensor> dxs;
+    std::vector<T *> x_ptrs;
+    std::vector<const T *> dx_ptrs;
+    std::vector<int> offsets;
+    memory_ptr m_hist;
+    memory_ptr v_hist;
+    T lr;
+    T beta1;
+    T beta2;
+    T eps;
+    T decay;
+    int step;
+};
+
+REGIST_OP_ALGO(AdamW)
+    .Input("X", type::float32::string)
+    .Input("dX", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = AdamW<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+REGIST_OP_ALGO(MultiTensorAdamW)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = AdamW<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_cpu
+} // end namespace mlfe
@@ -0,0 +1,98 @@
+#include "../core/op_algo.h"
+#include "../device_context/cpu_context.h"
+#include "../math/basic_functions.h"
+#include "../math/optimizers.h"
+#include "../utils/parallel_for.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mlfe{
+namespace algorithm_cpu{
+
+// scales all outputs in place so that their global l2 norm is at most
+// MaxNorm, and writes the norm before scaling to the Norm attribute.
+// the squared norm is one parallel pass over fixed blocks, the scaling
+// is a second pass which only runs when the norm is too large.
+template <class Tp>
+class GlobalNormClip : public OpAlgo{
+using T = typename Tp::T;
+public:
+    GlobalNormClip(OpAlgoContext *oac) : OpAlgo(oac){
+        offsets.push_back(0);
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+            const int x_size = xs.back().size();
+            for(int from = 0; from < x_size; from += math::multi_tensor_grain){
+                blocks.push_back({n, from,
+                    std::min(from + math::multi_tensor_grain, x_size)});
+            }
+            offsets.push_back(offsets.back() + x_size);
+        }
+        max_norm = oac->get_attr<T>("MaxNorm");
+        norm = oac->get_attr<Tensor>("Norm");
+        x_ptrs.resize(xs.size());
+        block_norms.resize(blocks.size());
+    }
+
+    void Compute() override{
+        for(int n = 0; n < xs.size(); ++n){
+            x_ptrs[n] = xs[n].mutable_device_data<T>();
+        }
+
+        parallel_for(0, blocks.size(), 1, [&](int from, int to){
+            for(int b = from; b < to; ++b){
+                const block &blk = blocks[b];
+                math::squared_norm<T, CPUContext>(
+                    blk.to - blk.from,
+                    x_ptrs[blk.output] + blk.from,
+                    block_norms.data() + b
+                    );
+            }
+        });
+        double squared_sum = 0;
+        for(auto &val : block_norms){
+            squared_sum += val;
+        }
+        const T global_norm = static_cast<T>(std::sqrt(squared_sum));
+        norm.mutable_data<T>()[0] = global_norm;
+
+        if(global_norm > max_norm){
+            const T scale = max_norm / global_norm;
+            parallel_for_segments(offsets, math::multi_tensor_grain,
+                [&](int n, int from, int to){
+                    math::scal<T, CPUContext>(
+                        to - from,
+                        scale,
+                        x_ptrs[n] + from,
+                        x_ptrs[n] + from
+                        );
+                });
+        }
+    }
+
+private:
+    struct block{
+        int output;
+        int from;
+        int to;
+    };
+    std::vector<Tensor> xs;
+    std::vector<T *> x_ptrs;
+    std::vector<int> offsets;
+    std::vector<block> blocks;
+    std::vector<T> block_norms;
+    Tensor norm;
+    T max_norm;
+};
+
+REGIST_OP_ALGO(GlobalNormClip)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = GlobalNormClip<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_cpu
+} // end namespace mlfe
@@ -0,0 +1,70 @@
+#include "../core/op_algo.h"
+#include "../device_context/cuda_context.h"
+#include "../math/basic_functions.h"
+#include "../math/optimizers.h"
+#include <cmath>
+
+namespace mlfe{
+namespace algorithm_cuda{
+
+// scales all outputs in place so that their global l2 norm is at most
+// MaxNorm, and writes the norm before scaling to the Norm attribute.
+// the squared norm of each output is reduced on the device, only those
+// partial sums are copied back to sum them and decide the scale.
+template <class Tp>
+class GlobalNormClip : public OpAlgo{
+using T = typename Tp::T;
+public:
+    GlobalNormClip(OpAlgoContext *oac) : OpAlgo(oac){
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+        }
+        max_norm = oac->get_attr<T>("MaxNorm");
+        norm = oac->get_attr<Tensor>("Norm");
+        partial_norms = create_memory(xs.size() * Tp::size);
+    }
+
+    void Compute() override{
+        auto partial_ptr = partial_norms->mutable_device_data<T>();
+        for(int n = 0; n < xs.size(); ++n){
+            math::squared_norm<T, CUDAContext>(
+                xs[n].size(),
+                xs[n].device_data<T>(),
+                partial_ptr + n
+                );
+        }
+        auto partial_host = partial_norms->host_data<T>();
+        double squared_sum = 0;
+        for(int n = 0; n < xs.size(); ++n){
+            squared_sum += partial_host[n];
+        }
+        const T global_norm = static_cast<T>(std::sqrt(squared_sum));
+        norm.mutable_data<T>()[0] = global_norm;
+
+        if(global_norm > max_norm){
+            const T scale = max_norm / global_norm;
+            for(auto &x : xs){
+                auto x_ptr = x.mutable_device_data<T>();
+                math::scal<T, CUDAContext>(x.size(), scale, x_ptr, x_ptr);
+            }
+        }
+    }
+
+private:
+    std::vector<Tensor> xs;
+    memory_ptr partial_norms;
+    Tensor norm;
+    T max_norm;
+};
+
+REGIST_OP_ALGO(GlobalNormClip)
+    .Output("Y", type::float32::string)
+    .Device("CUDA")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = GlobalNormClip<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_cuda
+} // end namespace mlfe
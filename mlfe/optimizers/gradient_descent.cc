@@ -14,6 +14,9 @@ public:
 
     void apply(Tensor var, Tensor var_grad) override;
 
+protected:
+    void add_attrs(OpAlgoContext &oac) const override;
+
 private:
     double _lr;
     double _mm;
@@ -22,7 +25,7 @@ private:
 };
 
 gradient_descent::gradient_descent(double lr, double momentum)
-    : _lr(lr), _mm(momentum){
+    : optimizer("GradientDescent"), _lr(lr), _mm(momentum){
     auto dev = get_enabled_device();
     std::string op_name = "GradientDescent";
     std::string full_op_name = "Name:" + op_name + "/Device:";
@@ -34,12 +37,16 @@ void gradient_descent::apply(Tensor var, Tensor var_grad){
     if(_reg_var.find(var) == _reg_var.end()){
         OpAlgoContext oac("GradientDescent");
         oac.add_output(var);
-        oac.add_attr({"LearningRate", static_cast<float>(_lr)});
-        oac.add_attr({"MomentumRate", static_cast<float>(_mm)});
-        oac.add_attr({"WeightDecay", static_cast<float>(0)});
+        add_attrs(oac);
         _reg_var[var] = OpAlgoRegistry::Get()->GetOpAlgo(_opt_name, &oac);
     }
-    _reg_var[var]->Compute();
+    _reg_var[var]->Run();
+}
+
+void gradient_descent::add_attrs(OpAlgoContext &oac) const{
+    oac.add_attr({"LearningRate", static_cast<float>(_lr)});
+    oac.add_attr({"MomentumRate", static_cast<float>(_mm)});
+    oac.add_attr({"WeightDecay", static_cast<float>(0)});
 }
 
 } // end namespace optimizer
@@ -2,10 +2,31 @@
 #include "../device_context/cpu_context.h"
 #include "../math/basic_functions.h"
 #include "../math/optimizers.h"
+#include "../utils/parallel_for.h"
 
 namespace mlfe{
 namespace algorithm_cpu{
+namespace{
 
+// X = X - LearningRate*(dX + WeightDecay*X), the step without momentum,
+// which keeps no history.
+template <class T>
+void gradient_descent(const int size,
+                      T *x_ptr,
+                      const T *dx_ptr,
+                      const T lr,
+                      const T wd
+                     ){
+    if(wd != T(0)){
+        math::scal<T, CPUContext>(size, T(1) - lr * wd, x_ptr, x_ptr);
+    }
+    math::axpy<T, CPUContext>(size, -lr, dx_ptr, x_ptr);
+}
+
+} // end anonymous namespace
+
+// same update as the cuda algo, sgd with momentum and weight decay.
+// without momentum it is an axpy and no momentum buffer is allocated.
 template <class Tp>
 class GradientDescent : public OpAlgo{
 using T = typename Tp::T;
@@ -14,27 +35,46 @@ public:
         x = oac->get_output(0);
         x_grad = x.grad();
         lr = oac->get_attr<T>("LearningRate");
+        mr = oac->get_attr<T>("MomentumRate");
+        wd = oac->get_attr<T>("WeightDecay");
         size = x.size();
+        if(mr != T(0)){
+            mmt_hist = create_memory(size * Tp::size);
+            math::set<T, CPUContext>(
+                size,
+                static_cast<T>(0),
+                mmt_hist->mutable_device_data<T>()
+                );
+        }
     }
 
     void Compute() override{
         auto x_ptr = x.mutable_device_data<T>();
         auto dx_ptr = x_grad.device_data<T>();
 
-        // X = X - LearningRate*dX
-        math::axpy<T, CPUContext>(
+        if(!mmt_hist){
+            gradient_descent<T>(size, x_ptr, dx_ptr, lr, wd);
+            return;
+        }
+        math::gradient_descent_momentum<T, CPUContext>(
             size,
-            -lr,
+            x_ptr,
             dx_ptr,
-            x_ptr
+            mmt_hist->mutable_device_data<T>(),
+            lr,
+            mr,
+            wd
             );
     }
 
 private:
     Tensor x;
     Tensor x_grad;
+    memory_ptr mmt_hist;
     int size;
     T lr;
+    T mr;
+    T wd;
 };
 
 REGIST_OP_ALGO(GradientDescent)
@@ -106,5 +146,85 @@ REGIST_OP_ALGO(GradientDescentWithMomentum)
     })
     .Finish();
 
+// GradientDescent over all outputs at once. the momentum of every
+// output lives in one buffer, if there is momentum, and the elements of
+// all outputs are split into chunks for parallel_for, so small tensors
+// share a chunk.
+template <class Tp>
+class MultiTensorGradientDescent : public OpAlgo{
+using T = typename Tp::T;
+public:
+    MultiTensorGradientDescent(OpAlgoContext *oac) : OpAlgo(oac){
+        offsets.push_back(0);
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+            x_grads.push_back(xs.back().grad());
+            offsets.push_back(offsets.back() + xs.back().size());
+        }
+        lr = oac->get_attr<T>("LearningRate");
+        mr = oac->get_attr<T>("MomentumRate");
+        wd = oac->get_attr<T>("WeightDecay");
+        x_ptrs.resize(xs.size());
+        dx_ptrs.resize(xs.size());
+        if(mr != T(0)){
+            mmt_hist = create_memory(offsets.back() * Tp::size);
+            math::set<T, CPUContext>(
+                offsets.back(),
+                static_cast<T>(0),
+                mmt_hist->mutable_device_data<T>()
+                );
+        }
+    }
+
+    void Compute() override{
+        for(int n = 0; n < xs.size(); ++n){
+            x_ptrs[n] = xs[n].mutable_device_data<T>();
+            dx_ptrs[n] = x_grads[n].device_data<T>();
+        }
+        if(!mmt_hist){
+            parallel_for_segments(offsets, math::multi_tensor_grain,
+                [&](int n, int from, int to){
+                    gradient_descent<T>(to - from, x_ptrs[n] + from,
+                                        dx_ptrs[n] + from, lr, wd);
+                });
+            return;
+        }
+        auto mmt_hist_ptr = mmt_hist->mutable_device_data<T>();
+
+        parallel_for_segments(offsets, math::multi_tensor_grain,
+            [&](int n, int from, int to){
+                math::gradient_descent_momentum<T, CPUContext>(
+                    to - from,
+                    x_ptrs[n] + from,
+                    dx_ptrs[n] + from,
+                    mmt_hist_ptr + offsets[n] + from,
+                    lr,
+                    mr,
+                    wd
+                    );
+            });
+    }
+
+private:
+    std::vector<Tensor> xs;
+    std::vector<Tensor> x_grads;
+    std::vector<T *> x_ptrs;
+    std::vector<const T *> dx_ptrs;
+    std::vector<int> offsets;
+    memory_ptr mmt_hist;
+    T lr;
+    T mr;
+    T wd;
+};
+
+REGIST_OP_ALGO(MultiTensorGradientDescent)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = MultiTensorGradientDescent<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
 } // end namespace algorithm_cpu
 } // end namespace mlfe
@@ -0,0 +1,17 @@
+#ifndef __LAMB_H__
+#define __LAMB_H__
+#include "optimizer.h"
+
+namespace mlfe{
+namespace functional{
+
+opt::optimizer_ptr create_lamb_optimizer(double lr,
+                                         double beta1 = 0.9,
+                                         double beta2 = 0.999,
+                                         double eps = 1e-6,
+                                         double weight_decay = 1e-2
+                                         );
+
+} // end namespace functional
+} // end namespace mlfe
+#endif // end #ifndef __LAMB_H__
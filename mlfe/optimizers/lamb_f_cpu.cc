@@ -0,0 +1,171 @@
+#include "../core/op_algo.h"
+#include "../device_context/cpu_context.h"
+#include "../math/basic_functions.h"
+#include "../math/optimizers.h"
+#include "../utils/parallel_for.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mlfe{
+namespace algorithm_cpu{
+
+// updates all outputs at once, one output is the single tensor Lamb.
+// the trust ratio of an output needs the norms over all of it, so a step
+// is two passes: the moments and the per block squared norms, then the
+// update. the outputs are cut into fixed blocks, which keeps the sums
+// the same for any number of threads.
+template <class Tp>
+class Lamb : public OpAlgo{
+using T = typename Tp::T;
+public:
+    Lamb(OpAlgoContext *oac) : OpAlgo(oac){
+        int size = 0;
+        for(int n = 0; n < oac->num_outputs(); ++n){
+            xs.push_back(oac->get_output(n));
+            dxs.push_back(xs.back().grad());
+            offsets.push_back(size);
+            const int x_size = xs.back().size();
+            for(int from = 0; from < x_size; from += math::multi_tensor_grain){
+                blocks.push_back({n, from,
+                    std::min(from + math::multi_tensor_grain, x_size)});
+            }
+            size += x_size;
+        }
+        lr = oac->get_attr<T>("LearningRate");
+        beta1 = oac->get_attr<T>("Beta1");
+        beta2 = oac->get_attr<T>("Beta2");
+        eps = oac->get_attr<T>("Epsilon");
+        decay = oac->get_attr<T>("WeightDecay");
+        step = 0;
+        m_hist = create_memory(size * Tp::size);
+        v_hist = create_memory(size * Tp::size);
+        x_ptrs.resize(xs.size());
+        dx_ptrs.resize(xs.size());
+        block_norms.resize(blocks.size() * 2);
+        norms.resize(xs.size() * 2);
+        trust_ratios.resize(xs.size());
+
+        math::set<T, CPUContext>(
+            size,
+            static_cast<T>(0),
+            m_hist->mutable_device_data<T>()
+            );
+        math::set<T, CPUContext>(
+            size,
+            static_cast<T>(0),
+            v_hist->mutable_device_data<T>()
+            );
+    }
+
+    void Compute() override{
+        for(int n = 0; n < xs.size(); ++n){
+            x_ptrs[n] = xs[n].mutable_device_data<T>();
+            dx_ptrs[n] = dxs[n].device_data<T>();
+        }
+        auto m_hist_ptr = m_hist->mutable_device_data<T>();
+        auto v_hist_ptr = v_hist->mutable_device_data<T>();
+
+        ++step;
+        parallel_for(0, blocks.size(), 1, [&](int from, int to){
+            for(int b = from; b < to; ++b){
+                const block &blk = blocks[b];
+                const int n = blk.output;
+                T *blk_norms = block_norms.data() + b * 2;
+                blk_norms[0] = blk_norms[1] = T(0);
+                math::lamb_moments<T, CPUContext>(
+                    blk.to - blk.from,
+                    x_ptrs[n] + blk.from,
+                    dx_ptrs[n] + blk.from,
+                    m_hist_ptr + offsets[n] + blk.from,
+                    v_hist_ptr + offsets[n] + blk.from,
+                    beta1,
+                    beta2,
+                    eps,
+                    decay,
+                    step,
+                    blk_norms
+                    );
+            }
+        });
+
+        // trust ratio ||w|| / ||r||, or 1 if either norm is zero.
+        std::fill(norms.begin(), norms.end(), T(0));
+        for(int b = 0; b < blocks.size(); ++b){
+            norms[blocks[b].output * 2] += block_norms[b * 2];
+            norms[blocks[b].output * 2 + 1] += block_norms[b * 2 + 1];
+        }
+        for(int n = 0; n < xs.size(); ++n){
+            const T w_norm = std::sqrt(norms[n * 2]);
+            const T r_norm = std::sqrt(norms[n * 2 + 1]);
+            trust_ratios[n] = w_norm > T(0) && r_norm > T(0) ?
+                w_norm / r_norm : T(1);
+        }
+
+        parallel_for(0, blocks.size(), 1, [&](int from, int to){
+            for(int b = from; b < to; ++b){
+                const block &blk = blocks[b];
+                const int n = blk.output;
+                math::lamb_update<T, CPUContext>(
+                    blk.to - blk.from,
+                    x_ptrs[n] + blk.from,
+                    m_hist_ptr + offsets[n] + blk.from,
+                    v_hist_ptr + offsets[n] + blk.from,
+                    lr,
+                    beta1,
+                    beta2,
+                    eps,
+                    decay,
+                    step,
+                    trust_ratios[n]
+                    );
+            }
+        });
+    }
+
+private:
+    struct block{
+        int output;
+        int from;
+        int to;
+    };
+    std::vector<Tensor> xs;
+    std::vector<Tensor> dxs;
+    std::vector<T *> x_ptrs;
+    std::vector<const T *> dx_ptrs;
+    std::vector<int> offsets;
+    std::vector<block> blocks;
+    std::vector<T> block_norms;
+    std::vector<T> norms;
+    std::vector<T> trust_ratios;
+    memory_ptr m_hist;
+    memory_ptr v_hist;
+    T lr;
+    T beta1;
+    T beta2;
+    T eps;
+    T decay;
+    int step;
+};
+
+REGIST_OP_ALGO(Lamb)
+    .Input("X", type::float32::string)
+    .Input("dX", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = Lamb<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+REGIST_OP_ALGO(MultiTensorLamb)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) ->std::shared_ptr<OpAlgo>{
+        using T = Lamb<type::float32>;
+        return std::make_shared<T>(oac);
+    })
+    .Finish();
+
+} // end namespace algorithm_cpu
+} // end namespace mlfe
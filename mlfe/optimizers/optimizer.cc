@@ -1,9 +1,82 @@
 #include "optimizer.h"
+#include "../core/tensor.h"
+#include "../core/op_algo.h"
 
 namespace mlfe{
 namespace opt{
 
-optimizer::optimizer() = default;
+optimizer::optimizer(std::string op_name)
+    : _clip_norm(0), _grad_norm(0){
+    std::string dev_name = get_enabled_device()->get_device_name();
+    _multi_op_name = "MultiTensor" + op_name;
+    _multi_opt_name = "Name:" + _multi_op_name + "/Device:" + dev_name;
+}
+
+void optimizer::apply(std::vector<Tensor> vars){
+    if(_clip_norm > 0){
+        clip_gradients(vars);
+    }
+    apply_multi(vars);
+}
+
+void optimizer::set_clip_norm(double max_norm){
+    _clip_norm = max_norm;
+    _clip_algo = nullptr;
+}
+
+double optimizer::get_grad_norm() const{
+    return _grad_norm;
+}
+
+void optimizer::apply_multi(std::vector<Tensor> vars){
+    if(_multi_vars.empty()){
+        _multi_vars = vars;
+    }
+    else if(_multi_vars != vars){
+        throw std::string("optimizer: apply(vars) is called with other vars "
+            "than before, which would lose the state of the optimizer.");
+    }
+    if(!OpAlgoRegistry::Get()->Has(_multi_opt_name)){
+        for(auto &var : vars){
+            apply(var, var.grad());
+        }
+        return;
+    }
+    if(!_multi_algo){
+        OpAlgoContext oac(_multi_op_name);
+        for(auto &var : vars){
+            oac.add_output(var);
+        }
+        add_attrs(oac);
+        _multi_algo = OpAlgoRegistry::Get()->GetOpAlgo(_multi_opt_name, &oac);
+    }
+    _multi_algo->Run();
+}
+
+void optimizer::clip_gradients(std::vector<Tensor> vars){
+    if(!_clip_algo || _clip_vars != vars){
+        auto dev = get_enabled_device();
+        std::string op_name = "Name:GlobalNormClip/Device:";
+        std::string dev_name = dev->get_device_name();
+        OpAlgoContext oac("GlobalNormClip");
+        for(auto &var : vars){
+            oac.add_output(var.grad());
+        }
+        _clip_result = std::make_shared<Tensor>(
+            functional::create_variable({1}));
+        oac.add_attr({"MaxNorm", static_cast<float>(_clip_norm)});
+        oac.add_attr({"Norm", *_clip_result});
+        if(!OpAlgoRegistry::Get()->Has(op_name + dev_name)){
+            throw std::string("optimizer: gradient clipping is not "
+                "supported on ") + dev_name + ".";
+        }
+        _clip_algo = OpAlgoRegistry::Get()->GetOpAlgo(
+            op_name + dev_name, &oac);
+        _clip_vars = vars;
+    }
+    _clip_algo->Run();
+    _grad_norm = _clip_result->data<float>()[0];
+}
 
 } // end namespace optimizer
 } // end namespace mlfe
@@ -1,10 +1,14 @@
 #ifndef __OPTIMIZER_H__
 #define __OPTIMIZER_H__
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace mlfe{
 //forward declaration
 class Tensor;
+class OpAlgo;
+class OpAlgoContext;
 
 namespace opt{
 
@@ -12,8 +16,46 @@ class optimizer{
 public:
     virtual void apply(Tensor var, Tensor var_grad) = 0;
 
+    // updates all vars with their grads. optimizers with a multi tensor
+    // algo for the enabled device do it in one parallel pass, the others
+    // call apply(var, var.grad()) for each var.
+    // the state of a var is not shared between the two apply functions.
+    // the multi tensor algo keeps the state of the vars of the first call,
+    // so apply(vars) throws if it is called with other vars later.
+    void apply(std::vector<Tensor> vars);
+
+    // apply(vars) first scales the grads of vars by
+    // max_norm / global norm if their global l2 norm is above max_norm.
+    // a max_norm of zero, the default, turns clipping off.
+    void set_clip_norm(double max_norm);
+
+    // the global l2 norm of the grads of the last apply(vars) with
+    // clipping on, before they were scaled.
+    double get_grad_norm() const;
+
 protected:
-    optimizer();
+    // op_name is the op of apply(var, var_grad), like "Adam", and
+    // "MultiTensor" + op_name the op of apply(vars).
+    explicit optimizer(std::string op_name);
+
+    // adds the attributes of the op, like the learning rate, to oac.
+    virtual void add_attrs(OpAlgoContext &oac) const = 0;
+
+private:
+    void apply_multi(std::vector<Tensor> vars);
+
+    void clip_gradients(std::vector<Tensor> vars);
+
+    std::string _multi_op_name;
+    std::string _multi_opt_name;
+    std::vector<Tensor> _multi_vars;
+    std::shared_ptr<OpAlgo> _multi_algo;
+
+    double _clip_norm;
+    double _grad_norm;
+    std::vector<Tensor> _clip_vars;
+    std::shared_ptr<OpAlgo> _clip_algo;
+    std::shared_ptr<Tensor> _clip_result;
 };
 
 using optimizer_ptr = std::shared_ptr<optimizer>;
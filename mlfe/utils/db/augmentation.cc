@@ -0,0 +1,137 @@
+#include "augmentation.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace mlfe{
+namespace {
+
+using uint8 = type::uint8::T;
+
+// the offset of row r of channel c, in units of one element, where an
+// element is a pixel of channels bytes for nhwc and a byte for nchw.
+inline int row_offset(const ImageShape &shape, const int c, const int r){
+    return shape.channels_last ?
+        r * shape.width : (c * shape.height + r) * shape.width;
+}
+
+} // end anonymous namespace
+
+RandomCrop::RandomCrop(int height, int width, int padding)
+    : _height(height), _width(width), _padding(padding){
+    if(height <= 0 || width <= 0 || padding < 0){
+        throw std::string("RandomCrop: invalid size or padding.");
+    }
+}
+
+ImageShape RandomCrop::OutputShape(const ImageShape &in) const{
+    if(_height > in.height + 2 * _padding || _width > in.width + 2 * _padding){
+        throw std::string("RandomCrop: the crop is larger than the image.");
+    }
+    return {in.channels, _height, _width, in.channels_last};
+}
+
+void RandomCrop::Apply(const ImageShape &in,
+                       const uint8 *x,
+                       uint8 *y,
+                       ImageRandom &rng
+                      ) const{
+    const ImageShape out = OutputShape(in);
+    // the window origin in image coordinates, negative inside the padding.
+    const int oy = rng.Uniform(in.height + 2 * _padding - _height + 1) - _padding;
+    const int ox = rng.Uniform(in.width + 2 * _padding - _width + 1) - _padding;
+    const int unit = in.channels_last ? in.channels : 1;
+    const int planes = in.channels_last ? 1 : in.channels;
+    // the columns of the window inside the image.
+    const int lo = std::min(std::max(-ox, 0), _width);
+    const int hi = std::max(std::min(in.width - ox, _width), lo);
+    for(int c = 0; c < planes; ++c){
+        for(int r = 0; r < _height; ++r){
+            uint8 *dst = y + row_offset(out, c, r) * unit;
+            const int sr = oy + r;
+            if(sr < 0 || sr >= in.height){
+                std::memset(dst, 0, _width * unit);
+                continue;
+            }
+            const uint8 *src = x + (row_offset(in, c, sr) + ox + lo) * unit;
+            std::memset(dst, 0, lo * unit);
+            std::memcpy(dst + lo * unit, src, (hi - lo) * unit);
+            std::memset(dst + hi * unit, 0, (_width - hi) * unit);
+        }
+    }
+}
+
+RandomFlip::RandomFlip(float prob) : _prob(prob){}
+
+void RandomFlip::Apply(const ImageShape &in,
+                       const uint8 *x,
+                       uint8 *y,
+                       ImageRandom &rng
+                      ) const{
+    if(!rng.Bernoulli(_prob)){
+        std::memcpy(y, x, in.Size());
+        return;
+    }
+    const int w = in.width;
+    if(in.channels_last){
+        const int ch = in.channels;
+        for(int r = 0; r < in.height; ++r){
+            const uint8 *src = x + r * w * ch;
+            uint8 *dst = y + r * w * ch;
+            for(int j = 0; j < w; ++j){
+                for(int k = 0; k < ch; ++k){
+                    dst[j * ch + k] = src[(w - 1 - j) * ch + k];
+                }
+            }
+        }
+    }
+    else{
+        for(int r = 0; r < in.channels * in.height; ++r){
+            const uint8 *src = x + r * w;
+            uint8 *dst = y + r * w;
+            for(int j = 0; j < w; ++j){
+                dst[j] = src[w - 1 - j];
+            }
+        }
+    }
+}
+
+Cutout::Cutout(int size, std::vector<uint8> fill)
+    : _size(size), _fill(fill){
+    if(size <= 0){
+        throw std::string("Cutout: size must be positive.");
+    }
+}
+
+void Cutout::Apply(const ImageShape &in,
+                   const uint8 *x,
+                   uint8 *y,
+                   ImageRandom &rng
+                  ) const{
+    if(!_fill.empty() && _fill.size() != in.channels){
+        throw std::string("Cutout: needs a fill value for every channel.");
+    }
+    std::memcpy(y, x, in.Size());
+    const int cy = rng.Uniform(in.height);
+    const int cx = rng.Uniform(in.width);
+    const int y0 = std::max(cy - _size / 2, 0);
+    const int y1 = std::min(cy - _size / 2 + _size, in.height);
+    const int x0 = std::max(cx - _size / 2, 0);
+    const int x1 = std::min(cx - _size / 2 + _size, in.width);
+    for(int c = 0; c < in.channels; ++c){
+        const uint8 fill = _fill.empty() ? 0 : _fill[c];
+        for(int r = y0; r < y1; ++r){
+            if(in.channels_last){
+                uint8 *row = y + row_offset(in, c, r) * in.channels + c;
+                for(int j = x0; j < x1; ++j){
+                    row[j * in.channels] = fill;
+                }
+            }
+            else{
+                std::memset(y + row_offset(in, c, r) + x0, fill, x1 - x0);
+            }
+        }
+    }
+}
+
+} // end namespace mlfe
@@ -0,0 +1,128 @@
+#ifndef __AUGMENTATION_HPP__
+#define __AUGMENTATION_HPP__
+#include "../../math/random.h"
+#include "../../utils/types.h"
+#include <memory>
+#include <vector>
+
+namespace mlfe{
+
+// the geometry of an uint8 image blob, nhwc if channels_last,
+// otherwise nchw.
+struct ImageShape{
+    int channels;
+    int height;
+    int width;
+    bool channels_last;
+
+    int Size() const{ return channels * height * width; }
+};
+
+// random words of one image, drawn in order from a philox stream, so an
+// image is augmented the same way on any worker.
+class ImageRandom{
+using u32 = type::uint32::T;
+public:
+    ImageRandom(const math::philox gen) : _gen(gen), _block(0), _used(4){}
+
+    u32 Next(){
+        if(_used == 4){
+            _gen(_block++, _words);
+            _used = 0;
+        }
+        return _words[_used++];
+    }
+
+    // an integer in [0, n).
+    int Uniform(const int n){
+        return static_cast<int>((static_cast<unsigned long long>(Next()) * n) >> 32);
+    }
+
+    // true with probability prob.
+    bool Bernoulli(const float prob){
+        return (Next() >> 8) < static_cast<u32>(prob * 16777216.f);
+    }
+
+private:
+    math::philox _gen;
+    u32 _block;
+    int _used;
+    u32 _words[4];
+};
+
+// one stage of an augmentation pipeline on uint8 images.
+// y is a different buffer than x and holds OutputShape(in).Size() bytes.
+class Augmentation{
+using uint8 = type::uint8::T;
+public:
+    virtual ~Augmentation(){}
+
+    virtual ImageShape OutputShape(const ImageShape &in) const{
+        return in;
+    }
+
+    virtual void Apply(const ImageShape &in,
+                       const uint8 *x,
+                       uint8 *y,
+                       ImageRandom &rng
+                      ) const = 0;
+};
+
+using AugmentationPtr = std::shared_ptr<Augmentation>;
+
+// a height x width window at a random offset of the image zero padded
+// by padding pixels on every side.
+class RandomCrop final : public Augmentation{
+using uint8 = type::uint8::T;
+public:
+    RandomCrop(int height, int width, int padding = 0);
+
+    ImageShape OutputShape(const ImageShape &in) const override;
+
+    void Apply(const ImageShape &in,
+               const uint8 *x,
+               uint8 *y,
+               ImageRandom &rng
+              ) const override;
+
+private:
+    int _height, _width, _padding;
+};
+
+// mirrors the image left to right with probability prob.
+class RandomFlip final : public Augmentation{
+using uint8 = type::uint8::T;
+public:
+    RandomFlip(float prob = 0.5f);
+
+    void Apply(const ImageShape &in,
+               const uint8 *x,
+               uint8 *y,
+               ImageRandom &rng
+              ) const override;
+
+private:
+    float _prob;
+};
+
+// fills a size x size square centered on a random pixel with fill[c],
+// clipped at the borders (devries and taylor, 2017). fill defaults to 0,
+// pass the mean pixel to zero the square after normalization.
+class Cutout final : public Augmentation{
+using uint8 = type::uint8::T;
+public:
+    Cutout(int size, std::vector<uint8> fill = {});
+
+    void Apply(const ImageShape &in,
+               const uint8 *x,
+               uint8 *y,
+               ImageRandom &rng
+              ) const override;
+
+private:
+    int _size;
+    std::vector<uint8> _fill;
+};
+
+} // end namespace mlfe
+#endif // end ifndef __AUGMENTATION_HPP__
@@ -2,10 +2,17 @@
 #define __DATA_BASE_HPP__
 #include <string>
 #include <fstream>
+#include <cstdint>
 #include "../file_io.h"
 
 namespace mlfe{
 
+// bytes owned by a data base, valid until it is closed.
+struct DataView{
+    const char *data;
+    uint32_t size;
+};
+
 class DataBase : public FileIO{
 public:
     virtual ~DataBase() { }
@@ -18,6 +25,17 @@ public:
 
     virtual void Get(const std::string key, std::string &val) = 0;
 
+    // Get without a copy, only for a data base opened with option.mmap.
+    virtual DataView GetView() = 0;
+
+    virtual DataView GetView(const std::string key) = 0;
+
+    // the index-th record in the order the db was written in, which is
+    // key order for a db written with option.ordered and insertion order
+    // otherwise. safe to call from many threads since it does not move
+    // the cursor.
+    virtual DataView GetViewAt(const int index) = 0;
+
     virtual void Put(const std::string key, const std::string val) = 0;
     
     virtual void MoveToFirst() = 0;
@@ -27,12 +45,20 @@ public:
     virtual void Delete(const std::string key) = 0;
 
     virtual int NumData() = 0;
+
+    // true if the records are stored compressed, then views point to
+    // the compressed frames (see simpledb::DecodeRecord).
+    virtual bool IsCompressed() = 0;
     
     struct Option{
         bool create = false;
         bool ordered = false;
         bool binary = false;
         bool delete_previous = false;
+        // read-only, the file is mapped into memory instead of read.
+        bool mmap = false;
+        // lz4 compresses every record of a new db.
+        bool compress = false;
     } option;
 };
 
@@ -1,10 +1,138 @@
 #include "simple_db.h"
 #include "../assert.h"
+#include "../lz4.h"
+#include <algorithm>
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <cstring>
 
 namespace mlfe{ namespace simpledb{
+namespace {
+
+constexpr uint32_t current_version = 3;
+
+// the header of a version 1 file has no flags.
+constexpr uint32_t header_size_v1 = 4 * sizeof(uint32_t);
+
+constexpr uint32_t stored_raw = 0x80000000;
+
+inline uint32_t load_u32(const char *p){
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// fnv-1a, the high half is kept in the slot to skip most key compares.
+inline uint64_t hash_key(const char *key, const size_t size){
+    uint64_t h = 14695981039346656037ull;
+    for(size_t n = 0; n < size; ++n){
+        h = (h ^ static_cast<unsigned char>(key[n])) * 1099511628211ull;
+    }
+    return h;
+}
+
+// a power of two with at least a quarter of the slots empty.
+inline uint32_t num_slots(const uint32_t num_items){
+    uint32_t slots = 1;
+    while(slots < num_items + num_items / 3 + 1){
+        slots *= 2;
+    }
+    return slots;
+}
+
+// fills the slots of the keys at key_offsets in the keys section.
+template <class Slot>
+void build_slots(const char *keys,
+                 const std::vector<uint32_t> &key_offsets,
+                 std::vector<Slot> &slots
+                ){
+    slots.assign(num_slots(key_offsets.size()), Slot{0, 0});
+    const uint32_t mask = slots.size() - 1;
+    for(uint32_t n = 0; n < key_offsets.size(); ++n){
+        const char *key = keys + key_offsets[n];
+        const uint64_t h = hash_key(key, std::strlen(key));
+        uint32_t s = static_cast<uint32_t>(h) & mask;
+        while(slots[s].item != 0){
+            s = (s + 1) & mask;
+        }
+        slots[s] = {static_cast<uint32_t>(h >> 32), n + 1};
+    }
+}
+
+// true if the count keys at key_offsets are in key order.
+bool keys_sorted(const char *key_offsets,
+                 const char *keys,
+                 const uint32_t keys_size,
+                 const uint32_t count
+                ){
+    const char *prev = nullptr;
+    for(uint32_t n = 0; n < count; ++n){
+        const uint32_t offset = load_u32(key_offsets + n * sizeof(uint32_t));
+        runtime_assert(offset < keys_size &&
+            std::memchr(keys + offset, 0, keys_size - offset) != nullptr,
+            "the key is out of the file. (maybe, file has been corrupted.)");
+        if(prev != nullptr && std::strcmp(prev, keys + offset) > 0){
+            return false;
+        }
+        prev = keys + offset;
+    }
+    return true;
+}
+
+// the item indices in key order, of the count keys at key_offsets.
+void sort_keys(const char *key_offsets,
+               const char *keys,
+               const uint32_t keys_size,
+               const uint32_t count,
+               std::vector<uint32_t> &sorted
+              ){
+    std::vector<std::pair<const char *, uint32_t>> items(count);
+    for(uint32_t n = 0; n < count; ++n){
+        const uint32_t offset = load_u32(key_offsets + n * sizeof(uint32_t));
+        runtime_assert(offset < keys_size &&
+            std::memchr(keys + offset, 0, keys_size - offset) != nullptr,
+            "the key is out of the file. (maybe, file has been corrupted.)");
+        items[n] = std::make_pair(keys + offset, n);
+    }
+    std::sort(items.begin(), items.end(), [](
+        const std::pair<const char *, uint32_t> &a,
+        const std::pair<const char *, uint32_t> &b){
+        return std::strcmp(a.first, b.first) < 0;
+    });
+    sorted.resize(count);
+    for(uint32_t n = 0; n < count; ++n){
+        sorted[n] = items[n].second;
+    }
+}
+
+} // end anonymous namespace
+
+uint32_t DecodedSize(const DataView frame){
+    uint32_t tag;
+    if(frame.size < sizeof(tag)){
+        throw std::string("the record is not a compressed frame.");
+    }
+    std::memcpy(&tag, frame.data, sizeof(tag));
+    return tag & ~stored_raw;
+}
+
+void DecodeRecord(const DataView frame, char *dst){
+    uint32_t tag;
+    const uint32_t size = DecodedSize(frame);
+    std::memcpy(&tag, frame.data, sizeof(tag));
+    const char *src = frame.data + sizeof(tag);
+    const uint32_t src_size = frame.size - sizeof(tag);
+    if(tag & stored_raw){
+        if(src_size != size){
+            throw std::string("the record frame has been corrupted.");
+        }
+        std::memcpy(dst, src, size);
+    }
+    else if(lz4::Decompress(src, src_size, dst, size) != static_cast<int>(size)){
+        throw std::string("the record frame has been corrupted.");
+    }
+}
     
 SimpleDB::SimpleDB(){
     Init();
@@ -15,6 +143,10 @@ SimpleDB::~SimpleDB(){
 }
 
 void SimpleDB::Close() {
+    if(mapped_file.IsOpen()){
+        mapped_file.Close();
+        Init();
+    }
     if(FileIO::IsOpen()){
         WriteHeader();
         WriteDiskInfo();
@@ -24,6 +156,10 @@ void SimpleDB::Close() {
 }
 
 void SimpleDB::Open(const std::string name) {
+    if(option.mmap){
+        OpenMapped(name);
+        return;
+    }
     std::ios::openmode mode = GetFileModeByOption();
     /*
      * TODO:
@@ -40,10 +176,11 @@ void SimpleDB::Open(const std::string name) {
     }
     SeekToEnd();
     file_size = GetPosition();
-    if(file_size < HeaderSize() && file_size != 0){
+    if(file_size < header_size_v1 && file_size != 0){
         throw std::string("Header size does not match.");
     }
     if(file_size == 0 || option.delete_previous){
+        header_info.flags = option.compress ? compressed_records : 0;
         WriteHeader();
     }
     else if(!option.create){
@@ -55,6 +192,16 @@ void SimpleDB::Open(const std::string name) {
 }
 
 void SimpleDB::Get(std::string &val) {
+    if(mapped_file.IsOpen()){
+        DataView view = GetView();
+        if(IsCompressed()){
+            val.resize(DecodedSize(view));
+            DecodeRecord(view, &val[0]);
+            return;
+        }
+        val.assign(view.data, view.size);
+        return;
+    }
     ItemDiskInfo target;
     if(option.ordered){
         target = iter->second;
@@ -62,36 +209,156 @@ void SimpleDB::Get(std::string &val) {
     else{
         target = *insertion_order_iter->second;
     }
-    val.resize(target.data_size);
+    std::string &stored = IsCompressed() ? record_buffer : val;
+    stored.resize(target.data_size);
     SeekFromFirstTo(target.pos_data_from_first);
-    Read(const_cast<char *>(val.c_str()), val.size());
+    Read(const_cast<char *>(stored.c_str()), stored.size());
+    if(IsCompressed()){
+        const DataView frame = {stored.data(), target.data_size};
+        val.resize(DecodedSize(frame));
+        DecodeRecord(frame, &val[0]);
+    }
 }
 
 void SimpleDB::Get(const std::string key, std::string &val) {
+    if(mapped_file.IsOpen()){
+        DataView view = GetView(key);
+        if(IsCompressed()){
+            val.resize(DecodedSize(view));
+            DecodeRecord(view, &val[0]);
+            return;
+        }
+        val.assign(view.data, view.size);
+        return;
+    }
     runtime_assert(disk_info_tree.count(key) == 1, "Key not exists.");
     ItemDiskInfo target= disk_info_tree[key];
-    val.resize(target.data_size);
+    std::string &stored = IsCompressed() ? record_buffer : val;
+    stored.resize(target.data_size);
     SeekFromFirstTo(target.pos_data_from_first);
-    Read(const_cast<char *>(val.c_str()), val.size());
+    Read(const_cast<char *>(stored.c_str()), stored.size());
+    if(IsCompressed()){
+        const DataView frame = {stored.data(), target.data_size};
+        val.resize(DecodedSize(frame));
+        DecodeRecord(frame, &val[0]);
+    }
+}
+
+DataView SimpleDB::GetView() {
+    if(!mapped_file.IsOpen()){
+        throw std::string("GetView() needs option.mmap.");
+    }
+    if(mapped.cursor >= header_info.number_of_items){
+        throw std::string("GetView() is past the last item.");
+    }
+    const ItemDiskInfo target = MappedItem(mapped.sorted.empty() ?
+        mapped.cursor : mapped.sorted[mapped.cursor]);
+    return {mapped_file.Data() + target.pos_data_from_first, target.data_size};
+}
+
+DataView SimpleDB::GetView(const std::string key) {
+    if(!mapped_file.IsOpen()){
+        throw std::string("GetView() needs option.mmap.");
+    }
+    const int index = FindMapped(key);
+    runtime_assert(index >= 0, "Key not exists.");
+    const ItemDiskInfo target = MappedItem(index);
+    return {mapped_file.Data() + target.pos_data_from_first, target.data_size};
+}
+
+DataView SimpleDB::GetViewAt(const int index) {
+    if(!mapped_file.IsOpen()){
+        throw std::string("GetViewAt() needs option.mmap.");
+    }
+    if(index < 0 || static_cast<uint32_t>(index) >= header_info.number_of_items){
+        throw std::string("GetViewAt() index out of range.");
+    }
+    const ItemDiskInfo target = MappedItem(index);
+    return {mapped_file.Data() + target.pos_data_from_first, target.data_size};
+}
+
+int SimpleDB::FindMapped(const std::string &key){
+    const uint64_t h = hash_key(key.data(), key.size());
+    const uint32_t tag = static_cast<uint32_t>(h >> 32);
+    const uint32_t mask = mapped.num_slots - 1;
+    uint32_t s = static_cast<uint32_t>(h) & mask;
+    // a table has empty slots, the bound only stops a corrupted one.
+    for(uint32_t probe = 0; probe < mapped.num_slots; ++probe){
+        IndexSlot slot;
+        std::memcpy(&slot, mapped.slots + s * sizeof(IndexSlot), sizeof(slot));
+        if(slot.item == 0){
+            return -1;
+        }
+        const uint32_t index = slot.item - 1;
+        if(slot.hash == tag && index < header_info.number_of_items){
+            const uint32_t offset = load_u32(mapped.key_offsets + index * sizeof(uint32_t));
+            if(offset < mapped.keys_size &&
+               key.size() < mapped.keys_size - offset &&
+               mapped.keys[offset + key.size()] == '\0' &&
+               std::memcmp(mapped.keys + offset, key.data(), key.size()) == 0){
+                return index;
+            }
+        }
+        s = (s + 1) & mask;
+    }
+    return -1;
+}
+
+SimpleDB::ItemDiskInfo SimpleDB::MappedItem(const uint32_t index){
+    ItemDiskInfo info;
+    std::memcpy(&info, mapped.disk_info + index * sizeof(ItemDiskInfo), sizeof(info));
+    if(info.pos_data_from_first > file_size ||
+       info.data_size > file_size - info.pos_data_from_first){
+        throw std::string("the item is out of the file. (maybe, file has been corrupted.)");
+    }
+    return info;
 }
 
 void SimpleDB::Put(const std::string key, const std::string val) {
     runtime_assert(disk_info_tree.count(key) == 0, "Key already exists.");
+    const std::string *stored = &val;
+    if(IsCompressed()){
+        EncodeRecord(val, record_buffer);
+        stored = &record_buffer;
+    }
     ItemDiskInfo new_data;
-    new_data.data_size = val.size();
+    new_data.data_size = stored->size();
     new_data.pos_data_from_first = last_cursor;
     disk_info_tree[key] = new_data;
     insertion_order.push_back(std::make_pair(key, &disk_info_tree[key]));
-    Write(const_cast<char *>(val.c_str()), val.size());
+    Write(const_cast<char *>(stored->c_str()), stored->size());
     last_cursor += new_data.data_size;
 }
 
+void SimpleDB::EncodeRecord(const std::string &val, std::string &record){
+    runtime_assert(val.size() < stored_raw, "the record is too large.");
+    const int size = val.size();
+    uint32_t tag = size;
+    record.resize(sizeof(tag) + lz4::CompressBound(size));
+    int stored_size = lz4::Compress(val.data(), size, &record[sizeof(tag)]);
+    // records that do not compress, like noise, are stored as they are.
+    if(stored_size >= size){
+        tag |= stored_raw;
+        stored_size = size;
+        std::memcpy(&record[sizeof(tag)], val.data(), size);
+    }
+    std::memcpy(&record[0], &tag, sizeof(tag));
+    record.resize(sizeof(tag) + stored_size);
+}
+
 void SimpleDB::MoveToFirst(){
+    if(mapped_file.IsOpen()){
+        mapped.cursor = 0;
+        return;
+    }
     iter = disk_info_tree.begin();
     insertion_order_iter = insertion_order.begin();
 }
 
 bool SimpleDB::MoveToNext(){
+    if(mapped_file.IsOpen()){
+        return ++mapped.cursor < header_info.number_of_items;
+    }
     ++iter;
     ++insertion_order_iter;
     if(iter == disk_info_tree.end()){
@@ -105,22 +372,119 @@ void SimpleDB::Delete(const std::string key) {
 }
 
 int SimpleDB::NumData() {
+    if(mapped_file.IsOpen()){
+        return header_info.number_of_items;
+    }
     return disk_info_tree.size();
 }
+
+bool SimpleDB::IsCompressed() {
+    return header_info.flags & compressed_records;
+}
     
 void SimpleDB::Init(){
     header_info.signature = 0x57957295;
-    header_info.version = 0x00000001;
+    header_info.version = current_version;
     header_info.number_of_items = 0;
-    header_info.disk_info_offset = sizeof(header_info);
+    header_info.flags = 0;
+    header_info.disk_info_offset = HeaderSize();
     disk_info_tree.clear();
     insertion_order.clear();
+    mapped.disk_info = nullptr;
+    mapped.key_offsets = nullptr;
+    mapped.slots = nullptr;
+    mapped.keys = nullptr;
+    mapped.keys_size = 0;
+    mapped.num_slots = 0;
+    mapped.built.clear();
+    mapped.sorted.clear();
+    mapped.cursor = 0;
+}
+
+void SimpleDB::OpenMapped(const std::string name){
+    if(option.create || option.delete_previous){
+        throw std::string("option.mmap opens a db read-only.");
+    }
+    mapped_file.Open(name);
+    if(mapped_file.Size() < header_size_v1){
+        mapped_file.Close();
+        throw std::string("Header size does not match.");
+    }
+    file_size = mapped_file.Size();
+    const char *base = mapped_file.Data();
+    try{
+        CheckHeader(base, file_size);
+        const uint64_t count = header_info.number_of_items;
+        uint64_t keys_offset = header_info.disk_info_offset +
+            sizeof(ItemDiskInfo) * count;
+        if(HasHashIndex()){
+            keys_offset += sizeof(uint32_t) * count +
+                sizeof(IndexSlot) * uint64_t(num_slots(count));
+        }
+        runtime_assert(keys_offset <= file_size,
+            "the disk info is out of the file. (maybe, file has been corrupted.)");
+        mapped.disk_info = base + header_info.disk_info_offset;
+        mapped.keys = base + keys_offset;
+        mapped.keys_size = file_size - keys_offset;
+        if(HasHashIndex()){
+            mapped.key_offsets = mapped.disk_info + sizeof(ItemDiskInfo) * count;
+            mapped.slots = mapped.key_offsets + sizeof(uint32_t) * count;
+            mapped.num_slots = num_slots(count);
+        }
+        else{
+            // older files are scanned once to build the same index.
+            std::vector<uint32_t> key_offsets(count);
+            uint32_t offset = 0;
+            for(uint32_t n = 0; n < count; ++n){
+                const void *key_end = offset < mapped.keys_size ?
+                    std::memchr(mapped.keys + offset, 0, mapped.keys_size - offset) : nullptr;
+                runtime_assert(
+                               key_end != nullptr,
+                               "the number of data and the number of key are not same. (maybe, file has been corrupted.)"
+                               );
+                key_offsets[n] = offset;
+                offset = static_cast<const char *>(key_end) - mapped.keys + 1;
+            }
+            std::vector<IndexSlot> slots;
+            build_slots(mapped.keys, key_offsets, slots);
+            const size_t offsets_size = sizeof(uint32_t) * key_offsets.size();
+            mapped.built.resize(offsets_size + sizeof(IndexSlot) * slots.size());
+            std::memcpy(mapped.built.data(), key_offsets.data(), offsets_size);
+            std::memcpy(mapped.built.data() + offsets_size, slots.data(),
+                        sizeof(IndexSlot) * slots.size());
+            mapped.key_offsets = mapped.built.data();
+            mapped.slots = mapped.built.data() + offsets_size;
+            mapped.num_slots = slots.size();
+        }
+        // an ordered db reads the items in key order from the first one.
+        // a file written in key order is read as it is, others are checked
+        // in one pass and only sorted if they are not in order already.
+        if(option.ordered && !(header_info.flags & sorted_keys) &&
+           !keys_sorted(mapped.key_offsets, mapped.keys, mapped.keys_size, count)){
+            sort_keys(mapped.key_offsets, mapped.keys, mapped.keys_size,
+                      count, mapped.sorted);
+        }
+    }
+    catch(std::string &e){
+        mapped_file.Close();
+        Init();
+        throw e;
+    }
+    last_cursor = header_info.disk_info_offset;
 }
 
 void SimpleDB::ReadHeader(){
     HeaderInfo temp;
+    const uint32_t size = std::min<uint32_t>(file_size, sizeof(temp));
     SeekToFirst();
-    Read(reinterpret_cast<char *>(&temp), sizeof(temp));
+    Read(reinterpret_cast<char *>(&temp), size);
+    CheckHeader(reinterpret_cast<const char *>(&temp), size);
+}
+
+void SimpleDB::CheckHeader(const char *header, uint32_t size){
+    HeaderInfo temp;
+    temp.flags = 0;
+    std::memcpy(&temp, header, std::min<uint32_t>(size, sizeof(temp)));
     if (temp.signature != header_info.signature) {
         std::ostringstream info;
         info<<"Signature not matches.";
@@ -131,34 +495,45 @@ void SimpleDB::ReadHeader(){
         info<<"]";
         throw info.str();
     }
-    if (temp.version != header_info.version) {
+    if (temp.version == 0 || temp.version > current_version) {
         std::ostringstream info;
         info << "Version not matches.";
         info << "[";
         info << temp.version << "(opened file)";
         info << "vs";
-        info << header_info.version << "(current library)";
+        info << current_version << "(current library)";
         info << "]";
         throw info.str();
     }
+    if (temp.version != 1 && size < sizeof(temp)) {
+        throw std::string("Header size does not match.");
+    }
+    header_info.version = temp.version;
+    header_info.flags = temp.version == 1 ? 0 : temp.flags;
     header_info.number_of_items = temp.number_of_items;
     header_info.disk_info_offset = temp.disk_info_offset;
 }
 
 void SimpleDB::WriteHeader(){
     SeekToFirst();
+    // WriteDiskInfo() follows in the order of option.ordered.
+    if(option.ordered){
+        header_info.flags |= sorted_keys;
+    }
+    else{
+        header_info.flags &= ~sorted_keys;
+    }
     header_info.version = header_info.version;
     header_info.signature = header_info.signature;
     header_info.number_of_items = disk_info_tree.size();
     header_info.disk_info_offset = HeaderSize() + GetAllItemSize();
-    Write(reinterpret_cast<char *>(&header_info), sizeof(header_info));
+    Write(reinterpret_cast<char *>(&header_info), HeaderSize());
 }
 
 void SimpleDB::ReadDiskInfo(){
     std::vector<ItemDiskInfo> vec_disk_info;
     std::vector<char> keys;
     uint32_t total_key_size = 0;
-    uint32_t accum_key_size = 0;
     uint32_t key_count = 0;
     
     vec_disk_info.resize(header_info.number_of_items);
@@ -168,6 +543,13 @@ void SimpleDB::ReadDiskInfo(){
          sizeof(ItemDiskInfo) * header_info.number_of_items
          );
     
+    if(HasHashIndex()){
+        SeekFromFirstTo(GetPosition() +
+            sizeof(uint32_t) * header_info.number_of_items +
+            sizeof(IndexSlot) * num_slots(header_info.number_of_items));
+    }
+    runtime_assert(GetPosition() <= file_size,
+        "the disk info is out of the file. (maybe, file has been corrupted.)");
     total_key_size = file_size - (GetPosition());
     keys.resize(total_key_size);
     Read(keys.data(), total_key_size);
@@ -177,52 +559,71 @@ void SimpleDB::ReadDiskInfo(){
                    key_count == total_key_size,
                    "the number of data and the number of key are not same. (maybe, file has been corrupted.)"
                    );
+    BuildDiskInfo(reinterpret_cast<const char *>(vec_disk_info.data()),
+                  keys.data(), total_key_size);
+    SeekFromFirstTo(HeaderSize() + GetAllItemSize());
+}
+
+void SimpleDB::BuildDiskInfo(const char *disk_info, const char *keys, uint32_t keys_size){
+    uint32_t accum_key_size = 0;
     for(int n = 0; n < header_info.number_of_items; ++n){
-        std::string key(keys.data() + accum_key_size);
-        vec_disk_info[n].data_size = vec_disk_info[n].data_size;
-        vec_disk_info[n].pos_data_from_first = vec_disk_info[n].pos_data_from_first;
-        disk_info_tree[key] = vec_disk_info[n];
+        ItemDiskInfo info;
+        std::memcpy(&info, disk_info + n * sizeof(ItemDiskInfo), sizeof(info));
+        const char *key_ptr = keys + accum_key_size;
+        const void *key_end = accum_key_size < keys_size ?
+            std::memchr(key_ptr, 0, keys_size - accum_key_size) : nullptr;
+        runtime_assert(
+                       key_end != nullptr,
+                       "the number of data and the number of key are not same. (maybe, file has been corrupted.)"
+                       );
+        std::string key(key_ptr, static_cast<const char *>(key_end));
+        disk_info_tree[key] = info;
         insertion_order.push_back(std::make_pair(key, &disk_info_tree[key]));
         accum_key_size += key.size() + 1;
     }
-    SeekFromFirstTo(HeaderSize() + GetAllItemSize());
 }
 
 void SimpleDB::WriteDiskInfo(){
     SeekFromFirstTo(header_info.disk_info_offset);
-    
-    /*
-     * TODO:
-     * 1. Merge ItemDiskInfo and key into one string for one write op.
-     * maybe it also needs the algorithm that not use for-loop.
-     * 2. remove the conditional branch.
-     */
+    std::vector<std::pair<const std::string *, const ItemDiskInfo *>> items;
+    items.reserve(disk_info_tree.size());
     if(option.ordered){
         for(auto &iter : disk_info_tree){
-            iter.second.data_size = iter.second.data_size;
-            iter.second.pos_data_from_first = iter.second.pos_data_from_first;
-            Write(reinterpret_cast<char *>(&iter.second), sizeof(ItemDiskInfo));
-        }
-        
-        for(auto &iter : disk_info_tree){
-            Write(const_cast<char *>(iter.first.c_str()), iter.first.size() + 1);
+            items.push_back(std::make_pair(&iter.first, &iter.second));
         }
     }
     else{
         for(auto &iter : insertion_order){
-            iter.second->data_size = iter.second->data_size;
-            iter.second->pos_data_from_first = iter.second->pos_data_from_first;
-            Write(reinterpret_cast<char *>(iter.second), sizeof(ItemDiskInfo));
-        }
-        
-        for(auto &iter : insertion_order){
-            Write(const_cast<char *>(iter.first.c_str()), iter.first.size() + 1);
+            items.push_back(std::make_pair(&iter.first, iter.second));
         }
     }
+    std::vector<ItemDiskInfo> disk_info(items.size());
+    std::vector<uint32_t> key_offsets(items.size());
+    std::string keys;
+    for(uint32_t n = 0; n < items.size(); ++n){
+        disk_info[n] = *items[n].second;
+        key_offsets[n] = keys.size();
+        keys.append(items[n].first->c_str(), items[n].first->size() + 1);
+    }
+    Write(reinterpret_cast<char *>(disk_info.data()),
+          sizeof(ItemDiskInfo) * disk_info.size());
+    if(HasHashIndex()){
+        std::vector<IndexSlot> slots;
+        build_slots(keys.data(), key_offsets, slots);
+        Write(reinterpret_cast<char *>(key_offsets.data()),
+              sizeof(uint32_t) * key_offsets.size());
+        Write(reinterpret_cast<char *>(slots.data()),
+              sizeof(IndexSlot) * slots.size());
+    }
+    Write(const_cast<char *>(keys.data()), keys.size());
+}
+
+bool SimpleDB::HasHashIndex(){
+    return header_info.version >= 3;
 }
 
 int SimpleDB::HeaderSize(){
-    return sizeof(HeaderInfo);
+    return header_info.version == 1 ? header_size_v1 : sizeof(HeaderInfo);
 }
 
 uint32_t SimpleDB::GetAllItemSize(){
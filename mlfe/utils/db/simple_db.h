@@ -1,6 +1,8 @@
 #ifndef __SIMPLE_DB_HPP__
 #define __SIMPLE_DB_HPP__
 #include "data_base.h"
+#include "../mapped_file.h"
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -10,7 +12,6 @@ namespace mlfe{ namespace simpledb{
  * TODO:
  * more algorithms need: B-Tree, data cashing, reducing direct calling of IO seek,
  * async algorithm for put, get, delete,
- * data compression to reduce DB size,
  * efficient key-value management,
  * db options, db status, thread-safe,
  * file integrity check.
@@ -28,6 +29,12 @@ public:
     void Get(std::string &val) override;
     
     void Get(const std::string key, std::string &val) override;
+
+    DataView GetView() override;
+
+    DataView GetView(const std::string key) override;
+
+    DataView GetViewAt(const int index) override;
     
     void Put(const std::string key, const std::string val) override;
     
@@ -38,19 +45,34 @@ public:
     void Delete(const std::string key) override;
     
     int NumData() override;
+
+    bool IsCompressed() override;
     
 protected:
     void Init();
     
     void ReadHeader();
+
+    void CheckHeader(const char *header, uint32_t size);
     
     void WriteHeader();
     
     void ReadDiskInfo();
+
+    void BuildDiskInfo(const char *disk_info, const char *keys, uint32_t keys_size);
+
+    void OpenMapped(const std::string name);
+
+    // the position of key in the items of a mapped db, -1 if it is not.
+    int FindMapped(const std::string &key);
     
     void WriteDiskInfo();
+
+    bool HasHashIndex();
     
     int HeaderSize();
+
+    void EncodeRecord(const std::string &val, std::string &record);
     
     uint32_t GetAllItemSize();
     
@@ -62,17 +84,59 @@ private:
      * Define max item, max size of data, max size of key.
      * dealing with Padding bit, when use int64_t in odd.
      */
+    /*
+     * version 2 appended the flags, version 3 the hash index. files of
+     * the older versions are still read and appended in their layout.
+     */
     struct HeaderInfo{
         uint32_t signature;
         uint32_t version;
         uint32_t number_of_items;
         uint32_t disk_info_offset;
+        uint32_t flags;
     } header_info;
+
+    enum HeaderFlag : uint32_t{
+        compressed_records = 1,
+        // the items were written in key order, by option.ordered.
+        sorted_keys = 2
+    };
+
+    /*
+     * the hash index follows the disk info of a version 3 file:
+     *   [uint32 key offset] * number_of_items, into the keys section
+     *   [IndexSlot] * NumSlots(number_of_items)
+     *   keys, '\0' terminated, in the order of the disk info
+     * a key is found by linear probing from its hash, so opening a
+     * mapped db reads nothing but the header.
+     */
+    struct IndexSlot{
+        uint32_t hash;
+        // the position of the item plus one, 0 for an empty slot.
+        uint32_t item;
+    };
+
+    struct MappedIndex{
+        const char *disk_info;
+        const char *key_offsets;
+        const char *slots;
+        const char *keys;
+        uint32_t keys_size;
+        uint32_t num_slots;
+        // the index of a file without one, built on open.
+        std::vector<char> built;
+        // items in key order, for option.ordered, empty when the file
+        // already stores them in that order.
+        std::vector<uint32_t> sorted;
+        uint32_t cursor;
+    } mapped;
     
     struct ItemDiskInfo{
         uint32_t data_size;
         uint32_t pos_data_from_first;
     };
+
+    ItemDiskInfo MappedItem(const uint32_t index);
     
     /*
      * TODO:
@@ -85,8 +149,24 @@ private:
     std::vector<std::pair<std::string, ItemDiskInfo *> >::iterator insertion_order_iter;
     uint32_t file_size;
     uint32_t last_cursor;
+    MappedFile mapped_file;
+    std::string record_buffer;
 };
 
+/*
+ * a record of a db with option.compress is a frame of
+ * [uint32 tag][lz4 block], the low 31 bits of the tag are the size of
+ * the record and the top bit marks a record stored as it is, because it
+ * did not compress. Get decodes the frames, GetView returns them as they
+ * are stored.
+ */
+
+// the size of the record of a frame.
+uint32_t DecodedSize(const DataView frame);
+
+// writes the record of a frame into dst, which holds DecodedSize bytes.
+void DecodeRecord(const DataView frame, char *dst);
+
 } /* namespace simpledb */
 } /* namespace mlfe */
 #endif /* __SIMPLE_DB_HPP__ */
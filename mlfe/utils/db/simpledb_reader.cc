@@ -5,17 +5,35 @@
 #include "../../flatbuffers/tensor_blob_fb_generated.h"
 #include <vector>
 #include <algorithm>
+#include <numeric>
+#include <random>
 
 namespace mlfe {
 
 SimpleDBReader::SimpleDBReader(
     std::string path
-){
+) : SimpleDBReader(path, Option()){}
+
+SimpleDBReader::SimpleDBReader(
+    std::string path,
+    Option option
+) : option(option){
+    runtime_assert(option.num_workers >= 1 && option.prefetch >= 1,
+        "SimpleDBReader: needs at least one worker and one prefetch.");
+    runtime_assert(option.world_size >= 1 &&
+        option.rank >= 0 && option.rank < option.world_size,
+        "SimpleDBReader: rank must be in [0, world_size).");
     OpenDB(path);
-    bg_worker = std::make_shared<ThreadPool>(1);
-    wanna_fill.push(std::vector<std::shared_ptr<std::vector<uint8>>>());
-    wanna_fill.front().push_back(std::make_shared<std::vector<uint8>>());
-    wanna_fill.front().push_back(std::make_shared<std::vector<uint8>>());
+    const int num_data = db->NumData();
+    runtime_assert(num_data > 0, "SimpleDBReader: the db is empty.");
+    shard_size = (num_data + option.world_size - 1) / option.world_size;
+    workers = std::make_shared<ThreadPool>(option.num_workers);
+    slots.resize(option.prefetch);
+    next_slot = 0;
+    batch_size = 0;
+    read_position = 0;
+    schedule_position = 0;
+    order_epoch = -1;
 }
 
 SimpleDBReader::~SimpleDBReader() {
@@ -25,50 +43,253 @@ SimpleDBReader::~SimpleDBReader() {
 void SimpleDBReader::OpenDB(std::string path) {
     db = std::make_shared<simpledb::SimpleDB>();
     db->option.binary = true;
+    db->option.mmap = true;
     db->Open(path);
-    db->MoveToFirst();
+}
+
+void SimpleDBReader::SetAugmentation(int t,
+                                     ImageShape shape,
+                                     std::vector<AugmentationPtr> stages,
+                                     std::vector<float> mean,
+                                     std::vector<float> stddev
+                                    ){
+    runtime_assert(t >= 0, "SimpleDBReader: tensor index must be positive.");
+    Transform tf;
+    tf.shape = shape;
+    tf.output_shape = shape;
+    for(auto &stage : stages){
+        tf.output_shape = stage->OutputShape(tf.output_shape);
+    }
+    tf.stages = stages;
+    if(!mean.empty() || !stddev.empty()){
+        const int channels = tf.output_shape.channels;
+        tf.mean = mean.empty() ? Vec<float>(channels, 0.f) : mean;
+        tf.stddev = stddev.empty() ? Vec<float>(channels, 1.f) : stddev;
+        runtime_assert(tf.mean.size() == channels && tf.stddev.size() == channels,
+            "SimpleDBReader: needs a mean and a stddev for every channel.");
+    }
+    // batches read ahead are read again with the new transform.
+    WaitAll();
+    if(transforms.size() <= t){
+        transforms.resize(t + 1);
+    }
+    transforms[t] = tf;
+    batch_size = 0;
+}
+
+int SimpleDBReader::NumData() const{
+    return shard_size;
 }
 
 void SimpleDBReader::MoveToFirst(){
-    db->MoveToFirst();
+    WaitAll();
+    batch_size = 0;
+    read_position = 0;
 }
 
 void SimpleDBReader::Close() {
-    bg_worker->Wait(0);
-}
-
-void SimpleDBReader::FillBuffer(int batch) {
-    if (!wanna_fill.empty()) {
-        flatbuffers::FlatBufferBuilder builder;
-        auto buffers = wanna_fill.front();
-        wanna_fill.pop();
-        for (int b = 0; b < batch; ++b) {
-            const serializable::TensorBlobs * serialized_tb;
-            std::string serialized_data;
-            db->Get(serialized_data);
-            builder.PushFlatBuffer(reinterpret_cast<const unsigned char *>(serialized_data.data()), serialized_data.size());
-            serialized_tb = serializable::GetTensorBlobs(builder.GetBufferPointer());
-
-            int num_data = serialized_tb->tensors()->size();
-            for(int t = 0; t < num_data; ++t){
-                auto obj = serialized_tb->tensors()->Get(t);
-                auto ptr = obj->data()->data();
-                int data_size = obj->data()->size();
-                int offset = b * data_size;
-                if(buffers[t]->size() != batch * data_size){
-                    buffers[t]->resize(batch * data_size);
-                }
-                for(int n = 0; n < data_size; ++n) {
-                    auto buffer_ptr = buffers[t]->data();
-                    buffer_ptr[offset + n] = ptr[n];
-                }
+    WaitAll();
+}
+
+void SimpleDBReader::WaitAll(){
+    for(int n = 0; n < slots.size(); ++n){
+        workers->Wait(n);
+    }
+}
+
+void SimpleDBReader::Read(int batch,
+                          std::vector<Tensor> tensors,
+                          std::vector<float> scales
+                         ){
+    Batch &buffer = NextBatch(batch);
+    for(int t = 0; t < tensors.size(); ++t){
+        Assemble<float>(buffer, t, tensors[t].size(),
+                        t < scales.size() ? scales[t] : 1.f,
+                        tensors[t].mutable_data<float>());
+    }
+    ReleaseBatch();
+}
+
+SimpleDBReader::Batch &SimpleDBReader::NextBatch(int batch){
+    runtime_assert(batch > 0, "SimpleDBReader: batch must be positive.");
+    // batches read ahead with another size are read again.
+    if(batch != batch_size){
+        WaitAll();
+        batch_size = batch;
+        schedule_position = read_position;
+        for(int k = 0; k < slots.size(); ++k){
+            Schedule((next_slot + k) % slots.size());
+        }
+    }
+    workers->Wait(next_slot);
+    Batch &buffer = slots[next_slot];
+    if(!buffer.error.empty()){
+        const std::string message = buffer.error;
+        buffer.error.clear();
+        WaitAll();
+        batch_size = 0;
+        throw message;
+    }
+    return buffer;
+}
+
+void SimpleDBReader::ReleaseBatch(){
+    read_position += batch_size;
+    Schedule(next_slot);
+    next_slot = (next_slot + 1) % slots.size();
+}
+
+void SimpleDBReader::Schedule(int slot){
+    Batch &buffer = slots[slot];
+    buffer.records.resize(batch_size);
+    buffer.position = schedule_position;
+    for(int b = 0; b < batch_size; ++b){
+        buffer.records[b] = RecordAt(schedule_position + b);
+    }
+    schedule_position += batch_size;
+    workers->AddTask(std::bind(&SimpleDBReader::FillBuffer, this, slot), slot);
+}
+
+int SimpleDBReader::RecordAt(long long position){
+    const int num_data = db->NumData();
+    const long long epoch = position / shard_size;
+    const int n = (option.rank + option.world_size *
+        static_cast<int>(position % shard_size)) % num_data;
+    if(!option.shuffle){
+        return n;
+    }
+    if(epoch != order_epoch){
+        std::seed_seq seq{option.seed, static_cast<unsigned int>(epoch)};
+        std::mt19937 rng(seq);
+        order.resize(num_data);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        order_epoch = epoch;
+    }
+    return order[n];
+}
+
+void SimpleDBReader::FillBuffer(int slot) {
+    Batch &buffer = slots[slot];
+    // errors on a worker are thrown by the Read of the batch.
+    try{
+        CollectBatch(buffer);
+    }
+    catch(std::string &e){
+        buffer.error = e;
+    }
+}
+
+void SimpleDBReader::CollectBatch(Batch &buffer){
+    buffer.blobs.clear();
+    buffer.num_blobs = 0;
+    Vec<DataView> decoded;
+    if(db->IsCompressed()){
+        decoded = DecodeBatch(buffer);
+    }
+    // reading a byte of every page faults the batch in here, not in Read.
+    uint8 touched = 0;
+    for (int b = 0; b < buffer.records.size(); ++b) {
+        const DataView record = decoded.empty() ?
+            db->GetViewAt(buffer.records[b]) : decoded[b];
+        auto serialized_tb = serializable::GetTensorBlobs(record.data);
+        const int num_data = serialized_tb->tensors()->size();
+        if(b == 0){
+            buffer.num_blobs = num_data;
+            buffer.blobs.reserve(buffer.records.size() * num_data);
+        }
+        if(num_data != buffer.num_blobs){
+            throw std::string("SimpleDBReader: records have different "
+                              "number of tensors.");
+        }
+        for(int t = 0; t < num_data; ++t){
+            auto data = serialized_tb->tensors()->Get(t)->data();
+            DataView blob;
+            blob.data = reinterpret_cast<const char *>(data->data());
+            blob.size = data->size();
+            if(b > 0 && blob.size != buffer.blobs[t].size){
+                throw std::string("SimpleDBReader: tensor ") +
+                    std::to_string(t) + " has different sizes.";
+            }
+            for(int n = 0; n < blob.size; n += 4096){
+                touched ^= blob.data[n];
             }
-            builder.Clear();
-            if (!db->MoveToNext()) {
-                db->MoveToFirst();
+            buffer.blobs.push_back(blob);
+        }
+    }
+    volatile uint8 sink = touched;
+    (void)sink;
+    AugmentBatch(buffer);
+}
+
+SimpleDBReader::Vec<DataView> SimpleDBReader::DecodeBatch(Batch &buffer){
+    const int batch = buffer.records.size();
+    Vec<DataView> frames(batch), records(batch);
+    Vec<size_t> offsets(batch + 1, 0);
+    for(int b = 0; b < batch; ++b){
+        frames[b] = db->GetViewAt(buffer.records[b]);
+        // records start 8 bytes aligned like the flatbuffers they hold.
+        const size_t size = simpledb::DecodedSize(frames[b]);
+        offsets[b + 1] = offsets[b] + (size + 7) / 8 * 8;
+        records[b].size = size;
+    }
+    // grows to the largest batch once, then it is reused.
+    buffer.decoded.resize(offsets[batch]);
+    for(int b = 0; b < batch; ++b){
+        char *dst = buffer.decoded.data() + offsets[b];
+        simpledb::DecodeRecord(frames[b], dst);
+        records[b].data = dst;
+    }
+    return records;
+}
+
+void SimpleDBReader::AugmentBatch(Batch &buffer){
+    const int batch = buffer.records.size();
+    const int num_transforms = std::min<int>(transforms.size(), buffer.num_blobs);
+    size_t staging_size = 0;
+    for(int t = 0; t < num_transforms; ++t){
+        if(!transforms[t].stages.empty()){
+            staging_size += batch * transforms[t].output_shape.Size();
+        }
+    }
+    if(staging_size == 0){
+        return;
+    }
+    buffer.staging.resize(staging_size);
+    uint8 *out = buffer.staging.data();
+    Vec<uint8> ping, pong;
+    for(int t = 0; t < num_transforms; ++t){
+        const Transform &tf = transforms[t];
+        if(tf.stages.empty()){
+            continue;
+        }
+        for(int b = 0; b < batch; ++b){
+            DataView &blob = buffer.blobs[b * buffer.num_blobs + t];
+            if(blob.size != tf.shape.Size()){
+                throw std::string("SimpleDBReader: tensor ") +
+                    std::to_string(t) + " does not match the image shape.";
+            }
+            // the draws of an image depend only on its stream position.
+            ImageRandom rng(math::philox(option.seed, t,
+                static_cast<type::uint32::T>(buffer.position + b)));
+            const uint8 *x = reinterpret_cast<const uint8 *>(blob.data);
+            ImageShape shape = tf.shape;
+            for(int s = 0; s < tf.stages.size(); ++s){
+                const ImageShape next = tf.stages[s]->OutputShape(shape);
+                uint8 *y = out;
+                if(s + 1 < tf.stages.size()){
+                    Vec<uint8> &scratch = s % 2 == 0 ? ping : pong;
+                    scratch.resize(next.Size());
+                    y = scratch.data();
+                }
+                tf.stages[s]->Apply(shape, x, y, rng);
+                x = y;
+                shape = next;
             }
+            blob.data = reinterpret_cast<const char *>(out);
+            blob.size = tf.output_shape.Size();
+            out += blob.size;
         }
-        wanna_consume.push(buffers);
     }
 }
 } // end namespace mlfe
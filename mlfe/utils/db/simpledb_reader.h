@@ -2,11 +2,21 @@
 #define __SIMPLEDB_READER_HPP__
 
 #include "../../core/tensor.h"
+#include "../../device_context/cpu_context.h"
+#include "../../math/basic_functions.h"
+#include "../../utils/parallel_for.h"
 #include "../../utils/thread_pool.h"
 #include "../../utils/db/data_base.h"
+#include "../../utils/db/augmentation.h"
 
 namespace mlfe {
 
+// reads batches of TensorBlobs records from a memory-mapped SimpleDB.
+// records are parsed in place, and a batch is written straight into the
+// destination with the uint8 to float conversion and scale fused.
+// batches are read ahead by a pool of workers. the records form one
+// endless stream over the epochs, so the result does not depend on the
+// number of workers or the prefetch depth.
 class SimpleDBReader{
 template <class T>
 using Ptr = std::shared_ptr<T>;
@@ -16,50 +26,198 @@ template <class T>
 using RefWrapVec = std::reference_wrapper<Vec<T>>;
 using uint8 = type::uint8::T;
 public:
+    struct Option{
+        // threads that parse the records of a batch and fault them in.
+        int num_workers = 1;
+        // batches in flight, each one is read by a single worker.
+        int prefetch = 2;
+        // a new permutation of the records in insertion order every
+        // epoch, the same on every rank for the same seed.
+        bool shuffle = false;
+        unsigned int seed = 0;
+        // this process reads every world_size-th record of the epoch,
+        // starting from rank. the last records wrap around so all ranks
+        // read the same number of records.
+        int rank = 0;
+        int world_size = 1;
+    };
+
     SimpleDBReader(std::string path);
 
+    SimpleDBReader(std::string path, Option option);
+
     ~SimpleDBReader();
 
+    // tensors[t] = scales[t] * (blob t of the next batch records).
+    // scales defaults to 1 for every tensor.
+    void Read(int batch,
+              std::vector<Tensor> tensors,
+              std::vector<float> scales = {}
+             );
+
     template <class T>
-    void Read(int batch, std::vector<RefWrapVec<T>> tensors);
+    void Read(int batch,
+              std::vector<RefWrapVec<T>> tensors,
+              std::vector<T> scales = {}
+             );
 
+    // blob t of every record is an image of the given shape. the stages
+    // run in order on the workers, then Read normalizes every channel,
+    // y = (scale * x - mean[c]) / stddev[c], in the same pass as the
+    // conversion to float. mean and stddev default to 0 and 1.
+    void SetAugmentation(int t,
+                         ImageShape shape,
+                         std::vector<AugmentationPtr> stages,
+                         std::vector<float> mean = {},
+                         std::vector<float> stddev = {}
+                        );
+
+    // records read by this rank in an epoch.
+    int NumData() const;
+
+    // starts again from the first record of the first epoch.
     void MoveToFirst();
 
     void Close();
 
 protected:
+    // blob t of record b is blobs[b * num_blobs + t], which points into
+    // the mapped file and stays valid until the db is closed.
+    // augmented blobs point into staging instead, and the blobs of a
+    // compressed db into the records decoded by the worker.
+    struct Batch{
+        Vec<int> records;
+        long long position;
+        Vec<DataView> blobs;
+        int num_blobs;
+        Vec<uint8> staging;
+        Vec<char> decoded;
+        std::string error;
+    };
+
+    struct Transform{
+        ImageShape shape;
+        ImageShape output_shape;
+        Vec<AugmentationPtr> stages;
+        Vec<float> mean;
+        Vec<float> stddev;
+    };
+
     void OpenDB(std::string path);
 
-    void FillBuffer(int batch);
+    // assigns the next records of the stream to a slot and reads them
+    // on a worker.
+    void Schedule(int slot);
+
+    void FillBuffer(int slot);
+
+    void CollectBatch(Batch &buffer);
+
+    // decompresses the records of a batch into decoded, and returns
+    // views of them.
+    Vec<DataView> DecodeBatch(Batch &buffer);
+
+    void AugmentBatch(Batch &buffer);
+
+    // the record at a position of the stream.
+    int RecordAt(long long position);
+
+    void WaitAll();
+
+    Batch &NextBatch(int batch);
+
+    void ReleaseBatch();
+
+    template <class T>
+    void Assemble(const Batch &buffer, int t, int size, T scale, T *dst);
 
 private:
-    std::shared_ptr<ThreadPool> bg_worker;
-    std::queue<Vec<Ptr<std::vector<uint8>>>> wanna_consume;
-    std::queue<Vec<Ptr<std::vector<uint8>>>> wanna_fill;
+    Option option;
+    std::shared_ptr<ThreadPool> workers;
+    // slots[(next_slot + k) % prefetch] holds the k-th batch ahead.
+    Vec<Batch> slots;
+    int next_slot;
+    // the size of the scheduled batches, 0 if nothing is scheduled.
+    int batch_size;
+    long long read_position;
+    long long schedule_position;
+    // the permutation of order_epoch when shuffling.
+    Vec<int> order;
+    long long order_epoch;
+    int shard_size;
+    // transforms[t] of blob t, if it has a shape.
+    Vec<Transform> transforms;
     std::shared_ptr<DataBase> db;
 };
 
 template <class T>
-void SimpleDBReader::Read(int batch, std::vector<RefWrapVec<T>> tensors) {
-    bg_worker->Wait(0);
-    if(!wanna_fill.empty()){
-        bg_worker->AddTask(std::bind(&SimpleDBReader::FillBuffer, this, batch), 0);
-        bg_worker->Wait(0);
+void SimpleDBReader::Read(int batch,
+                          std::vector<RefWrapVec<T>> tensors,
+                          std::vector<T> scales
+                         ){
+    Batch &buffer = NextBatch(batch);
+    for(int t = 0; t < tensors.size(); ++t){
+        Vec<T> &dst = tensors[t].get();
+        Assemble<T>(buffer, t, dst.size(),
+                    t < scales.size() ? scales[t] : T(1), dst.data());
+    }
+    ReleaseBatch();
+}
+
+template <class T>
+void SimpleDBReader::Assemble(const Batch &buffer,
+                              int t,
+                              int size,
+                              T scale,
+                              T *dst
+                             ){
+    const int batch = buffer.blobs.size() / buffer.num_blobs;
+    if(t >= buffer.num_blobs){
+        throw std::string("SimpleDBReader: records have only ") +
+            std::to_string(buffer.num_blobs) + " tensors.";
+    }
+    const int blob_size = buffer.blobs[t].size;
+    if(size != batch * blob_size){
+        throw std::string("SimpleDBReader: tensor ") + std::to_string(t) +
+            " has " + std::to_string(size) + " elements, the batch has " +
+            std::to_string(batch * blob_size) + ".";
+    }
+    // per channel coefficients of the conversion when normalizing.
+    const bool normalize = t < transforms.size() && !transforms[t].mean.empty();
+    int channels = 1, inner = blob_size;
+    Vec<T> alpha(1, scale), beta(1, T(0));
+    if(normalize){
+        const Transform &tf = transforms[t];
+        channels = tf.output_shape.channels;
+        inner = tf.output_shape.channels_last ?
+            1 : tf.output_shape.height * tf.output_shape.width;
+        alpha.resize(channels);
+        beta.resize(channels);
+        for(int c = 0; c < channels; ++c){
+            alpha[c] = scale / tf.stddev[c];
+            beta[c] = -tf.mean[c] / tf.stddev[c];
+        }
     }
-    auto buffer = wanna_consume.front();
-    wanna_consume.pop();
-    std::copy(
-        buffer[0]->data(),
-        buffer[0]->data() + buffer[0]->size(),
-        tensors[0].get().begin()
-    );
-    std::copy(
-        buffer[1]->data(),
-        buffer[1]->data() + buffer[1]->size(),
-        tensors[1].get().begin()
-    );
-    wanna_fill.push(buffer);
-    bg_worker->AddTask(std::bind(&SimpleDBReader::FillBuffer, this, batch), 0);
+    // a record is small, so several of them make up one chunk.
+    const int grain = std::max(1, (1 << 14) / std::max(blob_size, 1));
+    const DataView *blobs = buffer.blobs.data();
+    const int num_blobs = buffer.num_blobs;
+    const T *alpha_ptr = alpha.data();
+    const T *beta_ptr = beta.data();
+    parallel_for(0, batch, grain, [=](int from, int to){
+        for(int b = from; b < to; ++b){
+            const uint8 *x = reinterpret_cast<const uint8 *>(
+                blobs[b * num_blobs + t].data);
+            if(normalize){
+                math::normalize_uint8<T, CPUContext>(blob_size, channels,
+                    inner, alpha_ptr, beta_ptr, x, dst + b * blob_size);
+            }
+            else{
+                math::scale_uint8<T, CPUContext>(blob_size, alpha_ptr[0],
+                    x, dst + b * blob_size);
+            }
+        }
+    });
 }
 
 } // end namespace mlfe
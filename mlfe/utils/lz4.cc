@@ -0,0 +1,193 @@
+#include "lz4.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace mlfe{ namespace lz4{
+namespace {
+
+// limits of the block format: a match is at least 4 bytes, the last 5
+// bytes are literals and the last match starts 12 bytes before the end.
+constexpr int min_match = 4;
+constexpr int last_literals = 5;
+constexpr int mf_limit = 12;
+constexpr int max_offset = 65535;
+
+// 4096 positions, 16KB on the stack like the reference encoder.
+constexpr int hash_log = 12;
+
+inline uint32_t read32(const char *p){
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline int hash(const uint32_t v){
+    return static_cast<int>((v * 2654435761u) >> (32 - hash_log));
+}
+
+inline char *write_length(char *op, int len){
+    for(; len >= 255; len -= 255){
+        *op++ = static_cast<char>(255);
+    }
+    *op++ = static_cast<char>(len);
+    return op;
+}
+
+inline char *write_sequence(char *op,
+                            const char *literals,
+                            const int num_literals,
+                            const int offset,
+                            const int match_len
+                           ){
+    char *token = op++;
+    const int lit_code = std::min(num_literals, 15);
+    if(num_literals >= 15){
+        op = write_length(op, num_literals - 15);
+    }
+    std::memcpy(op, literals, num_literals);
+    op += num_literals;
+    if(offset == 0){
+        *token = static_cast<char>(lit_code << 4);
+        return op;
+    }
+    *op++ = static_cast<char>(offset & 255);
+    *op++ = static_cast<char>(offset >> 8);
+    const int len = match_len - min_match;
+    *token = static_cast<char>((lit_code << 4) | std::min(len, 15));
+    if(len >= 15){
+        op = write_length(op, len - 15);
+    }
+    return op;
+}
+
+// reads the extra bytes of a length, false past the end of the input.
+inline bool read_length(const unsigned char *&ip,
+                        const unsigned char *iend,
+                        size_t &len
+                       ){
+    unsigned int s;
+    do{
+        if(ip >= iend){
+            return false;
+        }
+        s = *ip++;
+        len += s;
+    }while(s == 255);
+    return true;
+}
+
+} // end anonymous namespace
+
+int CompressBound(const int size){
+    return size + size / 255 + 16;
+}
+
+int Compress(const char *src, const int size, char *dst){
+    const char *ip = src;
+    const char *anchor = src;
+    const char *const end = src + size;
+    char *op = dst;
+    if(size > mf_limit){
+        const char *const match_limit = end - last_literals;
+        const char *const last_match = end - mf_limit;
+        int table[1 << hash_log];
+        std::fill(table, table + (1 << hash_log), -1);
+        while(ip <= last_match){
+            const uint32_t seq = read32(ip);
+            const int h = hash(seq);
+            const int ref = table[h];
+            const int pos = static_cast<int>(ip - src);
+            table[h] = pos;
+            if(ref < 0 || pos - ref > max_offset || read32(src + ref) != seq){
+                // steps grow with the distance to the last match, which
+                // skips quickly over data that does not compress.
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            const char *match = src + ref;
+            while(ip > anchor && match > src && ip[-1] == match[-1]){
+                --ip;
+                --match;
+            }
+            const char *ip_end = ip + min_match;
+            const char *match_end = match + min_match;
+            while(ip_end < match_limit && *ip_end == *match_end){
+                ++ip_end;
+                ++match_end;
+            }
+            op = write_sequence(op, anchor, static_cast<int>(ip - anchor),
+                                static_cast<int>(ip - match),
+                                static_cast<int>(ip_end - ip));
+            ip = anchor = ip_end;
+            if(ip <= last_match){
+                table[hash(read32(ip - 2))] = static_cast<int>(ip - 2 - src);
+            }
+        }
+    }
+    op = write_sequence(op, anchor, static_cast<int>(end - anchor), 0, 0);
+    return static_cast<int>(op - dst);
+}
+
+int Decompress(const char *src, const int size, char *dst, const int capacity){
+    const unsigned char *ip = reinterpret_cast<const unsigned char *>(src);
+    const unsigned char *const iend = ip + size;
+    char *op = dst;
+    char *const oend = dst + capacity;
+    while(ip < iend){
+        const unsigned int token = *ip++;
+        size_t num_literals = token >> 4;
+        if(num_literals == 15 && !read_length(ip, iend, num_literals)){
+            return -1;
+        }
+        if(num_literals > size_t(iend - ip) || num_literals > size_t(oend - op)){
+            return -1;
+        }
+        std::memcpy(op, ip, num_literals);
+        op += num_literals;
+        ip += num_literals;
+        // the last sequence has literals only.
+        if(ip == iend){
+            break;
+        }
+        if(iend - ip < 2){
+            return -1;
+        }
+        const size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        if(offset == 0 || offset > size_t(op - dst)){
+            return -1;
+        }
+        size_t len = token & 15;
+        if(len == 15 && !read_length(ip, iend, len)){
+            return -1;
+        }
+        len += min_match;
+        if(len > size_t(oend - op)){
+            return -1;
+        }
+        const char *match = op - offset;
+        if(offset >= 8 && size_t(oend - op) >= len + 8){
+            // 8 byte steps may write past the match into the free space
+            // after it. the source of a step was written before it, since
+            // the match is at least 8 bytes back.
+            for(size_t k = 0; k < len; k += 8){
+                std::memcpy(op + k, match + k, 8);
+            }
+        }
+        else if(offset == 1){
+            // runs of a byte, like the background of an image.
+            std::memset(op, *match, len);
+        }
+        else{
+            for(size_t k = 0; k < len; ++k){
+                op[k] = match[k];
+            }
+        }
+        op += len;
+    }
+    return static_cast<int>(op - dst);
+}
+
+} // end namespace lz4
+} // end namespace mlfe
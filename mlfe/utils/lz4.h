@@ -0,0 +1,23 @@
+#ifndef __LZ4_HPP__
+#define __LZ4_HPP__
+
+namespace mlfe{ namespace lz4{
+
+// an in-tree codec for the lz4 block format (no frame, no checksum).
+// the output of Compress can be read by any lz4 block decoder.
+
+// the largest compressed size of size bytes.
+int CompressBound(const int size);
+
+// compresses size bytes of src into dst, which holds at least
+// CompressBound(size) bytes, and returns the compressed size.
+int Compress(const char *src, const int size, char *dst);
+
+// decompresses size bytes of src into dst, which holds capacity bytes.
+// returns the decompressed size, or -1 if src is malformed or does not
+// fit into dst.
+int Decompress(const char *src, const int size, char *dst, const int capacity);
+
+} // end namespace lz4
+} // end namespace mlfe
+#endif // end ifndef __LZ4_HPP__
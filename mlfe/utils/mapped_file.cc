@@ -0,0 +1,123 @@
+#include "mapped_file.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mlfe{
+
+MappedFile::MappedFile() : data(nullptr), size(0){
+#if defined(_WIN32)
+    file_handle = INVALID_HANDLE_VALUE;
+    map_handle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile(){
+    Close();
+}
+
+#if defined(_WIN32)
+
+void MappedFile::Open(std::string name){
+    if(IsOpen()){
+        throw std::string("File is already opened.");
+    }
+    file_handle = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file_handle == INVALID_HANDLE_VALUE){
+        throw std::string("File can not open. - ") + name;
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file_handle, &file_size);
+    size = static_cast<uint64_t>(file_size.QuadPart);
+    if(size == 0){
+        return;
+    }
+    map_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY,
+        0, 0, nullptr);
+    if(map_handle != nullptr){
+        data = static_cast<const char *>(
+            MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0));
+    }
+    if(data == nullptr){
+        Close();
+        throw std::string("File can not map. - ") + name;
+    }
+}
+
+void MappedFile::Close(){
+    if(data != nullptr){
+        UnmapViewOfFile(data);
+    }
+    if(map_handle != nullptr){
+        CloseHandle(map_handle);
+    }
+    if(file_handle != INVALID_HANDLE_VALUE){
+        CloseHandle(file_handle);
+    }
+    data = nullptr;
+    size = 0;
+    map_handle = nullptr;
+    file_handle = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::IsOpen() const{
+    return file_handle != INVALID_HANDLE_VALUE;
+}
+
+#else
+
+void MappedFile::Open(std::string name){
+    if(IsOpen()){
+        throw std::string("File is already opened.");
+    }
+    const int fd = open(name.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::string("File can not open. - ") + name;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0){
+        close(fd);
+        throw std::string("File can not stat. - ") + name;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    // an empty mapping is not allowed, an empty file is a valid address.
+    void *ptr = size == 0 ? const_cast<char *>("") :
+        mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping keeps its own reference to the file.
+    close(fd);
+    if(ptr == MAP_FAILED){
+        size = 0;
+        throw std::string("File can not map. - ") + name;
+    }
+    data = static_cast<const char *>(ptr);
+}
+
+void MappedFile::Close(){
+    if(data != nullptr && size != 0){
+        munmap(const_cast<char *>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+}
+
+bool MappedFile::IsOpen() const{
+    return data != nullptr;
+}
+
+#endif
+
+const char *MappedFile::Data() const{
+    return data;
+}
+
+uint64_t MappedFile::Size() const{
+    return size;
+}
+
+} /* namespace mlfe */
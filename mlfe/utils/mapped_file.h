@@ -0,0 +1,41 @@
+#ifndef __MAPPED_FILE_HPP__
+#define __MAPPED_FILE_HPP__
+#include <string>
+#include <cstdint>
+
+namespace mlfe{
+
+// a whole file mapped read-only into memory. the pages are loaded by the
+// os on first touch and shared with the page cache, so reading a range
+// is a pointer computation with no system call or copy.
+class MappedFile{
+public:
+    MappedFile();
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    void Open(std::string name);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    const char *Data() const;
+
+    uint64_t Size() const;
+
+private:
+    const char *data;
+    uint64_t size;
+#if defined(_WIN32)
+    void *file_handle;
+    void *map_handle;
+#endif
+};
+
+} /* namespace mlfe */
+#endif /* __MAPPED_FILE_HPP__ */
@@ -0,0 +1,215 @@
+#include "parallel_for.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mlfe{
+namespace {
+
+thread_local bool in_parallel_region = false;
+
+class worker_pool{
+using Fn = std::function<void(int, int)>;
+public:
+    worker_pool(int num_threads)
+        : _stop(false), _generation(0), _active(0){
+        start(num_threads);
+    }
+
+    ~worker_pool(){
+        join();
+    }
+
+    int size() const{
+        return _workers.size() + 1;
+    }
+
+    void resize(int num_threads){
+        std::lock_guard<std::mutex> run_lock(_run_m);
+        join();
+        start(num_threads);
+    }
+
+    // returns false if the workers are owned by another caller.
+    bool run(int begin, int end, int chunk, const Fn &fn){
+        std::unique_lock<std::mutex> run_lock(_run_m, std::try_to_lock);
+        if(!run_lock.owns_lock()){
+            return false;
+        }
+        {
+            std::unique_lock<std::mutex> lock(_m);
+            // a late worker may still hold the previous job.
+            _done_cv.wait(lock, [this](){ return _active == 0; });
+            _fn = &fn;
+            _end = end;
+            _chunk = chunk;
+            _next = begin;
+            _num_chunks = (end - begin + chunk - 1) / chunk;
+            _done_chunks = 0;
+            ++_generation;
+        }
+        _cv.notify_all();
+        in_parallel_region = true;
+        int done = work(_fn, _end, _chunk);
+        in_parallel_region = false;
+        std::unique_lock<std::mutex> lock(_m);
+        _done_chunks += done;
+        _done_cv.wait(lock, [this](){
+            return _done_chunks == _num_chunks && _active == 0;
+        });
+        _fn = nullptr;
+        return true;
+    }
+
+private:
+    void start(int num_threads){
+        _stop = false;
+        for(int n = 1; n < num_threads; ++n){
+            _workers.push_back(std::thread(&worker_pool::loop, this));
+        }
+    }
+
+    void join(){
+        {
+            std::lock_guard<std::mutex> lock(_m);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for(auto &t : _workers){
+            t.join();
+        }
+        _workers.clear();
+    }
+
+    int work(const Fn *fn, int end, int chunk){
+        int done = 0;
+        while(true){
+            int from = _next.fetch_add(chunk);
+            if(from >= end){
+                break;
+            }
+            (*fn)(from, std::min(from + chunk, end));
+            ++done;
+        }
+        return done;
+    }
+
+    void loop(){
+        unsigned long long seen = 0;
+        in_parallel_region = true;
+        while(true){
+            const Fn *fn;
+            int end, chunk;
+            {
+                std::unique_lock<std::mutex> lock(_m);
+                _cv.wait(lock, [&](){
+                    return _stop || _generation != seen;
+                });
+                if(_stop){
+                    return;
+                }
+                seen = _generation;
+                fn = _fn;
+                end = _end;
+                chunk = _chunk;
+                ++_active;
+            }
+            int done = fn != nullptr ? work(fn, end, chunk) : 0;
+            {
+                std::lock_guard<std::mutex> lock(_m);
+                _done_chunks += done;
+                --_active;
+            }
+            _done_cv.notify_all();
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::mutex _run_m;
+    std::mutex _m;
+    std::condition_variable _cv;
+    std::condition_variable _done_cv;
+    bool _stop;
+    unsigned long long _generation;
+    int _active;
+    const Fn *_fn = nullptr;
+    int _end = 0;
+    int _chunk = 1;
+    std::atomic<int> _next;
+    int _num_chunks = 0;
+    int _done_chunks = 0;
+};
+
+int default_num_threads(){
+    const char *env = std::getenv("MLFE_NUM_THREADS");
+    if(env != nullptr && std::atoi(env) > 0){
+        return std::atoi(env);
+    }
+    return std::max<int>(std::thread::hardware_concurrency(), 1);
+}
+
+worker_pool *get_pool(){
+    static std::unique_ptr<worker_pool> pool(
+        new worker_pool(default_num_threads()));
+    return pool.get();
+}
+
+} // end anonymous namespace
+
+int get_num_threads(){
+    return get_pool()->size();
+}
+
+void set_num_threads(int num_threads){
+    get_pool()->resize(std::max(num_threads, 1));
+}
+
+void parallel_for(const int begin,
+                  const int end,
+                  const int grain,
+                  const std::function<void(int, int)> &fn
+                 ){
+    const int size = end - begin;
+    if(size <= 0){
+        return;
+    }
+    auto pool = get_pool();
+    const int num_threads = pool->size();
+    // a few chunks per thread keeps the threads busy on uneven work.
+    const int chunk = std::max(std::max(grain, 1),
+        (size + num_threads * 4 - 1) / (num_threads * 4));
+    if(num_threads == 1 || size <= chunk || in_parallel_region ||
+       !pool->run(begin, end, chunk, fn)){
+        fn(begin, end);
+    }
+}
+
+void parallel_for_segments(const std::vector<int> &offsets,
+                           const int grain,
+                           const std::function<void(int, int, int)> &fn
+                          ){
+    if(offsets.size() < 2){
+        return;
+    }
+    parallel_for(offsets.front(), offsets.back(), grain,
+        [&](int from, int to){
+            // the last segment starting at or before from.
+            int s = static_cast<int>(std::upper_bound(
+                offsets.begin(), offsets.end(), from) - offsets.begin()) - 1;
+            while(from < to){
+                const int seg_end = std::min(to, offsets[s + 1]);
+                if(seg_end > from){
+                    fn(s, from - offsets[s], seg_end - offsets[s]);
+                }
+                from = seg_end;
+                ++s;
+            }
+        });
+}
+
+} // end namespace mlfe
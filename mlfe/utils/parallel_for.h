@@ -0,0 +1,36 @@
+#ifndef __PARALLEL_FOR_HPP__
+#define __PARALLEL_FOR_HPP__
+#include <functional>
+#include <vector>
+
+namespace mlfe{
+
+// the number of threads used by parallel_for, including the caller.
+// defaults to the hardware concurrency, or MLFE_NUM_THREADS if it is set.
+int get_num_threads();
+
+void set_num_threads(int num_threads);
+
+// splits [begin, end) into chunks of at least grain items and runs
+// fn(chunk_begin, chunk_end) on the cpu worker threads.
+// the caller also takes chunks and returns when all chunks are done.
+// nested calls, and calls made while another thread owns the workers,
+// run serially on the calling thread.
+void parallel_for(const int begin,
+                  const int end,
+                  const int grain,
+                  const std::function<void(int, int)> &fn
+                 );
+
+// parallel_for over the concatenation of segments, where segment s is
+// [offsets[s], offsets[s + 1]). a chunk may cover the end of one segment
+// and the start of the next, fn(segment, from, to) is called once for
+// each part with from and to relative to the segment.
+// many small segments are packed into one chunk this way.
+void parallel_for_segments(const std::vector<int> &offsets,
+                           const int grain,
+                           const std::function<void(int, int, int)> &fn
+                          );
+
+} // end namespace mlfe
+#endif // end ifndef __PARALLEL_FOR_HPP__
@@ -11,16 +11,19 @@
 namespace mlfe{
 class ThreadPool{
 public:
+    // tasks are run in the order they are added, by any of the threads.
     ThreadPool(int size) : is_stop(false){
-        runtime_assert(size == 1, "thread size must be 1.(in current version, supported upto 1)");
+        runtime_assert(size >= 1, "thread size must be at least 1.");
         for(int n = 0; n < size; ++n){
             threads.push_back(std::thread(std::bind(&ThreadPool::InternalExecutor, this)));
-            task_state[n] = true;
         }
     }
     
     ~ThreadPool(){
-        is_stop = true;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            is_stop = true;
+        }
         cv.notify_all();
         for(int n = 0; n < threads.size(); ++n){
             threads[n].join();
@@ -34,18 +37,25 @@ public:
         cv.notify_one();
     }
     
+    // an id without tasks counts as finished.
     void Wait(int id){
         std::unique_lock<std::mutex> lock(m);
-        while(!task_state[id]){
+        while(!IsFinishedLocked(id)){
             state_noti.wait(lock);
         }
     }
     
     bool IsFinished(int id){
-        return task_state[id];
+        std::unique_lock<std::mutex> lock(m);
+        return IsFinishedLocked(id);
     }
     
 private:
+    bool IsFinishedLocked(int id){
+        auto it = task_state.find(id);
+        return it == task_state.end() || it->second;
+    }
+
     void InternalExecutor(){
         while(true){
             std::unique_lock<std::mutex> lock(m);
@@ -61,7 +71,7 @@ private:
             task.first();
             lock.lock();
             task_state[task.second] = true;
-            state_noti.notify_one();
+            state_noti.notify_all();
         }
     }
     std::condition_variable cv;
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <mlfe/device_context/cpu_context.h>
+#include <mlfe/math/basic_functions.h>
+#include <mlfe/utils/db/augmentation.h>
+#include <vector>
+
+namespace augmentation_test{
+using namespace mlfe;
+using uint8 = type::uint8::T;
+
+// pixel (c, r, j) of a test image, never 0.
+uint8 pixel(int c, int r, int j){
+    return uint8(1 + (c * 97 + r * 13 + j) % 250);
+}
+
+int index(const ImageShape &shape, int c, int r, int j){
+    return shape.channels_last ?
+        (r * shape.width + j) * shape.channels + c :
+        (c * shape.height + r) * shape.width + j;
+}
+
+std::vector<uint8> make_image(const ImageShape &shape){
+    std::vector<uint8> image(shape.Size());
+    for(int c = 0; c < shape.channels; ++c){
+        for(int r = 0; r < shape.height; ++r){
+            for(int j = 0; j < shape.width; ++j){
+                image[index(shape, c, r, j)] = pixel(c, r, j);
+            }
+        }
+    }
+    return image;
+}
+
+// applies a stage to the test image in both layouts with the same draws
+// and checks that the results are the same image.
+std::vector<uint8> apply_both_layouts(const Augmentation &stage,
+                                      ImageShape shape,
+                                      ImageShape &out_shape
+                                     ){
+    std::vector<uint8> outs[2];
+    for(int layout = 0; layout < 2; ++layout){
+        shape.channels_last = layout == 1;
+        out_shape = stage.OutputShape(shape);
+        auto image = make_image(shape);
+        outs[layout].resize(out_shape.Size());
+        ImageRandom rng(math::philox(1, 2, 3));
+        stage.Apply(shape, image.data(), outs[layout].data(), rng);
+    }
+    ImageShape nhwc = out_shape;
+    ImageShape nchw = out_shape;
+    nhwc.channels_last = true;
+    nchw.channels_last = false;
+    for(int c = 0; c < out_shape.channels; ++c){
+        for(int r = 0; r < out_shape.height; ++r){
+            for(int j = 0; j < out_shape.width; ++j){
+                EXPECT_EQ(outs[0][index(nchw, c, r, j)],
+                          outs[1][index(nhwc, c, r, j)]);
+            }
+        }
+    }
+    out_shape.channels_last = false;
+    return outs[0];
+}
+
+} // end namespace augmentation_test
+
+TEST(augmentation, random_crop){
+    using namespace augmentation_test;
+    const ImageShape shape = {3, 5, 6, false};
+    for(int seed = 0; seed < 20; ++seed){
+        RandomCrop crop(4, 7, 2);
+        const ImageShape out_shape = crop.OutputShape(shape);
+        auto image = make_image(shape);
+        std::vector<uint8> y(out_shape.Size());
+        ImageRandom rng(math::philox(seed, 0, 0));
+        crop.Apply(shape, image.data(), y.data(), rng);
+        ASSERT_EQ(out_shape.height, 4);
+        ASSERT_EQ(out_shape.width, 7);
+        // the result is a window of the zero padded image.
+        int matches = 0;
+        for(int oy = -2; oy <= 5 + 2 - 4; ++oy){
+            for(int ox = -2; ox <= 6 + 2 - 7; ++ox){
+                bool same = true;
+                for(int c = 0; c < 3; ++c){
+                    for(int r = 0; r < 4; ++r){
+                        for(int j = 0; j < 7; ++j){
+                            const int sr = oy + r, sj = ox + j;
+                            const bool inside = sr >= 0 && sr < 5 && sj >= 0 && sj < 6;
+                            same &= y[index(out_shape, c, r, j)] ==
+                                (inside ? pixel(c, sr, sj) : 0);
+                        }
+                    }
+                }
+                matches += same;
+            }
+        }
+        EXPECT_EQ(matches, 1);
+    }
+    ImageShape out_shape;
+    apply_both_layouts(RandomCrop(3, 3, 1), shape, out_shape);
+    EXPECT_THROW(RandomCrop(10, 3).OutputShape(shape), std::string);
+}
+
+TEST(augmentation, random_flip){
+    using namespace augmentation_test;
+    const ImageShape shape = {3, 4, 5, false};
+    ImageShape out_shape;
+    auto flipped = apply_both_layouts(RandomFlip(1.f), shape, out_shape);
+    auto same = apply_both_layouts(RandomFlip(0.f), shape, out_shape);
+    for(int c = 0; c < 3; ++c){
+        for(int r = 0; r < 4; ++r){
+            for(int j = 0; j < 5; ++j){
+                EXPECT_EQ(flipped[index(shape, c, r, j)], pixel(c, r, 4 - j));
+                EXPECT_EQ(same[index(shape, c, r, j)], pixel(c, r, j));
+            }
+        }
+    }
+}
+
+TEST(augmentation, cutout){
+    using namespace augmentation_test;
+    const ImageShape shape = {3, 9, 8, false};
+    for(int seed = 0; seed < 20; ++seed){
+        Cutout cutout(4, {0, 0, 0});
+        auto image = make_image(shape);
+        std::vector<uint8> y(shape.Size());
+        ImageRandom rng(math::philox(seed, 0, 0));
+        cutout.Apply(shape, image.data(), y.data(), rng);
+        // the cut pixels form a rectangle of at most 4 x 4, the same in
+        // every channel, and the rest is unchanged.
+        int r0 = 9, r1 = -1, j0 = 8, j1 = -1, cut = 0;
+        for(int r = 0; r < 9; ++r){
+            for(int j = 0; j < 8; ++j){
+                const bool is_cut = y[index(shape, 0, r, j)] == 0;
+                for(int c = 0; c < 3; ++c){
+                    EXPECT_EQ(y[index(shape, c, r, j)],
+                              is_cut ? 0 : pixel(c, r, j));
+                }
+                if(is_cut){
+                    r0 = std::min(r0, r);
+                    r1 = std::max(r1, r);
+                    j0 = std::min(j0, j);
+                    j1 = std::max(j1, j);
+                    ++cut;
+                }
+            }
+        }
+        ASSERT_GT(cut, 0);
+        EXPECT_LE(r1 - r0 + 1, 4);
+        EXPECT_LE(j1 - j0 + 1, 4);
+        EXPECT_EQ(cut, (r1 - r0 + 1) * (j1 - j0 + 1));
+    }
+    ImageShape out_shape;
+    apply_both_layouts(Cutout(3, {7, 8, 9}), shape, out_shape);
+}
+
+TEST(augmentation, normalize_uint8){
+    using namespace augmentation_test;
+    const std::vector<float> alpha = {0.5f, -2.f, 3.f};
+    const std::vector<float> beta = {1.f, 0.25f, -4.f};
+    // nchw with long and short planes, and nhwc.
+    for(int inner : {1, 4, 35}){
+        const int size = 3 * inner * 11 + 2;
+        std::vector<uint8> x(size);
+        std::vector<float> y(size);
+        for(int n = 0; n < size; ++n){
+            x[n] = uint8(n * 7 % 256);
+        }
+        math::normalize_uint8<float, CPUContext>(size, 3, inner,
+            alpha.data(), beta.data(), x.data(), y.data());
+        for(int n = 0; n < size; ++n){
+            const int c = (n / inner) % 3;
+            EXPECT_FLOAT_EQ(y[n], alpha[c] * float(x[n]) + beta[c]);
+        }
+    }
+}
@@ -476,3 +476,28 @@ TEST(autodiff_test, case3_grad_check){
     EXPECT_EQ(tcase.x1.grad().data<T>()[2], 0);
     EXPECT_EQ(tcase.x1.grad().data<T>()[3], -12);
 }
+
+// the readme example, 3 * (x + 2)^2 with scalar constants, which are
+// broadcast and do not take a buffer of the shape of x.
+TEST(autodiff_test, scalar_constant_grad_check){
+    using namespace mlfe;
+    namespace fn = functional;
+    using T = float;
+    auto one = fn::create_variable({2, 2});
+    std::fill(one.begin<T>(), one.end<T>(), 1);
+    auto three = one + 2.0;
+    auto y = three * three * fn::constant(3, {1});
+    auto result = fn::mean(y);
+    result.eval();
+    result.backprop();
+    EXPECT_EQ(result.data<T>()[0], 27);
+    for(int n = 0; n < one.size(); ++n){
+        EXPECT_EQ(one.grad().data<T>()[n], 4.5);
+    }
+    // the rest of the scalar ops.
+    auto x = (one * 6.0 - 2.0) / 4.0;
+    x.eval();
+    for(int n = 0; n < x.size(); ++n){
+        EXPECT_EQ(x.data<T>()[n], 1);
+    }
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace mlfe;
+namespace fn = functional;
+
+namespace{
+
+const std::string conv_algo = "Name:Convolution/Device:CPU";
+
+const std::string conv_im2col = conv_algo + "/Variant:Im2Col";
+
+void fill_random(Tensor x, int seed){
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    for(auto it = x.begin<float>(); it != x.end<float>(); ++it){
+        *it = dist(rng);
+    }
+}
+
+// an op of this test with an algo which rejects every node.
+class ones_algo : public OpAlgo{
+public:
+    ones_algo(OpAlgoContext *oac) : OpAlgo(oac){
+        y = oac->get_output(0);
+    }
+
+    void Compute() override{
+        std::fill(y.begin<float>(), y.end<float>(), 1.f);
+    }
+
+private:
+    Tensor y;
+};
+
+REGIST_OP_ALGO(AutotunerTest)
+    .Input("X", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        return std::make_shared<ones_algo>(oac);
+    })
+    .Finish();
+
+REGIST_OP_ALGO(AutotunerTest)
+    .Input("X", type::float32::string)
+    .Output("Y", type::float32::string)
+    .Device("CPU")
+    .Variant("Rejecting")
+    .CreatorFn([](OpAlgoContext *oac) -> std::shared_ptr<OpAlgo>{
+        throw std::runtime_error("the node is not supported.");
+    })
+    .Finish();
+
+autotuner::registerer test_tuning("AutotunerTest", [](OpAlgoContext *){
+    return std::string();
+});
+
+} // end anonymous namespace
+
+TEST(autotuner, variants){
+    auto variants = OpAlgoRegistry::Get()->GetVariants(conv_algo);
+    EXPECT_EQ(variants, std::vector<std::string>({conv_algo, conv_im2col}));
+    EXPECT_TRUE(autotuner::is_tuned("Convolution"));
+    EXPECT_FALSE(autotuner::is_tuned("ReLU"));
+}
+
+TEST(autotuner, cache_file_is_opt_in){
+    if(std::getenv("MLFE_AUTOTUNE_CACHE") == nullptr){
+        EXPECT_TRUE(autotuner::cache_file().empty());
+    }
+}
+
+TEST(autotuner, caches_the_winner){
+    const std::string file_name = "autotuner_test.cache";
+    const std::string prev_file = autotuner::cache_file();
+    std::remove(file_name.c_str());
+    autotuner::set_cache_file(file_name);
+
+    auto x = fn::create_variable({2, 3, 16, 16});
+    auto w = fn::create_variable({8, 3, 3, 3});
+    const int tuned = autotuner::num_tuned();
+    fn::conv2d(x, w, {1, 1}, {1, 1});
+    EXPECT_EQ(autotuner::num_tuned(), tuned + 1);
+    auto entries = autotuner::entries();
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_NE(entries[0].key.find("Convolution 2x3x16x16 8x3x3x3"),
+              std::string::npos);
+    EXPECT_NE(entries[0].key.find("strides=1,1 pads=1,1"), std::string::npos);
+    EXPECT_NE(entries[0].key.find(autotuner::isa()), std::string::npos);
+    EXPECT_EQ(entries[0].algo.find(conv_algo), 0);
+    EXPECT_GE(entries[0].time, 0);
+
+    // the same key again, and then as a new process would, from the file.
+    fn::conv2d(x, w, {1, 1}, {1, 1});
+    autotuner::clear();
+    EXPECT_TRUE(autotuner::entries().empty());
+    fn::conv2d(x, w, {1, 1}, {1, 1});
+    EXPECT_EQ(autotuner::num_tuned(), tuned + 1);
+    ASSERT_EQ(autotuner::entries().size(), 1);
+    EXPECT_EQ(autotuner::entries()[0].algo, entries[0].algo);
+
+    // a winner another process wrote since, is kept.
+    const std::string other = "Convolution 1x1x1x1 1x1x1x1 other";
+    std::ofstream append(file_name, std::ios::app);
+    append << other << "\t" << conv_algo << "\t1" << std::endl;
+    append.close();
+
+    // other pads are another key.
+    fn::conv2d(x, w, {1, 1}, {0, 0});
+    EXPECT_EQ(autotuner::num_tuned(), tuned + 2);
+    EXPECT_EQ(autotuner::entries().size(), 3);
+
+    std::ifstream file(file_name);
+    std::string text((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    file.close();
+    EXPECT_NE(text.find(entries[0].key + "\t" + entries[0].algo),
+              std::string::npos);
+    EXPECT_NE(text.find(other + "\t" + conv_algo), std::string::npos);
+
+    // with tuning disabled, nothing is timed.
+    autotuner::set_enabled(false);
+    fn::conv2d(x, w, {2, 2}, {0, 0});
+    autotuner::set_enabled(true);
+    EXPECT_EQ(autotuner::num_tuned(), tuned + 2);
+
+    std::remove(file_name.c_str());
+    std::remove((file_name + ".lock").c_str());
+    autotuner::set_cache_file(prev_file);
+}
+
+TEST(autotuner, skips_throwing_candidates){
+    auto x = fn::create_variable({4});
+    auto y = fn::create_variable({4});
+    OpAlgoContext ctx("AutotunerTest");
+    y.add_child(x);
+    Tensor::AssignOpFunctor(y, ctx);
+    y.eval();
+    EXPECT_EQ(y.data<float>()[3], 1.f);
+}
+
+TEST(autotuner, im2col_matches_contraction){
+    using T = float;
+    constexpr T eps = 1e-4;
+    autotuner::set_enabled(false);
+    for(int s = 1; s <= 2; ++s){
+        auto x = fn::create_variable({2, 3, 9, 9});
+        auto w = fn::create_variable({4, 3, 3, 3});
+        fill_random(x, 1);
+        fill_random(w, 2);
+        auto y = fn::conv2d(x, w, {s, s}, {1, 1});
+        y.eval();
+        std::vector<T> expected(y.begin<T>(), y.end<T>());
+        std::fill(y.begin<T>(), y.end<T>(), 0.f);
+
+        auto ctx = y.get_context();
+        OpAlgoRegistry::Get()->GetOpAlgo(conv_im2col, &ctx)->Compute();
+        for(int n = 0; n < y.size(); ++n){
+            EXPECT_NEAR(y.data<T>()[n], expected[n], eps);
+        }
+    }
+
+    // im2col has one stride for both axes.
+    auto x = fn::create_variable({1, 1, 6, 6});
+    auto w = fn::create_variable({1, 1, 3, 3});
+    auto y = fn::conv2d(x, w, {1, 2}, {0, 0});
+    auto ctx = y.get_context();
+    EXPECT_THROW(OpAlgoRegistry::Get()->GetOpAlgo(conv_im2col, &ctx),
+                 std::string);
+    autotuner::set_enabled(true);
+}
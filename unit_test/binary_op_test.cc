@@ -3,6 +3,7 @@
 #include <mlfe/operators.h>
 #include <mlfe/utils/gradient_checker.h>
 #include <cmath>
+#include <limits>
 #include <random>
 
 using namespace mlfe;
@@ -254,6 +255,123 @@ TEST(binary_op, div_grad){
     }
 }
 
+namespace broadcast_test{
+
+// the element of a broadcast operand at the index of y.
+float at(Tensor x, const std::vector<int> &y_shape, int index){
+    const auto shape = x.shape();
+    int offset = 0, stride = 1;
+    for(int d = int(y_shape.size()) - 1; d >= 0; --d){
+        const int i = index % y_shape[d];
+        index /= y_shape[d];
+        const int xd = d - int(y_shape.size() - shape.size());
+        if(xd >= 0 && shape[xd] != 1){
+            offset += i * stride;
+        }
+        if(xd >= 0){
+            stride *= shape[xd];
+        }
+    }
+    return x.data<float>()[offset];
+}
+
+void fill(Tensor x, float lo, float hi, std::mt19937 &rng){
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::generate(x.begin<float>(), x.end<float>(), [&](){ return dist(rng); });
+}
+
+using Shapes = std::vector<std::pair<std::vector<int>, std::vector<int>>>;
+
+// same shape, scalar, row, column, channel, both sides and rank 5.
+const Shapes shapes = {
+    {{3, 4}, {3, 4}}, {{3, 4}, {1}}, {{1}, {2, 3}}, {{5, 7}, {7}},
+    {{5, 7}, {5, 1}}, {{2, 3, 4, 5}, {3, 1, 1}}, {{2, 1, 4}, {3, 1}},
+    {{1, 3, 1, 2}, {2, 1, 4, 1}}, {{2, 2, 1, 3, 2}, {2, 1, 3, 1}}};
+
+} // end namespace broadcast_test
+
+TEST(binary_op, broadcast){
+    using namespace broadcast_test;
+    std::mt19937 rng(1);
+    for(auto &pair : shapes){
+        auto x1 = fn::create_variable(pair.first);
+        auto x2 = fn::create_variable(pair.second);
+        fill(x1, -2, 2, rng);
+        fill(x2, 0.5f, 2, rng);
+        std::vector<Tensor> ys = {fn::add(x1, x2), fn::sub(x1, x2),
+                                  fn::mul(x1, x2), fn::div(x1, x2)};
+        const auto y_shape = ys[0].shape();
+        for(int op = 0; op < 4; ++op){
+            ys[op].eval();
+            ASSERT_EQ(ys[op].shape(), y_shape);
+            for(int n = 0; n < ys[op].size(); ++n){
+                const float a = at(x1, y_shape, n), b = at(x2, y_shape, n);
+                const float expected[4] = {a + b, a - b, a * b, a / b};
+                EXPECT_FLOAT_EQ(ys[op].data<float>()[n], expected[op]);
+            }
+        }
+        auto reduced = fn::reduce_sum_to(ys[0], x2.shape());
+        reduced.eval();
+        std::vector<float> sums(x2.size(), 0.f);
+        for(int n = 0; n < ys[0].size(); ++n){
+            // the index of x2 is found through a tensor of indices.
+            auto index = fn::create_variable(x2.shape());
+            for(int k = 0; k < x2.size(); ++k){
+                index.mutable_data<float>()[k] = k;
+            }
+            sums[int(at(index, y_shape, n))] += ys[0].data<float>()[n];
+        }
+        for(int k = 0; k < x2.size(); ++k){
+            EXPECT_NEAR(reduced.data<float>()[k], sums[k], 1e-4);
+        }
+    }
+    EXPECT_THROW(fn::add(fn::create_variable({2, 3}), fn::create_variable({2})),
+                 std::string);
+    // a vector added to a 4d tensor is a bias per channel.
+    auto x = fn::create_variable({2, 3, 2, 2});
+    auto bias = fn::create_variable({3});
+    fill(x, -1, 1, rng);
+    fill(bias, -1, 1, rng);
+    auto y = fn::add(x, bias);
+    y.eval();
+    for(int n = 0; n < x.size(); ++n){
+        EXPECT_FLOAT_EQ(y.data<float>()[n],
+            x.data<float>()[n] + bias.data<float>()[n / 4 % 3]);
+    }
+}
+
+TEST(binary_op, broadcast_grad){
+    using namespace broadcast_test;
+    constexpr float grad_eps = 1e-3;
+    constexpr float pass_eps = 2e-3;
+    std::mt19937 rng(2);
+    for(auto &pair : shapes){
+        for(int op = 0; op < 4; ++op){
+            auto x1 = fn::create_variable(pair.first);
+            auto x2 = fn::create_variable(pair.second);
+            fill(x1, -1, 1, rng);
+            fill(x2, 0.5f, 1.5f, rng);
+            Tensor y = op == 0 ? fn::add(x1, x2) : op == 1 ? fn::sub(x1, x2) :
+                       op == 2 ? fn::mul(x1, x2) : fn::div(x1, x2);
+            // an upstream gradient that is not 1.
+            auto w = fn::create_variable(y.shape());
+            fill(w, -1, 1, rng);
+            auto result = fn::mul(y, w);
+            result.eval();
+            result.backprop();
+            for(auto x : {x1, x2}){
+                std::vector<float> analytical(x.grad().cbegin<float>(),
+                                              x.grad().cend<float>());
+                ASSERT_EQ(analytical.size(), x.size());
+                auto numerical = numerical_gradient(grad_eps, result, x);
+                for(int n = 0; n < x.size(); ++n){
+                    EXPECT_NEAR(analytical[n], numerical.data<float>()[n], pass_eps);
+                }
+            }
+        }
+    }
+}
+
 TEST(binary_op, matmul){
 
     // [2, 2] = [2, 3] x [3, 2]
@@ -622,6 +740,102 @@ TEST(binary_op, squared_difference_grad){
 }
 
 
+// the fused gradients write dx2 as a second output of the dx1 node, check
+// it follows x1 across backprops, on a size split over threads.
+TEST(binary_op, fused_grad_second_output){
+    using T = float;
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(0.5, 2);
+    for(int op = 0; op < 3; ++op){
+        auto x1 = fn::create_variable({4, 1 << 13});
+        auto x2 = fn::create_variable({4, 1 << 13});
+        auto y = op == 0 ? fn::squared_difference(x1, x2) :
+                 op == 1 ? fn::mul(x1, x2) : fn::div(x1, x2);
+        std::generate(x2.begin<T>(), x2.end<T>(), [&](){ return dist(rng); });
+        for(int step = 0; step < 2; ++step){
+            std::generate(x1.begin<T>(), x1.end<T>(), [&](){
+                return dist(rng);
+            });
+            y.eval();
+            y.backprop();
+            for(int n = 0; n < x2.size(); ++n){
+                const T a = x1.data<T>()[n];
+                const T b = x2.data<T>()[n];
+                const T expect = op == 0 ? -2 * (a - b) :
+                                 op == 1 ? a : -a / (b * b);
+                EXPECT_NEAR(x2.grad().data<T>()[n], expect, 1e-5);
+            }
+        }
+    }
+}
+
+TEST(binary_op, softmax_cross_entropy){
+    using T = float;
+    constexpr T pass_eps = 1e-3;
+    // many classes, so the online softmax spans several blocks.
+    constexpr int m = 3;
+    constexpr int n = 10000;
+    auto x = fn::create_variable({m, n});
+    auto t = fn::create_variable({m, n});
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(-10, 10);
+
+    std::generate(x.begin<T>(), x.end<T>(), [&rng, &dist](){
+        return dist(rng);
+    });
+    std::fill(t.begin<T>(), t.end<T>(), T(0));
+    for(int i = 0; i < m; ++i){
+        t.mutable_data<T>()[i * n + (i * 4099) % n] = 1;
+    }
+    auto loss = fn::softmax_cross_entropy(x, t);
+    EXPECT_EQ(loss.size(), m);
+    loss.eval();
+
+    for(int i = 0; i < m; ++i){
+        const T *x_row = x.data<T>() + i * n;
+        const T *t_row = t.data<T>() + i * n;
+        double max_val = *std::max_element(x_row, x_row + n);
+        double sum = 0;
+        for(int j = 0; j < n; ++j){
+            sum += std::exp(x_row[j] - max_val);
+        }
+        double expected = 0;
+        for(int j = 0; j < n; ++j){
+            expected -= t_row[j] * (x_row[j] - max_val - std::log(sum));
+        }
+        EXPECT_NEAR(loss.data<T>()[i], expected, pass_eps);
+    }
+}
+
+TEST(binary_op, softmax_cross_entropy_grad){
+    using T = float;
+    constexpr T grad_eps = 1e-3;
+    constexpr T pass_eps = 1e-2;
+    auto x = fn::create_variable({2, 5});
+    auto t = fn::create_variable({2, 5});
+    auto analytical_x = std::vector<T>(x.size());
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(-1, 1);
+
+    std::generate(x.begin<T>(), x.end<T>(), [&rng, &dist](){
+        return dist(rng);
+    });
+    std::fill(t.begin<T>(), t.end<T>(), T(0));
+    t.mutable_data<T>()[1] = 1;
+    t.mutable_data<T>()[5 + 3] = 1;
+    auto loss = fn::softmax_cross_entropy(x, t);
+    loss.eval();
+    loss.backprop();
+    std::copy(x.grad().begin<T>(), x.grad().end<T>(), analytical_x.begin());
+    auto numerical = numerical_gradient(grad_eps, loss, x);
+
+    for(int n = 0; n < x.size(); ++n){
+        auto diff = std::abs(analytical_x.data()[n] - numerical.data<T>()[n]);
+        EXPECT_LE(diff, pass_eps);
+        EXPECT_GE(diff, -pass_eps);
+    }
+}
+
 // TODO : add more kernel, stride and padding size test.
 // kernel size = 3 x 3
 // stride size = 1 x 1
@@ -902,3 +1116,188 @@ TEST(binary_op, pool2d_max_k2_s2_p0_grad){
     EXPECT_EQ(x.grad().data<T>()[16 + 14], 0);
     EXPECT_EQ(x.grad().data<T>()[16 + 15], 0);
 }
+
+// kernel size = 3 x 3
+// stride size = 2 x 2
+// padding size = 1 x 1
+TEST(binary_op, pool2d_max_k3_s2_p1){
+    using T = float;
+    constexpr int n = 2;
+    constexpr int ci = 3;
+    constexpr int hi = 5;
+    constexpr int wi = 7;
+    auto x = fn::create_variable({n, ci, hi, wi});
+    auto y = fn::pool_max(x, {3, 3}, {2, 2}, {1, 1});
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(-1, 1);
+
+    std::generate(x.begin<T>(), x.end<T>(), [&rng, &dist](){
+        return dist(rng);
+    });
+    EXPECT_EQ(y.shape()[2], 3);
+    EXPECT_EQ(y.shape()[3], 4);
+    y.eval();
+
+    for(int p = 0; p < n * ci; ++p){
+        for(int oh = 0; oh < 3; ++oh){
+            for(int ow = 0; ow < 4; ++ow){
+                T expected = -1e10;
+                for(int h = oh * 2 - 1; h < oh * 2 + 2; ++h){
+                    for(int w = ow * 2 - 1; w < ow * 2 + 2; ++w){
+                        if(h >= 0 && h < hi && w >= 0 && w < wi){
+                            expected = std::max(expected,
+                                x.data<T>()[p * hi * wi + h * wi + w]);
+                        }
+                    }
+                }
+                EXPECT_EQ(y.data<T>()[p * 12 + oh * 4 + ow], expected);
+            }
+        }
+    }
+}
+
+TEST(binary_op, pool2d_max_k3_s2_p1_grad){
+    using T = float;
+    constexpr T grad_eps = 1e-3;
+    constexpr T pass_eps = 1e-2;
+    auto x = fn::create_variable({2, 2, 5, 5});
+    auto y = fn::pool_max(x, {3, 3}, {2, 2}, {1, 1});
+    auto analytical_x = std::vector<T>(x.size());
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(-1, 1);
+
+    std::generate(x.begin<T>(), x.end<T>(), [&rng, &dist](){
+        return dist(rng);
+    });
+    y.eval();
+    y.backprop();
+    std::copy(x.grad().begin<T>(), x.grad().end<T>(), analytical_x.begin());
+    auto numerical = numerical_gradient(grad_eps, y, x);
+
+    for(int n = 0; n < x.size(); ++n){
+        auto diff = std::abs(analytical_x.data()[n] - numerical.data<T>()[n]);
+        EXPECT_LE(diff, pass_eps);
+        EXPECT_GE(diff, -pass_eps);
+    }
+}
+
+// a border window of only -inf keeps its maximum inside the input.
+TEST(binary_op, pool2d_max_k3_s2_p1_neg_inf){
+    using T = float;
+    constexpr T inf = std::numeric_limits<T>::infinity();
+    auto x = fn::create_variable({1, 1, 4, 4});
+    auto y = fn::pool_max(x, {3, 3}, {2, 2}, {1, 1});
+    std::fill(x.begin<T>(), x.end<T>(), -inf);
+    y.eval();
+    y.backprop();
+    for(int n = 0; n < y.size(); ++n){
+        EXPECT_EQ(y.data<T>()[n], -inf);
+    }
+    // every dy lands in dx.
+    T dx_sum = 0;
+    for(int n = 0; n < x.size(); ++n){
+        dx_sum += x.grad().data<T>()[n];
+    }
+    EXPECT_EQ(dx_sum, T(y.size()));
+}
+
+TEST(binary_op, pool2d_padding_smaller_than_kernel){
+    using T = float;
+    auto x = fn::create_variable({1, 1, 3, 3});
+    EXPECT_THROW(fn::pool_max(x, {2, 2}, {1, 1}, {2, 2}), std::string);
+    EXPECT_THROW(fn::pool_max(x, {2, 2}, {1, 1}, {0, 2}), std::string);
+    EXPECT_THROW(fn::pool_avg(x, {2, 2}, {1, 1}, {2, 0}), std::string);
+
+    // the corner windows of the largest padding see one element.
+    auto y = fn::pool_max(x, {2, 2}, {1, 1}, {1, 1});
+    for(int n = 0; n < x.size(); ++n){
+        x.mutable_data<T>()[n] = n + 1;
+    }
+    y.eval();
+    y.backprop();
+    ASSERT_EQ(y.shape(), std::vector<int>({1, 1, 4, 4}));
+    EXPECT_EQ(y.data<T>()[0], 1);
+    EXPECT_EQ(y.data<T>()[3], 3);
+    EXPECT_EQ(y.data<T>()[12], 7);
+    EXPECT_EQ(y.data<T>()[15], 9);
+    T dx_sum = 0;
+    for(int n = 0; n < x.size(); ++n){
+        dx_sum += x.grad().data<T>()[n];
+    }
+    EXPECT_EQ(dx_sum, T(y.size()));
+}
+
+// kernel size = 2 x 2
+// stride size = 2 x 2
+// padding size = 0 x 0
+TEST(binary_op, pool2d_avg_k2_s2_p0){
+    using T = float;
+    constexpr T eps = 1e-5;
+    auto x = fn::create_variable({1, 1, 4, 4});
+    auto y = fn::pool_avg(x, {2, 2}, {2, 2}, {0, 0});
+
+    // x =
+    //    [  1  2  3  4
+    //       5  6  7  8
+    //       9 10 11 12
+    //      13 14 15 16 ]
+    for(int n = 0; n < x.size(); ++n){
+        x.mutable_data<T>()[n] = n + 1;
+    }
+    y.eval();
+
+    EXPECT_NEAR(y.data<T>()[0], (1 + 2 + 5 + 6) / 4.f, eps);
+    EXPECT_NEAR(y.data<T>()[1], (3 + 4 + 7 + 8) / 4.f, eps);
+    EXPECT_NEAR(y.data<T>()[2], (9 + 10 + 13 + 14) / 4.f, eps);
+    EXPECT_NEAR(y.data<T>()[3], (11 + 12 + 15 + 16) / 4.f, eps);
+}
+
+TEST(binary_op, pool2d_avg_k3_s2_p1_grad){
+    using T = float;
+    constexpr T grad_eps = 1e-3;
+    constexpr T pass_eps = 1e-2;
+    auto x = fn::create_variable({2, 2, 5, 6});
+    auto y = fn::pool_avg(x, {3, 3}, {2, 2}, {1, 1});
+    auto analytical_x = std::vector<T>(x.size());
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(-1, 1);
+
+    std::generate(x.begin<T>(), x.end<T>(), [&rng, &dist](){
+        return dist(rng);
+    });
+    y.eval();
+    y.backprop();
+    std::copy(x.grad().begin<T>(), x.grad().end<T>(), analytical_x.begin());
+    auto numerical = numerical_gradient(grad_eps, y, x);
+
+    for(int n = 0; n < x.size(); ++n){
+        auto diff = std::abs(analytical_x.data()[n] - numerical.data<T>()[n]);
+        EXPECT_LE(diff, pass_eps);
+        EXPECT_GE(diff, -pass_eps);
+    }
+}
+
+TEST(binary_op, global_pool_avg_grad){
+    using T = float;
+    constexpr T eps = 1e-5;
+    auto x = fn::create_variable({2, 3, 4, 5});
+    auto y = fn::global_pool_avg(x);
+    std::mt19937 rng;
+    std::uniform_real_distribution<T> dist(-1, 1);
+
+    std::generate(x.begin<T>(), x.end<T>(), [&rng, &dist](){
+        return dist(rng);
+    });
+    EXPECT_EQ(y.size(), 6);
+    y.eval();
+    y.backprop();
+
+    for(int p = 0; p < 6; ++p){
+        const T *plane = x.data<T>() + p * 20;
+        T expected = std::accumulate(plane, plane + 20, T(0)) / 20;
+        EXPECT_NEAR(y.data<T>()[p], expected, eps);
+    }
+    for(int n = 0; n < x.size(); ++n){
+        EXPECT_NEAR(x.grad().data<T>()[n], 1.f / 20, eps);
+    }
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <mlfe/math/fast_math.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// the error bounds document the approximations, libm is not checked.
+#if !defined(OPTION_STRICT_MATH)
+
+namespace fast_math_test{
+using namespace mlfe::math;
+
+// distance between a float result and a double reference, in units of
+// the last place of the reference rounded to float.
+double ulp_error(float result, double reference){
+    const float ref_f = static_cast<float>(reference);
+    const int exponent = std::max(std::ilogb(ref_f), -126);
+    const double ulp = std::ldexp(1., exponent - 23);
+    return std::abs(static_cast<double>(result) - reference) / ulp;
+}
+
+// walks the float bit patterns between lo and hi with a fixed step,
+// which samples every binade of the range evenly.
+template <class Fn, class RefFn>
+double max_ulp_error(float lo, float hi, Fn fn, RefFn ref_fn){
+    constexpr unsigned int samples = 1 << 18;
+    double max_error = 0;
+    for(int sign = 0; sign < 2; ++sign){
+        const float from = sign == 0 ? std::max(lo, 0.f) : std::max(-hi, 0.f);
+        const float to = sign == 0 ? std::max(hi, 0.f) : std::max(-lo, 0.f);
+        unsigned int b_from, b_to;
+        std::memcpy(&b_from, &from, sizeof(float));
+        std::memcpy(&b_to, &to, sizeof(float));
+        const unsigned int step = std::max((b_to - b_from) / samples, 1u);
+        for(unsigned int b = b_from; b <= b_to && b >= b_from; b += step){
+            float x;
+            std::memcpy(&x, &b, sizeof(float));
+            x = sign == 0 ? x : -x;
+            max_error = std::max(max_error, ulp_error(fn(x), ref_fn(x)));
+        }
+    }
+    return max_error;
+}
+
+} // end namespace fast_math_test
+
+TEST(fast_math, exp){
+    using namespace fast_math_test;
+    auto err = max_ulp_error(-87.3f, 88.7f,
+        [](float x){ return fast::exp(x); },
+        [](double x){ return std::exp(x); });
+    EXPECT_LE(err, 1.);
+    EXPECT_EQ(fast::exp(100.f), INFINITY);
+    EXPECT_EQ(fast::exp(-200.f), 0.f);
+}
+
+TEST(fast_math, log){
+    using namespace fast_math_test;
+    auto err = max_ulp_error(1e-45f, 3e38f,
+        [](float x){ return fast::log(x); },
+        [](double x){ return std::log(x); });
+    EXPECT_LE(err, 1.);
+    EXPECT_EQ(fast::log(0.f), -INFINITY);
+    EXPECT_EQ(fast::log(INFINITY), INFINITY);
+    EXPECT_TRUE(std::isnan(fast::log(-1.f)));
+}
+
+TEST(fast_math, log1p){
+    using namespace fast_math_test;
+    auto err = max_ulp_error(-0.999f, 3e38f,
+        [](float x){ return fast::log1p(x); },
+        [](double x){ return std::log1p(x); });
+    EXPECT_LE(err, 2.5);
+    EXPECT_EQ(fast::log1p(1e-30f), 1e-30f);
+}
+
+TEST(fast_math, tanh){
+    using namespace fast_math_test;
+    auto err = max_ulp_error(-1e30f, 1e30f,
+        [](float x){ return fast::tanh(x); },
+        [](double x){ return std::tanh(x); });
+    EXPECT_LE(err, 1.5);
+    EXPECT_EQ(fast::tanh(INFINITY), 1.f);
+    EXPECT_EQ(fast::tanh(-INFINITY), -1.f);
+}
+
+TEST(fast_math, sigmoid){
+    using namespace fast_math_test;
+    auto err = max_ulp_error(-87.3f, 1e30f,
+        [](float x){ return fast::sigmoid(x); },
+        [](double x){ return 1. / (1. + std::exp(-x)); });
+    EXPECT_LE(err, 2.5);
+}
+
+#endif // end #if !defined(OPTION_STRICT_MATH)
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <string>
+
+using namespace mlfe;
+namespace fn = functional;
+
+namespace memory_tracker_test{
+
+memory_tracker::tag_usage find(std::string tag){
+    for(auto &u : memory_tracker::usage()){
+        if(u.tag == tag){
+            return u;
+        }
+    }
+    return {tag, 0, 0, 0};
+}
+
+} // end namespace memory_tracker_test
+
+TEST(memory_tracker, accounts_allocations){
+    const auto before = memory_tracker::current_bytes();
+    {
+        memory_tracker::scoped_tag tag("memory_tracker_test");
+        auto mem = create_memory(1000);
+        EXPECT_EQ(memory_tracker::current_bytes(), before + 1000);
+        EXPECT_EQ(memory_tracker_test::find("memory_tracker_test").current,
+                  1000);
+        // a view is not accounted.
+        auto view = create_memory_view(mem, 100, 200);
+        EXPECT_EQ(memory_tracker::current_bytes(), before + 1000);
+    }
+    EXPECT_EQ(memory_tracker::current_bytes(), before);
+    EXPECT_EQ(memory_tracker_test::find("memory_tracker_test").current, 0);
+    EXPECT_EQ(memory_tracker_test::find("memory_tracker_test").peak, 1000);
+}
+
+// the budget of a small model, fixed by its shapes. other tests leave
+// their graphs alive, so only the increase of each tag is counted.
+TEST(memory_tracker, backprop_budget){
+    using memory_tracker_test::find;
+    const int size = 1 << 12;
+    const std::size_t bytes = size * sizeof(float);
+    const auto sq_diff = find("SquaredDifference").current;
+    const auto sq_diff_grad = find("SquaredDifferenceGradient").current;
+    const auto mean_grad = find("ReduceMeanGradient").current;
+    auto x1 = fn::create_variable({size});
+    auto x2 = fn::create_variable({size});
+    auto y = fn::mean(fn::squared_difference(x1, x2));
+    EXPECT_EQ(find("SquaredDifference").current - sq_diff, bytes);
+
+    memory_tracker::reset_peak();
+    const auto before = memory_tracker::current_bytes();
+    y.eval();
+    y.backprop();
+    // dx1 and dx2 of the fused gradient, and the gradient of the mean.
+    EXPECT_EQ(find("SquaredDifferenceGradient").current - sq_diff_grad,
+              2 * bytes);
+    EXPECT_EQ(find("ReduceMeanGradient").current - mean_grad, bytes);
+    EXPECT_LE(memory_tracker::peak_bytes() - before, 4 * bytes);
+    EXPECT_NE(memory_tracker::report().find("SquaredDifferenceGradient"),
+              std::string::npos);
+}
@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <mlfe/optimizers.h>
+#include <mlfe/utils/parallel_for.h>
+#include <algorithm>
+#include <cmath>
+
+namespace optimizer_test{
+using namespace mlfe;
+namespace fn = functional;
+
+// mean squared distance of many vars of uneven size to fixed targets.
+struct squared_loss{
+    squared_loss(){
+        const std::vector<int> sizes = {1, 3, 10, 17, 1000, 40000, 5};
+        for(int n = 0; n < sizes.size(); ++n){
+            auto var = fn::create_variable({sizes[n]});
+            auto target = fn::create_variable({sizes[n]});
+            for(int k = 0; k < sizes[n]; ++k){
+                var.mutable_data<float>()[k] = std::sin(float(k + n));
+                target.mutable_data<float>()[k] = std::cos(float(k * n));
+            }
+            vars.push_back(var);
+            losses.push_back(fn::mean(fn::squared_difference(var, target)));
+        }
+    }
+
+    void backprop(){
+        for(auto &loss : losses){
+            loss.eval();
+            loss.backprop();
+        }
+    }
+
+    std::vector<Tensor> vars;
+    std::vector<Tensor> losses;
+};
+
+// apply(vars) and apply(var, grad) give the same update.
+void expect_same_steps(opt::optimizer_ptr single, opt::optimizer_ptr multi){
+    const int num_threads = get_num_threads();
+    set_num_threads(4);
+    squared_loss a, b;
+    for(int step = 0; step < 3; ++step){
+        a.backprop();
+        for(auto &var : a.vars){
+            single->apply(var, var.grad());
+        }
+        b.backprop();
+        multi->apply(b.vars);
+    }
+    set_num_threads(num_threads);
+    for(int n = 0; n < a.vars.size(); ++n){
+        for(int k = 0; k < a.vars[n].size(); ++k){
+            EXPECT_NEAR(a.vars[n].data<float>()[k],
+                        b.vars[n].data<float>()[k], 1e-6);
+        }
+    }
+}
+
+} // end namespace optimizer_test
+
+TEST(optimizer, multi_tensor_gradient_descent){
+    using namespace optimizer_test;
+    expect_same_steps(fn::create_gradient_descent_optimizer(0.1, 0.9),
+                      fn::create_gradient_descent_optimizer(0.1, 0.9));
+}
+
+TEST(optimizer, multi_tensor_gradient_descent_without_momentum){
+    using namespace optimizer_test;
+    expect_same_steps(fn::create_gradient_descent_optimizer(0.1, 0),
+                      fn::create_gradient_descent_optimizer(0.1, 0));
+}
+
+TEST(optimizer, multi_tensor_adam){
+    using namespace optimizer_test;
+    expect_same_steps(fn::create_adam_optimizer(1e-2),
+                      fn::create_adam_optimizer(1e-2));
+}
+
+TEST(optimizer, multi_tensor_adadelta){
+    using namespace optimizer_test;
+    expect_same_steps(fn::create_adadelta_optimizer(1., 0.95),
+                      fn::create_adadelta_optimizer(1., 0.95));
+}
+
+TEST(optimizer, gradient_descent_momentum){
+    using namespace mlfe;
+    namespace fn = functional;
+    // loss = mean((w - 0)^2) of one element, dw = 2w.
+    auto w = fn::create_variable({1});
+    auto loss = fn::mean(fn::squared_difference(w, fn::constant(0, {1})));
+    auto sgd = fn::create_gradient_descent_optimizer(0.1, 0.5);
+    w.mutable_data<float>()[0] = 1.f;
+    float expected = 1.f, momentum = 0.f;
+    for(int step = 0; step < 3; ++step){
+        loss.eval();
+        loss.backprop();
+        sgd->apply({w});
+        momentum = 0.5f * momentum + 0.1f * 2.f * expected;
+        expected -= momentum;
+        EXPECT_NEAR(w.data<float>()[0], expected, 1e-6);
+    }
+}
+
+TEST(optimizer, gradient_descent_without_momentum){
+    using namespace mlfe;
+    namespace fn = functional;
+    auto w = fn::create_variable({1});
+    auto loss = fn::mean(fn::squared_difference(w, fn::constant(0, {1})));
+    auto sgd = fn::create_gradient_descent_optimizer(0.1, 0);
+    w.mutable_data<float>()[0] = 1.f;
+    float expected = 1.f;
+    for(int step = 0; step < 3; ++step){
+        loss.eval();
+        loss.backprop();
+        sgd->apply({w});
+        expected -= 0.1f * 2.f * expected;
+        EXPECT_NEAR(w.data<float>()[0], expected, 1e-6);
+    }
+}
+
+TEST(optimizer, apply_keeps_its_vars){
+    using namespace optimizer_test;
+    squared_loss a;
+    auto adam = fn::create_adam_optimizer(1e-2);
+    a.backprop();
+    adam->apply(a.vars);
+    adam->apply(a.vars);
+    // other vars would start over from a fresh state.
+    std::vector<Tensor> some(a.vars.begin(), a.vars.begin() + 2);
+    EXPECT_THROW(adam->apply(some), std::string);
+}
+
+TEST(optimizer, flat_parameters_and_gradients){
+    using namespace optimizer_test;
+    const int num_threads = get_num_threads();
+    set_num_threads(4);
+    squared_loss a, b;
+    auto sgd_a = fn::create_gradient_descent_optimizer(0.1, 0.9);
+    auto sgd_b = fn::create_gradient_descent_optimizer(0.1, 0.9);
+    // the gradients exist after the first backprop.
+    b.backprop();
+    std::vector<Tensor> grads;
+    for(auto &var : b.vars){
+        grads.push_back(var.grad());
+    }
+    auto params = fn::flatten_memory(b.vars);
+    auto flat_grads = fn::flatten_memory(grads);
+    for(int step = 0; step < 3; ++step){
+        a.backprop();
+        sgd_a->apply(a.vars);
+        b.backprop();
+        sgd_b->apply(b.vars);
+    }
+    set_num_threads(num_threads);
+
+    const float *param_ptr = params->host_data<float>();
+    const float *grad_ptr = flat_grads->host_data<float>();
+    for(int n = 0; n < a.vars.size(); ++n){
+        EXPECT_EQ(b.vars[n].data<float>(), param_ptr);
+        EXPECT_EQ(b.vars[n].grad().data<float>(), grad_ptr);
+        for(int k = 0; k < a.vars[n].size(); ++k){
+            EXPECT_EQ(a.vars[n].data<float>()[k], param_ptr[k]);
+            EXPECT_EQ(a.vars[n].grad().data<float>()[k], grad_ptr[k]);
+        }
+        param_ptr += a.vars[n].size();
+        grad_ptr += a.vars[n].size();
+    }
+}
+
+namespace optimizer_test{
+
+// one step of adamw or lamb on a copy of the var, decay = 0 is adam.
+struct adam_reference{
+    adam_reference(Tensor var, float lr, float decay, bool lamb)
+        : w(var.cbegin<float>(), var.cend<float>()),
+          m(w.size(), 0.f), v(w.size(), 0.f),
+          lr(lr), decay(decay), lamb(lamb), step(0){}
+
+    void apply(Tensor grad){
+        const double b1 = 0.9, b2 = 0.999, eps = 1e-6;
+        ++step;
+        std::vector<double> r(w.size());
+        double w_norm = 0, r_norm = 0;
+        for(int n = 0; n < w.size(); ++n){
+            const double g = grad.data<float>()[n];
+            m[n] = b1 * m[n] + (1 - b1) * g;
+            v[n] = b2 * v[n] + (1 - b2) * g * g;
+            const double m_hat = m[n] / (1 - std::pow(b1, step));
+            const double v_hat = v[n] / (1 - std::pow(b2, step));
+            r[n] = m_hat / (std::sqrt(v_hat) + eps) + decay * w[n];
+            w_norm += w[n] * w[n];
+            r_norm += r[n] * r[n];
+        }
+        const double trust = lamb && w_norm > 0 && r_norm > 0 ?
+            std::sqrt(w_norm / r_norm) : 1.;
+        for(int n = 0; n < w.size(); ++n){
+            w[n] -= lr * trust * r[n];
+        }
+    }
+
+    std::vector<double> w, m, v;
+    double lr, decay;
+    bool lamb;
+    int step;
+};
+
+void expect_reference_steps(opt::optimizer_ptr optimizer,
+                            float lr, float decay, bool lamb){
+    squared_loss loss;
+    std::vector<adam_reference> refs;
+    for(auto &var : loss.vars){
+        refs.push_back(adam_reference(var, lr, decay, lamb));
+    }
+    for(int step = 0; step < 5; ++step){
+        loss.backprop();
+        for(int n = 0; n < loss.vars.size(); ++n){
+            refs[n].apply(loss.vars[n].grad());
+        }
+        optimizer->apply(loss.vars);
+        for(int n = 0; n < loss.vars.size(); ++n){
+            for(int k = 0; k < loss.vars[n].size(); ++k){
+                EXPECT_NEAR(loss.vars[n].data<float>()[k], refs[n].w[k], 1e-5);
+            }
+        }
+    }
+}
+
+} // end namespace optimizer_test
+
+TEST(optimizer, adam_bias_correction){
+    using namespace optimizer_test;
+    // the first step moves every weight by about lr.
+    expect_reference_steps(fn::create_adam_optimizer(1e-2, 0.9, 0.999, 1e-6),
+                           1e-2, 0, false);
+}
+
+TEST(optimizer, adamw){
+    using namespace optimizer_test;
+    expect_reference_steps(
+        fn::create_adamw_optimizer(1e-2, 0.9, 0.999, 1e-6, 0.1),
+        1e-2, 0.1, false);
+    expect_same_steps(fn::create_adamw_optimizer(1e-2),
+                      fn::create_adamw_optimizer(1e-2));
+}
+
+TEST(optimizer, lamb){
+    using namespace optimizer_test;
+    expect_reference_steps(
+        fn::create_lamb_optimizer(1e-2, 0.9, 0.999, 1e-6, 0.1),
+        1e-2, 0.1, true);
+    expect_same_steps(fn::create_lamb_optimizer(1e-2),
+                      fn::create_lamb_optimizer(1e-2));
+}
+
+TEST(optimizer, clip_by_global_norm){
+    using namespace optimizer_test;
+    squared_loss a, b;
+    auto sgd_a = fn::create_gradient_descent_optimizer(0.1, 0);
+    auto sgd_b = fn::create_gradient_descent_optimizer(0.1, 0);
+    sgd_b->set_clip_norm(0.05);
+    a.backprop();
+    b.backprop();
+    double squared_sum = 0;
+    for(auto &var : a.vars){
+        for(int k = 0; k < var.size(); ++k){
+            squared_sum += std::pow(var.grad().data<float>()[k], 2);
+        }
+    }
+    const double norm = std::sqrt(squared_sum);
+    ASSERT_GT(norm, 0.05);
+
+    sgd_a->apply(a.vars);
+    sgd_b->apply(b.vars);
+    EXPECT_NEAR(sgd_b->get_grad_norm(), norm, 1e-5);
+    // the clipped step is the full step scaled by 0.05 / norm.
+    for(int n = 0; n < a.vars.size(); ++n){
+        for(int k = 0; k < a.vars[n].size(); ++k){
+            const float g = b.vars[n].grad().data<float>()[k];
+            EXPECT_NEAR(g, a.vars[n].grad().data<float>()[k] * 0.05 / norm,
+                        1e-6);
+        }
+    }
+
+    // no scaling below the max norm.
+    sgd_b->set_clip_norm(1e3);
+    b.backprop();
+    std::vector<float> grad(b.vars[4].grad().cbegin<float>(),
+                            b.vars[4].grad().cend<float>());
+    sgd_b->apply(b.vars);
+    EXPECT_TRUE(std::equal(grad.begin(), grad.end(),
+                           b.vars[4].grad().cbegin<float>()));
+}
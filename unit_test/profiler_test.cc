@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace mlfe;
+namespace fn = functional;
+
+TEST(profiler, records_ops){
+    auto x1 = fn::create_variable({8, 16});
+    auto x2 = fn::create_variable({8, 16});
+    std::fill(x1.begin<float>(), x1.end<float>(), 1.f);
+    std::fill(x2.begin<float>(), x2.end<float>(), 2.f);
+    auto y = fn::mean(fn::squared_difference(x1, x2));
+
+    profiler::start();
+    y.eval();
+    y.backprop();
+    profiler::stop();
+    auto events = profiler::events();
+
+    int sq_diff = 0, sq_diff_grad = 0;
+    for(auto &e : events){
+        EXPECT_GE(e.duration, 0);
+        EXPECT_EQ(e.thread_id, 0);
+        if(e.name == "SquaredDifference"){
+            ++sq_diff;
+            EXPECT_EQ(e.shape, std::vector<int>({8, 16}));
+            // x1, x2 and y.
+            EXPECT_EQ(e.bytes, 3 * 8 * 16 * sizeof(float));
+        }
+        if(e.name == "SquaredDifferenceGradient"){
+            ++sq_diff_grad;
+            // x1, x2, dy, dx1 and dx2.
+            EXPECT_EQ(e.bytes, 5 * 8 * 16 * sizeof(float));
+        }
+    }
+    EXPECT_EQ(sq_diff, 1);
+    EXPECT_EQ(sq_diff_grad, 1);
+
+    // nothing is recorded while stopped.
+    x1.mutable_data<float>();
+    y.eval();
+    EXPECT_EQ(profiler::events().size(), events.size());
+
+    auto table = profiler::summary();
+    EXPECT_NE(table.find("SquaredDifferenceGradient"), std::string::npos);
+    EXPECT_NE(table.find("ReduceMean"), std::string::npos);
+
+    const std::string file_name = "profiler_test_trace.json";
+    profiler::write_chrome_trace(file_name);
+    std::ifstream file(file_name);
+    std::string json((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(file_name.c_str());
+    EXPECT_EQ(json.find("{\"traceEvents\":["), 0);
+    EXPECT_NE(json.find("\"name\":\"SquaredDifference\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+}
+
+TEST(profiler, graph_cost){
+    const int size = sizeof(float);
+    auto x = fn::create_variable({2, 3, 8, 8});
+    auto w = fn::create_variable({4, 3, 3, 3});
+    auto y = fn::conv2d(x, w, {1, 1}, {0, 0});
+    auto cost = fn::graph_cost({y});
+    // 2 x 4 x 6 x 6 outputs, a multiply-add of 3 x 3 x 3 taps each.
+    EXPECT_EQ(cost.flops, 2. * 288 * 27);
+    EXPECT_EQ(cost.bytes_read, (x.size() + w.size()) * size);
+    EXPECT_EQ(cost.bytes_written, y.size() * size);
+
+    auto a = fn::create_variable({4, 5});
+    auto b = fn::create_variable({5, 6});
+    auto c = fn::matmul(a, b);
+    EXPECT_EQ(fn::graph_cost({c}).flops, 2. * 4 * 6 * 5);
+
+    // an op reached from two roots is counted once.
+    auto z = fn::add(c, c);
+    cost = fn::graph_cost({z, c});
+    EXPECT_EQ(cost.flops, 2. * 4 * 6 * 5 + 4 * 6);
+    EXPECT_EQ(cost.bytes_written, 2 * 4 * 6 * size);
+}
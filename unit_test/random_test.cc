@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <mlfe/core.h>
+#include <mlfe/operators.h>
+#include <mlfe/math/random.h>
+#include <mlfe/device_context/cpu_context.h>
+#include <mlfe/utils/parallel_for.h>
+#include <cmath>
+#include <vector>
+
+using namespace mlfe;
+namespace fn = functional;
+
+TEST(random, philox_known_answer){
+    // philox4x32-10 test vector of random123 for a zero counter and key.
+    unsigned int words[4];
+    math::philox(0, 0, 0)(0, words);
+    EXPECT_EQ(words[0], 0x6627e8d5u);
+    EXPECT_EQ(words[1], 0xe169c58du);
+    EXPECT_EQ(words[2], 0xbc57ac4cu);
+    EXPECT_EQ(words[3], 0x9b00dbd8u);
+}
+
+TEST(random, philox_is_independent_of_thread_count){
+    using T = float;
+    constexpr int size = 100003;
+    const int num_threads = get_num_threads();
+    const math::philox gen(7, 3, 11);
+    std::vector<T> single(size), multi(size);
+    std::vector<T> mask_single(size), mask_multi(size);
+
+    set_num_threads(1);
+    math::normal_philox<T, CPUContext>(size, 1, gen, single.data());
+    math::bernoulli_philox<T, CPUContext>(size, 0.3f, gen, mask_single.data());
+    set_num_threads(4);
+    math::normal_philox<T, CPUContext>(size, 1, gen, multi.data());
+    math::bernoulli_philox<T, CPUContext>(size, 0.3f, gen, mask_multi.data());
+    set_num_threads(num_threads);
+
+    EXPECT_TRUE(single == multi);
+    EXPECT_TRUE(mask_single == mask_multi);
+}
+
+TEST(random, philox_streams_differ){
+    using T = float;
+    constexpr int size = 64;
+    std::vector<T> a(size), b(size), c(size);
+    math::normal_philox<T, CPUContext>(size, 1, math::philox(1, 0, 0), a.data());
+    math::normal_philox<T, CPUContext>(size, 1, math::philox(1, 1, 0), b.data());
+    math::normal_philox<T, CPUContext>(size, 1, math::philox(1, 0, 1), c.data());
+    EXPECT_FALSE(a == b);
+    EXPECT_FALSE(a == c);
+    EXPECT_FALSE(b == c);
+}
+
+TEST(random, dropout_mask_is_packed_bernoulli){
+    using T = float;
+    constexpr int size = 1000;
+    const math::philox gen(5, 2, 9);
+    std::vector<T> x(size, T(2)), y(size), dx(size), keep(size);
+    std::vector<unsigned int> mask((size + 31) / 32);
+    math::bernoulli_philox<T, CPUContext>(size, 0.6f, gen, keep.data());
+    math::dropout_philox<T, CPUContext>(
+        size, 0.6f, gen, x.data(), mask.data(), y.data());
+    math::dropout_gradient<T, CPUContext>(
+        size, 0.6f, mask.data(), x.data(), dx.data());
+    for(int n = 0; n < size; ++n){
+        const bool bit = (mask[n / 32] >> (n % 32)) & 1;
+        EXPECT_EQ(bit, keep[n] == T(1));
+        EXPECT_EQ(y[n], bit ? T(2) / T(0.6) : T(0));
+        EXPECT_EQ(dx[n], y[n]);
+    }
+}
+
+TEST(random, normal){
+    using T = float;
+    constexpr int size = 1 << 16;
+    constexpr T std = 0.5f;
+    auto y = fn::normal(std, {size});
+    y.eval();
+
+    double mean = 0, var = 0;
+    for(int n = 0; n < size; ++n){
+        mean += y.data<T>()[n];
+    }
+    mean /= size;
+    for(int n = 0; n < size; ++n){
+        var += std::pow(y.data<T>()[n] - mean, 2);
+    }
+    var /= size;
+    EXPECT_NEAR(mean, 0, 0.01);
+    EXPECT_NEAR(std::sqrt(var), std, 0.01);
+}
+
+TEST(random, truncated_normal){
+    using T = float;
+    constexpr int size = 1 << 16;
+    constexpr T std = 0.5f;
+    auto y = fn::truncated_normal(std, {size});
+    y.eval();
+
+    double mean = 0;
+    for(int n = 0; n < size; ++n){
+        EXPECT_LE(std::abs(y.data<T>()[n]), std);
+        mean += y.data<T>()[n];
+    }
+    EXPECT_NEAR(mean / size, 0, 0.01);
+}
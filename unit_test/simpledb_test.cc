@@ -0,0 +1,461 @@
+#include <gtest/gtest.h>
+#include <mlfe/core.h>
+#include <mlfe/flatbuffers/tensor_blob_fb_generated.h>
+#include <mlfe/utils/lz4.h>
+#include <mlfe/utils/db/simple_db.h>
+#include <mlfe/utils/db/simpledb_reader.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace simpledb_test{
+using namespace mlfe;
+
+// writes num records of record_size bytes, record n filled with n % 251.
+void write_db(const std::string name, int num, int record_size,
+              bool compress = false, bool ordered = false){
+    simpledb::SimpleDB db;
+    db.option.delete_previous = true;
+    db.option.binary = true;
+    db.option.compress = compress;
+    db.option.ordered = ordered;
+    db.Open(name);
+    for(int n = 0; n < num; ++n){
+        db.Put(std::to_string(n), std::string(record_size + n % 3, char(n % 251)));
+    }
+    db.Close();
+}
+
+// record n holds an image of size bytes, (n + k) % 256, and a label n % 10.
+void write_tensor_blobs_db(const std::string name, int num, int size, bool compress = false){
+    simpledb::SimpleDB db;
+    flatbuffers::FlatBufferBuilder fbb;
+    db.option.delete_previous = true;
+    db.option.binary = true;
+    db.option.compress = compress;
+    db.Open(name);
+    for(int n = 0; n < num; ++n){
+        std::vector<uint8_t> image(size), label(1, n % 10);
+        for(int k = 0; k < size; ++k){
+            image[k] = (n + k) % 256;
+        }
+        std::vector<flatbuffers::Offset<serializable::TensorBlob>> tbs;
+        tbs.push_back(serializable::CreateTensorBlob(fbb,
+            fbb.CreateString("image"), fbb.CreateVector(image.data(), size),
+            fbb.CreateVector(std::vector<int>{size}.data(), 1)));
+        tbs.push_back(serializable::CreateTensorBlob(fbb,
+            fbb.CreateString("label"), fbb.CreateVector(label.data(), 1),
+            fbb.CreateVector(std::vector<int>{1}.data(), 1)));
+        fbb.Finish(serializable::CreateTensorBlobs(fbb, fbb.CreateVector(tbs)));
+        db.Put(std::to_string(n), std::string(
+            reinterpret_cast<char *>(fbb.GetBufferPointer()), fbb.GetSize()));
+        fbb.Clear();
+    }
+    db.Close();
+}
+
+// the records of the next steps * batch positions, image[0] is the record.
+std::vector<int> read_records(SimpleDBReader &reader, int steps, int batch){
+    constexpr int size = 100;
+    auto image = functional::create_variable({batch, size});
+    std::vector<int> records;
+    for(int step = 0; step < steps; ++step){
+        reader.Read(batch, {image});
+        for(int b = 0; b < batch; ++b){
+            records.push_back(image.data<float>()[b * size]);
+        }
+    }
+    return records;
+}
+
+} // end namespace simpledb_test
+
+TEST(simpledb, mmap_read){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_mmap.db";
+    constexpr int num = 100;
+    write_db(name, num, 37);
+
+    simpledb::SimpleDB stream_db, mapped_db;
+    stream_db.option.binary = true;
+    mapped_db.option.binary = true;
+    mapped_db.option.mmap = true;
+    stream_db.Open(name);
+    mapped_db.Open(name);
+    ASSERT_EQ(mapped_db.NumData(), num);
+    stream_db.MoveToFirst();
+    mapped_db.MoveToFirst();
+    for(int n = 0; n < num; ++n){
+        std::string expected, val;
+        stream_db.Get(expected);
+        mapped_db.Get(val);
+        DataView view = mapped_db.GetView();
+        EXPECT_EQ(val, expected);
+        EXPECT_EQ(std::string(view.data, view.size), expected);
+        EXPECT_EQ(expected, std::string(37 + n % 3, char(n % 251)));
+        stream_db.MoveToNext();
+        mapped_db.MoveToNext();
+    }
+    DataView view = mapped_db.GetView("42");
+    EXPECT_EQ(std::string(view.data, view.size), std::string(37, char(42)));
+    EXPECT_THROW(mapped_db.GetView("none"), std::string);
+    EXPECT_THROW(stream_db.GetView(), std::string);
+    stream_db.Close();
+    mapped_db.Close();
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, hash_index){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_hash_index.db";
+    constexpr int num = 3000;
+    write_db(name, num, 5);
+    simpledb::SimpleDB stream_db, mapped_db;
+    stream_db.option.binary = true;
+    mapped_db.option.binary = true;
+    mapped_db.option.mmap = true;
+    stream_db.option.ordered = true;
+    mapped_db.option.ordered = true;
+    stream_db.Open(name);
+    mapped_db.Open(name);
+    ASSERT_EQ(mapped_db.NumData(), num);
+    // keys that are prefixes of others, like 1, 10 and 100.
+    for(int n = 0; n < num; ++n){
+        DataView view = mapped_db.GetView(std::to_string(n));
+        EXPECT_EQ(std::string(view.data, view.size),
+                  std::string(5 + n % 3, char(n % 251)));
+    }
+    for(auto key : {"", "-1", "3000", "01", "1 "}){
+        EXPECT_THROW(mapped_db.GetView(key), std::string);
+    }
+    // an ordered db starts at the first key, before MoveToFirst().
+    DataView first = mapped_db.GetView();
+    EXPECT_EQ(std::string(first.data, first.size), std::string(5, char(0)));
+    // ordered iteration goes by key in both modes.
+    stream_db.MoveToFirst();
+    mapped_db.MoveToFirst();
+    int count = 0;
+    do{
+        std::string expected, val;
+        stream_db.Get(expected);
+        mapped_db.Get(val);
+        EXPECT_EQ(val, expected);
+        ++count;
+        stream_db.MoveToNext();
+    }while(mapped_db.MoveToNext());
+    EXPECT_EQ(count, num);
+    stream_db.Close();
+    mapped_db.Close();
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, written_in_key_order){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_key_order.db";
+    constexpr int num = 300;
+    write_db(name, num, 5, false, true);
+    simpledb::SimpleDB stream_db, mapped_db, as_stored_db;
+    stream_db.option.binary = true;
+    mapped_db.option.binary = true;
+    as_stored_db.option.binary = true;
+    mapped_db.option.mmap = true;
+    as_stored_db.option.mmap = true;
+    stream_db.option.ordered = true;
+    mapped_db.option.ordered = true;
+    stream_db.Open(name);
+    mapped_db.Open(name);
+    as_stored_db.Open(name);
+    // the file stores the items in key order, both reads follow it.
+    stream_db.MoveToFirst();
+    mapped_db.MoveToFirst();
+    as_stored_db.MoveToFirst();
+    int count = 0;
+    do{
+        std::string expected, val, stored;
+        stream_db.Get(expected);
+        mapped_db.Get(val);
+        as_stored_db.Get(stored);
+        EXPECT_EQ(val, expected);
+        EXPECT_EQ(stored, expected);
+        ++count;
+        stream_db.MoveToNext();
+        as_stored_db.MoveToNext();
+    }while(mapped_db.MoveToNext());
+    EXPECT_EQ(count, num);
+    DataView view = mapped_db.GetView("42");
+    EXPECT_EQ(std::string(view.data, view.size), std::string(5, char(42)));
+    stream_db.Close();
+    mapped_db.Close();
+    as_stored_db.Close();
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, lz4_round_trip){
+    std::vector<std::string> inputs = {"", "a", "abcabcabcabcabcabcabcabc"};
+    // runs, short repeats, long matches, noise and a mix of them.
+    std::string runs(5000, 'x'), text, noise, mixed;
+    for(int n = 0; n < 3000; ++n){
+        text += "the quick brown fox " + std::to_string(n % 17) + " ";
+        noise += char((n * 2654435761u) >> 24);
+        mixed += n % 700 < 350 ? char(n % 7) : char((n * 40503u) >> 8);
+    }
+    inputs.insert(inputs.end(), {runs, text, noise, mixed, std::string(70000, 0) + text});
+    for(const auto &in : inputs){
+        std::vector<char> packed(mlfe::lz4::CompressBound(in.size()));
+        const int packed_size = mlfe::lz4::Compress(in.data(), in.size(), packed.data());
+        ASSERT_LE(packed_size, packed.size());
+        std::string out(in.size(), 0);
+        EXPECT_EQ(mlfe::lz4::Decompress(packed.data(), packed_size,
+            &out[0], out.size()), in.size());
+        EXPECT_EQ(out, in);
+        if(in.size() > 1){
+            // too small for the output, or cut short.
+            EXPECT_EQ(mlfe::lz4::Decompress(packed.data(), packed_size,
+                &out[0], out.size() - 1), -1);
+            EXPECT_NE(mlfe::lz4::Decompress(packed.data(), packed_size - 1,
+                &out[0], out.size()), in.size());
+        }
+    }
+    EXPECT_LT(mlfe::lz4::Compress(runs.data(), runs.size(),
+        std::vector<char>(mlfe::lz4::CompressBound(runs.size())).data()), 100);
+}
+
+TEST(simpledb, compressed_records){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_compressed.db";
+    constexpr int num = 50;
+    write_db(name, num, 300, true);
+    simpledb::SimpleDB stream_db, mapped_db;
+    stream_db.option.binary = true;
+    mapped_db.option.binary = true;
+    mapped_db.option.mmap = true;
+    stream_db.Open(name);
+    mapped_db.Open(name);
+    ASSERT_TRUE(mapped_db.IsCompressed());
+    ASSERT_TRUE(stream_db.IsCompressed());
+    stream_db.MoveToFirst();
+    mapped_db.MoveToFirst();
+    for(int n = 0; n < num; ++n){
+        const std::string expected(300 + n % 3, char(n % 251));
+        std::string val;
+        stream_db.Get(val);
+        EXPECT_EQ(val, expected);
+        mapped_db.Get(val);
+        EXPECT_EQ(val, expected);
+        // views are the stored frames.
+        DataView frame = mapped_db.GetView();
+        EXPECT_LT(frame.size, 40);
+        EXPECT_EQ(simpledb::DecodedSize(frame), expected.size());
+        stream_db.MoveToNext();
+        mapped_db.MoveToNext();
+    }
+    std::string val;
+    stream_db.Get("7", val);
+    EXPECT_EQ(val, std::string(301, char(7)));
+    stream_db.Close();
+    mapped_db.Close();
+
+    // the reader decodes on its workers.
+    write_tensor_blobs_db(name, 10, 100, true);
+    {
+        SimpleDBReader::Option option;
+        option.num_workers = 2;
+        SimpleDBReader reader(name, option), plain_reader(name);
+        EXPECT_EQ(read_records(reader, 6, 4), read_records(plain_reader, 6, 4));
+    }
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, version1_file){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_v1.db";
+    // a version 1 file, the 16 bytes header has no flags.
+    {
+        const std::string data = "helloworld!";
+        const uint32_t header[4] = {0x57957295, 1, 2, 16 + 11};
+        const uint32_t disk_info[4] = {5, 16, 6, 21};
+        std::ofstream file(name, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(data.data(), data.size());
+        file.write(reinterpret_cast<const char *>(disk_info), sizeof(disk_info));
+        file.write("a\0b\0", 4);
+    }
+    for(bool mmap : {true, false}){
+        simpledb::SimpleDB db;
+        db.option.binary = true;
+        db.option.mmap = mmap;
+        db.Open(name);
+        ASSERT_EQ(db.NumData(), 2);
+        EXPECT_FALSE(db.IsCompressed());
+        std::string val;
+        db.Get("a", val);
+        EXPECT_EQ(val, "hello");
+        db.Get("b", val);
+        EXPECT_EQ(val, "world!");
+        if(!mmap){
+            // appending keeps the version 1 layout.
+            db.Put("c", "v1");
+        }
+        db.Close();
+    }
+    {
+        std::ifstream file(name, std::ios::binary);
+        uint32_t header[4];
+        file.read(reinterpret_cast<char *>(header), sizeof(header));
+        EXPECT_EQ(header[1], 1);
+        EXPECT_EQ(header[3], 16 + 13);
+        simpledb::SimpleDB db;
+        db.option.binary = true;
+        db.Open(name);
+        std::string val;
+        db.Get("c", val);
+        EXPECT_EQ(val, "v1");
+    }
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, reader_batches){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_reader.db";
+    constexpr int num = 10, size = 100, batch = 4;
+    write_tensor_blobs_db(name, num, size);
+    {
+        SimpleDBReader reader(name);
+        auto image = functional::create_variable({batch, size});
+        auto label = functional::create_variable({batch});
+        std::vector<float> image_vec(batch * size), label_vec(batch);
+        // the reader wraps around at the end of the db.
+        for(int step = 0; step < 4; ++step){
+            if(step % 2 == 0){
+                reader.Read(batch, {image, label}, {1.f / 255.f});
+            }
+            else{
+                reader.Read<float>(batch, {image_vec, label_vec}, {1.f / 255.f});
+                std::copy(image_vec.begin(), image_vec.end(), image.begin<float>());
+                std::copy(label_vec.begin(), label_vec.end(), label.begin<float>());
+            }
+            for(int b = 0; b < batch; ++b){
+                const int n = (step * batch + b) % num;
+                EXPECT_EQ(label.data<float>()[b], n % 10);
+                for(int k = 0; k < size; ++k){
+                    EXPECT_EQ(image.data<float>()[b * size + k],
+                              ((n + k) % 256) * (1.f / 255.f));
+                }
+            }
+        }
+        auto wrong = functional::create_variable({batch, size + 1});
+        EXPECT_THROW(reader.Read(batch, {wrong}), std::string);
+    }
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, reader_shuffle_and_shard){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_shard.db";
+    constexpr int num = 37, world_size = 3;
+    write_tensor_blobs_db(name, num, 100);
+    {
+        SimpleDBReader::Option option;
+        option.shuffle = true;
+        option.seed = 7;
+        option.world_size = world_size;
+        std::vector<std::vector<int>> epochs(2);
+        for(int rank = 0; rank < world_size; ++rank){
+            option.rank = rank;
+            option.num_workers = rank + 1;
+            option.prefetch = 2 * rank + 1;
+            SimpleDBReader reader(name, option);
+            ASSERT_EQ(reader.NumData(), 13);
+            // batches across the epoch boundary, 2 epochs in 13 steps.
+            auto records = read_records(reader, 13, 2);
+            for(int n = 0; n < records.size(); ++n){
+                epochs[n / 13].push_back(records[n]);
+            }
+            // the stream does not depend on the workers or prefetch.
+            SimpleDBReader::Option serial = option;
+            serial.num_workers = 1;
+            serial.prefetch = 1;
+            SimpleDBReader serial_reader(name, serial);
+            EXPECT_EQ(read_records(serial_reader, 26, 1), records);
+            reader.MoveToFirst();
+            EXPECT_EQ(read_records(reader, 2, 13), std::vector<int>(
+                records.begin(), records.end()));
+        }
+        // the ranks cover every record in an epoch, 2 of them twice.
+        for(auto &epoch : epochs){
+            std::vector<int> sorted = epoch;
+            std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+            EXPECT_EQ(sorted.size(), num);
+            EXPECT_EQ(epoch.size(), num + 2);
+        }
+        EXPECT_NE(epochs[0], epochs[1]);
+    }
+    std::remove(name.c_str());
+}
+
+TEST(simpledb, reader_augmentation){
+    using namespace simpledb_test;
+    const std::string name = "simpledb_test_augmentation.db";
+    constexpr int num = 12, batch = 4;
+    // 4 channel 5 x 5 nchw images.
+    write_tensor_blobs_db(name, num, 100);
+    {
+        const ImageShape shape = {4, 5, 5, false};
+        const std::vector<float> mean = {0.1f, 0.2f, 0.3f, 0.4f};
+        const std::vector<float> stddev = {0.5f, 1.f, 2.f, 4.f};
+        auto stages = std::vector<AugmentationPtr>{
+            std::make_shared<RandomCrop>(3, 3, 1),
+            std::make_shared<RandomFlip>(),
+            std::make_shared<Cutout>(2)};
+        SimpleDBReader::Option option;
+        option.seed = 3;
+        SimpleDBReader reader(name, option);
+        option.num_workers = 3;
+        option.prefetch = 3;
+        SimpleDBReader parallel_reader(name, option);
+        SimpleDBReader plain_reader(name);
+        reader.SetAugmentation(0, shape, stages, mean, stddev);
+        parallel_reader.SetAugmentation(0, shape, stages, mean, stddev);
+        plain_reader.SetAugmentation(0, shape, {}, mean, stddev);
+
+        auto image = functional::create_variable({batch, 4 * 3 * 3});
+        auto parallel_image = functional::create_variable({batch, 4 * 3 * 3});
+        auto plain = functional::create_variable({batch, 100});
+        int changed = 0;
+        for(int step = 0; step < 6; ++step){
+            reader.Read(batch, {image}, {1.f / 255.f});
+            parallel_reader.Read(batch, {parallel_image}, {1.f / 255.f});
+            plain_reader.Read(batch, {plain}, {1.f / 255.f});
+            for(int n = 0; n < image.size(); ++n){
+                EXPECT_EQ(image.data<float>()[n], parallel_image.data<float>()[n]);
+            }
+            for(int b = 0; b < batch; ++b){
+                const int record = (step * batch + b) % num;
+                for(int k = 0; k < 100; ++k){
+                    const int c = k / 25;
+                    const float x = ((record + k) % 256) * (1.f / 255.f);
+                    EXPECT_NEAR(plain.data<float>()[b * 100 + k],
+                                (x - mean[c]) / stddev[c], 1e-6);
+                }
+                // every output value is a normalized input pixel or zero.
+                for(int k = 0; k < 4 * 3 * 3; ++k){
+                    const int c = k / 9;
+                    const float y = image.data<float>()[b * 36 + k];
+                    const float x = y * stddev[c] + mean[c];
+                    const int pixel = std::lround(x * 255.f);
+                    const bool zero = pixel == 0;
+                    const bool in_image = pixel >= record + c * 25 &&
+                        pixel < record + c * 25 + 25;
+                    EXPECT_TRUE(zero || in_image);
+                    changed += zero;
+                }
+            }
+        }
+        EXPECT_GT(changed, 0);
+    }
+    std::remove(name.c_str());
+}
@@ -84,4 +84,67 @@ TEST(tensor_test, iterator_increment){
         ++mptr_dirt;
         ++mptr_iter;
     }
-}
\ No newline at end of file
+}
+
+TEST(tensor_test, flatten_memory){
+    using namespace mlfe;
+    namespace fn = functional;
+    auto a = fn::create_variable({2, 3});
+    auto b = fn::create_variable({5});
+    auto a_view = fn::reshape(a, {6});
+    for(int n = 0; n < a.size(); ++n){
+        a.mutable_data<float>()[n] = n;
+    }
+    for(int n = 0; n < b.size(); ++n){
+        b.mutable_data<float>()[n] = 10 + n;
+    }
+
+    auto flat = fn::flatten_memory({a, b});
+    EXPECT_EQ(flat->size(), (a.size() + b.size()) * sizeof(float));
+    const float *flat_ptr = flat->host_data<float>();
+    EXPECT_EQ(a.data<float>(), flat_ptr);
+    EXPECT_EQ(b.data<float>(), flat_ptr + a.size());
+    EXPECT_EQ(a_view.data<float>(), flat_ptr);
+    for(int n = 0; n < a.size() + b.size(); ++n){
+        EXPECT_EQ(flat_ptr[n], n < a.size() ? n : 10 + n - a.size());
+    }
+
+    // writes through the buffer show up in the tensors.
+    flat->mutable_host_data<float>()[a.size()] = -1.f;
+    EXPECT_EQ(b.data<float>()[0], -1.f);
+    EXPECT_THROW(fn::flatten_memory({a, a_view}), std::string);
+}
+
+TEST(tensor_test, memory_deferred_write){
+    using namespace mlfe;
+    namespace fn = functional;
+    auto a = fn::create_variable({4});
+    auto a_view = fn::reshape(a, {2, 2});
+    int writes = 0;
+    a.get_memory()->defer_write([&writes](void *ptr){
+        auto data = static_cast<float *>(ptr);
+        std::fill(data, data + 4, 3.f);
+        ++writes;
+    });
+    EXPECT_TRUE(a.get_memory()->has_deferred_write());
+    EXPECT_EQ(writes, 0);
+    // the first access writes, through any tensor sharing the memory.
+    EXPECT_EQ(a_view.data<float>()[3], 3.f);
+    EXPECT_FALSE(a.get_memory()->has_deferred_write());
+    a.mutable_data<float>()[0] = 1.f;
+    EXPECT_EQ(a.data<float>()[0], 1.f);
+    EXPECT_EQ(writes, 1);
+
+    // a view of a flattened memory writes at once, for readers of the base.
+    auto b = fn::create_variable({4});
+    auto flat = fn::flatten_memory({a, b});
+    b.get_memory()->defer_write([&writes](void *ptr){
+        auto data = static_cast<float *>(ptr);
+        std::fill(data, data + 4, 5.f);
+        ++writes;
+    });
+    EXPECT_FALSE(b.get_memory()->has_deferred_write());
+    EXPECT_EQ(writes, 2);
+    EXPECT_EQ(flat->host_data<float>()[0], 1.f);
+    EXPECT_EQ(flat->host_data<float>()[4], 5.f);
+}
@@ -2,6 +2,7 @@
 #include <mlfe/core.h>
 #include <mlfe/operators.h>
 #include <mlfe/utils/gradient_checker.h>
+#include <mlfe/utils/parallel_for.h>
 #include <random>
 
 using namespace mlfe;
@@ -133,3 +134,174 @@ TEST(unary_op, relu_grad){
         EXPECT_GE(diff, -pass_eps);
     }
 }
+
+TEST(unary_op, dropout){
+    using T = float;
+    constexpr int size = 1 << 16;
+    auto x = fn::create_variable({size});
+    auto prob = fn::create_variable({1});
+    auto y = fn::dropout(x, prob);
+    std::fill(x.begin<T>(), x.end<T>(), T(1));
+    prob.mutable_data<T>()[0] = 0.25f;
+    y.eval();
+
+    int kept = 0;
+    for(int n = 0; n < size; ++n){
+        const T val = y.data<T>()[n];
+        EXPECT_TRUE(val == T(0) || std::abs(val - T(1) / T(0.75)) < 1e-6);
+        kept += val != T(0);
+    }
+    EXPECT_NEAR(kept / T(size), 0.75f, 0.01f);
+
+    // every step draws a new mask.
+    std::vector<T> first(y.cbegin<T>(), y.cend<T>());
+    std::fill(x.begin<T>(), x.end<T>(), T(1));
+    y.eval();
+    EXPECT_FALSE(std::equal(first.begin(), first.end(), y.cbegin<T>()));
+}
+
+TEST(unary_op, dropout_grad){
+    using T = float;
+    auto x = fn::create_variable({70});
+    auto prob = fn::create_variable({1});
+    auto y = fn::dropout(x, prob);
+    std::fill(x.begin<T>(), x.end<T>(), T(3));
+    prob.mutable_data<T>()[0] = 0.5f;
+    y.eval();
+    y.backprop();
+
+    // dy is one, so dx is y / x.
+    for(int n = 0; n < x.size(); ++n){
+        EXPECT_EQ(x.grad().data<T>()[n], y.data<T>()[n] / T(3));
+    }
+}
+
+namespace reduce_test{
+
+using Reduce = Tensor (*)(Tensor, std::vector<int>, bool);
+
+// the sum, mean and max of x along axes, accumulated in double.
+std::vector<double> reference(Tensor x, std::vector<int> axes, int kind){
+    const auto shape = x.shape();
+    const int rank = shape.size();
+    std::vector<bool> reduced(rank, axes.empty());
+    for(auto axis : axes){
+        reduced[axis < 0 ? axis + rank : axis] = true;
+    }
+    int y_size = 1;
+    for(int d = 0; d < rank; ++d){
+        y_size *= reduced[d] ? 1 : shape[d];
+    }
+    std::vector<double> y(y_size, kind == 2 ? -1e30 : 0);
+    std::vector<int> count(y_size, 0);
+    for(int n = 0; n < x.size(); ++n){
+        int index = 0, rest = n, stride = 1;
+        for(int d = rank - 1; d >= 0; --d){
+            const int i = rest % shape[d];
+            rest /= shape[d];
+            if(!reduced[d]){
+                index += i * stride;
+                stride *= shape[d];
+            }
+        }
+        const double v = x.data<float>()[n];
+        y[index] = kind == 2 ? std::max(y[index], v) : y[index] + v;
+        ++count[index];
+    }
+    for(int n = 0; kind == 1 && n < y_size; ++n){
+        y[n] /= count[n];
+    }
+    return y;
+}
+
+const std::vector<std::vector<int>> axes_cases = {
+    {}, {0}, {1}, {2}, {-1}, {0, 2}, {1, 2}, {0, 1, 2}};
+
+} // end namespace reduce_test
+
+TEST(unary_op, reduce){
+    using namespace reduce_test;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    const Reduce ops[3] = {fn::reduce_sum, fn::reduce_mean, fn::reduce_max};
+    auto x = fn::create_variable({3, 4, 5});
+    std::generate(x.begin<float>(), x.end<float>(), [&](){ return dist(rng); });
+    for(auto &axes : axes_cases){
+        for(int kind = 0; kind < 3; ++kind){
+            auto y = ops[kind](x, axes, true);
+            auto squeezed = ops[kind](x, axes, false);
+            y.eval();
+            squeezed.eval();
+            auto expected = reference(x, axes, kind);
+            ASSERT_EQ(y.size(), expected.size());
+            ASSERT_EQ(y.shape().size(), 3);
+            ASSERT_EQ(squeezed.size(), expected.size());
+            for(int n = 0; n < y.size(); ++n){
+                EXPECT_NEAR(y.data<float>()[n], expected[n], 1e-5);
+                EXPECT_EQ(squeezed.data<float>()[n], y.data<float>()[n]);
+            }
+        }
+    }
+    EXPECT_EQ(fn::reduce_sum(x, {1}).shape(), std::vector<int>({3, 5}));
+    EXPECT_EQ(fn::reduce_sum(x, {1}, true).shape(), std::vector<int>({3, 1, 5}));
+    EXPECT_EQ(fn::reduce_sum(x).shape(), std::vector<int>({1}));
+    EXPECT_THROW(fn::reduce_sum(x, {3}), std::string);
+}
+
+// large reductions into a few outputs are split over the threads and
+// summed pairwise. the result is close to a double sum and the same for
+// any number of threads.
+TEST(unary_op, reduce_large){
+    using namespace reduce_test;
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> dist(0, 1);
+    const std::vector<std::pair<std::vector<int>, std::vector<int>>> cases = {
+        {{1 << 22}, {}}, {{4, 1 << 18}, {1}}, {{1 << 16, 8}, {0}},
+        {{64, 32, 64}, {0, 2}}};
+    const int num_threads = get_num_threads();
+    for(auto &c : cases){
+        auto x = fn::create_variable(c.first);
+        std::generate(x.begin<float>(), x.end<float>(), [&](){ return dist(rng); });
+        auto expected = reference(x, c.second, 0);
+        std::vector<float> results[2];
+        for(int t = 0; t < 2; ++t){
+            set_num_threads(t == 0 ? 1 : 4);
+            auto y = fn::reduce_sum(x, c.second);
+            y.eval();
+            results[t].assign(y.cbegin<float>(), y.cend<float>());
+        }
+        set_num_threads(num_threads);
+        EXPECT_EQ(results[0], results[1]);
+        for(int n = 0; n < expected.size(); ++n){
+            EXPECT_NEAR(results[0][n], expected[n], expected[n] * 1e-6);
+        }
+    }
+}
+
+TEST(unary_op, reduce_grad){
+    using namespace reduce_test;
+    using T = float;
+    constexpr T grad_eps = 1e-3;
+    constexpr T pass_eps = 2e-3;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<T> dist(-1, 1);
+    const Reduce ops[3] = {fn::reduce_sum, fn::reduce_mean, fn::reduce_max};
+    for(auto &axes : axes_cases){
+        for(int kind = 0; kind < 3; ++kind){
+            auto x = fn::create_variable({3, 4, 5});
+            std::generate(x.begin<T>(), x.end<T>(), [&](){ return dist(rng); });
+            auto y = ops[kind](x, axes, false);
+            // an upstream gradient that is not 1.
+            auto w = fn::create_variable(y.shape());
+            std::generate(w.begin<T>(), w.end<T>(), [&](){ return dist(rng); });
+            auto result = fn::mul(y, w);
+            result.eval();
+            result.backprop();
+            std::vector<T> analytical(x.grad().cbegin<T>(), x.grad().cend<T>());
+            auto numerical = numerical_gradient(grad_eps, result, x);
+            for(int n = 0; n < x.size(); ++n){
+                EXPECT_NEAR(analytical[n], numerical.data<T>()[n], pass_eps);
+            }
+        }
+    }
+}